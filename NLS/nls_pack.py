@@ -0,0 +1,217 @@
+#!/usr/bin/env python3
+#
+# nls_pack.py
+#
+# Builds the binary language pack from the JSON messages file and u8g2 font file.
+# The pack is loaded by the controller by single sequential read, without JSON parsing.
+# The message keys are read from the firmware source, SRC/Core/Inc/nls.h, so the pack
+# must be rebuilt when the message list of the firmware changes.
+#
+# Usage:
+#   nls_pack.py ru_lang.json ubuntu_cyr.font russian.nlp
+#   nls_pack.py --header ../SRC/Core/Inc/nls.h ru_lang.json ubuntu_cyr.font russian.nlp
+#
+# Then add "pack": "russian.nlp" to the language entry in cfg.json
+#
+# The CRC32 of the messages and font files loaded without the pack can be checked by the controller too:
+#   nls_pack.py --crc ru_lang.json ubuntu_cyr.font
+# prints the CRC32 of each file, add them as "messages_crc": "XXXXXXXX", "font_crc": "XXXXXXXX" to the language entry
+#
+# Pack format (little endian), see t_nls_pack_header in nls_cfg.h:
+#   char magic[4] "NLSP", uint16 version, uint16 msg_num, uint32 keys_crc,
+#   uint32 pool_size, uint32 font_size, uint32 data_crc
+#   uint16 offset[msg_num], string pool, font data
+#
+
+import argparse
+import os
+import re
+import struct
+import sys
+import zlib
+
+PACK_VERSION	= 1
+NO_MESSAGE		= 0xFFFF
+STANDALONE		= "standalone"							# standalone_msg in vars.cpp
+
+
+def load_keys(header):
+	""" Read the message keys from NLS_MSG::message[] table. Returns the key list, menu ranges and the first standalone message """
+	keys	= []
+	menus	= []											# [title, first, last]
+	single	= None
+	in_table = False
+	with open(header, encoding="utf-8") as f:
+		for line in f:
+			if not in_table:
+				if re.search(r"t_msg\s+message\[MSG_LAST\]", line):
+					in_table = True
+				continue
+			if line.strip().startswith("};"):
+				break
+			c = re.search(r"//\s*(.*)$", line)
+			m = re.search(r'\{\s*"((?:[^"\\]|\\.)*)"\s*,\s*0\s*\}', line)
+			if not m and c:									# Section comment
+				section = c.group(1).upper()
+				if "SINGLE MESSAGE" in section:
+					single = len(keys)
+				elif section.endswith("MENU"):
+					menus.append([None, len(keys), len(keys)])
+				continue
+			if m:
+				key = m.group(1).encode().decode("unicode_escape")
+				if menus and single is None:
+					if menus[-1][0] is None:
+						menus[-1][0] = key					# The first menu item is the title
+					menus[-1][2] = len(keys) + 1
+				keys.append(key)
+	if not keys or single is None:
+		sys.exit("Failed to read the message table from %s" % header)
+	return keys, menus, single
+
+
+def find(keys, menus, single, key, parent):
+	""" The same search as NLS_MSG::find() in the firmware """
+	first, last = 0, len(keys)
+	if parent:
+		if parent == STANDALONE:
+			first = single
+		else:
+			for title, f, l in menus:
+				if parent == title:
+					first, last = f, l
+					break
+	for i in range(first, last):
+		if keys[i] == key:
+			return i
+	return -1
+
+
+class JsonReader:
+	""" Minimal JSON tokenizer, reports the string key/value pairs with the parent object name, like the firmware does """
+	def __init__(self, text, name):
+		self.t		= text
+		self.p		= 0
+		self.name	= name
+
+	def error(self, msg):
+		line = self.t.count("\n", 0, self.p) + 1
+		sys.exit("%s:%d: %s" % (self.name, line, msg))
+
+	def skip(self):
+		while self.p < len(self.t) and (self.t[self.p].isspace() or self.t[self.p] == ","):
+			self.p += 1
+
+	def string(self):
+		self.p += 1										# Skip opening quote
+		s = []
+		while self.p < len(self.t):
+			c = self.t[self.p]
+			self.p += 1
+			if c == '"':
+				return "".join(s)
+			if c == "\\":
+				e = self.t[self.p]
+				self.p += 1
+				if e == "u":
+					s.append(chr(int(self.t[self.p:self.p+4], 16)))
+					self.p += 4
+				else:
+					s.append({"n": "\n", "t": "\t", "r": "\r", "b": "\b", "f": "\f"}.get(e, e))
+			elif c == "\n":
+				self.error("unterminated string")
+			else:
+				s.append(c)
+		self.error("unterminated string")
+
+	def pairs(self):
+		self.p = self.t.find("{")							# The firmware skips everything before the body
+		if self.p < 0:
+			self.error("no JSON object found")
+		yield from self.obj("")
+
+	def obj(self, parent):
+		self.p += 1										# Skip '{'
+		while True:
+			self.skip()
+			if self.p >= len(self.t):
+				self.error("unexpected end of file")
+			if self.t[self.p] == "}":
+				self.p += 1
+				return
+			if self.t[self.p] != '"':
+				self.error("expected key")
+			key = self.string()
+			self.skip()
+			if self.t[self.p] != ":":
+				self.error("expected ':' after \"%s\"" % key)
+			self.p += 1
+			self.skip()
+			c = self.t[self.p]
+			if c == "{":
+				yield from self.obj(key)
+			elif c == '"':
+				yield parent, key, self.string()
+			else:
+				self.error("expected string value for \"%s\"" % key)
+
+
+def main():
+	here = os.path.dirname(os.path.abspath(__file__))
+	ap = argparse.ArgumentParser(description="Build binary language pack for the soldering station")
+	ap.add_argument("messages",	nargs="?", help="JSON messages file")
+	ap.add_argument("font",		nargs="?", help="u8g2 font file, use '-' for the default font")
+	ap.add_argument("pack",		nargs="?", help="output pack file")
+	ap.add_argument("--header",	default=os.path.join(here, "..", "SRC", "Core", "Inc", "nls.h"), help="path to nls.h")
+	ap.add_argument("--crc",	nargs="+", metavar="FILE", help="print CRC32 of the files for cfg.json and exit")
+	a = ap.parse_args()
+
+	if a.crc:
+		for fn in a.crc:
+			with open(fn, "rb") as f:
+				print("%-20s %08X" % (os.path.basename(fn), zlib.crc32(f.read())))
+		return
+	if not a.pack:
+		ap.error("the messages, font and pack files are required")
+
+	keys, menus, single = load_keys(a.header)
+	with open(a.messages, encoding="utf-8-sig") as f:
+		reader = JsonReader(f.read(), a.messages)
+
+	messages = [None] * len(keys)
+	for parent, key, value in reader.pairs():
+		i = find(keys, menus, single, key, parent)
+		if i < 0:
+			print("warning: unknown message \"%s\" in \"%s\"" % (key, parent), file=sys.stderr)
+			continue
+		messages[i] = value
+
+	pool	= bytearray()
+	offsets	= []
+	for m in messages:
+		if m is None:
+			offsets.append(NO_MESSAGE)
+		else:
+			offsets.append(len(pool))
+			pool += m.encode("utf-8") + b"\0"
+	if len(pool) >= NO_MESSAGE:
+		sys.exit("The string pool is too big")
+
+	font = b""
+	if a.font != "-":
+		with open(a.font, "rb") as f:
+			font = f.read()
+
+	keys_crc = 0
+	for k in keys:
+		keys_crc = zlib.crc32(k.encode("utf-8") + b"\0", keys_crc)
+	data = struct.pack("<%dH" % len(offsets), *offsets) + bytes(pool) + font
+	hdr	 = struct.pack("<4sHHIIII", b"NLSP", PACK_VERSION, len(keys), keys_crc, len(pool), len(font), zlib.crc32(data))
+	with open(a.pack, "wb") as f:
+		f.write(hdr + data)
+	print("%s: %d of %d messages, %d bytes of strings, %d bytes of font" %
+		(a.pack, len([m for m in messages if m is not None]), len(keys), len(pool), len(font)))
+
+
+if __name__ == "__main__":
+	main()
@@ -0,0 +1,83 @@
+/*
+ * bench.h
+ *
+ *  Created on: 18 oct 2026
+ *
+ * Storage throughput benchmark. Measures sequential and random operations on the FatFS volume using the scratch file.
+ * The raw W25Qxx sector operations are measured on the separate scratch area: the contiguous file allocated by FatFS
+ * and closed during the test, so the raw operations cannot touch any other file or the file system structures.
+ * The scratch files are removed after the test, so the file system data is not affected.
+ * BENCH_STAT does not depend on the hardware: it accumulates operation latencies and calculates the statistics.
+ * The time is measured by BENCH_TIMER, the firmware uses the core cycle counter (CYCLE_TIMER).
+ */
+
+#ifndef BENCH_H_
+#define BENCH_H_
+
+#include <stdint.h>
+#include "ff.h"
+
+typedef struct s_bench_result {
+	uint32_t	kbps;										// Throughput, KBytes/s
+	uint32_t	p50;										// Operation latency percentiles, us
+	uint32_t	p90;
+	uint32_t	max;
+} t_bench_result;
+
+class BENCH_STAT {
+	public:
+		BENCH_STAT(void)									{ }
+		void		reset(void)								{ samples = 0; total_us = 0; bytes = 0;	}
+		void		add(uint32_t us, uint32_t size);		// Add the operation latency and data size
+		void		result(t_bench_result *r);
+		static const uint8_t	max_samples	= 16;
+	private:
+		uint32_t	sample[max_samples];
+		uint8_t		samples		= 0;
+		uint32_t	total_us	= 0;
+		uint32_t	bytes		= 0;
+};
+
+class BENCH_TIMER {
+	public:
+		virtual void		start(void)						= 0;
+		virtual uint32_t	elapsed(void)					= 0;	// Time from start(), us
+};
+
+#ifdef USE_HAL_DRIVER
+class CYCLE_TIMER : public BENCH_TIMER {
+	public:
+		CYCLE_TIMER(void)									{ }
+		virtual void		start(void);
+		virtual uint32_t	elapsed(void);
+	private:
+		uint32_t	start_cycle		= 0;
+};
+#endif
+
+typedef enum {
+	BENCH_SEQ_WRITE = 0, BENCH_SEQ_READ, BENCH_RND_WRITE, BENCH_RND_READ, BENCH_FS_LAST
+} t_bench_fs;
+
+typedef enum {
+	BENCH_ERASE = 0, BENCH_PROGRAM, BENCH_READ, BENCH_RAW_LAST
+} t_bench_raw;
+
+class STORAGE_BENCH {
+	public:
+		STORAGE_BENCH(BENCH_TIMER *timer)					{ this->timer = timer; }
+		bool		volume(const char *drive, t_bench_result res[BENCH_FS_LAST], t_bench_result raw[BENCH_RAW_LAST] = 0);
+	private:
+		bool		fileSystem(FIL *f, t_bench_result res[BENCH_FS_LAST]);
+		bool		rawFlash(const char *drive, t_bench_result raw[BENCH_RAW_LAST]);
+		BENCH_TIMER	*timer;
+		BENCH_STAT	stat;
+		uint8_t		*buff			= 0;
+		const uint16_t	block_size	= 4096;					// Sequential operation size, W25Qxx sector size
+		const uint16_t	rnd_size	= 512;					// Random operation size
+		const uint8_t	blocks		= 16;					// Scratch file size in blocks
+		const char		*scratch	= "bench.tmp";			// File system scratch file name
+		const char		*raw_area	= "bench.raw";			// Raw flash scratch area file name
+};
+
+#endif
@@ -1,6 +1,8 @@
 /*
  * buzzer.h
  *
+ *  2026 OCT 18
+ *  	The tones are played by TIM4 update interrupt from the queue, the beep functions do not block
  */
 
 #ifndef BUZZER_H_
@@ -18,9 +20,22 @@ class BUZZER {
 		void		shortBeep(void);
 		void		doubleBeep(void);
 		void		failedBeep(void);
+		static void	tick(void);								// Called from TIM4 update interrupt
 	private:
-		void		playTone(uint16_t period_mks, uint16_t duration_ms);
+		typedef struct s_tone {
+			uint16_t	period_mks;							// The tone period, 0 means silence
+			uint16_t	duration_ms;
+		} t_tone;
+		void		play(const t_tone seq[], uint8_t n);
+		static void	next(void);
 		bool		enabled = true;
+		static const uint8_t	queue_size	= 16;
+		static t_tone			queue[queue_size];			// The tones to be played, shared by all instances
+		static volatile uint8_t	q_head;						// The index of the next tone to be added
+		static volatile uint8_t	q_tail;						// The index of the next tone to be played
+		static volatile bool	playing;
+		static uint32_t			remaining;					// The remaining time of the current tone, mks
+		static uint16_t			period;						// The TIM4 period of the current tone, mks
 };
 
 #endif
@@ -9,6 +9,8 @@
  *  2024 OCT 06 v.1.15
  *  	Added CFG_FAST_COOLING and CFG_DSPL_TYPE entries to the CFG_BIT_MASK
  *  	Changed the type of bit_mask field (uint8_t -> uint16_t) in the RECORD struct.
+ *  2026 OCT 18
+ *  	RECORD and TIP are protected by CRC32 and have the format version field, CFG_VERSION and TIP_VERSION
  */
 
 #ifndef CFGTYPES_H_
@@ -36,6 +38,9 @@ typedef enum { d_t12 = 0, d_gun = 1, d_unknown } tDevice;
 
 typedef enum {FLASH_OK = 0, FLASH_ERROR, FLASH_NO_FILESYSTEM, FLASH_NO_DIRECTORY} FLASH_STATUS;
 
+#define		CFG_VERSION		(1)						// The RECORD format version. Version 0 had 16-bit checksum and no version field
+#define		TIP_VERSION		(1)						// The TIP format version. Version 0 had 8-bit checksum and no version field
+
 /* Configuration record in the EEPROM (after the tip table) has the following format:
  * Records are aligned by 2**n bytes (in this case, 32 bytes)
  *
@@ -50,7 +55,8 @@ typedef enum {FLASH_OK = 0, FLASH_ERROR, FLASH_NO_FILESYSTEM, FLASH_NO_DIRECTORY
  */
 typedef struct s_config RECORD;
 struct s_config {
-	uint16_t	crc;								// The checksum
+	uint32_t	crc;								// CRC32 of the record with zero crc field
+	uint16_t	version;							// CFG_VERSION
 	uint16_t	iron_temp;							// The IRON preset temperature in degrees (Celsius or Fahrenheit)
 	uint16_t	gun_temp;							// The Hot Air Gun preset temperature in degrees (Celsius or Fahrenheit)
 	uint16_t	gun_fan_speed;						// The Hot Air Gun fan speed
@@ -68,7 +74,7 @@ struct s_config {
 };
 
 /*
- * Configuration data of each initialized tip are saved in the tipcal.dat file (16 bytes per tip record).
+ * Configuration data of each initialized tip are saved in the tipcal.dat file (20 bytes per tip record).
  * The tip configuration record has the following format:
  * 4 reference temperature points
  * tip status bitmap
@@ -80,7 +86,8 @@ struct s_tip {
 	uint8_t		mask;								// The bit mask: TIP_ACTIVE + TIP_CALIBRATED
 	char		name[tip_name_sz];					// T12 tip name suffix, JL02 for T12-JL02
 	int8_t		ambient;							// The ambient temperature in Celsius when the tip being calibrated
-	uint8_t		crc;								// CRC checksum
+	uint8_t		version;							// TIP_VERSION
+	uint32_t	crc;								// CRC32 of the previous fields
 };
 
 // This tip structure is used to show available tips when tip is activating
@@ -8,6 +8,8 @@
  *  	Added new parameter to CFG_CORE::setup()
  *  	Added new internal type (struct s_setup) into CFG_CORE class allowing to pass parameters into CFG_CORE::setup()
  *  	Added new method, CFG_CORE::getMainParams()
+ *  2026 OCT 18
+ *  	Added the sorted list of active tips, CFG::active_tip, to build tip menu without whole tip table scan
  */
 
 #ifndef CONFIG_H_
@@ -141,8 +143,12 @@ class CFG : public W25Q, public CFG_CORE, public TIP_CFG, public BUZZER {
 		void		correctConfig(RECORD *cfg);
 		bool 		selectTip(tDevice dev_type, uint8_t index);
 		uint8_t		buildTipTable(TIP_TABLE tt[]);
+		void		buildActiveList(void);
+		uint16_t	activePosition(uint8_t index);
 		std::string buildFullTipName(const uint8_t index);
 		TIP_TABLE	*tip_table = 0;						// Tip table - chunk number of the tip or 0xFF if does not exist in the EEPROM
+		uint8_t		*active_tip = 0;					// Sorted list of the active tip indexes
+		uint16_t	active_num	= 0;					// Number of active tips in the list
 };
 
 #endif
@@ -6,6 +6,9 @@
  *
  *  2022 DEC 26
  *     Added gtimPeriod() function that return the period of GUN timer in ms
+ *  2026 OCT 18
+ *  	Added acHalfPeriod(), acFrequency() and acCheck()
+ *  	Added buttonsCheck()
  */
 
 #ifndef CORE_H_
@@ -20,6 +23,8 @@
 // Forward function declaration
 bool		isACsine(void);
 uint16_t	gtimPeriod(void);
+uint32_t	acHalfPeriod(void);							// AC half-cycle period, mks; 0 if no AC
+uint8_t		acFrequency(void);							// AC frequency: 50, 60 or 0 if no AC
 
 #ifdef __cplusplus
 extern "C" {
@@ -27,6 +32,8 @@ extern "C" {
 
 void setup(void);
 void loop(void);
+void acCheck(void);
+void buttonsCheck(void);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,23 @@
+/*
+ * crc.h
+ *
+ *  Created on: 2026 OCT 18
+ *      Author: Alex
+ */
+
+#ifndef CRC_H_
+#define CRC_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+uint32_t	crc32(uint32_t crc, const void *data, uint32_t size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -11,6 +11,11 @@
  *		Added DSPL::drawButtonStatus()
  *	2024 OCT 12
  *		Added a parameter to DSPL::init() to support IPS display
+ *	2026 OCT 18
+ *		DSPL::directoryShow() draws the visible page of the directory only
+ *		Added DSPL::memoryShow()
+ *		The brightness fades in TIM3 update interrupt, see BRGT::adjust() and BRGT::fadeTick()
+ *		DSPL::memoryShow() shows the font cache statistics
  */
 
 #ifndef DISPLAY_H_
@@ -24,6 +29,8 @@
 #include "font.h"
 #include "nls.h"
 #include "tools.h"
+#include "memstat.h"
+#include "font_cache.h"
 
 // TFT brightness control class
 #define TFT_TIM		htim3
@@ -33,21 +40,32 @@ class BRGT {
 	public:
 		BRGT(void)								{ }
 		void		start(void)								{ HAL_TIM_PWM_Start(&TFT_TIM, TIM_CHANNEL_1);	}
-		void		stop(void)								{ HAL_TIM_PWM_Stop(&TFT_TIM, TIM_CHANNEL_1);	}
+		void		stop(void)								{ fading = false; HAL_TIM_PWM_Stop(&TFT_TIM, TIM_CHANNEL_1);	}
 		void		set(uint8_t brightness)					{ this->brightness = brightness;				}
 		uint8_t		get(void)								{ return TFT_TIM.Instance->CCR1 & 0xff;			}
-		void		off(void)								{ TFT_TIM.Instance->CCR1 = 0;					}
-		void		dim(uint8_t br)							{ TFT_TIM.Instance->CCR1 = br;					}
-		void		on(void)								{ TFT_TIM.Instance->CCR1 = brightness;			}
+		void		off(void)								{ fading = false; TFT_TIM.Instance->CCR1 = 0;	}
+		void		dim(uint8_t br)							{ fading = false; TFT_TIM.Instance->CCR1 = br;	}
+		void		on(void)								{ fading = false; TFT_TIM.Instance->CCR1 = brightness;	}
+		void		setFade(uint16_t duration_ms, bool gamma);
 		bool		adjust(void);
+		void		fadeTick(void);
 	private:
-		uint8_t	brightness			= 0;					// Setup display brightness
+		uint16_t	ramp(uint16_t p);
+		uint8_t				brightness	= 0;				// Setup display brightness
+		volatile bool		fading		= false;			// The fade is running in TIM3 interrupt
+		volatile uint8_t	f_from		= 0;				// The brightness when the fade started
+		volatile uint8_t	f_to		= 0;				// The brightness at the end of the fade
+		volatile uint32_t	f_start		= 0;				// The fade start time, ms
+		uint16_t			f_duration	= 250;				// The fade duration, ms
+		bool				f_gamma		= true;				// Use gamma corrected ramp
+		static const uint16_t	gamma_ramp[33];				// (x/32)^2.2 * 1024
 };
 
 typedef enum { u_lower = 0, u_upper = 1, u_extra = 2, u_none = 3 } tUnitPos;
 
 class DSPL : public tft_ILI9341, public BRGT, public GRAPH, public NLS_MSG {
 	public:
+		static const uint8_t	dir_lines	= 6;			// Number of directory entries on the screen
 					DSPL(void) : tft_ILI9341()				{ }
 		virtual		~DSPL()									{ }
 		void		init(bool ips = false);
@@ -82,7 +100,7 @@ class DSPL : public tft_ILI9341, public BRGT, public GRAPH, public NLS_MSG {
 		void 		animatePower(tUnitPos pos, int16_t t);
 		void		drawTipList(TIP_ITEM list[], uint8_t list_len, uint8_t index, bool name_only);
 		void		menuShow(t_msg_id menu_id, uint8_t item, const char* value, bool modify);
-		void		directoryShow(const std::vector<std::string> &dir_list, uint16_t item);
+		void		directoryShow(const char* const names[], uint8_t items, uint8_t selected);
 		void		tuneShow(uint16_t tune_temp, uint16_t temp, uint8_t pwr_pcnt);
 		void 		calibShow(uint8_t ref_point, uint16_t current_temp, uint16_t real_temp, bool celsius, uint8_t power, bool on, bool ready, uint8_t int_temp_pcnt);
 		void		calibManualShow(uint16_t ref_temp, uint16_t current_temp, uint16_t setup_temp, bool celsius, uint8_t power, bool on, bool ready);
@@ -100,6 +118,7 @@ class DSPL : public tft_ILI9341, public BRGT, public GRAPH, public NLS_MSG {
 		void 		showVersion(void);
 		void 		debugShow(uint16_t data[9], bool iron_on, bool gun_on, bool iron_connected, bool gun_connected, bool is_ac_ok);
 		void		debugMessage(const char *msg, uint16_t x, uint16_t y, uint16_t len);
+		void		memoryShow(t_mem_stat &st, uint32_t pool_failures, uint32_t pool_oversized, uint8_t idle, uint32_t latency, FONT_CACHE *fc);
 		void		encoderDebugShow(uint16_t i_enc, uint32_t i_ints, uint8_t i_b, uint16_t g_enc, uint32_t g_ints, uint8_t g_b, uint8_t ret);
 	private:
 		void		checkBox(BITMAP &bm, uint16_t x, uint8_t size, bool checked);
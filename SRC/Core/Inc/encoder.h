@@ -8,6 +8,14 @@
  *  	Added RENC::enc_int variable to calculate the number of encoder interrupts. Used in debug mode.
  *  	Added RENC::intNumber() method
  *  	Added RENC::buttonPressed() method to check current button status
+ *  2026 OCT 18
+ *  	The interrupt handler puts timestamped detent events into the queue, RENC::read() applies them to the position.
+ *  	The increment depends on the rotation velocity, see RENC::setAcceleration()
+ *  	The button is checked by EXTI interrupt and debounced in SysTick, see RENC::buttonIntr() and RENC::buttonTick().
+ *  	The button events are classified at the edge and queued. The long and double press thresholds are set by RENC::setButtonTiming(),
+ *  	the double press is disabled by default
+ *  	RENC::reset() discards the queued button events and the press in progress
+ *  	RENC::extendUpper() widens the position range keeping the queued events, used by the growing list
  */
  
 #ifndef ENCODER_H_
@@ -23,15 +31,24 @@ class RENC {
 		void		setClockWise(bool clockwise)			{ this->clockwise = clockwise;									}
 		bool		write(int16_t initPos);
 		void    	reset(int16_t initPos, int16_t low, int16_t upp, uint8_t inc, uint8_t fast_inc, bool looped);
+		void		extendUpper(int16_t upp)				{ if (upp > max_pos) max_pos = upp;								}
 		void 		encoderIntr(void);
+		void		buttonIntr(void);
+		bool		buttonTick(uint32_t now);
+		void		setButtonTiming(uint16_t long_ms, uint16_t double_ms);
 		void 		setTimeout(uint16_t timeout_ms)			{ over_press = timeout_ms; 										}
+		uint32_t	buttonTime(void)						{ return b_time;												}
 		void    	setIncrement(uint8_t inc)           	{ increment = fast_increment = inc; 							}
 		uint8_t		getIncrement(void)                 		{ return increment; 											}
-		int16_t 	read(void)                          	{ return pos;													}
+		void		setAcceleration(uint8_t slow, uint8_t fast);
+		int16_t 	read(void);
+		uint32_t	lostEvents(void)						{ return lost;													}
 		bool 		buttonPressed(void)						{ return (GPIO_PIN_RESET == HAL_GPIO_ReadPin(b_port, b_pin));	}
 		uint32_t	intNumber(void);
 	private:
-		EMP_AVERAGE			avg;							// Do average the button readings to maintain the button status
+		void		flush(void)								{ q_tail = q_head; win_num = 0;									}
+		uint8_t		step(uint32_t t, bool up);
+		void		buttonEvent(uint8_t event, uint32_t t);
 		int16_t				min_pos	= 0;					// Minimum value of rotary encoder
 		int16_t				max_pos	= 0;					// Maximum value of roraty encoder
 		uint16_t			over_press = 0;					// Maximum time in ms the button can be pressed
@@ -39,13 +56,35 @@ class RENC {
 		uint8_t            	increment = 0;              	// The value to add or substract for each encoder tick
 		uint8_t             fast_increment = 0;         	// The value to change encoder when it runs quickly
 		volatile uint32_t 	rpt		= 0;                	// Time in ms when the encoder was rotated
-		volatile uint32_t 	changed	= 0;                	// Time in ms when the value was changed
-		volatile int16_t  	pos		= 0;                	// Encoder current position
+		int16_t  			pos		= 0;                	// Encoder current position
+		static const uint8_t queue_size	= 64;				// Detent event queue size, power of 2
+		volatile uint32_t	queue[queue_size];				// Detent events: time in ms << 1 | direction (1 - up)
+		volatile uint8_t	q_head	= 0;					// Written by the interrupt handler only
+		volatile uint8_t	q_tail	= 0;					// Written by read() only
+		volatile uint32_t	lost	= 0;					// The number of detents lost because the queue was full
+		static const uint8_t win_size	= 4;				// Sliding window to calculate the rotation velocity, detents
+		uint32_t			win[win_size];					// Time of the latest detents in the same direction
+		uint8_t				win_num	= 0;					// The number of detents in the window
+		bool				win_up	= false;				// The rotation direction in the window
+		uint8_t				v_slow	= 8;					// Velocity (detents per second) to start acceleration
+		uint8_t				v_fast	= 40;					// Velocity to reach fast_increment
 		volatile bool       s_up	= false;				// The status of the secondary channel
 		bool				i_b_rel	= false;				// Ignore button release event
-		bool				b_on	= false;				// The button current position: true - pressed
+		bool				b_on	= false;				// The button debounced position: true - pressed
 		uint32_t 			bpt		= 0;                	// Time in ms when the button was pressed (press time)
-		uint32_t			b_check	= 0;					// Time in ms when the button should be checked
+		volatile bool		b_pend	= false;				// The button edge is waiting for debounce
+		volatile uint32_t	b_first	= 0;					// Time in ms of the first edge in the bounce sequence
+		volatile uint32_t	b_edge	= 0;					// Time in ms of the last edge in the bounce sequence
+		uint32_t			b_short	= 0;					// Release time of the short press waiting for the second one, or 0
+		static const uint8_t b_queue_size = 8;				// Button event queue size, power of 2
+		volatile uint8_t	b_ev[b_queue_size];				// Button events: 1 - short, 2 - long, 3 - double press
+		volatile uint32_t	b_ev_time[b_queue_size];		// Time in ms of the event edge
+		volatile uint8_t	b_head	= 0;					// Written by buttonTick() only
+		volatile uint8_t	b_tail	= 0;					// Written by the main loop only
+		uint32_t			b_time	= 0;					// Time of the latest event returned by buttonStatus()
+		volatile bool		b_flush	= false;				// Ignore the press in progress, set by reset(), cleared by buttonTick()
+		uint16_t 			long_press		= 1500;			// If the button was pressed more that this timeout, we assume the long button press
+		uint16_t			double_press	= 0;			// Maximum pause between two short presses of double press, 0 - disabled
 		GPIO_TypeDef* 		b_port	= 0;					// The PORT of the press button
 		GPIO_TypeDef*     	m_port	= 0;					// The PORT of the main channel
 		GPIO_TypeDef*		s_port	= 0;          			// The PORT of the secondary channel
@@ -54,12 +93,8 @@ class RENC {
 		uint16_t			s_pin	= 0;	    			// The PIN number of the secondary channel
 		uint32_t			enc_int	= 0;					// The number of encoder interrupts received
 		bool				clockwise		= true;			// How exactly the encoder soldered
-        const uint8_t     	trigger_on		= 100;			// avg limit to change button status to on
-        const uint8_t     	trigger_off 	= 50;			// avg limit to change button status to off
-        const uint8_t     	avg_length   	= 4;			// avg length
-        const uint8_t		b_check_period	= 20;			// The button check period, ms
-		const uint16_t 		long_press		= 1500;			// If the button was pressed more that this timeout, we assume the long button press
-		const uint16_t		fast_timeout	= 300;			// Time in ms to change encoder quickly
+		const uint8_t		b_debounce		= 10;			// The button should be stable this time after the last edge, ms
+		const uint16_t		win_timeout		= 200;			// The pause in rotation to restart the velocity window, ms
 		const uint16_t		def_over_press	= 2500;			// Default value for button over press timeout (ms)
 };
 
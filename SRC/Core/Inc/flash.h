@@ -1,6 +1,8 @@
 /*
  * flash.h
  *
+ * 2026 OCT 18
+ *     The configuration and tip records are checked by CRC32. The files of previous format are converted when loaded
  */
 
 #ifndef _FLASH_H_
@@ -15,6 +17,7 @@ typedef enum active_file  	{W25Q_NOT_MOUNTED = 0, W25Q_NONE, W25Q_TIPS_CURRENT,
 
 class W25Q {
 	public:
+		static const uint8_t tip_chunk_sz = 16;					// Number of tip records read at once (320 bytes)
 		W25Q(void)			{ }
 		FLASH_STATUS	init(void);								// Initialize flash, read tip configuration
 		bool			reset();								// Initialize flash, re-check flash size
@@ -24,15 +27,19 @@ class W25Q {
 		bool			loadRecord(RECORD* config_record);
 		bool			saveRecord(RECORD* config_record);
 		TIP_IO_STATUS	loadTipData(TIP* tip, uint8_t tip_index, bool keep = false);
-		int16_t 		saveTipData(TIP* tip, bool keep = false); // Return tip index in the file or -1 if error
+		TIP_IO_STATUS	loadTipChunk(TIP tip[], uint8_t *n, bool keep = false); // Read next *n tip records
+		int16_t 		saveTipData(TIP* tip, uint8_t chunk, bool keep = false); // Return tip index in the file or -1 if error
 		bool			formatFlashDrive(void);
 		bool			clearTips(void);
 		bool			clearConfig(void);
 		bool			canDelete(const TCHAR *file_name);
 	private:
 		TIP_IO_STATUS	returnStatus(bool keep, TIP_IO_STATUS ret_code);
-		uint8_t 		TIP_checkSum(TIP* tip, bool write);
-		uint8_t			CFG_checkSum(RECORD* cfg, bool write);
+		bool	 		TIP_checkSum(TIP* tip, bool write);
+		bool			CFG_checkSum(RECORD* cfg, bool write);
+		bool			readRecord(const TCHAR *fn, RECORD *cfg, bool *converted);
+		bool			migrateTips(void);
+		void			tipVotes(FIL *f, uint16_t *tips, uint16_t *tips_v0);	// Count the correct records of both formats
 		bool			backup(ACT_FILE type);
 		FIL				cfg_f;
 		ACT_FILE		act_f = W25Q_NOT_MOUNTED;				// Open file
@@ -41,6 +48,7 @@ class W25Q {
 		const TCHAR*	fn_tip_backup	= "tipcal.bak";
 		const TCHAR*	fn_cfg			= "config.dat";
 		const TCHAR*	fn_cfg_backup	= "config.bak";
+		const TCHAR*	fn_tip_tmp		= "tipcal.tmp";		// Temporary file to convert the tip calibration file
 };
 
 #endif
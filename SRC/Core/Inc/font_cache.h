@@ -0,0 +1,63 @@
+/*
+ * font_cache.h
+ *
+ *  Created on: 18 oct 2026
+ *
+ * The u8g2 font that is not loaded into the memory, but is read from the W25Qxx flash glyph by glyph.
+ * When the font is opened, the glyph index is built and the font header is loaded into the memory.
+ * The glyphs, actually drawn, are kept in the fixed-size LRU cache.
+ * The font file is read directly from the flash sectors, so the file system can be unmounted while the font is in use.
+ * The font can be a part of the file, i.e. the font data of the binary language pack.
+ */
+
+#ifndef FONT_CACHE_H_
+#define FONT_CACHE_H_
+
+#include <stdint.h>
+#include "ff.h"
+
+class FONT_CACHE {
+	public:
+		FONT_CACHE(void)									{ }
+		bool			open(FIL *file, uint32_t offset = 0, uint32_t size = 0); // Build the glyph index of the font at offset in the opened file. Closes the file
+		void			close(void);
+		bool			isOpen(void)						{ return header_data != 0;	}
+		uint8_t*		font(void)							{ return header_data;		}	// Font pointer to be used by the display
+		const uint8_t*	glyph(uint16_t encoding);			// Returns the glyph data or 0 if not found
+		uint32_t		hits(void)							{ return cache_hits;		}
+		uint32_t		misses(void)						{ return cache_misses;		}
+		uint32_t		readTime(void)						{ return read_ms;			}	// Total time of glyph read, ms
+	private:
+		static const uint8_t	font_cache_slots	= 24;		// Number of cached glyphs
+		static const uint16_t	font_sector_size	= 4096;		// W25Qxx sector size
+		static const uint8_t	font_header_size	= 23;		// U8G2_FONT_DATA_STRUCT_SIZE
+		typedef struct s_glyph_index {
+			uint16_t	encoding;
+			uint8_t		size;								// The glyph data size
+			uint32_t	offset;								// The glyph data offset in the font file
+		} t_glyph_index;
+		typedef struct s_cache_slot {
+			uint16_t	encoding;							// 0xFFFF if the slot is empty
+			uint32_t	used;								// The LRU counter value of the last access
+		} t_cache_slot;
+		bool			readAt(uint32_t offset, uint8_t *buff, uint16_t size);
+		bool			buildIndex(void);
+		bool			addGlyph(uint16_t encoding, uint32_t offset, uint8_t size);
+		uint8_t			*header_data	= 0;				// Font header, 23 bytes
+		uint32_t		*sector			= 0;				// The flash sectors (LBA) of the font file
+		uint16_t		sectors			= 0;
+		uint16_t		font_start		= 0;				// The font offset in the first sector
+		uint32_t		font_size		= 0;
+		t_glyph_index	*index			= 0;				// Glyph index sorted by encoding
+		uint16_t		glyphs			= 0;
+		uint16_t		index_size		= 0;
+		t_cache_slot	slot[font_cache_slots];
+		uint8_t			*cache_data		= 0;				// The glyph data of the cache slots
+		uint8_t			slot_size		= 0;				// Maximum glyph size in the font
+		uint32_t		lru_counter		= 0;
+		uint32_t		cache_hits		= 0;
+		uint32_t		cache_misses	= 0;
+		uint32_t		read_ms			= 0;
+};
+
+#endif
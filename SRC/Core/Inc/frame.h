@@ -0,0 +1,41 @@
+/*
+ * frame.h
+ *
+ *  Created on: 2026 OCT 18
+ *      Author: Alex
+ *
+ *  Binary packet framing of the serial port. The packet is: type, sequence number, payload, CRC32 of the previous bytes.
+ *  The packet is encoded by COBS (Consistent Overhead Byte Stuffing), so it has no zero bytes,
+ *  and is terminated by zero byte. The code does not use the hardware.
+ */
+
+#ifndef FRAME_H_
+#define FRAME_H_
+
+#include <stdint.h>
+
+#define FRAME_MAX_PAYLOAD	(64)
+#define FRAME_OVERHEAD		(6)									// type, sequence number and CRC32
+#define FRAME_MAX_SIZE		(FRAME_MAX_PAYLOAD + FRAME_OVERHEAD + 2 + 1)	// COBS overhead and zero delimiter
+
+typedef enum {
+	FRAME_TELEMETRY	= 1,										// Payload is t_tstream_pkt, see tstream.h
+	FRAME_COMMAND,												// Payload is t_rc_request, see remote.h
+	FRAME_REPLY,												// Payload is t_rc_reply
+	FRAME_EVENT													// Payload is t_rc_state
+} t_frame_type;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+uint16_t	COBS_Encode(const uint8_t *src, uint16_t len, uint8_t *dst);	// Returns the encoded length
+uint16_t	COBS_Decode(const uint8_t *src, uint16_t len, uint8_t *dst);	// Returns the decoded length or 0 if error
+uint16_t	FRAME_Pack(uint8_t type, uint8_t seq, const void *payload, uint16_t len, uint8_t *out);
+int16_t		FRAME_Unpack(const uint8_t *frame, uint16_t len, uint8_t *type, uint8_t *seq, uint8_t *payload);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -5,6 +5,8 @@
  * 	  Added fast_cooling parameter to HOTGUN
  * 	  Added HOTGUN::setFastGunCooling()
  * 	  Changed the HOTGUN::sw_avg_len from 10 to 13
+ * 2026 OCT 18
+ * 	  Added HOTGUN::powerMode()
  */
 
 #ifndef GUN_H_
@@ -20,6 +22,7 @@ class HOTGUN : public UNIT {
         HOTGUN(void) : h_power(hot_gun_hist_length), h_temp(hot_gun_hist_length) { }
         void        		init(void);
 		bool				isOn(void)						{ return (mode == POWER_ON || mode == POWER_FIXED); }
+		PowerMode			powerMode(void)					{ return mode;									}
 		virtual uint16_t	presetTemp(void)				{ return temp_set; 								}
 		uint16_t			presetFan(void)					{ return fan_speed;								}
 		virtual uint16_t 	averageTemp(void)				{ return avg_sync_temp; 						}
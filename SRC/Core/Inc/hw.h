@@ -6,6 +6,11 @@
  *
  *  2023 JAN 01
  *      Added arguments into HW::init() method to initialize the hardware at startup
+ *  2026 OCT 18
+ *  	Added the main loop scheduler, HW::sched
+ *  	Added the control loop telemetry, HW::tlog
+ *  	Added the serial port and live telemetry stream, HW::serial and HW::tstream, in SERIAL_PORT build only
+ *  	Added the remote control protocol, HW::remote, in SERIAL_PORT build only
  */
 
 #ifndef HW_H_
@@ -24,6 +29,11 @@
 #include "buzzer.h"
 #include "nls.h"
 #include "nls_cfg.h"
+#include "scheduler.h"
+#include "tlog.h"
+#include "serial.h"
+#include "tstream.h"
+#include "remote.h"
 
 class HW {
 	public:
@@ -42,6 +52,13 @@ class HW {
 		RENC		i_enc, g_enc;
 		HOTGUN		hotgun;
 		BUZZER		buzz;
+		SCHED		sched;
+		TLOG		tlog;
+#ifdef SERIAL_PORT
+		SERIAL		serial;
+		TSTREAM		tstream;
+		REMOTE		remote;
+#endif
 	private:
 		EMP_AVERAGE 	t_amb;								// Exponential average of the ambient temperature
 		const uint8_t	ambient_emp_coeff	= 30;			// Exponential average coefficient for ambient temperature
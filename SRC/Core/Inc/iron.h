@@ -7,7 +7,9 @@
  * 	   Added b_reset bool variable flag to initialize the IRON temperature EMP_AVERAGE values
  * 2023 JAN 01
  *     Added argument into IRON::init() method
- *
+ * 2026 OCT 18
+ *     Added IRON::powerMode()
+ *     Added MWINDOW, the adaptive quiet window of the IRON temperature measurement, see mwindow.h. The IRON power is limited by the window
  */
 
 #ifndef IRON_H_
@@ -15,6 +17,7 @@
 
 #include "stat.h"
 #include "unit.h"
+#include "mwindow.h"
 
 class IRON : public UNIT {
 	public:
@@ -24,6 +27,7 @@ class IRON : public UNIT {
 		virtual void		switchPower(bool On);
 		virtual void		autoTunePID(uint16_t base_pwr, uint16_t delta_power, uint16_t base_temp, uint16_t temp);
 		bool				isOn(void)						{ return (mode == POWER_ON); }
+		PowerMode			powerMode(void)					{ return mode; }
 		uint16_t 			temp(void)						{ return temp_curr; }
 		virtual uint16_t	presetTemp(void)				{ return temp_set; }
 		virtual uint16_t	averageTemp(void)				{ return h_temp.read(); }
@@ -43,7 +47,11 @@ class IRON : public UNIT {
 		void				reset(void);					// Iron is disconnected, clear the temp history
 		void        		lowPowerMode(uint16_t t);		// Activate low power mode (preset temp.) To disable, use switchPower(true)
 		void				boostPowerMode(uint16_t t);		// Activate boost power mode
+		uint16_t			tempPoint(uint16_t arr)			{ return mwin.tempPoint(arr);					}
+		uint16_t			measure(const uint16_t s[], uint8_t n, uint16_t applied, uint16_t cnt)	{ return mwin.measure(s, n, applied, cnt);	}
+		uint16_t			window(void)					{ return mwin.window();							}
 	private:
+		MWINDOW		mwin;									// The quiet window of the temperature measurement
 		uint16_t 	temp_set				= 0;			// The temperature that should be kept
 		uint16_t	temp_low				= 0;			// The temperature in low power mode (if not zero)
 		uint16_t	temp_boost				= 0;			// The temperature in boost mode (if not zero)
@@ -59,7 +67,7 @@ class IRON : public UNIT {
 		EMP_AVERAGE d_power;								// Exponential average of power math dispersion
 		EMP_AVERAGE d_temp;									// Exponential temperature math dispersion
 		bool		t_reset					= false;		// The temperature value was reset
-		const uint16_t	max_power      		= 1960;			// Maximum power to the IRON
+		const uint16_t	heat_up_gap			= 200;			// The IRON is heating up if the temperature is lower than preset one by this value
 		const uint16_t	max_fix_power  		= 1000;			// Maximum power in fixed power mode
 		const uint8_t	ec	   				= 20;			// Exponential average coefficient
 		const uint16_t	iron_cold			= 100;			// The internal temperature when the IRON is cold
@@ -3,6 +3,8 @@
  *
  *  Created on: 15 aug. 2019.
  *      Author: Alex
+ *  2026 OCT 18
+ *  	Added TIPS::sortNames() to build sorted index of tip names
  */
 
 #ifndef IRON_TIPS_H_
@@ -17,7 +19,9 @@ class TIPS {
 		TIPS()													{ }
 		uint16_t		loaded(void);
 		const char* 	name(uint8_t index);
-		int 			index(const char *name);
+		int 			index(const char *name);				// Binary search of the tip name
+	private:
+		void			sortNames(void);
 };
 
 
@@ -1,23 +1,45 @@
 /*
  * jsoncfg.h
  *
+ * 2026 OCT 18
+ *     Added read_blk_size, the file is read by blocks
+ *     The parser listeners use zero-allocation callbacks. Added JSON_KEY_STACK class instead of std::stack<std::string>
+ *     Added optional binary language pack file name into the language configuration
+ *     FILE_PARSER::readFile() calculates CRC32 of the file. Added optional CRC32 of the messages and font files to the language configuration
  */
 
 #ifndef JSONCFG_H_
 #define JSONCFG_H_
 
 #include <vector>
-#include <stack>
 #include "JsonParser.h"
 #include "ff.h"
 #include "nls.h"
 
+//--------------------------------------------------- Stack of JSON keys -------------------------------------
+// All keys are packed into the single fixed buffer one by one
+// The levels that do not fit the buffer are counted only, so pop() of such level keeps the parent key
+class JSON_KEY_STACK {
+	public:
+		JSON_KEY_STACK(void)								{ }
+		void			clear(void)							{ depth = lost = 0; 			}
+		bool			empty(void)							{ return depth == 0 && lost == 0;	}
+		bool			push(const char *key);
+		void			pop(void);
+		const char*		top(void);
+	private:
+		char			k_buff[128];						// Keys buffer
+		uint8_t			k_pos[8];							// Start position of each key in the buffer
+		uint8_t			depth	= 0;
+		uint16_t		lost	= 0;						// Number of overflowed levels above the top key
+};
+
 //--------------------------------------------------- Configuration file parser -------------------------------
 class FILE_PARSER: public JsonListener {
 	public:
-    	FILE_PARSER() : JsonListener()              		{ }
+    	FILE_PARSER() : JsonListener()              		{ d_key[0] = '\0'; }
     	virtual			~FILE_PARSER(void)					{ }
-    	virtual void 	key(std::string key)                { d_key = key; }
+    	virtual void 	key(const char *key, uint16_t len);
     	virtual void	endObject();
     	virtual void	startObject();
     	virtual void	startArray();
@@ -25,11 +47,14 @@ class FILE_PARSER: public JsonListener {
     	virtual void	startDocument();
     	virtual void	endDocument()						{ }
     	virtual void	whitespace(char c)					{ }
+    	uint32_t		fileCRC(void)						{ return file_crc;	}	// CRC32 of the last read file
 	protected:
     	void			readFile(FIL *file);
-    	std::string				d_key;
-    	std::stack<std::string>	s_array;
-    	std::stack<std::string> s_key;						// Json structure stack
+    	uint32_t				file_crc		= 0;
+    	char					d_key[JSON_BUFFER_MAX_LENGTH];
+    	JSON_KEY_STACK			s_array;
+    	JSON_KEY_STACK			s_key;						// Json structure stack
+    	const uint16_t			read_blk_size	= 512;		// The file read buffer size
 //    	std::string				d_parent;
 //    	std::string				d_array;
 //    	std::stack<std::string> p_key;						// Json structure stack
@@ -40,6 +65,11 @@ typedef struct s_lang_cfg {
 	std::string		lang;
 	std::string		messages_file;
 	std::string		font_file;
+	std::string		pack_file;								// Precompiled binary language pack (optional)
+	uint32_t		messages_crc;							// CRC32 of the messages file (optional)
+	uint32_t		font_crc;								// CRC32 of the font file (optional)
+	bool			check_messages;							// The messages_crc is specified
+	bool			check_font;								// The font_crc is specified
 } t_lang_cfg;
 
 typedef std::vector<t_lang_cfg> t_lang_list;
@@ -47,13 +77,16 @@ typedef std::vector<t_lang_cfg> t_lang_list;
 class JSON_LANG_CFG : public FILE_PARSER {
 	public:
 		JSON_LANG_CFG()                                		{ }
+    	virtual void		startDocument();
     	virtual void		endDocument();
-		virtual void 		value(std::string value);
+		virtual void 		value(const char *value, uint16_t len);
 		void				readConfig(FIL *file);
 		void				addEnglish();					// Add default (English) language entry to the list
 		uint8_t				listSize(void)					{ return lang_list.size();	}
 		t_lang_list			*getLangList(void)				{ return &lang_list; 		}
 	private:
+		bool				isComplete(void);				// The language entry has messages or pack file
+		void				clearData(void);
 		t_lang_cfg			data;
 		t_lang_list 		lang_list;						// Use vector to save language list config
 };
@@ -64,7 +97,7 @@ class JSON_MESSAGES : public FILE_PARSER {
 		JSON_MESSAGES()                                		{ }
 		void				readConfig(FIL *file)			{ readFile(file);		}
 		void				setNLS_MSG(NLS_MSG *pMsg)		{ this->pMsg = pMsg;	}
-		virtual void 		value(std::string value);
+		virtual void 		value(const char *value, uint16_t len);
 	private:
 		NLS_MSG				*pMsg		= 0;
 };
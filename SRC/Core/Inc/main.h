@@ -56,7 +56,7 @@ void HAL_TIM_MspPostInit(TIM_HandleTypeDef *htim);
 void Error_Handler(void);
 
 /* USER CODE BEGIN EFP */
-
+void MX_USART1_UART_Init(void);					// Called by SERIAL::init() in SERIAL_PORT build only
 /* USER CODE END EFP */
 
 /* Private defines -----------------------------------------------------------*/
@@ -64,6 +64,7 @@ void Error_Handler(void);
 #define AC_RELAY_GPIO_Port GPIOC
 #define G_ENC_B_Pin GPIO_PIN_14
 #define G_ENC_B_GPIO_Port GPIOC
+#define G_ENC_B_EXTI_IRQn EXTI15_10_IRQn
 #define G_ENC_R_Pin GPIO_PIN_15
 #define G_ENC_R_GPIO_Port GPIOC
 #define IRON_POWER_Pin GPIO_PIN_0
@@ -102,6 +103,7 @@ void Error_Handler(void);
 #define I_ENC_R_GPIO_Port GPIOA
 #define I_ENC_B_Pin GPIO_PIN_9
 #define I_ENC_B_GPIO_Port GPIOA
+#define I_ENC_B_EXTI_IRQn EXTI9_5_IRQn
 #define REED_SW_Pin GPIO_PIN_10
 #define REED_SW_GPIO_Port GPIOA
 #define GUN_POWER_Pin GPIO_PIN_11
@@ -125,6 +127,7 @@ void Error_Handler(void);
 
 /* USER CODE BEGIN Private defines */
 #define FW_VERSION	("1.15")
+//#define SERIAL_PORT								// Service build: USART1 on the TILT (TX) and REED (RX) switch inputs, the switches are disabled, see serial.h
 /* USER CODE END Private defines */
 
 #ifdef __cplusplus
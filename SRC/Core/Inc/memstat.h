@@ -0,0 +1,62 @@
+/*
+ * memstat.h
+ *
+ *  Created on: 2026 OCT 18
+ *      Author: Alex
+ *
+ *  Heap and stack usage telemetry.
+ *  The heap top and peak are tracked by _sbrk() in syscalls.c, live allocations are counted by malloc() wrappers.
+ *  The free RAM between the heap top and the stack is painted at startup, the stack high-water mark
+ *  is the lowest painted word changed since. The interrupt handlers count the nesting depth.
+ *  The largest allocatable block is the biggest chunk in the newlib-nano free list or the unclaimed space
+ *  above the heap top, whichever is bigger.
+ */
+
+#ifndef MEMSTAT_H_
+#define MEMSTAT_H_
+
+#include <stdint.h>
+
+typedef struct s_mem_stat {
+	uint32_t	heap_used;										// Bytes allocated by malloc() now
+	uint32_t	heap_peak;										// The maximum heap size claimed by _sbrk()
+	uint32_t	heap_free;										// Free bytes inside the heap, can be fragmented
+	uint32_t	largest_free;									// The largest block malloc() can return without sbrk() failure
+	uint32_t	allocs;											// The number of live allocations
+	uint32_t	sbrk_fails;										// The number of refused _sbrk() requests
+	uint32_t	stack_peak;										// Stack high-water mark, bytes
+	uint32_t	stack_free;										// Untouched bytes between the heap top and the stack high-water mark
+	uint8_t		irq_depth;										// The maximum interrupt nesting depth
+} t_mem_stat;
+
+typedef struct s_mem_chunk t_mem_chunk;
+struct s_mem_chunk {											// The free chunk header of newlib-nano malloc(), see nano-mallocr.c
+	long		size;											// The chunk size including the header
+	t_mem_chunk	*next;											// The next free chunk, the list is sorted by address
+};
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+extern volatile uint8_t	mem_irq_depth;
+extern volatile uint8_t	mem_irq_peak;
+
+static inline void MEM_IrqEnter(void) {
+	if (++mem_irq_depth > mem_irq_peak)
+		mem_irq_peak = mem_irq_depth;
+}
+
+static inline void MEM_IrqLeave(void) {
+	--mem_irq_depth;
+}
+
+void		MEM_PaintStack(void);
+void		MEM_Stat(t_mem_stat *st);
+uint32_t	MEM_LargestFree(const t_mem_chunk *free_list, uint32_t unclaimed);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -12,6 +12,14 @@
  *  2024 OCT 09
  *  	Moved flash debug into ABOUT mode. Changed MABOUT and MDEBUG constructors
  *  	Added MENCODER class to debug rotary encoders
+ *  2026 OCT 18
+ *  	FDEBUG reads the visible page of the directory only and counts the directory entries in background
+ *  	Added storage benchmark to FDEBUG, started by short press of IRON encoder button
+ *  	Added MWORK::remote() to apply remote control commands in the main working mode
+ *  	FDEBUG shows the SD-CARD copy progress, FDEBUG::copyProgress()
+ *  	Added MODE::events() to pass the scheduler events to the active mode
+ *  	Added MWORK::idle_sample to average the idle power by its own period, not by the screen redraw
+ *  	FDEBUG saves the telemetry session files to the SD-CARD by double press of IRON encoder button
  *
  */
 
@@ -19,6 +27,8 @@
 #include <string>
 #include "hw.h"
 #include "sdload.h"
+#include "bench.h"
+#include "remote.h"
 
 #ifndef _MODE_H_
 #define _MODE_H_
@@ -29,6 +39,7 @@ class MODE {
 		void			setup(MODE* return_mode, MODE* short_mode, MODE* long_mode);
 		virtual void	init(void)							{ }
 		virtual MODE*	loop(void)							{ return 0; }
+		virtual void	events(uint32_t ev)					{ }		// The events raised by interrupt handlers, see t_event
 		virtual			~MODE(void)							{ }
 		void			useDevice(tDevice dev)				{ dev_type 	= dev; 	}
 		MODE*			returnToMain(void);
@@ -59,9 +70,13 @@ class MWORK : public MODE {
 		MWORK(HW *pCore) : MODE(pCore), idle_pwr(5)		{ }
 		virtual void	init(void);
 		virtual MODE*	loop(void);
+		virtual void	events(uint32_t ev);
+		uint8_t			remote(const t_rc_request &req);	// Apply the remote control command. Returns t_rc_status
 	private:
 		void 			adjustPresetTemp(void);
 		bool			hwTimeout(bool tilt_active);
+		void			ironStandby(int16_t ambient);		// Switch the IRON to the low power mode
+		void			ironResume(void);					// Return the IRON from the low power or boost mode
 		void 			swTimeout(uint16_t temp, uint16_t temp_set, uint16_t temp_setH, uint32_t td, uint32_t pd, uint16_t ap);
 		void			changeIronShort(void);				// The IRON encoder button short press callback
 		void			changeIronLong(void);				// The IRON encoder button long  press callback
@@ -69,6 +84,7 @@ class MWORK : public MODE {
 		void			ironPhaseEnd(void);					// Proceed end of phase
 		bool			idleMode(void);						// Check the iron is used. Return tilt is active
 		EMP_AVERAGE  	idle_pwr;							// Exponential average value for idle power
+		uint32_t		idle_sample		= 0;				// Time when to sample the idle power (ms), see swTimeout()
 		uint32_t		phase_end		= 0;				// Time when to change phase (ms)
 		uint32_t		lowpower_time	= 0;				// Time when switch to standby power mode
 		uint32_t		swoff_time		= 0;				// Time when to switch the IRON off by sotfware method (see swTimeout())
@@ -339,26 +355,51 @@ class MDEBUG : public MODE {
 		const uint16_t	min_fan_speed	= 600;
 		const uint16_t	max_fan_power 	= 1999;
 		const uint8_t	gun_power		= 5;
+		bool			show_memory		= false;			// Show heap and stack usage instead of sensor data
 };
 
 //---------------------- The Flash debug mode: display flash status & content ---
-class FDEBUG : public MODE {
+class FDEBUG : public MODE, public SDLOAD_PROGRESS {
 	public:
 		FDEBUG(HW *pCore, MFAIL *pFail) : MODE(pCore)		{ this->pFail = pFail; }
 		virtual void	init(void);
 		virtual MODE*	loop(void);
+		virtual void	copyProgress(const char *name, uint8_t percent);
 		void			readDirectory();
 	private:
+		typedef struct s_dir_entry {
+			char		name[24];							// The entry name, truncated to fit the screen
+		} t_dir_entry;
+		void			closeDirectory(void);
+		void			countEntries(void);
+		bool			readEntry(uint16_t index, FILINFO *fi);
+		const char*		entryName(uint16_t index);
+		void			showDirectory(void);
+		void			benchmark(void);
+		void			saveLogs(void);
+		MODE*			leave(MODE *next);
+		void			showBenchResult(const char *name, t_bench_result res[], uint8_t n, uint8_t lat, uint16_t y);
 		SDLOAD		lang_loader;							// To load language data from sd-card to flash
 		FLASH_STATUS	status	=	FLASH_OK;
 		uint16_t		old_ge 			= 0;				// Old Gun encoder value
 		std::string		c_dir			= "/";				// Current directory path
-		std::vector<std::string>	dir_list;				// Directory list
-		int8_t			delete_index	= -1;				// File to be deleted index
+		DIR				dir;								// The directory to read the page entries
+		DIR				count_dir;							// The directory to count entries in background
+		bool			dir_open		= false;
+		bool			counting		= false;			// The directory entries are being counted
+		uint16_t		dir_pos			= 0;				// The index of the next entry to be read from dir
+		uint16_t		dir_size		= 0;				// Number of entries counted so far
+		t_dir_entry		page[8];							// The page cache of directory entries
+		uint16_t		page_first		= 0;				// The index of the first cached entry
+		uint8_t			page_num		= 0;				// Number of cached entries
+		int16_t			delete_index	= -1;				// File to be deleted index
+		bool			result_shown	= false;			// The benchmark or the log saving results are on the screen
 		bool			confirm_format	= false;			// Confirmation dialog activates
 		t_msg_id		msg				= MSG_LAST;			// Error message index
 		MFAIL			*pFail;
 		const uint32_t	update_timeout	= 60000;			// Default update display timeout, ms
+		const uint8_t	count_step		= 16;				// Number of entries counted per loop() call
+		const uint16_t	double_press	= 400;				// The IRON button double press time to save the session logs, ms
 
 };
 
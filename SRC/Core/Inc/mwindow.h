@@ -0,0 +1,67 @@
+/*
+ * mwindow.h
+ *
+ *  Created on: 2026 OCT 18
+ *      Author: Alex
+ *
+ *  The quiet window of the IRON temperature measurement. The thermocouple amplifier is saturated while the heater is powered,
+ *  so the temperature is read by TIM2 channel 4 some time after the heater is switched off, near the end of TIM2 period.
+ *  The ADC reads the IRON temperature several times in a row. When the heater was powered till the window start,
+ *  the drift of these samples shows whether the amplifier has settled: the window grows if the drift is big and shrinks slowly if small.
+ *  When the heater was off long enough, the scatter of the samples is the noise, the window grows if the noise is high.
+ *  The IRON power is always limited by the window. When the samples are taken too early anyway (the TIM2 period was shortened
+ *  to follow the AC phase) or the ADC has not finished before the period end, the last settled temperature is used.
+ *  The ADC time margin grows every time the ADC is late. The code does not use the hardware.
+ */
+
+#ifndef MWINDOW_H_
+#define MWINDOW_H_
+
+#include <stdint.h>
+#include "stat.h"
+
+// The ADC sequence started by TIM2 channel 4, see MX_ADC1_Init(): ADC clock is PCLK2/4 = 21 MHz,
+// 5 channels of 15, 15, 84, 84 and 56 sampling cycles plus 12 conversion cycles each, ADC_LOOPS loops
+#define MW_ADC_CLOCK		(21000000)
+#define MW_ADC_LOOP_CYCLES	(15 + 15 + 84 + 84 + 56 + 5*12)
+#define MW_ADC_LOOPS		(4)
+#define MW_ADC_TICKS		(10)								// The initial ADC time margin, TIM2 ticks (10 mks)
+#define MW_ADC_LATENCY		(2)									// Interrupt latency and HAL overhead, TIM2 ticks
+
+static_assert((MW_ADC_LOOPS * MW_ADC_LOOP_CYCLES * 100000ULL + MW_ADC_CLOCK - 1) / MW_ADC_CLOCK + MW_ADC_LATENCY <= MW_ADC_TICKS,
+		"The ADC sequence should finish before TIM2 period ends");
+
+class MWINDOW {
+	public:
+		MWINDOW(void)										{ }
+		void		init(void);
+		uint16_t	tempPoint(uint16_t arr);				// Returns TIM2 channel 4 compare value for the TIM2 period (ARR)
+		uint16_t	maxPower(void)							{ return t_point - win;			}	// The maximum IRON PWM value
+		uint16_t	measure(const uint16_t s[], uint8_t n, uint16_t applied, uint16_t cnt);	// Check the samples, returns the temperature
+		uint16_t	window(void)							{ return win;					}
+		uint8_t		adcTicks(void)							{ return adc_ticks;				}
+		uint32_t	late(void)								{ return adc_late;				}
+	private:
+		uint16_t	hold(uint16_t t);
+		EMP_AVERAGE	drift;									// The samples drift when the heater was powered till the window start
+		EMP_AVERAGE	noise;									// The samples scatter when the amplifier has settled
+		volatile uint16_t	t_point		= 1989;				// TIM2 channel 4 compare value
+		volatile uint16_t	win			= 20;				// The quiet window, TIM2 ticks (10 mks)
+		volatile uint8_t	adc_ticks	= MW_ADC_TICKS;		// The time to read all the ADC channels with the margin, TIM2 ticks
+		uint32_t	adc_late		= 0;					// The number of the ADC sequences finished after TIM2 period end
+		uint16_t	t_last			= 0;					// The latest temperature read when the amplifier has settled
+		bool		t_valid			= false;				// t_last has been read
+		uint8_t		holds			= 0;					// The number of the readings replaced by t_last in a row
+		uint8_t		checks			= 0;					// The number of drift checks since the window was changed
+		const uint8_t	max_adc_ticks	= 30;
+		const uint8_t	max_holds	= 4;					// Do not keep the old temperature longer, use the samples
+		const uint16_t	min_win		= 4;
+		const uint16_t	max_win		= 60;
+		const uint8_t	win_checks	= 25;					// Adapt the window every 25 drift checks (0.5 s at full power)
+		const uint8_t	drift_high	= 4;					// The drift above the noise, ADC counts (about half of Celsius degree)
+		const uint8_t	drift_low	= 2;
+		const uint8_t	noise_high	= 24;
+		const uint8_t	emp_len		= 8;
+};
+
+#endif
@@ -7,6 +7,14 @@
  * 		Added "fast gun chill" setup menu item
  * 		Added "display type" setup menu item
  * 		Added "IPS" and "TFT" messages
+ * 	2026 OCT 18
+ * 		NLS_MSG::set() accepts the parser buffer pointers instead of std::string
+ * 		Added hash index of the message keys, NLS_MSG::find()
+ * 		Added NLS_MSG::setMessage() and NLS_MSG::keysCRC() to load binary language pack
+ * 		The localized messages are stored in the single memory block (arena)
+ * 		static_assert checks the message number fits the key hash table
+ * 		NLS_MSG::str() returns the pointer to the message instead of the std::string copy
+ * 		Added NLS_MSG::trimArena()
  *
  */
 
@@ -30,110 +38,130 @@ typedef enum e_msg { MSG_MENU_MAIN, MSG_MENU_SETUP = 12, MSG_MENU_BOOST = 12+18,
 					MSG_MANUAL			= MSG_MENU_CALIB + 2
 } t_msg_id;
 
+#define	NLS_KEY_INDEX_SZ	128								// The message key hash table size, power of 2
+static_assert(MSG_LAST < NLS_KEY_INDEX_SZ, "The message key hash table must have at least one empty slot and 8-bit message id");
+
 typedef struct s_msg_nls {
 	const char		*msg;
-	std::string		msg_nls;
+	const char		*msg_nls;								// Pointer to the localized message inside arena or null
 } t_msg;
 
 class NLS_MSG {
 	public:
-		NLS_MSG()											{ }
+		NLS_MSG()											{ buildIndex(); }
 		void			activate(bool use_nls)				{ this->use_nls = use_nls; }
 		const char*		msg(t_msg_id id);
-		std::string		str(t_msg_id id);
+		const char*		str(t_msg_id id)					{ return msg(id);		}	// The message inside the arena, no copy
 		uint8_t			menuSize(t_msg_id id);
-		bool			set(std::string& parameter, std::string& value, std::string& parent);
+		bool			set(const char *parameter, const char *value, uint16_t len, const char *parent);
+		int16_t			find(const char *parameter, const char *parent); // Message id by the key or -1 if not found
+		bool			setMessage(uint8_t id, const char *value, uint16_t len);
+		bool			setMessage(uint8_t id, uint16_t offset); // The message is already in the arena
+		bool			allocateArena(uint16_t size);		// Allocate memory for all localized messages
+		char*			arenaData(void)						{ return arena;			}
+		void			arenaUsed(uint16_t size)			{ arena_used = size;	}
+		bool			isLoaded(void)						{ return arena_used > 0;	}	// At least one message is in the arena
+		void			trimArena(void);					// Release the unused end of the arena
+		void			freeArena(void);					// Release all localized messages
+		uint32_t		keysCRC(void);						// CRC32 of all message keys, checked when the binary language pack is loaded
 	protected:
 		bool	use_nls		= false;
 		t_msg		message[MSG_LAST] = {
 				// MAIN MENU
-				{"Main Menu",		std::string()},			// Title is the first element of each menu
-				{"parameters",		std::string()},
-				{"boost setup",		std::string()},
-				{"change tip",		std::string()},
-				{"calibrate tip",	std::string()},
-				{"activate tips",	std::string()},			// Change MSG_ACTIVATE_TIPS if new item menu inserted
-				{"tune iron",		std::string()},			// Change MSG_TUNE_IRON if new item menu inserted
-				{"gun setup",		std::string()},
-				{"reset config",	std::string()},
-				{"tune iron PID",	std::string()},
-				{"about",			std::string()},			// Change MSG_ABOUT if new item menu inserted
-				{"quit",			std::string()},
+				{"Main Menu",		0},						// Title is the first element of each menu
+				{"parameters",		0},
+				{"boost setup",		0},
+				{"change tip",		0},
+				{"calibrate tip",	0},
+				{"activate tips",	0},						// Change MSG_ACTIVATE_TIPS if new item menu inserted
+				{"tune iron",		0},						// Change MSG_TUNE_IRON if new item menu inserted
+				{"gun setup",		0},
+				{"reset config",	0},
+				{"tune iron PID",	0},
+				{"about",			0},						// Change MSG_ABOUT if new item menu inserted
+				{"quit",			0},
 				// SETUP MENU
-				{"Parameters",		std::string()},			// Title
-				{"units",			std::string()},
-				{"buzzer",			std::string()},
-				{"iron encoder",	std::string()},
-				{"gun encoder",		std::string()},
-				{"fast gun chill",	std::string()},
-				{"switch type",		std::string()},
-				{"temp. step",		std::string()},
-				{"auto start",		std::string()},
-				{"auto off",		std::string()},			// Change in-place menu item
-				{"standby temp",	std::string()},			// Change in-place menu item
-				{"standby time",	std::string()},			// Change in-place menu item
-				{"brightness",		std::string()},			// Change in-place menu item
-				{"rotation",		std::string()},			// Change in-place menu item
-				{"language",		std::string()},			// Change in-place menu item
-				{"display type",	std::string()},
-				{"save",			std::string()},
-				{"cancel",			std::string()},
+				{"Parameters",		0},						// Title
+				{"units",			0},
+				{"buzzer",			0},
+				{"iron encoder",	0},
+				{"gun encoder",		0},
+				{"fast gun chill",	0},
+				{"switch type",		0},
+				{"temp. step",		0},
+				{"auto start",		0},
+				{"auto off",		0},						// Change in-place menu item
+				{"standby temp",	0},						// Change in-place menu item
+				{"standby time",	0},						// Change in-place menu item
+				{"brightness",		0},						// Change in-place menu item
+				{"rotation",		0},						// Change in-place menu item
+				{"language",		0},						// Change in-place menu item
+				{"display type",	0},
+				{"save",			0},
+				{"cancel",			0},
 				// BOOST MENU
-				{"Boost setup",		std::string()},			// Title
-				{"temperature",		std::string()},
-				{"duration",		std::string()},
-				{"back to menu",	std::string()},
+				{"Boost setup",		0},						// Title
+				{"temperature",		0},
+				{"duration",		0},
+				{"back to menu",	0},
 				// IRON TIP CALIBRATION MENU
-				{"Calibrate",		std::string()},			// Title
-				{"automatic",		std::string()},			// Change MSG_AUTO if new item menu inserted
-				{"manual",			std::string()},			// Change MSG_MANUAL if new item menu inserted
-				{"clear",			std::string()},
-				{"quit",			std::string()},
+				{"Calibrate",		0},						// Title
+				{"automatic",		0},						// Change MSG_AUTO if new item menu inserted
+				{"manual",			0},						// Change MSG_MANUAL if new item menu inserted
+				{"clear",			0},
+				{"quit",			0},
 				// GUN MENU
-				{"Hot Air Gun",		std::string()},			// Title
-				{"calibrate",		std::string()},
-				{"tune gun",		std::string()},			// Change MSG_TUNE_GUN if new item menu inserted
-				{"tune gun PID",	std::string()},
-				{"clear",			std::string()},
-				{"exit",			std::string()},
+				{"Hot Air Gun",		0},						// Title
+				{"calibrate",		0},
+				{"tune gun",		0},						// Change MSG_TUNE_GUN if new item menu inserted
+				{"tune gun PID",	0},
+				{"clear",			0},
+				{"exit",			0},
 				// SINGLE MESSAGE STRINGS
-				{"ON",				std::string()},
-				{"OFF",				std::string()},
-				{"Fan:",			std::string()},
-				{"pwr:",			std::string()},
-				{"Ref. #",			std::string()},
-				{"REED",			std::string()},
-				{"TILT",			std::string()},
-				{"deg.",			std::string()},
-				{"min",				std::string()},
-				{"sec",				std::string()},
-				{"cw",				std::string()},
-				{"ccw",				std::string()},
-				{"Set:",			std::string()},
-				{"ERROR",			std::string()},
-				{"Tune PID",		std::string()},
-				{"Select tip",		std::string()},
-				{"FLASH read error",		std::string()},
-				{"FLASH write error",		std::string()},
-				{"No directory",			std::string()},
-				{"format FLASH?",			std::string()},
-				{"Failed to format FLASH",	std::string()},
-				{"saving configuration",	std::string()},
-				{"Hot Gun",					std::string()},
-				{"Save?",					std::string()},
-				{"Yes",						std::string()},
-				{"No",						std::string()},
-				{"Delete file?",			std::string()},
-				{"FLASH debug",				std::string()},
-				{"Failed mount SD",			std::string()},
-				{"NO config file",			std::string()},
-				{"No lang. specified",		std::string()},
-				{"No memory",				std::string()},
-				{"Inconsistent lang",		std::string()},
-				{"IPS",						std::string()},
-				{"TFT",						std::string()}
+				{"ON",				0},
+				{"OFF",				0},
+				{"Fan:",			0},
+				{"pwr:",			0},
+				{"Ref. #",			0},
+				{"REED",			0},
+				{"TILT",			0},
+				{"deg.",			0},
+				{"min",				0},
+				{"sec",				0},
+				{"cw",				0},
+				{"ccw",				0},
+				{"Set:",			0},
+				{"ERROR",			0},
+				{"Tune PID",		0},
+				{"Select tip",		0},
+				{"FLASH read error",		0},
+				{"FLASH write error",		0},
+				{"No directory",			0},
+				{"format FLASH?",			0},
+				{"Failed to format FLASH",	0},
+				{"saving configuration",	0},
+				{"Hot Gun",					0},
+				{"Save?",					0},
+				{"Yes",						0},
+				{"No",						0},
+				{"Delete file?",			0},
+				{"FLASH debug",				0},
+				{"Failed mount SD",			0},
+				{"NO config file",			0},
+				{"No lang. specified",		0},
+				{"No memory",				0},
+				{"Inconsistent lang",		0},
+				{"IPS",						0},
+				{"TFT",						0}
 		};
 		const t_msg_id menu[5] = { MSG_MENU_MAIN, MSG_MENU_SETUP, MSG_MENU_BOOST, MSG_MENU_CALIB, MSG_MENU_GUN };
+	private:
+		void			buildIndex(void);
+		uint8_t			keyHash(const char *key);
+		uint8_t			key_index[NLS_KEY_INDEX_SZ];	// Open addressing hash table of the message ids, 0xFF is empty slot
+		char			*arena		= 0;					// The localized messages memory, allocated by malloc()
+		uint16_t		arena_size	= 0;
+		uint16_t		arena_used	= 0;
 };
 
 #endif
@@ -1,6 +1,11 @@
 /*
  * nls_cfg.h
  *
+ * 2026 OCT 18
+ *     Added binary language pack support, NLS::loadPack()
+ *     The big font is not loaded into the memory, but read from the flash by FONT_CACHE
+ *     Added NLS::fontCache() to show the font cache statistics
+ *     Added NLS::langEntry() to check CRC32 of the messages and font files
  */
 
 #ifndef NLS_CFG_H_
@@ -11,33 +16,58 @@
 #include "nls.h"
 #include "ff.h"
 #include "vars.h"
+#include "font_cache.h"
 
 typedef std::vector<std::string> tLangList;
 
+/*
+ * The binary language pack file header. The header is followed by:
+ * - message offset table, uint16_t per message in t_msg_id order, 0xFFFF if message is not translated
+ * - string pool, zero-terminated UTF-8 strings
+ * - u8g2 font data
+ * The data_crc is CRC32 of everything after the header
+ */
+typedef struct s_nls_pack_header {
+	char			magic[4];								// "NLSP"
+	uint16_t		version;
+	uint16_t		msg_num;								// Must be equal to MSG_LAST
+	uint32_t		keys_crc;								// Must be equal to NLS_MSG::keysCRC()
+	uint32_t		pool_size;
+	uint32_t		font_size;
+	uint32_t		data_crc;
+} t_nls_pack_header;
+
 class NLS {
 	public:
 		NLS(void)											{ }
 		void			init(NLS_MSG *pMsg);
 		uint8_t			numLanguages(void)					{ return lang_cfg.listSize();	}
 		uint8_t			languageIndex(void)					{ return language_index;		}
-		uint8_t*		font(void)							{ return font_data;				}
+		uint8_t*		font(void)							{ return font_cache.isOpen()?font_cache.font():font_data;	}
 		void			loadLanguageData(const char *language);
 		void			loadLanguageData(uint8_t index);
 		void			defaultNLS();
 		std::string		languageName(uint8_t index);
+		FONT_CACHE*		fontCache(void)						{ return &font_cache;			}
 	private:
 		uint8_t			index(const char *lang);
 		std::string		messageFile(uint8_t index);
 		std::string		fontFile(uint8_t index);
+		std::string		packFile(uint8_t index);
+		t_lang_cfg*		langEntry(uint8_t index);
+		bool			loadPack(uint8_t indx);
 		bool			loadFont(uint8_t indx);
 		bool			loadMessages(uint8_t indx);
 		FATFS			flashfs;
 		FIL				cfg_f;
 		JSON_LANG_CFG	lang_cfg;
 		JSON_MESSAGES	msg_parser;
+		NLS_MSG			*pMsg			= 0;
 		uint8_t			language_index	= 0;				// Current language index
 		uint8_t			*font_data		= 0;				// Loaded font data, memory allocated by malloc()
 		const TCHAR*	fn_cfg			= nsl_cfg;			// vars.h
+		FONT_CACHE		font_cache;							// The font too big to be loaded into the memory
+		const uint32_t	font_resident	= 16384;			// The maximum font size to be loaded into the memory
 };
 
 #endif
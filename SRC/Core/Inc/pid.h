@@ -2,6 +2,9 @@
  * pid.h
  *
  *      Author: Alex
+ *
+ *  2026 OCT 18
+ *  	Added PID::terms() to read the PID terms calculated by the last PID::reqPower() call
  */
 
 #ifndef _PID_H
@@ -41,6 +44,7 @@ class PID {
 		int32_t  	changePID(uint8_t p, int32_t k);    	// set or get (if parameter < 0) PID parameter
 		void		newPIDparams(uint16_t delta_power, uint32_t diff, uint32_t period);
 		void		pidStable(void)							{ power = stable; }
+		bool		terms(int32_t *kp, int32_t *ki, int32_t *kd);
 	private:
 		void  		debugPID(int t_set, int t_curr, long kp, long ki, long kd, long delta_p);
 		uint32_t 	T 							= 20;		// Check IRON or Hot Air Gun period, ms (to calculate auto PID parameters)
@@ -52,6 +56,10 @@ class PID {
 		int32_t		Kd				= 0;
 		int16_t  	denominator_p	= 11;              		// The common coefficient denominator power of 2 (11 means 2048)
 		int32_t		stable			= 20000;				// The power value when the iron reaches the preset temperature
+		volatile int32_t	t_kp	= 0;					// The PID terms of the last iteration, multiplied by denominator
+		volatile int32_t	t_ki	= 0;
+		volatile int32_t	t_kd	= 0;
+		volatile bool		t_new	= false;				// The PID terms were calculated since last terms() call
 };
 
 class PIDTUNE {
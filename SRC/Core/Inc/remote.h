@@ -0,0 +1,110 @@
+/*
+ * remote.h
+ *
+ *  Created on: 2026 OCT 18
+ *      Author: Alex
+ *
+ *  Remote control protocol of the test fixture. The host sends FRAME_COMMAND frames with t_rc_request payload,
+ *  the station answers every command by FRAME_REPLY frame with the same sequence number and t_rc_reply payload.
+ *  When the unit state changes (power mode, preset temperature, fan speed, tip), the station sends FRAME_EVENT frame
+ *  with t_rc_state payload. The next command is accepted after the reply was received. See TLOG/remote.py
+ *
+ *  REMOTE assembles the frames from the received bytes, checks the request and calls the handler.
+ *  The corrupted frames and the frames the transport lost the data of are dropped without reply and counted,
+ *  the count is sent in every state, so the host can tell the lost command from the slow reply.
+ *  The host starts every command with the zero byte also: the frame after the lost data is skipped till the delimiter.
+ *  The handler maps the request to the station API, the transport is the write function. Both are supplied by the caller,
+ *  so the code does not use the hardware. All methods are called from the main loop.
+ */
+
+#ifndef REMOTE_H_
+#define REMOTE_H_
+
+#include <stdint.h>
+#include "frame.h"
+
+typedef enum {
+	RC_PING = 0,											// No action, the reply has the unit state
+	RC_QUERY,												// The same as RC_PING
+	RC_SET_TEMP,											// Set the preset temperature, human readable units
+	RC_SET_FAN,												// Set the Hot Air Gun fan speed, 0 - max fan speed (see cfg.json)
+	RC_POWER,												// Switch the unit on (1) or off (0)
+	RC_STANDBY,												// Switch the IRON to the low power mode (1) or return to normal mode (0)
+	RC_TIP,													// Select the IRON tip by index
+	RC_RATE,												// Set telemetry stream rate, Hz
+	RC_LAST
+} t_rc_cmd;
+
+typedef enum {
+	RC_OK = 0,
+	RC_BAD_CMD,												// Unknown command or wrong payload length
+	RC_BAD_DEV,												// The command does not apply to the device
+	RC_BAD_ARG,												// The value is out of range
+	RC_BUSY,												// The station is not in the main working mode
+	RC_FAIL													// The command cannot be executed in current state
+} t_rc_status;
+
+typedef enum {
+	RC_CONNECTED	= 1,									// The device is connected
+	RC_CELSIUS		= 2,									// The temperatures are in Celsius, otherwise in Fahrenheit
+	RC_WORKING		= 4										// The station is in the main working mode and accepts the commands
+} t_rc_flag;
+
+typedef struct __attribute__((packed)) s_rc_request {
+	uint8_t		cmd;										// t_rc_cmd
+	uint8_t		dev;										// tDevice: 0 - IRON, 1 - Hot Air Gun
+	uint16_t	value;
+} t_rc_request;
+
+typedef struct __attribute__((packed)) s_rc_state {
+	uint8_t		dev;
+	uint8_t		mode;										// IRON::PowerMode or HOTGUN::PowerMode
+	uint8_t		flags;										// t_rc_flag bits
+	uint8_t		tip;										// The IRON tip index
+	uint16_t	temp;										// Average temperature, human readable units
+	uint16_t	preset;										// Preset temperature, human readable units
+	uint16_t	fan;										// Preset fan speed of the Hot Air Gun
+	uint8_t		power;										// Average power, %
+	uint8_t		errors;										// The number of dropped command frames, modulo 256
+} t_rc_state;
+
+typedef struct __attribute__((packed)) s_rc_reply {
+	uint8_t		cmd;
+	uint8_t		status;										// t_rc_status
+	t_rc_state	state;										// The device state after the command
+} t_rc_reply;
+
+class REMOTE_HANDLER {
+	public:
+		virtual				~REMOTE_HANDLER(void)			{ }
+		virtual uint8_t		execute(const t_rc_request &req)			= 0;	// Returns t_rc_status
+		virtual void		state(uint8_t dev, t_rc_state &st)			= 0;
+};
+
+class REMOTE {
+	public:
+		typedef bool (*t_write)(const uint8_t *data, uint16_t len);
+		REMOTE(void)										{ }
+		void		init(REMOTE_HANDLER *handler, t_write out)	{ this->handler = handler; this->out = out;	}
+		void		receive(const uint8_t *data, uint16_t len);	// Process the received bytes
+		void		lost(void);								// The transport lost the data after the bytes received
+		void		poll(void);								// Send events if the device state has been changed
+		uint32_t	errors(void)							{ return bad_frames;			}
+	private:
+		void		command(const uint8_t *frame, uint16_t len);
+		bool		changed(const t_rc_state &a, const t_rc_state &b);
+		void		state(uint8_t dev, t_rc_state &st);
+		void		send(uint8_t type, uint8_t seq, const void *payload, uint16_t len);
+		static const uint8_t	devices	= 2;
+		REMOTE_HANDLER	*handler	= 0;
+		t_write		out				= 0;
+		uint8_t		rx[FRAME_MAX_SIZE];						// The frame being received
+		uint16_t	rx_len			= 0;
+		bool		rx_skip			= false;				// The frame is too long or incomplete, skip it till the delimiter
+		uint8_t		ev_seq			= 0;					// The event sequence number
+		bool		ev_init			= false;				// The device state was sent
+		t_rc_state	last[devices];							// The device state sent last time
+		uint32_t	bad_frames		= 0;
+};
+
+#endif
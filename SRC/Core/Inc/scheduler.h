@@ -0,0 +1,61 @@
+/*
+ * scheduler.h
+ *
+ *  Created on: 2026 OCT 18
+ *      Author: Alex
+ *
+ *  Cooperative scheduler of the main loop. The timed tasks are called from the main loop when their period expires.
+ *  The interrupt handlers raise the event flags. When no task is due and no event is pending, the controller
+ *  waits for the next interrupt with WFI. It is not a tickless low-power idle: the core clock keeps running
+ *  and the SysTick (priority 0) wakes the controller every millisecond. The SysTick handler also runs acCheck()
+ *  and buttonsCheck(), so the sleep never lasts more than 1 ms. WFI only saves the power of the fetched instructions.
+ *  The idle load is the part of the time the controller sleeps, the latency is the time from the event raised
+ *  till the main loop takes it.
+ */
+
+#ifndef SCHEDULER_H_
+#define SCHEDULER_H_
+
+#include "main.h"
+
+typedef enum {
+	EV_ENCODER	= 1,										// An encoder rotated
+	EV_SWITCH	= 2,										// The reed or tilt switch changed its state
+	EV_TEMP		= 4,										// New temperature data available
+	EV_AC		= 8											// AC power appeared or lost
+} t_event;
+
+class SCHED {
+	public:
+		typedef void (*t_task)(void);
+		SCHED(void)											{ }
+		bool			addTask(t_task task, uint16_t period_ms);
+		void			runTasks(void);
+		uint32_t		takeEvents(void);
+		void			sleep(void);
+		uint8_t			idleLoad(void)						{ return idle_pcnt;				}	// Percent
+		uint32_t		maxLatency(void)					{ return lat_max;				}	// mks
+		uint32_t		avgLatency(void)					{ return lat_avg8 >> 3;			}	// mks
+		static void		signal(uint32_t events);			// Can be called from interrupt handler
+	private:
+		typedef struct s_task_entry {
+			t_task		task;
+			uint16_t	period;								// ms
+			uint32_t	next;								// Time in ms when to call the task
+		} t_task_entry;
+		static uint32_t	now(void);
+		bool			taskDue(void);
+		static const uint8_t	max_tasks	= 8;
+		t_task_entry	tasks[max_tasks];
+		uint8_t			task_num		= 0;
+		uint32_t		idle_cycles		= 0;				// The time slept in the current window, SysTick cycles
+		uint32_t		window_start	= 0;				// The start time of the load measurement window, ms
+		uint8_t			idle_pcnt		= 0;
+		uint32_t		lat_max			= 0;
+		uint32_t		lat_avg8		= 0;				// Averaged latency multiplied by 8
+		static volatile uint32_t	events;					// Pending events
+		static volatile uint32_t	ev_time;				// The time when the first pending event was raised, SysTick cycles
+		const uint16_t	window			= 1000;				// The load measurement window, ms
+};
+
+#endif
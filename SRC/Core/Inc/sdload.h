@@ -1,6 +1,12 @@
 /*
  * sdload.h
  *
+ * 2026 OCT 18
+ *     The file is copied only if its content differs from the flash copy, see SDLOAD::haveToUpdate()
+ *     Copy progress is shown on the display
+ *     Added SDLOAD::isSourceFile()
+ *     The copy progress is reported through SDLOAD_PROGRESS interface, so the class does not depend on the display
+ *     Added SDLOAD::saveLogs() to copy the telemetry session files from the flash to the SD-CARD
  */
 
 #ifndef SDLOAD_H_
@@ -10,13 +16,21 @@
 #include "ff.h"
 #include "vars.h"
 #include "sdspi.h"
+#include "nls.h"
 
 extern SDCARD sd;
 
+// The file copy progress receiver
+class SDLOAD_PROGRESS {
+	public:
+		virtual void	copyProgress(const char *name, uint8_t percent)	= 0;
+};
+
 class SDLOAD {
 	public:
 		SDLOAD(void)										{ }
-		t_msg_id	load(void);								// Returns number of languages loaded
+		t_msg_id	load(SDLOAD_PROGRESS *pProgress = 0);	// Returns MSG_LAST if at least one language loaded, error message otherwise
+		t_msg_id	saveLogs(const char *active, uint8_t *saved, SDLOAD_PROGRESS *pProgress = 0); // Returns MSG_LAST if all files saved
 		uint8_t		sdStatus(void)							{ return sd.init_status; } // SD status initialized by SD_Init() function (see sdspi.c)
 	private:
 		t_msg_id	init(void);
@@ -24,10 +38,15 @@ class SDLOAD {
 		void		umountAll(void);
 		bool		allocateCopyBuffer(void);
 		bool		isLanguageDataConsistent(t_lang_cfg &lang_data);
-		bool		haveToUpdate(std::string &name);
-		bool		copyFile(std::string &name);
+		bool		isSourceFile(std::string &name);
+		bool		isLogFile(const char *name);
+		bool		haveToUpdate(std::string &name, const char *src, const char *dst);
+		bool		copyFile(std::string &name, const char *src = "1:", const char *dst = "0:");
+		bool		fileCRC(std::string &path, uint32_t *crc);
+		void		showProgress(std::string &name, uint32_t done, uint32_t size);
 		uint8_t		*buffer		= 0;						// The buffer to copy the file, allocated later
 		uint16_t	buffer_size	= 0;						// The allocated buffer size
+		SDLOAD_PROGRESS	*pProgress	= 0;					// To show the copy progress
 		FATFS			sdfs, flashfs;
 		FIL				cfg_f;
 		JSON_LANG_CFG	lang_cfg;
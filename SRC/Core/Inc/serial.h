@@ -0,0 +1,63 @@
+/*
+ * serial.h
+ *
+ *  Created on: 2026 OCT 18
+ *      Author: Alex
+ *
+ *  The serial port for the service and test fixture builds, enabled by SERIAL_PORT define in main.h.
+ *  The controller has no free pins, so USART1 uses the switch inputs: TX on PB6 (TILT switch) and RX on PA10 (REED switch).
+ *  The port is configured in the .ioc file, MX_USART1_UART_Init() is generated but called by SERIAL::init() only,
+ *  the switch inputs are initialized in MX_GPIO_Init() when SERIAL_PORT is not defined.
+ *  The data is copied into the transmit ring and sent by HAL_UART_Transmit_DMA(), SERIAL::write() never waits.
+ *  The received data is written by DMA into the small circular buffer. On idle line, half and full transfer
+ *  the interrupt moves it into the receive ring, SERIAL::read() takes the data from the ring in the main loop.
+ *  When the main loop is late and the ring is full, the new data is dropped and the place is marked,
+ *  SERIAL::read() stops there and SERIAL::lost() tells the reader the stream has a gap.
+ */
+
+#ifndef SERIAL_H_
+#define SERIAL_H_
+
+#include "main.h"
+
+#ifdef SERIAL_PORT
+
+class SERIAL {
+	public:
+		SERIAL(void)										{ }
+		void		init(void);
+		bool		write(const uint8_t *data, uint16_t len);	// Returns false if there is no room for whole data
+		uint16_t	read(uint8_t *data, uint16_t max);		// Returns the number of bytes read, stops at the lost data
+		bool		lost(void);								// True once, when read() reached the place some data were lost at
+		uint32_t	dropped(void)							{ return tx_dropped;			}
+		uint32_t	overruns(void)							{ return rx_overruns;			}
+		uint32_t	rxErrors(void)							{ return rx_errors;				}
+		void		txComplete(void);						// Called from USART interrupt
+		void		rxEvent(uint16_t pos);					// Called from USART or DMA interrupt, DMA has written the data till pos
+		void		error(void);							// Called from USART interrupt, HAL stops the DMA transfer on error
+	private:
+		void		kick(void);
+		void		rxStart(void);
+		void		rxGap(void);
+		static const uint16_t	tx_size	= 1024;				// Transmit ring size, power of 2
+		uint8_t				tx_buff[tx_size];
+		volatile uint16_t	tx_head		= 0;				// Written by write() only
+		volatile uint16_t	tx_tail		= 0;				// Written by txComplete() only
+		volatile uint16_t	tx_len		= 0;				// Length of DMA transfer in progress, 0 if DMA is idle
+		uint32_t			tx_dropped	= 0;				// The number of bytes dropped because the ring was full
+		static const uint16_t	rx_dma_size	= 64;			// DMA buffer size. Half of it is received in 2.8 ms at 115200
+		uint8_t				rx_dma[rx_dma_size];
+		uint16_t			rx_pos		= 0;				// The DMA buffer position moved to the ring last time
+		static const uint16_t	rx_size	= 512;				// Receive ring size, power of 2. 44 ms of continuous data at 115200
+		uint8_t				rx_buff[rx_size];
+		volatile uint16_t	rx_head		= 0;				// Written by rxEvent() only
+		volatile uint16_t	rx_tail		= 0;				// Written by read() only
+		volatile bool		rx_gap		= false;			// The data were lost at rx_gap_at position of the ring
+		volatile uint16_t	rx_gap_at	= 0;
+		volatile uint32_t	rx_overruns	= 0;				// The number of bytes dropped because the ring was full
+		volatile uint32_t	rx_errors	= 0;				// The number of the reception restarts after framing, noise or overrun error
+};
+
+#endif
+
+#endif
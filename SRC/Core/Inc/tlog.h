@@ -0,0 +1,99 @@
+/*
+ * tlog.h
+ *
+ *  Created on: 2026 OCT 18
+ *      Author: Alex
+ *
+ *  Control loop telemetry. The interrupt handlers put the records into lock-free rings, one ring per producer:
+ *  the IRON ring is filled by ADC conversion complete callback, the Hot Air Gun ring by TIM1 channel 3 interrupt.
+ *  The main loop takes the records. When the session is active, the records are collected into the block buffer
+ *  and saved into the session file on the W25Qxx flash drive, otherwise they are discarded.
+ *  The session file reserves contiguous space when it is created, so the FAT and the directory are not changed
+ *  while the session is active. The block is the flash sector: the full block is programmed directly into its sector,
+ *  that was erased ahead of time, and the erase of the next sector is started without waiting for it.
+ *  So no sector erase is waited for in the main loop. The file is cut to the written size when the session stops.
+ *  The record can be split between two blocks.
+ *  The session file is the header (t_tlog_header) followed by the records (t_tlog_rec), see TLOG/tlog2csv.py
+ *  The files are copied to the SD-CARD in the flash debug mode, see SDLOAD::saveLogs()
+ *  The sink function, if set, gets every record taken, for example to send it to the serial port
+ */
+
+#ifndef TLOG_H_
+#define TLOG_H_
+
+#include "main.h"
+#include "flash.h"
+
+typedef enum { TLOG_IRON = 0, TLOG_GUN, TLOG_DEVICES } t_tlog_dev;
+
+typedef enum {
+	TLOG_PID	= 1,										// The PID terms were calculated in this tick
+	TLOG_LOST	= 2											// Some records were lost before this one
+} t_tlog_flag;
+
+typedef struct __attribute__((packed)) s_tlog_rec {
+	uint32_t	ms;											// The record time, ms
+	uint8_t		dev;										// t_tlog_dev
+	uint8_t		flags;										// t_tlog_flag bits
+	uint16_t	raw;										// Raw ADC temperature value
+	uint16_t	temp;										// Filtered temperature, internal units
+	uint16_t	preset;										// Preset temperature, internal units
+	int32_t		kp, ki, kd;									// PID terms multiplied by PID denominator
+	uint16_t	power;										// Applied PWM value
+	uint16_t	current;									// Raw ADC current value
+	uint16_t	ambient;									// Raw ADC ambient temperature value
+	uint16_t	reserved;
+} t_tlog_rec;
+
+typedef struct __attribute__((packed)) s_tlog_header {
+	char		magic[4];									// "TLOG"
+	uint16_t	version;
+	uint16_t	rec_size;									// sizeof(t_tlog_rec)
+	uint32_t	start_ms;									// The session start time
+	uint32_t	reserved;
+} t_tlog_header;
+
+class TLOG {
+	public:
+		typedef void (*t_sink)(const t_tlog_rec &rec);
+		TLOG(void)											{ }
+		void		setSink(t_sink sink)					{ this->sink = sink;			}
+		void		push(const t_tlog_rec &rec);			// Called from interrupt handler only
+		bool		start(W25Q *drive);
+		void		stop(void);
+		void		drain(void);							// Called from the main loop
+		bool		isActive(void)							{ return buff != 0;				}
+		uint32_t	lost(void);								// The records lost in the session
+		uint32_t	written(void)							{ return file_size;				}
+		const char*	fileName(void)							{ return fn;					}
+	private:
+		bool		put(const t_tlog_rec &rec);
+		bool		append(void);
+		uint32_t	dropped(void);
+		static const uint8_t	ring_size	= 64;			// Records in the ring, power of 2
+		typedef struct s_ring {
+			t_tlog_rec			rec[ring_size];
+			volatile uint8_t	head;						// Written by the interrupt handler only
+			volatile uint8_t	tail;						// Written by the main loop only
+			volatile bool		lost;						// The ring was full when the record arrived
+			volatile uint32_t	dropped;					// The records dropped, written by the interrupt handler only
+		} t_ring;
+		t_ring		ring[TLOG_DEVICES];
+		W25Q		*drive		= 0;
+		t_sink		sink		= 0;
+		uint8_t		*buff		= 0;						// The block buffer, allocated when the session is active
+		uint16_t	buff_len	= 0;
+		uint32_t	file_size	= 0;
+		uint32_t	space		= 0;						// The reserved file size
+		uint32_t	sector		= 0;						// The flash sector of the first block
+		uint32_t	lost_base	= 0;						// The dropped records before the session started
+		uint32_t	lost_recs	= 0;
+		char		fn[16];									// Session file name
+		const uint16_t	block_size	= 4096;					// The data is appended to the file by blocks, W25Qxx sector size
+		const uint32_t	max_size	= 1024*1024;			// The session stops when the file reaches this size
+		const uint32_t	min_size	= 64*1024;				// The minimum space to start the session
+		const uint16_t	max_files	= 100;					// The number of session files tlog00.bin - tlog99.bin
+		const uint16_t	version		= 1;
+};
+
+#endif
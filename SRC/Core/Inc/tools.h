@@ -9,6 +9,7 @@
 #define TOOLS_H_
 
 #include "main.h"
+#include "crc.h"
 
 /*
  * Useful functions
@@ -0,0 +1,46 @@
+/*
+ * tstream.h
+ *
+ *  Created on: 2026 OCT 18
+ *      Author: Alex
+ *
+ *  Live telemetry over the serial port. The telemetry records taken from TLOG rings are sent as FRAME_TELEMETRY frames.
+ *  The IRON records are decimated to the configured rate, the Hot Air Gun records are sent every time (once per TIM1 period).
+ *  See TLOG/tstream.py to decode and plot the stream on the host.
+ */
+
+#ifndef TSTREAM_H_
+#define TSTREAM_H_
+
+#include "main.h"
+#include "tlog.h"
+#include "serial.h"
+
+typedef struct __attribute__((packed)) s_tstream_pkt {
+	t_tlog_rec	rec;
+	uint8_t		mode;										// The unit power mode, IRON::PowerMode or HOTGUN::PowerMode
+	uint8_t		reserved;
+} t_tstream_pkt;
+
+#ifdef SERIAL_PORT
+
+class TSTREAM {
+	public:
+		TSTREAM(void)										{ }
+		void		init(SERIAL *port)						{ this->port = port;			}
+		void		setRate(uint8_t hz)						{ rate = (hz > max_rate)?max_rate:hz;	}
+		uint8_t		getRate(void)							{ return rate;					}
+		void		send(const t_tlog_rec &rec, uint8_t mode);
+		uint32_t	dropped(void)							{ return frames_dropped;		}
+	private:
+		SERIAL		*port			= 0;
+		uint8_t		rate			= 10;					// IRON records per second, 0 - disabled
+		uint8_t		seq				= 0;
+		uint32_t	next_iron		= 0;					// The time to send the next IRON record, ms
+		uint32_t	frames_dropped	= 0;
+		const uint8_t	max_rate	= 50;					// The control loop rate
+};
+
+#endif
+
+#endif
@@ -0,0 +1,166 @@
+/*
+ * bench.cpp
+ *
+ *  Created on: 18 oct 2026
+ *
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include "bench.h"
+#include "main.h"
+#include "W25Qxx.h"
+
+void BENCH_STAT::add(uint32_t us, uint32_t size) {
+	if (samples < max_samples)
+		sample[samples++] = us;
+	total_us	+= us;
+	bytes		+= size;
+}
+
+void BENCH_STAT::result(t_bench_result *r) {
+	memset(r, 0, sizeof(t_bench_result));
+	if (samples == 0) return;
+	for (uint8_t i = 1; i < samples; ++i) {					// Insertion sort, the number of samples is small
+		uint32_t s = sample[i];
+		int8_t j = i - 1;
+		for ( ; j >= 0 && sample[j] > s; --j)
+			sample[j+1] = sample[j];
+		sample[j+1] = s;
+	}
+	r->p50	= sample[(samples - 1) / 2];
+	r->p90	= sample[(samples * 9 - 1) / 10];
+	r->max	= sample[samples - 1];
+	if (total_us > 0)
+		r->kbps	= (uint64_t)bytes * 1000000 / 1024 / total_us;
+}
+
+#ifdef USE_HAL_DRIVER
+// Use the core cycle counter to measure short operations
+void CYCLE_TIMER::start(void) {
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+	DWT->CTRL		 |= DWT_CTRL_CYCCNTENA_Msk;
+	start_cycle = DWT->CYCCNT;
+}
+
+uint32_t CYCLE_TIMER::elapsed(void) {
+	uint32_t cycles = DWT->CYCCNT - start_cycle;
+	return cycles / (SystemCoreClock / 1000000);
+}
+#endif
+
+/*
+ * Test the file system operations on the scratch file. The volume should be mounted.
+ * If raw is specified, the volume is W25Qxx flash, measure raw sector operations on the separate scratch area
+ */
+bool STORAGE_BENCH::volume(const char *drive, t_bench_result res[BENCH_FS_LAST], t_bench_result raw[BENCH_RAW_LAST]) {
+	buff = (uint8_t *)malloc(block_size);
+	if (!buff) return false;
+	std::string path = std::string(drive) + scratch;
+	FIL f;
+	bool ok = (FR_OK == f_open(&f, path.c_str(), FA_CREATE_ALWAYS | FA_WRITE | FA_READ));
+	if (ok) {
+		ok = fileSystem(&f, res);
+		f_close(&f);
+		f_unlink(path.c_str());
+	}
+	if (ok && raw)
+		ok = rawFlash(drive, raw);
+	free(buff);
+	buff = 0;
+	return ok;
+}
+
+// Write the scratch file by blocks, read it sequentially, write and read it randomly
+bool STORAGE_BENCH::fileSystem(FIL *f, t_bench_result res[BENCH_FS_LAST]) {
+	UINT n = 0;
+	bool ok = true;
+	stat.reset();											// Sequential write
+	for (uint8_t i = 0; i < blocks && ok; ++i) {
+		memset(buff, i, block_size);
+		timer->start();
+		ok = (FR_OK == f_write(f, buff, block_size, &n)) && n == block_size;
+		if (ok && i == blocks-1)
+			ok = (FR_OK == f_sync(f));
+		stat.add(timer->elapsed(), block_size);
+	}
+	stat.result(&res[BENCH_SEQ_WRITE]);
+
+	stat.reset();											// Sequential read
+	ok = ok && (FR_OK == f_lseek(f, 0));
+	for (uint8_t i = 0; i < blocks && ok; ++i) {
+		timer->start();
+		ok = (FR_OK == f_read(f, buff, block_size, &n)) && n == block_size;
+		stat.add(timer->elapsed(), block_size);
+	}
+	stat.result(&res[BENCH_SEQ_READ]);
+
+	uint32_t rnd = HAL_GetTick() | 1;
+	uint32_t rnd_blocks = (uint32_t)blocks * block_size / rnd_size;
+	stat.reset();											// Random write, every block is committed to the flash
+	memset(buff, 0xA5, rnd_size);
+	for (uint8_t i = 0; i < BENCH_STAT::max_samples && ok; ++i) {
+		rnd = rnd * 1103515245 + 12345;
+		FSIZE_t pos = ((rnd >> 16) % rnd_blocks) * rnd_size;
+		timer->start();
+		ok = (FR_OK == f_lseek(f, pos)) && (FR_OK == f_write(f, buff, rnd_size, &n)) && n == rnd_size;
+		ok = ok && (FR_OK == f_sync(f));
+		stat.add(timer->elapsed(), rnd_size);
+	}
+	stat.result(&res[BENCH_RND_WRITE]);
+
+	stat.reset();											// Random read, the blocks are not cached by the file buffer
+	for (uint8_t i = 0; i < BENCH_STAT::max_samples && ok; ++i) {
+		rnd = rnd * 1103515245 + 12345;
+		FSIZE_t pos = ((rnd >> 16) % rnd_blocks) * rnd_size;
+		timer->start();
+		ok = (FR_OK == f_lseek(f, pos)) && (FR_OK == f_read(f, buff, rnd_size, &n)) && n == rnd_size;
+		stat.add(timer->elapsed(), rnd_size);
+	}
+	stat.result(&res[BENCH_RND_READ]);
+	return ok;
+}
+
+/*
+ * The raw scratch area is the contiguous file allocated by f_expand(). The file is closed before the raw operations,
+ * so FatFS does not keep any of its sectors in the buffer. See diskio.c for sector to address conversion.
+ * The erase, program and read operations are timed separately, the program operation includes the last page wait
+ */
+bool STORAGE_BENCH::rawFlash(const char *drive, t_bench_result raw[BENCH_RAW_LAST]) {
+	std::string path = std::string(drive) + raw_area;
+	uint8_t n_sect = (blocks < BENCH_STAT::max_samples)?blocks:BENCH_STAT::max_samples;
+	FIL f;
+	if (FR_OK != f_open(&f, path.c_str(), FA_CREATE_ALWAYS | FA_WRITE))
+		return false;
+	bool ok = (FR_OK == f_expand(&f, (FSIZE_t)n_sect * block_size, 1)) && f.obj.fs->csize == 1;
+	LBA_t first = f.obj.fs->database + (LBA_t)(f.obj.sclust - 2) * f.obj.fs->csize;
+	f_close(&f);
+	if (ok) {
+		stat.reset();
+		for (uint8_t i = 0; i < n_sect && ok; ++i) {
+			timer->start();
+			ok = (W25Qxx_RET_OK == W25Qxx_Erase(first + i, 1));
+			stat.add(timer->elapsed(), block_size);
+		}
+		stat.result(&raw[BENCH_ERASE]);
+		stat.reset();
+		memset(buff, 0x5A, block_size);
+		for (uint8_t i = 0; i < n_sect && ok; ++i) {		// The sectors are erased already
+			timer->start();
+			ok = (W25Qxx_RET_OK == W25Qxx_Program((uint32_t)(first + i) << 12, buff, block_size));
+			ok = ok && (W25Qxx_RET_OK == W25Qxx_Sync());
+			stat.add(timer->elapsed(), block_size);
+		}
+		stat.result(&raw[BENCH_PROGRAM]);
+		stat.reset();
+		for (uint8_t i = 0; i < n_sect && ok; ++i) {
+			timer->start();
+			ok = (W25Qxx_RET_OK == W25Qxx_Read((uint32_t)(first + i) << 12, buff, block_size));
+			stat.add(timer->elapsed(), block_size);
+		}
+		stat.result(&raw[BENCH_READ]);
+	}
+	f_unlink(path.c_str());
+	return ok;
+}
@@ -1,45 +1,91 @@
 /*
  * buzzer.cpp
  *
+ *  2026 OCT 18
+ *  	TIM4 update interrupt counts the tone duration, the tone sequence is queued and the function returns immediately
  */
 
 #include "buzzer.h"
 #include "main.h"
 
+BUZZER::t_tone			BUZZER::queue[BUZZER::queue_size];
+volatile uint8_t		BUZZER::q_head		= 0;
+volatile uint8_t		BUZZER::q_tail		= 0;
+volatile bool			BUZZER::playing		= false;
+uint32_t				BUZZER::remaining	= 0;
+uint16_t				BUZZER::period		= 0;
+
 BUZZER::BUZZER(void) {
 	TIM4->CCR4 	= 0;
 }
 
-void BUZZER::playTone(uint16_t period_mks, uint16_t duration_ms) {
-	TIM4->ARR 	= period_mks-1;
-	TIM4->CCR4 	= period_mks >> 1;
-	HAL_Delay(duration_ms);
-	TIM4->CCR4 	= 0;
+/*
+ * Add the tone sequence to the queue and start playing if the buzzer is silent.
+ * TIM4 runs at 1 MHz, the update interrupt is enabled while the queue is not empty.
+ * When the timer is not started yet, the buzzer is silent, just like the blocking version was.
+ */
+void BUZZER::play(const t_tone seq[], uint8_t n) {
+	if ((TIM4->CR1 & TIM_CR1_CEN) == 0) return;
+	TIM4->DIER &= ~TIM_DIER_UIE;							// Stop the sequencer while the queue is updated
+	for (uint8_t i = 0; i < n; ++i) {
+		uint8_t h = (q_head + 1) % queue_size;
+		if (h == q_tail) break;								// The queue is full, drop the rest
+		queue[q_head] = seq[i];
+		q_head = h;
+	}
+	if (!playing)
+		next();
+	if (playing)
+		TIM4->DIER |= TIM_DIER_UIE;
+}
+
+// Start the next tone from the queue or stop the buzzer
+void BUZZER::next(void) {
+	if (q_tail == q_head) {
+		TIM4->CCR4 	= 0;
+		playing		= false;
+		return;
+	}
+	t_tone t	= queue[q_tail];
+	q_tail		= (q_tail + 1) % queue_size;
+	period		= (t.period_mks)?t.period_mks:1000;			// Count the silence by 1 ms periods
+	TIM4->ARR 	= period-1;
+	TIM4->CCR4 	= (t.period_mks)?(period >> 1):0;
+	TIM4->CNT	= 0;
+	remaining	= (uint32_t)t.duration_ms * 1000;
+	playing		= true;
+}
+
+void BUZZER::tick(void) {
+	if (remaining > period) {
+		remaining -= period;
+		return;
+	}
+	next();
+	if (!playing)
+		TIM4->DIER &= ~TIM_DIER_UIE;
 }
 
 void BUZZER::shortBeep(void) {
 	if (!enabled) return;
-	playTone(284, 160);
+	static const t_tone seq[] = { {284, 160} };
+	play(seq, 1);
 }
 
 void BUZZER::doubleBeep(void) {
 	if (!enabled) return;
-	playTone(284, 160);
-	HAL_Delay(100);
-	playTone(284, 160);
+	static const t_tone seq[] = { {284, 160}, {0, 100}, {284, 160} };
+	play(seq, 3);
 }
 
 void BUZZER::lowBeep(void) {
 	if (!enabled) return;
-	playTone(2840, 160);
+	static const t_tone seq[] = { {2840, 160} };
+	play(seq, 1);
 }
 
 void BUZZER::failedBeep(void) {
 	if (!enabled) return;
-	playTone(284, 160);
-	HAL_Delay(50);
-	playTone(2840, 60);
-	HAL_Delay(50);
-    playTone(1420, 160);
+	static const t_tone seq[] = { {284, 160}, {0, 50}, {2840, 60}, {0, 50}, {1420, 160} };
+	play(seq, 5);
 }
-
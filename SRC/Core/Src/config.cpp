@@ -9,6 +9,12 @@
  *  2024 OCT 06, v.1.15
  *  	Changed the CFG_CORE::setup(), using the struct instead of parameter list
  *  	Added CFG_CORE::getMainParams() method
+ *  2026 OCT 18
+ *  	CFG::buildTipTable() reads the tip calibration file by chunks in single pass
+ *  	The tip record is saved into the slot, found in tip_table
+ *  	Added sorted list of active tips. CFG::tipList() and CFG::nearActiveTip() do not scan whole tip table
+ *  	CFG::buildTipTable() maps the records of inactive and not calibrated tips too, so their slots are reused.
+ *  	The tip calibration file is read till the end, not limited by the tip list size
  */
 
 #include <stdlib.h>
@@ -31,7 +37,9 @@
 CFG_STATUS CFG::init(void) {
 //	TIP_CFG::activateGun(false);
 
-	tip_table = (TIP_TABLE*)malloc(sizeof(TIP_TABLE) * TIPS::loaded());
+	tip_table	= (TIP_TABLE*)malloc(sizeof(TIP_TABLE) * TIPS::loaded());
+	active_tip	= (uint8_t*)malloc(TIPS::loaded());
+	active_num	= 0;
 	if (tip_table) {
 		for (uint8_t i = 0; i < TIPS::loaded(); ++i) {
 			tip_table[i].tip_index 		= NO_TIP_CHUNK;
@@ -268,14 +276,16 @@ void CFG::saveTipCalibtarion(uint8_t index, uint16_t temp[4], uint8_t mask, int8
 	const char* name	= TIPS::name(index);
 	if (name && isValidTipConfig(&tip)) {
 		strncpy(tip.name, name, tip_name_sz);
-		int16_t tip_index = saveTipData(&tip);
-		if (tip_index >= 0) {
+		int16_t tip_index = saveTipData(&tip, tip_table[index].tip_index);
+		if (tip_index >= 0 && tip_index < NO_TIP_CHUNK) {
 			BUZZER::shortBeep();
 			tip_table[index].tip_index	= tip_index;
 			tip_table[index].tip_mask	= mask;
+			buildActiveList();
 			return;
 		}
 	}
+	buildActiveList();
 	BUZZER::failedBeep();
 }
 
@@ -300,10 +310,11 @@ bool CFG::toggleTipActivation(uint8_t index) {
 	}
 	if (!ret) return false;
 
-	tip_index = saveTipData(&tip, true);
-	if (tip_index >= 0 && tip_index < TIPS::loaded()) {
+	tip_index = saveTipData(&tip, tip_table[index].tip_index, true);
+	if (tip_index >= 0 && tip_index < NO_TIP_CHUNK) {		// The slot index should fit the tip table
 		tip_table[index].tip_index	= tip_index;
 		tip_table[index].tip_mask	= tip.mask;
+		buildActiveList();
 		return true;
 	}
 	return false;
@@ -320,18 +331,20 @@ int	CFG::tipList(uint8_t current, TIP_ITEM list[], uint8_t list_len, bool active
 
 	// Seek several (previous) tips backward
 	int16_t tip_index = current-1;
-	uint8_t previous = 3;
-	for (; tip_index > 0; --tip_index) {
-		if (!active_only || (tip_table[tip_index].tip_mask & TIP_ACTIVE)) {
-			if (--previous == 0)
-				break;
-		}
+	if (active_only) {										// Use the sorted list of active tips
+		uint16_t pos = activePosition(current);
+		tip_index = (pos >= 3)?active_tip[pos-3]:0;
+	} else {
+		tip_index = constrain(tip_index-2, 0, TIPS::loaded());
 	}
 	uint8_t loaded = 0;
+	uint16_t pos = activePosition(tip_index);				// The position of the first tip in the active tip list
 	for (; tip_index < TIPS::loaded(); ++tip_index) {
 		if (tip_index == 0) continue;						// Skip Hot Air Gun 'tip'
-		if (active_only && !(tip_table[tip_index].tip_mask & TIP_ACTIVE)) // This tip is not active, but active tip list required
-			continue;										// Skip this tip
+		if (active_only) {									// Take next tip from the active tip list
+			if (pos >= active_num) break;
+			tip_index = active_tip[pos++];
+		}
 		list[loaded].tip_index	= tip_index;
 		list[loaded].mask		= tip_table[tip_index].tip_mask;
 		std::string tip_name	= buildFullTipName(tip_index);
@@ -347,40 +360,21 @@ int	CFG::tipList(uint8_t current, TIP_ITEM list[], uint8_t list_len, bool active
 
 // Check the current tip is active. Return nearest active tip or 1 if no one tip has been activated
 uint8_t	CFG::nearActiveTip(uint8_t current_tip) {
-	if (!tip_table) {										// If tip_table is not initialized
+	if (!tip_table || active_num == 0) {					// If tip_table is not initialized or no active tip
 		return 1;
 	}
-	uint16_t max_tip = TIPS::loaded();
-	current_tip = constrain(current_tip, 1, max_tip);
-	if (tip_table[current_tip].tip_mask & TIP_ACTIVE)
-		return current_tip;
-	uint16_t top_tip = current_tip;
-	for (; top_tip > 0; --top_tip) {
-		if (tip_table[top_tip].tip_mask & TIP_ACTIVE)
-			break;
-	}
-	uint16_t bot_tip = current_tip;
-	for (; bot_tip < max_tip; ++bot_tip) {
-		if (tip_table[bot_tip].tip_mask & TIP_ACTIVE)
-			break;
-	}
-	if (top_tip == 0) {										// No active tip lower than current one
-		if (bot_tip != max_tip) {							// Found active tip greater than current one
-			return bot_tip;
-		} else {
-			return 1;
-		}
-	} else {												// Found active tip lower than current one
-		if (bot_tip == max_tip) {							// No active tip greater than current one
-			return top_tip;
-		} else {											// Found active tips on both sides
-			if (current_tip-top_tip < bot_tip-current_tip) {
-				return top_tip;
-			} else {
-				return bot_tip;
-			}
-		}
+	current_tip = constrain(current_tip, 1, TIPS::loaded()-1);
+	uint16_t pos = activePosition(current_tip);
+	if (pos >= active_num)									// No active tip greater than current one
+		return active_tip[active_num-1];
+	uint8_t bot_tip = active_tip[pos];
+	if (bot_tip == current_tip || pos == 0)					// The current tip is active or no active tip lower than current one
+		return bot_tip;
+	uint8_t top_tip = active_tip[pos-1];
+	if (current_tip-top_tip < bot_tip-current_tip) {		// Found active tips on both sides
+		return top_tip;
 	}
+	return bot_tip;
 }
 
 // Initialize the configuration area. Save default configuration to the FLASH
@@ -399,34 +393,64 @@ bool CFG::clearAllTipsCalibration(void) {
 			tip_table[i].tip_mask 		= 0;
 		}
 	}
+	active_num = 0;
 	return clearTips();
 }
 
 /*
- * Builds the tip configuration table: reads whole tip configuration area and search for configured or active tip
- * If the tip found, updates the tip_table array with the tip chunk number
+ * Builds the tip configuration table: reads whole tip configuration file and maps every tip record to its slot,
+ * even if the tip is not active and not calibrated, so the slot is reused when the tip is activated again.
+ * Returns the number of configured (active or calibrated) tips
  */
 uint8_t	CFG::buildTipTable(TIP_TABLE tt[]) {
-	TIP			tmp_tip;
+	TIP			chunk[tip_chunk_sz];
 	uint16_t	loaded 		= 0;
-	for (int16_t i = 0; i < TIPS::loaded(); ++i) {		// Limit this loop by whole TIP list for reliability
-		TIP_IO_STATUS ts = loadTipData(&tmp_tip, i, true);
-		if (ts == TIP_OK) {
-			int16_t glb_index = TIPS::index(tmp_tip.name);
+	uint16_t	i			= 0;						// Tip record index in the file
+	W25Q::close();											// Read the file from the beginning
+	while (i < NO_TIP_CHUNK) {								// Read till the end of file. The slot index should fit the tip table
+		uint8_t n = tip_chunk_sz;
+		if (loadTipChunk(chunk, &n, true) != TIP_OK || n == 0)
+			break;
+		for (uint8_t c = 0; c < n && i < NO_TIP_CHUNK; ++c, ++i) {
+			if (chunk[c].name[0] == '\0') continue;		// Wrong CRC
+			int16_t glb_index = TIPS::index(chunk[c].name);
 			// Loaded existing tip data once
-			if (glb_index >= 0 && tmp_tip.mask > 0 && tt[glb_index].tip_index == NO_TIP_CHUNK) {
+			if (glb_index >= 0 && tt[glb_index].tip_index == NO_TIP_CHUNK) {
 				tt[glb_index].tip_index 	= i;
-				tt[glb_index].tip_mask		= tmp_tip.mask;
-				++loaded;
+				tt[glb_index].tip_mask		= chunk[c].mask;
+				if (chunk[c].mask)
+					++loaded;
 			}
-		} else if (ts == TIP_IO) {
-			break;
 		}
 	}
 	W25Q::umount();
+	buildActiveList();
 	return loaded;
 }
 
+// Build the sorted list of active tips. Hot Air Gun 'tip' is never in the list
+void CFG::buildActiveList(void) {
+	active_num = 0;
+	if (!tip_table || !active_tip) return;
+	for (uint16_t i = 1; i < TIPS::loaded(); ++i) {
+		if (tip_table[i].tip_mask & TIP_ACTIVE)
+			active_tip[active_num++] = i;
+	}
+}
+
+// Returns the position of the first active tip with the index not less than required one
+uint16_t CFG::activePosition(uint8_t index) {
+	uint16_t lo = 0, hi = active_num;
+	while (lo < hi) {
+		uint16_t mid = (lo + hi) >> 1;
+		if (active_tip[mid] < index)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	return lo;
+}
+
 // Build full name of the current tip. Add prefix "T12-" for the "usual" tip or use complete name for "N*" tips
 std::string CFG::buildFullTipName(const uint8_t index) {
 	const char *name = TIPS::name(index);
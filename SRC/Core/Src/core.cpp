@@ -17,15 +17,34 @@
  *     Added active.setFail() call
  *  2024 OCT 09, v.1.15
  *  	Changed MABOUT and MDEBUG constructors. The flash debug mode now is calling from about dialog.
+ *  2026 OCT 18
+ *  	Added HAL_TIM_PeriodElapsedCallback() to drive the buzzer tone sequencer
+ *  	TIM1 channel 2 interrupt fires on every AC zero-cross. The half-cycle period, mains frequency and AC presence
+ *  	are calculated in the interrupt, TIM2 is kept aligned to the mains phase continuously. Removed syncAC()
+ *  	The main loop runs by the cooperative scheduler: the switches and brightness are checked by timed tasks,
+ *  	the interrupt handlers raise the events, the controller sleeps when there is nothing to do
+ *  	The encoder buttons are checked by EXTI interrupts and debounced by buttonsCheck() in SysTick
+ *  	The display brightness fades in TIM3 update interrupt, the scheduler task just starts the fade
+ *  	The ADC and TIM1 channel 3 interrupts put the telemetry records, the scheduler task saves them
+ *  	In SERIAL_PORT build the telemetry records are streamed to the serial port, the switches are not checked
+ *  	In SERIAL_PORT build the station is controlled by the remote commands, the Hot Air Gun reed switch is emulated
+ *  	The IRON temperature is read at the end of actual TIM2 period, the IRON power is limited by the adaptive measurement window
+ *  	The EXTI handlers are counted in the interrupt nesting depth, see memstat.h
+ *  	In SERIAL_PORT build the serial port is initialized by CubeMX generated code, the boot screen tells the switches are disabled
+ *  	In SERIAL_PORT build the remote control drops the command frame the serial port lost the data of
+ *  	The IRON measurement window gets the TIM2 counter at the ADC end to check the ADC has finished in time
+ *  	TIM2 period is preloaded (ARPE is set by CubeMX) and changed in the middle of the period only, see tim2Period()
  */
 
 #include "core.h"
 #include "hw.h"
 #include "mode.h"
+#include "memstat.h"
 
 #define ADC_CONV 	(5)										// Activated ADC Ranks Number (hadc2.Init.NbrOfConversion)
 #define ADC_LOOPS	(4)										// Number of ADC conversion loops. Even value better.
 #define ADC_BUFF_SZ	(ADC_CONV*ADC_LOOPS)
+static_assert(ADC_LOOPS == MW_ADC_LOOPS, "The ADC conversion time is checked in mwindow.h");
 
 extern ADC_HandleTypeDef	hadc1;
 extern TIM_HandleTypeDef	htim1;							// HOT AIR GUN + AC_Zero
@@ -35,13 +54,26 @@ extern TIM_HandleTypeDef	htim4;							// BUZZER
 typedef enum { ADC_IDLE, ADC_CURRENT, ADC_TEMP } t_ADC_mode;
 volatile static t_ADC_mode	adc_mode = ADC_IDLE;
 volatile static uint16_t	buff[ADC_BUFF_SZ];
-volatile static	uint32_t	tim1_cntr		= 0;			// Previous value of TIM1 counter. Using to check the TIM1 value changing
 volatile static	bool		ac_sine			= false;		// Flag indicating that TIM1 is driven by AC power interrupts on AC_ZERO pin
-static 	EMP_AVERAGE			gtim_period;					// gun timer period (ms)
-volatile static uint32_t	gtim_last_ms	= 0;			// Time when the gun timer became zero
-const static uint16_t  		max_iron_pwm	= 1960;			// Max value should be less than TIM2.CHANNEL3 value by 20
+volatile static uint32_t	zc_last			= 0;			// DWT cycle counter value at the last zero-cross
+volatile static uint32_t	zc_half8		= 0;			// Averaged half-cycle period multiplied by 8, mks
+volatile static uint32_t	zc_timeout		= 0;			// AC is lost when no zero-cross happens during this time, cycles
+volatile static uint16_t	raw_iron_curr	= 0;			// The last raw ADC values for telemetry
+volatile static uint16_t	raw_fan_curr	= 0;
+volatile static uint16_t	raw_gun_temp	= 0;
+volatile static uint16_t	raw_ambient		= 0;
+const static uint32_t		zc_min_half		= 7000;			// The shortest valid half-cycle period (71 Hz), mks
+const static uint32_t		zc_max_half		= 12500;		// The longest valid half-cycle period (40 Hz), mks
+const static uint16_t		tim2_period		= 2000;			// TIM2 period, 20 ms, 10 mks per tick
+const static int16_t		tim2_max_adj	= 10;			// Maximum TIM2 period correction to lock on the AC phase, ticks
 const static uint16_t  		max_gun_pwm		= 99;			// TIM1 period. Full power can be applied to the HOT GUN
-const static uint32_t		check_sw_period = 100;			// IRON switches check period, ms
+const static uint16_t		check_sw_period = 100;			// IRON switches check period, ms
+const static uint16_t		brightness_period = 5;			// Display brightness adjust period, ms
+const static uint16_t		tlog_period		= 100;			// Telemetry save period, ms
+#ifdef SERIAL_PORT
+const static uint16_t		remote_period	= 10;			// Remote control commands check period, ms
+static bool					remote_gun_on	= false;		// The Hot Air Gun is switched on by the remote command
+#endif
 
 static HW		core;										// Hardware core (including all device instances)
 
@@ -67,29 +99,213 @@ static	MMENU			main_menu(&core, &boost_setup, &iselect, &param_menu, &calib_menu
 static	MODE*           pMode = &work;
 
 bool     isACsine(void) 	{ return ac_sine; }
-uint16_t gtimPeriod(void)	{ return gtim_period.read(); }
-
-// Synchronize TIM2 timer to AC power
-uint16_t syncAC(void) {
-	uint32_t to = HAL_GetTick() + 300;						// The timeout
-	uint16_t nxt_tim1	= TIM1->CNT + 2;
-	if (nxt_tim1 > 99) nxt_tim1 -= 99;						// TIM1 is clocked by AC zero crossing signal, period is 99.
-	while (HAL_GetTick() < to) {							// Prevent hang
-		if (TIM1->CNT == nxt_tim1) {
-			TIM2->CNT = 0;									// Synchronize TIM2 to AC power zero crossing signal
-			break;
-		}
+uint32_t acHalfPeriod(void)	{ return ac_sine?(zc_half8 >> 3):0; }
+// TIM1 counts 100 zero-crosses, so its period in ms is the half-cycle period in mks divided by 10
+uint16_t gtimPeriod(void)	{ return (acHalfPeriod() + 5) / 10; }
+
+uint8_t acFrequency(void) {
+	uint32_t half = acHalfPeriod();
+	if (half == 0) return 0;
+	return (half > 9100)?50:60;								// 10000 mks for 50 Hz, 8333 mks for 60 Hz
+}
+
+/*
+ * Change TIM2 period. The auto-reload register is preloaded, the new period starts at the next TIM2 update event,
+ * so the counter never runs past the period. The period is changed in the middle of TIM2 period only:
+ * TIM2->ARR read by channel 3 interrupt at the beginning of the period is the active period.
+ * Returns false if it is not the time to change the period
+ */
+static bool tim2Period(uint16_t arr) {
+	uint32_t cnt = TIM2->CNT;
+	if (cnt < tim2_period/4 || cnt > tim2_period*3/4)
+		return false;
+	TIM2->ARR = arr;
+	return true;
+}
+
+// Start the zero-cross interrupt on the next TIM1 count. TIM2 would be synchronized on the second zero-cross
+static void acStart(void) {
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;			// Enable DWT cycle counter to measure the half-cycle period
+	DWT->CTRL		 |= DWT_CTRL_CYCCNTENA_Msk;
+	TIM1->CCR2		 = (TIM1->CNT + 1) % (TIM1->ARR + 1);
+	__HAL_TIM_CLEAR_FLAG(&htim1, TIM_FLAG_CC2);
+	__HAL_TIM_ENABLE_IT(&htim1, TIM_IT_CC2);
+}
+
+/*
+ * Called on every AC zero-cross from TIM1 channel 2 interrupt.
+ * Two consecutive zero-crosses with valid period mean the AC is present. At this moment TIM2 is synchronized to the AC phase.
+ * Then TIM2 phase error is corrected by adjusting its period slightly. The lock is possible on 50 Hz grid only,
+ * because TIM2 period is 20 ms.
+ */
+static void acZeroCross(void) {
+	uint32_t now	= DWT->CYCCNT;
+	uint32_t mks	= (now - zc_last) / (SystemCoreClock / 1000000);
+	zc_last			= now;
+	TIM1->CCR2		= (TIM1->CCR2 + 1) % (TIM1->ARR + 1);	// Next zero-cross
+	if (mks < zc_min_half || mks > zc_max_half) return;		// Noise or the first zero-cross after AC loss
+	if (!ac_sine) {
+		zc_half8	= mks << 3;
+		ac_sine		= true;
+		TIM2->CNT	= 0;									// Synchronize TIM2 to AC power zero crossing signal
+		SCHED::signal(EV_AC);
+	} else {
+		zc_half8	+= mks - (zc_half8 >> 3);
 	}
-	// Checking the TIM2 has been synchronized
-	to = HAL_GetTick() + 300;
-	nxt_tim1 = TIM1->CNT + 2;
-	if (nxt_tim1 > 99) nxt_tim1 -= 99;
-	while (HAL_GetTick() < to) {
-		if (TIM1->CNT == nxt_tim1) {
-			return TIM2->CNT;
-		}
+	zc_timeout		= ((zc_half8 >> 3) * 3 / 2) * (SystemCoreClock / 1000000);	// One and half of the half-cycle
+	int16_t adj = 0;
+	if (acFrequency() == 50) {
+		int16_t err = TIM2->CNT % (tim2_period/2);			// Two zero-crosses per TIM2 period
+		if (err > tim2_period/4) err -= tim2_period/2;		// Positive error means TIM2 is ahead of AC phase
+		adj = constrain(err/4, -tim2_max_adj, tim2_max_adj);
+	}
+	tim2Period(tim2_period - 1 + adj);						// One of two zero-crosses is in the middle of TIM2 period
+}
+
+// Called every 1 ms from SysTick interrupt to detect AC loss
+extern "C" void acCheck(void) {
+	if (ac_sine && (DWT->CYCCNT - zc_last) > zc_timeout) {
+		ac_sine		= false;
+		SCHED::signal(EV_AC);
+	}
+	if (!ac_sine && TIM2->ARR != tim2_period - 1u)
+		tim2Period(tim2_period - 1);						// Restore the nominal period in the middle of TIM2 period
+}
+
+// Called every 1 ms from SysTick interrupt to debounce and classify the encoder button events
+extern "C" void buttonsCheck(void) {
+	uint32_t now = HAL_GetTick();
+	bool ev = core.i_enc.buttonTick(now);
+	ev 		= core.g_enc.buttonTick(now) || ev;
+	if (ev) SCHED::signal(EV_ENCODER);
+}
+
+// Scheduler task: update the IRON tilt switch and Hot Air Gun reed switch status
+static void checkSwitches(void) {
+	static uint8_t prev = 0xFF;
+#ifdef SERIAL_PORT
+	GPIO_PinState tilt = GPIO_PIN_RESET;					// The switch inputs are used by USART1
+	GPIO_PinState reed = remote_gun_on?GPIO_PIN_SET:GPIO_PIN_RESET;	// The Hot Air Gun reed switch is emulated
+#else
+	GPIO_PinState tilt = HAL_GPIO_ReadPin(TILT_SW_GPIO_Port, TILT_SW_Pin);
+	GPIO_PinState reed = HAL_GPIO_ReadPin(REED_SW_GPIO_Port, REED_SW_Pin);
+#endif
+	core.iron.updateReedStatus(GPIO_PIN_SET == tilt);		// Update T12 TILT switch status
+	core.hotgun.updateReedStatus(GPIO_PIN_SET == reed);		// Switch active when the Hot Air Gun handle is off-hook
+	uint8_t sw = (tilt << 1) | reed;
+	if (sw != prev) {
+		prev = sw;
+		SCHED::signal(EV_SWITCH);
+	}
+}
+
+// Scheduler task: start the display brightness fade if the brightness was changed
+static void adjustBrightness(void) {
+	core.dspl.BRGT::adjust();
+}
+
+// Scheduler task: take the telemetry records and save them into the session file
+static void saveTelemetry(void) {
+	core.tlog.drain();
+}
+
+#ifdef SERIAL_PORT
+// TLOG sink: send the telemetry record to the serial port
+static void streamTelemetry(const t_tlog_rec &rec) {
+	uint8_t mode = (rec.dev == TLOG_IRON)?(uint8_t)core.iron.powerMode():(uint8_t)core.hotgun.powerMode();
+	core.tstream.send(rec, mode);
+}
+
+// Remote control handler: the commands are applied by the working mode, see MWORK::remote()
+class STATION_RC : public REMOTE_HANDLER {
+	public:
+		virtual uint8_t	execute(const t_rc_request &req);
+		virtual void	state(uint8_t dev, t_rc_state &st);
+};
+
+uint8_t STATION_RC::execute(const t_rc_request &req) {
+	if (req.cmd == RC_RATE) {
+		if (req.value > 50)
+			return RC_BAD_ARG;
+		core.tstream.setRate(req.value);
+		return RC_OK;
+	}
+	if (pMode != &work)										// The encoders are used by the menu now
+		return RC_BUSY;
+	if (req.cmd == RC_POWER && req.dev == d_gun) {
+		remote_gun_on = req.value != 0;
+		core.hotgun.updateReedStatus(remote_gun_on);		// The working mode switches the Hot Air Gun
+		return RC_OK;
+	}
+	return work.remote(req);
+}
+
+void STATION_RC::state(uint8_t dev, t_rc_state &st) {
+	CFG*	pCFG	= &core.cfg;
+	int16_t	ambient	= core.ambientTemp();
+	memset(&st, 0, sizeof(st));
+	st.dev		= dev;
+	st.flags	= (pCFG->isCelsius()?RC_CELSIUS:0) | ((pMode == &work)?RC_WORKING:0);
+	if (dev == d_gun) {
+		st.mode		= core.hotgun.powerMode();
+		st.temp		= pCFG->tempToHuman(core.hotgun.averageTemp(), ambient, d_gun);
+		st.preset	= pCFG->gunTempPreset();
+		st.fan		= core.hotgun.presetFan();
+		st.power	= core.hotgun.avgPowerPcnt();
+		if (core.hotgun.isConnected())
+			st.flags |= RC_CONNECTED;
+	} else {
+		st.mode		= core.iron.powerMode();
+		st.tip		= pCFG->currentTipIndex(d_t12);
+		st.temp		= pCFG->tempToHuman(core.iron.averageTemp(), ambient, d_t12);
+		st.preset	= pCFG->tempPresetHuman();
+		st.power	= core.iron.avgPowerPcnt();
+		if (core.iron.isConnected())
+			st.flags |= RC_CONNECTED;
+	}
+}
+
+static STATION_RC	station_rc;
+
+// REMOTE transport: send the frame to the serial port
+static bool remoteWrite(const uint8_t *data, uint16_t len) {
+	return core.serial.write(data, len);
+}
+
+// Scheduler task: take the received bytes, execute the remote commands and send the state change events
+static void remoteControl(void) {
+	uint8_t data[32];
+	for (;;) {
+		uint16_t n = core.serial.read(data, sizeof(data));
+		if (n > 0)
+			core.remote.receive(data, n);
+		else if (core.serial.lost())						// The receive ring was full, the frame being received is broken
+			core.remote.lost();
+		else
+			break;
 	}
-	return TIM2->ARR+1;										// This value is bigger than TIM2 period, the TIM2 has not been synchronized
+	core.remote.poll();
+}
+#endif
+
+// Put the telemetry record of the unit, called from interrupt handlers
+static void tlogPush(t_tlog_dev dev, UNIT *pUnit, uint16_t raw, uint16_t temp, uint16_t power, uint16_t current) {
+	t_tlog_rec rec;
+	int32_t kp, ki, kd;										// The record is packed, the terms are not aligned there
+	rec.ms		= HAL_GetTick();
+	rec.dev		= dev;
+	rec.flags	= pUnit->terms(&kp, &ki, &kd)?TLOG_PID:0;
+	rec.kp		= kp;
+	rec.ki		= ki;
+	rec.kd		= kd;
+	rec.raw		= raw;
+	rec.temp	= temp;
+	rec.preset	= pUnit->presetTemp();
+	rec.power	= power;
+	rec.current	= current;
+	rec.ambient	= raw_ambient;
+	rec.reserved = 0;
+	core.tlog.push(rec);
 }
 
 bool confirm(void) {
@@ -108,9 +324,7 @@ bool confirm(void) {
 		}
 		if (core.g_enc.buttonStatus() > 0)
 			return answer == 0;
-		if (core.dspl.BRGT::adjust()) {						// Adjust display brightness
-			HAL_Delay(5);
-		}
+		core.dspl.BRGT::adjust();							// Start the display brightness fade
 	}
 	return false;
 }
@@ -139,8 +353,17 @@ extern "C" void setup(void) {
 	HAL_TIM_OC_Start_IT(&htim2, TIM_CHANNEL_3);				// Check the current through the IRON and FAN, also check ambient temperature
 	HAL_TIM_OC_Start_IT(&htim2, TIM_CHANNEL_4);				// Calculate power of the IRON
 	HAL_TIM_PWM_Start(&htim4,   TIM_CHANNEL_4);				// PWM signal for the buzzer
-	gtim_period.length(10);
-	gtim_period.reset(1000);								// Default TIM1 period, ms
+	acStart();												// Track AC zero-crosses and synchronize TIM2 to AC power
+	core.sched.addTask(checkSwitches, check_sw_period);
+	core.sched.addTask(adjustBrightness, brightness_period);
+	core.sched.addTask(saveTelemetry, tlog_period);
+#ifdef SERIAL_PORT
+	core.serial.init();
+	core.tstream.init(&core.serial);
+	core.tlog.setSink(streamTelemetry);
+	core.remote.init(&station_rc, remoteWrite);
+	core.sched.addTask(remoteControl, remote_period);
+#endif
 
 	// Setup main mode parameters: return mode, short press mode, long press mode
 	work.setup(&main_menu, &iselect, &main_menu);
@@ -185,24 +408,24 @@ extern "C" void setup(void) {
 			break;
 	}
 
-	syncAC();												// Synchronize TIM2 timer to AC power
 	HAL_Delay(200);											// Wait till hardware status updated
 	uint8_t br = core.cfg.getDsplBrightness();
 	core.dspl.BRGT::set(br);
 	//core.dspl.BRGT::on()								 	// Tuurn-on the display backlight immediately. Also, comment-out the BRGT::off(); line in void DSPL::clear()
+#ifdef SERIAL_PORT
+	core.dspl.BRGT::on();									// The TILT and REED switch inputs are the serial port pins, warn the user
+	core.dspl.debugMessage("Serial port build:", 10, 60, 300);
+	core.dspl.debugMessage("TILT & REED switches off", 10, 90, 300);
+	HAL_Delay(2000);
+	core.dspl.clear();
+#endif
 	pMode->init();
 }
 
 extern "C" void loop(void) {
-	static uint32_t AC_check_time = 0;						// Time in ms when to check TIM1 is running
-	static uint32_t	check_sw	  = 0;						// Time when check iron switches status (ms)
-	if (HAL_GetTick() > check_sw) {
-		check_sw = HAL_GetTick() + check_sw_period;
-		GPIO_PinState pin = HAL_GPIO_ReadPin(TILT_SW_GPIO_Port, TILT_SW_Pin);
-		core.iron.updateReedStatus(GPIO_PIN_SET == pin);		// Update T12 TILT switch status
-		pin = HAL_GPIO_ReadPin(REED_SW_GPIO_Port, REED_SW_Pin);
-		core.hotgun.updateReedStatus(GPIO_PIN_SET == pin);	// Switch active when the Hot Air Gun handle is off-hook
-	}
+	core.sched.runTasks();
+	uint32_t ev = core.sched.takeEvents();
+	if (ev) pMode->events(ev);								// The mode reads the hardware status by itself, the events speed up the response
 	MODE* new_mode = pMode->returnToMain();
 	if (new_mode && new_mode != pMode) {
 		core.buzz.doubleBeep();
@@ -223,17 +446,7 @@ extern "C" void loop(void) {
 		pMode->init();
 	}
 
-	// If TIM1 counter has been changed since last check, we received AC_ZERO events from AC power
-	if (HAL_GetTick() >= AC_check_time) {
-		ac_sine		= (TIM1->CNT != tim1_cntr);
-		tim1_cntr	= TIM1->CNT;
-		AC_check_time = HAL_GetTick() + 41;					// 50Hz AC line generates 100Hz events. The pulse period is 10 ms
-	}
-
-	// Adjust display brightness
-	if (core.dspl.BRGT::adjust()) {
-		HAL_Delay(5);
-	}
+	core.sched.sleep();										// Wait for the next interrupt if nothing to do
 }
 
 static bool adcStart(t_ADC_mode mode) {
@@ -249,22 +462,21 @@ static bool adcStart(t_ADC_mode mode) {
 
 /*
  * IRQ handler
+ * on TIM1 Output channel #2 on every AC zero-cross
  * on TIM1 Output channel #3 to calculate required power for Hot Air Gun
  * on TIM2 Output channel #3 to read the current through the IRON and Fan of Hot Air Gun
- * also check that TIM1 counter changed driven by AC_ZERO interrupt
  * on TIM2 Output channel #4 to read the IRON, HOt Air Gun and ambient temperatures
  */
 extern "C" void HAL_TIM_OC_DelayElapsedCallback(TIM_HandleTypeDef *htim) {
-	if (htim->Instance == TIM1 && htim->Channel == HAL_TIM_ACTIVE_CHANNEL_3) {
+	if (htim->Instance == TIM1 && htim->Channel == HAL_TIM_ACTIVE_CHANNEL_2) {
+		acZeroCross();
+	} else if (htim->Instance == TIM1 && htim->Channel == HAL_TIM_ACTIVE_CHANNEL_3) {
 		uint16_t gun_power	= core.hotgun.power();
 		TIM1->CCR4	= constrain(gun_power, 0, max_gun_pwm);	// Apply Hot Air Gun power
-		uint32_t n = HAL_GetTick();
-		if (ac_sine && gtim_last_ms > 0) {
-			gtim_period.update(n - gtim_last_ms);
-		}
-		gtim_last_ms = n;
+		tlogPush(TLOG_GUN, &core.hotgun, raw_gun_temp, core.hotgun.averageTemp(), TIM1->CCR4, raw_fan_curr);
 	} else if (htim->Instance == TIM2) {
 		if (htim->Channel == HAL_TIM_ACTIVE_CHANNEL_3) {
+			TIM2->CCR4 = core.iron.tempPoint(TIM2->ARR);	// The TIM2 period follows AC phase, move the temperature reading point with it
 			if (TIM2->CCR1 || TIM2->CCR2)					// If IRON of Hot Air Gun has been powered
 				adcStart(ADC_CURRENT);
 		} else if (htim->Channel == HAL_TIM_ACTIVE_CHANNEL_4) {
@@ -273,6 +485,16 @@ extern "C" void HAL_TIM_OC_DelayElapsedCallback(TIM_HandleTypeDef *htim) {
 	}
 }
 
+/*
+ * IRQ handler on TIM4 update event, counts the buzzer tone duration
+ */
+extern "C" void HAL_TIM_PeriodElapsedCallback(TIM_HandleTypeDef *htim) {
+	if (htim->Instance == TIM4)
+		BUZZER::tick();
+	else if (htim->Instance == TFT_TIM.Instance)
+		core.dspl.BRGT::fadeTick();
+}
+
 /*
  * IRQ handler of ADC complete request. The data is in the ADC buffer (buff)
  * Data read by 5 slots: adc1-rank1, adc1-rank2, ..., adc1-rank5
@@ -287,26 +509,30 @@ extern "C" void HAL_ADC_ConvCpltCallback(ADC_HandleTypeDef* hadc) {
 	if (hadc->Instance != ADC1) return;
 	HAL_ADC_Stop_DMA(&hadc1);
 	if (adc_mode == ADC_TEMP) {								// Read the temperatures only, the current should be ignored
-		volatile uint32_t iron_temp	= 0;
+		uint16_t tim2_cnt = TIM2->CNT;						// The measurement window checks the ADC has finished before TIM2 period end
+		uint16_t iron_smpl[ADC_LOOPS];						// The IRON temperature samples are checked by the measurement window
 		volatile uint32_t gun_temp	= 0;
 		volatile uint32_t ambient 	= 0;
 		for (uint8_t i = 0; i < ADC_BUFF_SZ; i += ADC_CONV) {
-			iron_temp	+= buff[i+2];
+			iron_smpl[i/ADC_CONV] = buff[i+2];
 			gun_temp	+= buff[i+3];
 			ambient		+= buff[i+4];
 		}
-		iron_temp 	+= ADC_LOOPS/2;							// Round the result
-		iron_temp 	/= ADC_LOOPS;
+		uint16_t iron_temp = core.iron.measure(iron_smpl, ADC_LOOPS, TIM2->CCR1, tim2_cnt);	// TIM2->CCR1 is the power of the finished period
 		gun_temp 	+= ADC_LOOPS/2;							// Round the result
 		gun_temp  	/= ADC_LOOPS;
 		ambient 	+= ADC_LOOPS/2;							// Round the result
 		ambient  	/= ADC_LOOPS;
 		core.updateAmbient(ambient);
+		raw_gun_temp	= gun_temp;
+		raw_ambient		= ambient;
 
 		// Apply power to iron
 		uint16_t iron_power = core.iron.power(iron_temp);
 		TIM2->CCR1	= iron_power;
+		tlogPush(TLOG_IRON, &core.iron, iron_temp, core.iron.temp(), iron_power, raw_iron_curr);
 		core.hotgun.updateTemp(gun_temp);					// Update average Hot Air Gun temperature. Apply the power by TIM1.CNANNEL3 interrupt
+		SCHED::signal(EV_TEMP);
 	} else if (adc_mode == ADC_CURRENT) {					// Read the currents, the temperatures should be ignored
 		volatile uint32_t iron_curr	= 0;
 		volatile uint32_t fan_curr 	= 0;
@@ -319,6 +545,8 @@ extern "C" void HAL_ADC_ConvCpltCallback(ADC_HandleTypeDef* hadc) {
 		fan_curr	+= ADC_LOOPS/2;							// Round the result
 		fan_curr	/= ADC_LOOPS;
 
+		raw_iron_curr	= iron_curr;
+		raw_fan_curr	= fan_curr;
 		if (TIM2->CCR1)										// If IRON has been powered
 			core.iron.updateCurrent(iron_curr);
 		if (TIM2->CCR2)										// If Hot Air Gun Fan has been powered
@@ -332,16 +560,42 @@ extern "C" void HAL_ADC_LevelOutOfWindowCallback(ADC_HandleTypeDef *hadc) 	{ }
 
 // Iron Encoder Rotated
 extern "C" void EXTI0_IRQHandler(void) {
+	MEM_IrqEnter();
 	if(__HAL_GPIO_EXTI_GET_IT(I_ENC_L_Pin) != RESET) {
 	    core.i_enc.encoderIntr();
+	    SCHED::signal(EV_ENCODER);
 		__HAL_GPIO_EXTI_CLEAR_IT(I_ENC_L_Pin);
 	}
+	MEM_IrqLeave();
 }
 
 // Hot Air Gun Encoder Rotated
 extern "C" void EXTI1_IRQHandler(void) {
+	MEM_IrqEnter();
 	if(__HAL_GPIO_EXTI_GET_IT(G_ENC_L_Pin) != RESET) {
 		core.g_enc.encoderIntr();
+		SCHED::signal(EV_ENCODER);
 		__HAL_GPIO_EXTI_CLEAR_IT(G_ENC_L_Pin);
 	}
+	MEM_IrqLeave();
+}
+
+// Iron Encoder button changed
+extern "C" void EXTI9_5_IRQHandler(void) {
+	MEM_IrqEnter();
+	if(__HAL_GPIO_EXTI_GET_IT(I_ENC_B_Pin) != RESET) {
+		core.i_enc.buttonIntr();
+		__HAL_GPIO_EXTI_CLEAR_IT(I_ENC_B_Pin);
+	}
+	MEM_IrqLeave();
+}
+
+// Hot Air Gun Encoder button changed
+extern "C" void EXTI15_10_IRQHandler(void) {
+	MEM_IrqEnter();
+	if(__HAL_GPIO_EXTI_GET_IT(G_ENC_B_Pin) != RESET) {
+		core.g_enc.buttonIntr();
+		__HAL_GPIO_EXTI_CLEAR_IT(G_ENC_B_Pin);
+	}
+	MEM_IrqLeave();
 }
@@ -14,6 +14,13 @@
  *		Added DSPL::drawButtonStatus()
  * 2024 OCT 12
  * 		Added IPS display support to DSPL::init()
+ * 2026 OCT 18
+ * 		DSPL::directoryShow() draws the page of the entry names prepared by the caller
+ * 		The error message buffer is allocated in the display memory pool
+ * 		Added DSPL::memoryShow() to display heap and stack usage in the debug mode
+ * 		BRGT::adjust() starts the brightness fade that runs in TIM3 update interrupt, BRGT::fadeTick()
+ * 		DSPL::memoryShow() shows the font cache hits, misses and glyph read time
+ * 		DSPL::pidStart() limits the graph pixmap by the largest memory pool block
  */
 
 #include <string.h>
@@ -22,6 +29,7 @@
 #include <math.h>
 #include "display.h"
 #include "tools.h"
+#include "pool.h"
 #include "main.h"					// to ensure rebuild the creation date
 
 static const uint8_t bmDegree[] = {
@@ -220,23 +228,71 @@ static const char* k_proto[3] = {
 	"Kd = %5d"
 };
 
+const uint16_t BRGT::gamma_ramp[33] = {
+	0, 0, 2, 6, 11, 17, 26, 36, 49, 63, 79, 98, 118, 141, 166, 193,
+	223, 255, 289, 325, 364, 405, 449, 495, 544, 595, 649, 705, 763, 825, 888, 955,
+	1024
+};
+
+/*
+ * The fade duration from the current brightness to the setup one.
+ * With gamma corrected ramp the brightness changes uniformly for the eye
+ */
+void BRGT::setFade(uint16_t duration_ms, bool gamma) {
+	f_duration	= duration_ms;
+	f_gamma		= gamma;
+}
+
+/*
+ * Start the fade to the setup brightness if it differs from the current one.
+ * Does not block, returns true while the fade is running
+ */
 bool BRGT::adjust(void) {
-	if (brightness > TFT_TIM.Instance->CCR1) {
-		if (brightness - TFT_TIM.Instance->CCR1 > 8) {
-			TFT_TIM.Instance->CCR1 += 8;
-		} else {
-			++TFT_TIM.Instance->CCR1;
-		}
-		return true;
-	} else if (brightness < TFT_TIM.Instance->CCR1) {
-		if (TFT_TIM.Instance->CCR1 - brightness > 8) {
-			TFT_TIM.Instance->CCR1 -= 8;
-		} else {
-			--TFT_TIM.Instance->CCR1;
-		}
-		return true;
+	uint8_t br = get();
+	if (fading && f_to == brightness) return true;
+	if (br == brightness) return false;
+	if (f_duration == 0) {
+		on();
+		return false;
 	}
-	return false;
+	fading	= false;										// Stop the previous fade
+	f_from	= br;
+	f_to	= brightness;
+	f_start	= HAL_GetTick();
+	fading	= true;
+	__HAL_TIM_CLEAR_FLAG(&TFT_TIM, TIM_FLAG_UPDATE);
+	__HAL_TIM_ENABLE_IT(&TFT_TIM, TIM_IT_UPDATE);
+	return true;
+}
+
+// Map the perceived brightness position p (0-1024) to the PWM position (0-1024)
+uint16_t BRGT::ramp(uint16_t p) {
+	if (!f_gamma) return p;
+	uint8_t i = p >> 5;
+	if (i >= 32) return 1024;
+	uint16_t f = p & 0x1f;
+	return gamma_ramp[i] + ((gamma_ramp[i+1] - gamma_ramp[i]) * f >> 5);
+}
+
+// Called from TIM3 update interrupt, changes the brightness till the end of the fade
+void BRGT::fadeTick(void) {
+	if (!fading) {
+		__HAL_TIM_DISABLE_IT(&TFT_TIM, TIM_IT_UPDATE);
+		return;
+	}
+	uint32_t t = HAL_GetTick() - f_start;
+	if (t >= f_duration) {
+		TFT_TIM.Instance->CCR1 = f_to;
+		fading = false;
+		__HAL_TIM_DISABLE_IT(&TFT_TIM, TIM_IT_UPDATE);
+		return;
+	}
+	uint16_t x	= t * 1024 / f_duration;					// The fade progress
+	bool up		= f_to > f_from;
+	uint8_t lo	= up?f_from:f_to;
+	uint8_t hi	= up?f_to:f_from;
+	uint16_t g	= ramp(up?x:1024-x);						// The position between low and high brightness
+	TFT_TIM.Instance->CCR1 = lo + (((uint32_t)(hi - lo) * g) >> 10);
 }
 
 void DSPL::init(bool ips) {
@@ -649,40 +705,30 @@ void DSPL::menuShow(t_msg_id menu_id, uint8_t item, const char* value, bool modi
 	}
 }
 
-void DSPL::directoryShow(const std::vector<std::string> &dir_list, uint16_t item) {
+// Show the visible part of the directory list: names[0] is at the top of the screen, names[selected] is highlighted
+void DSPL::directoryShow(const char* const names[], uint8_t items, uint8_t selected) {
 	static const uint8_t left  = 50;
-	static const uint8_t max_items = 6;
 
-	uint16_t dir_size = dir_list.size();
-	if (dir_size < item) return;
+	if (items > dir_lines) items = dir_lines;
 	setFont(letter_font);
 	uint8_t  h		= getMaxCharHeight() + 10;				// Extra space between menu lines
 	uint16_t top	= h+12;
 	BITMAP bm_menu(width()-2*left, getMaxCharHeight());		// Bitmap to show the menu item (about full screen)
 	// Show the menu list
-	int8_t first = item;
-	uint16_t remains = dir_size - item;
-	if (remains < max_items)
-		first = (int16_t)dir_size - (int16_t)max_items;
-	if (first < 0) first = 0;
-	uint8_t items = ((dir_size - first) >= max_items)?max_items:(dir_size-first);
 	for (uint8_t i = 0; i < items; ++i) {
-		uint8_t menu_index = first + i;
 		bm_menu.clear();
 		uint16_t y = h*i+top;
 		uint16_t bg = bg_color;
 		uint16_t fg = fg_color;
-		if (menu_index <= dir_size) {
-			strToBitmap(bm_menu, dir_list[menu_index].c_str(), align_left, 10, true);
-			if (menu_index == item) {						// Mark active menu item
-				bg = fg_color;								// Inverse colors
-				fg = bg_color;
-			}
+		strToBitmap(bm_menu, names[i], align_left, 10, true);
+		if (i == selected) {								// Mark active menu item
+			bg = fg_color;									// Inverse colors
+			fg = bg_color;
 		}
 		drawBitmap(left, y, bm_menu, bg, fg);
 	}
 	// Clear extra line under menu list
-	if (items < max_items) {
+	if (items < dir_lines) {
 		drawFilledRect(left, h*items+top, bm_menu.width(), h, bg_color);
 	}
 }
@@ -859,10 +905,17 @@ bool DSPL::pidStart(void) {
 	if ((t_height & 1) == 0) t_height--;					// Ensure the graph height is odd to draw abscissa coordinate axis
 
 	uint16_t data_size = width() - bm_preset.width() - 54;
+	// The graph pixmap must fit the largest block of the memory pool, shorten the graph if the letter font is small
+	while (data_size > 0 && PIXMAP::memSize(data_size, t_height, 2) > TFT_POOL_MAX_BLOCK)
+		--data_size;
 	if (GRAPH::allocate(data_size)) {
 		// Allocate space for graph pixmap
 		if (pm_graph.width() == 0) {
 			pm_graph = PIXMAP(data_size, t_height, 2);		// Depth is 2 bits, 4-color graph
+			if (pm_graph.width() == 0) {					// The pool block is busy
+				GRAPH::freeData();
+				return false;
+			}
 			uint16_t g_colors[4] = { bg_color, fg_color, gd_color, dp_color};
 			pm_graph.setupPalette(g_colors, 4);
 		}
@@ -1044,7 +1097,7 @@ void DSPL::errorMessage(t_msg_id err_id, uint16_t y) {
 		setFont(letter_font);
 		uint16_t h	= getMaxCharHeight() + 5;
 		uint8_t len = strlen(msg);
-		char *err_msg = (char*)malloc(len+1);
+		char *err_msg = (char*)TFT_PoolAlloc(len+1);
 		if (!err_msg)
 			return;
 		strcpy(err_msg, msg);
@@ -1070,7 +1123,7 @@ void DSPL::errorMessage(t_msg_id err_id, uint16_t y) {
 				err_msg[finish] = '\n';
 			start = finish + 1;
 		}
-		free(err_msg);
+		TFT_PoolFree(err_msg);
 	}
 }
 
@@ -1172,6 +1225,46 @@ void DSPL::debugShow(uint16_t data[9], bool iron_on, bool gun_on, bool iron_conn
 	drawScrolledBitmap(10, top+6*h, bm.width(), bm, 0, 0, bg_color, fg_color);
 }
 
+void DSPL::memoryShow(t_mem_stat &st, uint32_t pool_failures, uint32_t pool_oversized, uint8_t idle, uint32_t latency, FONT_CACHE *fc) {
+	static const char *item_name[15] = {
+			"heap:",											// Allocated heap bytes
+			"hpk.:",											// Heap peak size
+			"frag:",											// Free bytes inside the heap
+			"allc:",											// Live allocations
+			"sbrk:",											// Refused heap requests
+			"idle:",											// Main loop idle time, percent
+			"fhit:",											// Glyphs found in the font cache
+			"fmis:",											// Glyphs read from the flash
+			"stck:",											// Stack high-water mark
+			"lfre:",											// The largest block malloc() can return
+			"irq :",											// Maximum interrupt nesting depth
+			"pool:",											// Refused display pool requests
+			"big :",											// Refused display buffers bigger than the largest pool block
+			"lat.:",											// Maximum event response latency, mks
+			"frd :"												// Total glyph read time, ms
+	};
+	bool font_cache = fc && fc->isOpen();
+	uint32_t data[15] = { st.heap_used, st.heap_peak, st.heap_free, st.allocs, st.sbrk_fails, idle,
+						  font_cache?fc->hits():0, font_cache?fc->misses():0,
+						  st.stack_peak, st.largest_free, st.irq_depth, pool_failures, pool_oversized, latency,
+						  font_cache?fc->readTime():0 };
+	char buff[10];
+	setFont(debug_font);
+	uint8_t  h		= getMaxCharHeight() + 5;							// Extra space between menu lines
+	uint16_t top	= h+12;
+	BITMAP bm(width()/2-40, getMaxCharHeight());
+	for (uint8_t i = 0; i < 15; ++i) {
+		bm.clear();
+		uint32_t v = data[i];
+		if (v > 99999) v = 99999;
+		sprintf(buff, "%5u", (unsigned int)v);
+		strToBitmap(bm, item_name[i], align_left);
+		strToBitmap(bm, buff, align_right);
+		uint16_t x = (i < 8)?10:width()/2+10;					// 8 lines in the left column, 7 lines in the right one
+		drawScrolledBitmap(x, top+(i%8)*h, bm.width(), bm, 0, 0, bg_color, fg_color);
+	}
+}
+
 void DSPL::debugMessage(const char *msg, uint16_t x, uint16_t y, uint16_t len) {
 	setFont(letter_font);
 	uint8_t  h	= getMaxCharHeight();
@@ -6,6 +6,12 @@
  *
  *  2024 OCT 09, v.1.15
  *  	Added RENC::intNuber() method that used in debug mode
+ *  2026 OCT 18
+ *  	RENC::encoderIntr() does not change the position, it puts the detent event into the queue.
+ *  	RENC::read() takes the events and calculates the increment from the rotation velocity
+ *  	The button is debounced and classified in RENC::buttonTick(), RENC::buttonStatus() reads the event queue
+ *  	RENC::reset() discards the button events made in the previous context
+ *  	The double press is detected only if it is enabled by RENC::setButtonTiming(), otherwise the short press is reported at once
  */
 
 #include "encoder.h"
@@ -15,7 +21,6 @@ RENC::RENC(GPIO_TypeDef* aPORT, uint16_t aPIN, GPIO_TypeDef* bPORT, uint16_t bPI
 	m_port 			= aPORT; s_port = bPORT; m_pin = aPIN; s_pin = bPIN;
 	pos 			= 0;
 	min_pos 		= -32767; max_pos = 32766; increment = 1;
-	changed 		= 0;
 	s_up			= false;
 	is_looped		= false;
 	increment		= fast_increment = 1;
@@ -26,10 +31,14 @@ void RENC::addButton(GPIO_TypeDef* ButtonPORT, uint16_t ButtonPIN) {
 	b_port 		= ButtonPORT;
 	b_pin  		= ButtonPIN;
 	over_press	= def_over_press;
-	avg.length(avg_length);
+	b_on		= (GPIO_PIN_RESET == HAL_GPIO_ReadPin(b_port, b_pin));
+	i_b_rel		= b_on;										// Ignore the button pressed at power on
 }
 
 void RENC::reset(int16_t initPos, int16_t low, int16_t upp, uint8_t inc, uint8_t fast_inc, bool looped) {
+	flush();												// Forget the rotation made in the previous context
+	b_tail	= b_head;										// Forget the button events too
+	b_flush	= true;											// The press in progress will be ignored by buttonTick()
 	min_pos = low; max_pos = upp;
 	if (!write(initPos)) initPos = min_pos;
 	increment = fast_increment = inc;
@@ -42,51 +51,153 @@ void RENC::reset(int16_t initPos, int16_t low, int16_t upp, uint8_t inc, uint8_t
  * 0	- not pressed
  * 1	- short press
  * 2	- long press
+ * 3	- double press, if enabled by setButtonTiming()
+ * The events are classified in buttonTick(), the events older than over press timeout are discarded
  */
 uint8_t	RENC::buttonStatus(void) {
-	if (HAL_GetTick() >= b_check) {							// It is time to check the button status
-		b_check = HAL_GetTick() + b_check_period;
-		uint8_t s = 0;
-		if (GPIO_PIN_RESET == HAL_GPIO_ReadPin(b_port, b_pin))	// if port state is low, the button pressed
-			s = trigger_on << 1;
-		if (b_on) {
-			if (avg.average(s) < trigger_off)
-				b_on = false;
-		} else {
-			if (avg.average(s) > trigger_on)
-				b_on = true;
+	while (b_tail != b_head) {
+		uint8_t  e	= b_ev[b_tail];
+		uint32_t t	= b_ev_time[b_tail];
+		b_tail		= (b_tail + 1) & (b_queue_size - 1);
+		if (HAL_GetTick() - t < over_press) {
+			b_time	= t;
+			return e;
 		}
+	}
+    return 0;
+}
 
-		if (b_on) {                                        	// Button status is 'pressed'
-			uint32_t n = HAL_GetTick() - bpt;
-			if ((bpt == 0) || (n > over_press)) {
-				bpt = HAL_GetTick();
-			} else if (n > long_press) {                    // Long press
-				if (i_b_rel) {
-					return 0;
-				} else{
-					i_b_rel = true;
-					return 2;
+/*
+ * long_ms		- the press time of the long press, 0 - keep current value
+ * double_ms	- the maximum pause between two short presses of the double press, 0 - double press disabled.
+ * When the double press is enabled, the single short press is reported after this pause
+ */
+void RENC::setButtonTiming(uint16_t long_ms, uint16_t double_ms) {
+	if (long_ms > 0 && long_ms < over_press) long_press = long_ms;
+	double_press = double_ms;
+}
+
+// Interrupt function, called when the button pin changed
+void RENC::buttonIntr(void) {
+	uint32_t now_t = HAL_GetTick();
+	if (!b_pend) b_first = now_t;
+	b_edge	= now_t;
+	b_pend	= true;
+}
+
+/*
+ * Called every 1 ms from SysTick interrupt. The button status is accepted when the pin is stable b_debounce ms.
+ * Returns true if new button event was queued
+ */
+bool RENC::buttonTick(uint32_t now) {
+	if (!b_port) return false;
+	uint8_t head = b_head;
+	if (b_flush) {
+		b_flush	= false;
+		b_short	= 0;										// Forget the first press of the double press too
+		i_b_rel	= b_on;										// The button is pressed now, ignore its release
+	}
+	if (b_pend && now - b_edge >= b_debounce) {
+		b_pend		= false;
+		uint32_t t	= b_first;
+		bool on = (GPIO_PIN_RESET == HAL_GPIO_ReadPin(b_port, b_pin));
+		if (on != b_on) {
+			b_on = on;
+			if (on) {										// The button has been pressed
+				bpt		= t;
+				i_b_rel	= false;
+			} else if (!i_b_rel && (t - bpt) < over_press) {// Short press, long press already managed
+				if (double_press == 0) {
+					buttonEvent(1, t);
+				} else if (b_short && (bpt - b_short) <= double_press) {
+					buttonEvent(3, t);
+					b_short = 0;
+				} else {
+					if (b_short) buttonEvent(1, b_short);	// The pause was too long
+					b_short = t;							// Wait for the second press
 				}
 			}
-		} else {                                            // Button status is 'not pressed'
-			if (bpt == 0 || i_b_rel) {
-				bpt = 0;
-				i_b_rel = false;
-				return 0;
-			}
-			uint32_t e = HAL_GetTick() - bpt;
-			bpt = 0;										// Ready for next press
-			if (e < over_press) {							// Long press already managed
-				return 1;
-			}
 		}
 	}
-    return 0;
+	if (b_on && !i_b_rel && (now - bpt) > long_press && (now - bpt) < over_press) {
+		if (b_short) {										// The short press before the long one
+			buttonEvent(1, b_short);
+			b_short = 0;
+		}
+		buttonEvent(2, now);
+		i_b_rel = true;
+	}
+	if (b_short && !b_on && !b_pend && (now - b_short) > double_press) {
+		buttonEvent(1, b_short);							// No second press
+		b_short = 0;
+	}
+	return head != b_head;
+}
+
+void RENC::buttonEvent(uint8_t event, uint32_t t) {
+	uint8_t h = (b_head + 1) & (b_queue_size - 1);
+	if (h == b_tail) return;								// The queue is full, the main loop does not check the button
+	b_ev[b_head]		= event;
+	b_ev_time[b_head]	= t;
+	b_head				= h;
+}
+
+/*
+ * The acceleration curve: the increment is used when velocity is below slow detents per second,
+ * the fast_increment is used above fast detents per second, between them the increment grows by square law
+ */
+void RENC::setAcceleration(uint8_t slow, uint8_t fast) {
+	if (fast <= slow) return;
+	v_slow	= slow;
+	v_fast	= fast;
+}
+
+// Calculate the increment of the detent made at time t using sliding window of the latest detents
+uint8_t RENC::step(uint32_t t, bool up) {
+	if (win_num == 0 || up != win_up || t - win[win_num-1] > win_timeout) {
+		win_num = 0;										// Direction changed or rotation paused, restart the window
+		win_up	= up;
+	}
+	if (win_num == win_size) {								// Slide the window
+		for (uint8_t i = 1; i < win_size; ++i)
+			win[i-1] = win[i];
+		--win_num;
+	}
+	win[win_num++] = t;
+	if (fast_increment <= increment || win_num < 2) return increment;
+	uint32_t span = win[win_num-1] - win[0];
+	if (span == 0) span = 1;
+	uint32_t v = (win_num-1) * 1000 / span;					// Detents per second
+	if (v <= v_slow) return increment;
+	if (v >= v_fast) return fast_increment;
+	uint32_t num = v - v_slow;
+	uint32_t den = v_fast - v_slow;
+	uint8_t inc = increment + (fast_increment - increment) * num * num / (den * den);
+	if (increment > 1) inc -= inc % increment;				// Keep the position multiple of the increment
+	return inc;
+}
+
+// Apply the queued detents to the position
+int16_t RENC::read(void) {
+	while (q_tail != q_head) {
+		uint32_t e	= queue[q_tail];
+		q_tail		= (q_tail + 1) & (queue_size - 1);
+		bool up		= e & 1;
+		int16_t inc	= step(e >> 1, up);
+		int32_t p	= pos + (up?inc:-inc);
+		if (p > max_pos) {
+			p = (is_looped)?min_pos:max_pos;
+		} else if (p < min_pos) {
+			p = (is_looped)?max_pos:min_pos;
+		}
+		pos = p;
+	}
+	return pos;
 }
 
 bool RENC::write(int16_t initPos)	{
 	if ((initPos >= min_pos) && (initPos <= max_pos)) {
+		flush();
 		pos		= initPos;
 		return true;
 	}
@@ -104,16 +215,14 @@ void RENC::encoderIntr(void) {								// Interrupt function, called when the cha
 	} else {
 		if (rpt > 0) {
 			if (s_up == (HAL_GPIO_ReadPin(s_port, s_pin) == GPIO_PIN_RESET)) {	// Secondary channel polarity has been changed
-				uint8_t inc = increment;
 				if ((now_t - rpt) < over_press) {
-					if ((now_t - changed) < fast_timeout) inc = fast_increment;
-						changed = now_t;
-						if (s_up == clockwise) pos -= inc; else pos += inc;
-						if (pos > max_pos) {
-							pos = (is_looped)?min_pos:max_pos;
-						} else if (pos < min_pos) {
-							pos = (is_looped)?max_pos:min_pos;
-						}
+					uint8_t h = (q_head + 1) & (queue_size - 1);
+					if (h == q_tail) {						// The queue is full
+						++lost;
+					} else {
+						queue[q_head] = (now_t << 1) | ((s_up == clockwise)?0:1);
+						q_head = h;
+					}
 				}
 			}
 			rpt = 0;
@@ -5,32 +5,97 @@
  * 2024 MAR 28
  *     Changed W25Q::init(). In case if no cfg file read, do not unmount the FLASH
  *     Added comments to the W25Q::formatFlashDrive()
+ * 2026 OCT 18
+ *     Added W25Q::loadTipChunk() to read the tip calibration file by big chunks
+ *     W25Q::saveTipData() now writes the tip record into the known slot instead of looking for the tip name in the file
+ *     The configuration and tip records are checked by CRC32. Added W25Q::migrateTips() and W25Q::readRecord() to convert
+ *     the files of previous format
+ *     Fixed the tip calibration file size calculation in W25Q::backup()
+ *     W25Q::loadTipChunk() clears the name of the record with wrong CRC
+ *     W25Q::init() counts the tip records with correct CRC, the inactive and not calibrated tips as well
+ *     W25Q::migrateTips() decides the file format by the file size and by the correct records in the whole file
  */
 #include <string.h>
+#include <stddef.h>
 #include "flash.h"
 #include "W25Qxx.h"
+#include "tools.h"
 
 FATFS	fs;
 
+// The configuration record of version 0, the fields after crc are the same as in the current version
+typedef struct s_config_v0 {
+	uint16_t	crc;
+	uint16_t	iron_temp;
+	uint16_t	gun_temp;
+	uint16_t	gun_fan_speed;
+	uint16_t	iron_Kp, iron_Ki, iron_Kd;
+	uint16_t	gun_Kp,  gun_Ki,  gun_Kd;
+	uint16_t	low_temp;
+	uint8_t		low_to;
+	uint8_t		boost;
+	uint8_t		tip;
+	uint8_t		off_timeout;
+	uint16_t	bit_mask;
+	uint8_t		dspl_bright;
+	uint8_t		dspl_rotation;
+	char		language[LANG_LENGTH];
+} RECORD_V0;
+
+// The tip record of version 0
+typedef struct s_tip_v0 {
+	uint16_t	t200, t260, t330, t400;
+	uint8_t		mask;
+	char		name[tip_name_sz];
+	int8_t		ambient;
+	uint8_t		crc;
+} TIP_V0;
+
+static bool TIP_checkSumV0(TIP_V0* tip) {
+	uint32_t summ = tip->t200;
+	summ <<= 1; summ += tip->t260;
+	summ <<= 1; summ += tip->t330;
+	summ <<= 1; summ += tip->t400;
+	summ <<= 1; summ += tip->mask;
+	summ <<= 1; summ += tip->ambient;
+	for (int i = 0; i < tip_name_sz; ++i) {
+		summ <<= 1; summ += (uint8_t)tip->name[i];
+	}
+	summ += 117;
+	return (tip->crc == (summ & 0xFF));
+}
+
+static bool CFG_checkSumV0(RECORD_V0* cfg) {
+	uint16_t 	summ 		= 117;
+	uint16_t    rec_summ 	= cfg->crc;
+	cfg->crc				= 0;
+	uint8_t*	d 			= (uint8_t*)cfg;
+	for (uint8_t i = 0; i < sizeof(RECORD_V0); ++i) {
+		summ <<= 1; summ += d[i];
+	}
+	cfg->crc = rec_summ;
+	return (rec_summ == summ);
+}
+
 FLASH_STATUS W25Q::init(void) {
 	if (!W25Qxx_Init()) return FLASH_ERROR;
 	if (!mount())		return FLASH_NO_FILESYSTEM;
+	migrateTips();
 
 	uint16_t	good_tips = 0;
 	if (FR_OK == f_open(&cfg_f, fn_tip_calib, FA_READ)) {	// Check the tip calibration data
+		act_f = W25Q_TIPS_CURRENT;
+		TIP		chunk[tip_chunk_sz];
 		while (true) {										// Read all tip calibration data
-			UINT	br = 0;
-			TIP		tmp_tip;
-			f_read(&cfg_f, (void *)&tmp_tip, (UINT)sizeof(TIP), &br);
-			if (br ==  (UINT)sizeof(TIP)) {
-				if (TIP_checkSum(&tmp_tip, false)) {		// CRC of the tip record is correct
-					++good_tips;
-				}
-			} else {
+			uint8_t n = tip_chunk_sz;
+			if (loadTipChunk(chunk, &n, true) != TIP_OK || n == 0)
 				break;										// File is over
+			for (uint8_t i = 0; i < n; ++i) {
+				if (chunk[i].name[0] != '\0')				// CRC of the tip record is correct, loadTipChunk() clears the name of bad record
+					++good_tips;
 			}
 		}
-		f_close(&cfg_f);
+		close();
 	}
 	if (good_tips == 0) {									// Not tip loaded, try the backup file
 		FILINFO fno;
@@ -83,29 +148,20 @@ bool W25Q::loadRecord(RECORD* config_record) {
 	if (!mount())
 		return false;
 	W25Q::close();
-	UINT br = 0;
-	bool ret = false;
+	bool ret		= false;
+	bool converted	= false;
 	RECORD tmp_record;
-	if (FR_OK == f_open(&cfg_f, fn_cfg, FA_READ | FA_OPEN_EXISTING)) {
-		f_read(&cfg_f, (void *)&tmp_record, (UINT)sizeof(RECORD), &br);
-		if (br ==  (UINT)sizeof(RECORD)) {
-			if (CFG_checkSum(&tmp_record, false)) {
-				memcpy((void *)config_record, (void *)&tmp_record, sizeof(RECORD));
-				ret = true;
-			}
-		}
-		f_close(&cfg_f);
+	if (readRecord(fn_cfg, &tmp_record, &converted)) {
+		memcpy((void *)config_record, (void *)&tmp_record, sizeof(RECORD));
+		ret = true;
 	}
 	if (!ret) {												// Failed to load configuration record from main file
-		if (FR_OK == f_open(&cfg_f, fn_cfg_backup, FA_READ | FA_OPEN_EXISTING)) {
-			f_read(&cfg_f, (void *)&tmp_record, (UINT)sizeof(RECORD), &br);
-			if (br == (UINT)sizeof(RECORD)) {
-				if (CFG_checkSum(&tmp_record, false)) {
-					memcpy((void *)config_record, (void *)&tmp_record, sizeof(RECORD));
-					ret = true;
-				}
+		FILINFO fno;
+		if (FR_OK == f_stat(fn_cfg_backup, &fno)) {
+			if (readRecord(fn_cfg_backup, &tmp_record, &converted)) {
+				memcpy((void *)config_record, (void *)&tmp_record, sizeof(RECORD));
+				ret = true;
 			}
-			f_close(&cfg_f);
 			if (ret) {										// Backup is valid, revert to the backup config
 				f_unlink(fn_cfg);
 				f_rename(fn_cfg_backup, fn_cfg);
@@ -114,10 +170,42 @@ bool W25Q::loadRecord(RECORD* config_record) {
 			}
 		}
 	}
+	if (ret && converted) {									// Rewrite the record of previous version in the current format
+		CFG_checkSum(config_record, true);
+		if (FR_OK == f_open(&cfg_f, fn_cfg, FA_CREATE_ALWAYS | FA_WRITE)) {
+			UINT written = 0;
+			f_write(&cfg_f, (void *)config_record, sizeof(RECORD), &written);
+			f_close(&cfg_f);
+		}
+	}
 	umount();
 	return ret;
 }
 
+// Read the configuration record from the file. The record of version 0 is converted to the current format
+bool W25Q::readRecord(const TCHAR *fn, RECORD *cfg, bool *converted) {
+	if (FR_OK != f_open(&cfg_f, fn, FA_READ | FA_OPEN_EXISTING))
+		return false;
+	UINT br = 0;
+	bool ret = false;
+	if (f_size(&cfg_f) == sizeof(RECORD)) {
+		f_read(&cfg_f, (void *)cfg, (UINT)sizeof(RECORD), &br);
+		ret = (br == (UINT)sizeof(RECORD)) && CFG_checkSum(cfg, false);
+	} else if (f_size(&cfg_f) == sizeof(RECORD_V0)) {
+		RECORD_V0 old;
+		f_read(&cfg_f, (void *)&old, (UINT)sizeof(RECORD_V0), &br);
+		if (br == (UINT)sizeof(RECORD_V0) && CFG_checkSumV0(&old)) {
+			memset((void *)cfg, 0, sizeof(RECORD));
+			memcpy((void *)&cfg->iron_temp, (void *)&old.iron_temp, sizeof(RECORD_V0) - offsetof(RECORD_V0, iron_temp));
+			cfg->version	= CFG_VERSION;
+			*converted		= true;
+			ret				= true;
+		}
+	}
+	f_close(&cfg_f);
+	return ret;
+}
+
 bool W25Q::saveRecord(RECORD* config_record) {
 	if (!mount())
 		return false;
@@ -165,43 +253,60 @@ TIP_IO_STATUS W25Q::loadTipData(TIP* tip, uint8_t tip_index, bool keep) {
 	return returnStatus(keep, TIP_IO);
 }
 
-// Return tip index in the file or -1 if error
-int16_t W25Q::saveTipData(TIP* tip, bool keep) {
-	if (!mount())
-		return -1;
-	bool new_entry = false;
-	if (act_f == W25Q_TIPS_CURRENT) {						// The tip configuration file is already opened
-		f_lseek(&cfg_f, 0);									// Rewind to the top of the file
-	} else {
-		W25Q::close();
-		backup(W25Q_TIPS_CURRENT);
-		if (FR_OK != f_open(&cfg_f, fn_tip_calib, FA_WRITE | FA_READ | FA_OPEN_EXISTING)) {
-			if (FR_OK == f_open(&cfg_f, fn_tip_calib, FA_CREATE_NEW | FA_WRITE)) {
-				new_entry = true;
-			} else {
-				return -1;
-			}
-
+/*
+ * Read next chunk of the tip calibration records from the current position of the file.
+ * Reads at most *n records by single f_read() call, updates *n by the actual number of records read.
+ * The record with incorrect CRC is returned with zero mask and empty name, so it does not match any tip
+ */
+TIP_IO_STATUS W25Q::loadTipChunk(TIP tip[], uint8_t *n, bool keep) {
+	if (!mount()) {
+		*n = 0;
+		return TIP_IO;
+	}
+	if (act_f != W25Q_TIPS_CURRENT) {						// Open the tip calibration file from the beginning
+		close();
+		if (FR_OK == f_open(&cfg_f, fn_tip_calib, FA_READ)) {
+			act_f = W25Q_TIPS_CURRENT;
 		}
-		act_f = W25Q_TIPS_CURRENT;
 	}
-	if (!new_entry) {										// Try to locate our tip in the file
-		UINT	br = 0;										// Bytes actually read from the file
-		TIP		tmp_tip;
-		while(true) {										// Looking for the tip
-			f_read(&cfg_f, (void *)&tmp_tip, (UINT)sizeof(TIP), &br);
-			if (br == (UINT)sizeof(TIP)) {
-				if (strncmp(tip->name, tmp_tip.name, tip_name_sz) == 0) {
-					f_lseek(&cfg_f, cfg_f.fptr-sizeof(TIP));
-					break;
-				}
-			} else {										// Tip not calibrated
-				break;
-			}
+	if (act_f != W25Q_TIPS_CURRENT) {
+		*n = 0;
+		return returnStatus(keep, TIP_IO);
+	}
+	UINT	br = 0;
+	if (FR_OK != f_read(&cfg_f, (void *)tip, (UINT)sizeof(TIP) * (*n), &br)) {
+		*n = 0;
+		return returnStatus(keep, TIP_IO);
+	}
+	*n = br / sizeof(TIP);									// Ignore incomplete record at the end of file
+	for (uint8_t i = 0; i < *n; ++i) {
+		if (!TIP_checkSum(&tip[i], false)) {
+			tip[i].mask		= 0;
+			tip[i].name[0]	= '\0';
 		}
 	}
+	return returnStatus(keep, TIP_OK);
+}
+
+/*
+ * Save tip record into the chunk of the file. If the chunk is outside of the file, append new record
+ * Return tip index in the file or -1 if error
+ */
+int16_t W25Q::saveTipData(TIP* tip, uint8_t chunk, bool keep) {
+	if (!mount())
+		return -1;
+	W25Q::close();											// The file can be opened for reading only
+	backup(W25Q_TIPS_CURRENT);
+	if (FR_OK != f_open(&cfg_f, fn_tip_calib, FA_WRITE | FA_READ | FA_OPEN_ALWAYS)) {
+		return -1;
+	}
+	act_f = W25Q_TIPS_CURRENT;
+	FSIZE_t	pos = (FSIZE_t)chunk * sizeof(TIP);
+	FSIZE_t	end = (f_size(&cfg_f) / sizeof(TIP)) * sizeof(TIP);	// Skip incomplete record at the end of file
+	if (pos > end) pos = end;								// New tip record
+	f_lseek(&cfg_f, pos);
 	// Update or add new tip information
-	int16_t tip_index = cfg_f.fptr / sizeof(TIP);
+	int16_t tip_index = pos / sizeof(TIP);
 	TIP_checkSum(tip, true);								// calculate CRC inside the data buffer
 	UINT	written = 0;
 	f_write(&cfg_f, (void *)tip, sizeof(TIP), &written);
@@ -266,35 +371,119 @@ TIP_IO_STATUS W25Q::returnStatus(bool keep, TIP_IO_STATUS ret_code) {
 	return ret_code;
 }
 
-// Checks the CRC inside tip structure. Returns true if OK, replaces the CRC with the correct value
-uint8_t W25Q::TIP_checkSum(TIP* tip, bool write) {
-	uint32_t summ = tip->t200;
-	summ <<= 1; summ += tip->t260;
-	summ <<= 1; summ += tip->t330;
-	summ <<= 1; summ += tip->t400;
-	summ <<= 1; summ += tip->mask;
-	summ <<= 1; summ += tip->ambient;
-	for (int i = 0; i < tip_name_sz; ++i) {
-		summ <<= 1; summ += (uint8_t)tip->name[i];
-	}
-	summ += 117;											// To avoid good check sum with all-zero
-	uint8_t res = (tip->crc == (summ & 0xFF));
-	if (write) tip->crc = summ & 0xFF;
+// Checks the CRC inside tip structure. Returns true if OK. Sets the version and the correct CRC if write is true
+bool W25Q::TIP_checkSum(TIP* tip, bool write) {
+	if (write) tip->version = TIP_VERSION;
+	uint32_t crc = crc32(0, tip, offsetof(TIP, crc));
+	bool res = (tip->version == TIP_VERSION && tip->crc == crc);
+	if (write) tip->crc = crc;
 	return res;
 }
 
-// Checks the CRC of the RECORD structure. Returns true if OK. Replace the CRC with the correct value if write is true
-uint8_t W25Q::CFG_checkSum(RECORD* cfg, bool write) {
-	uint16_t 	summ 		= 117;							// To avoid good check sum with all-zero, start with 117
-	uint16_t    rec_summ 	= cfg->crc;
-	cfg->crc				= 0;
-	uint8_t*	d 			= (uint8_t*)cfg;
-	for (uint8_t i = 0; i < sizeof(RECORD); ++i) {
-		summ <<= 1; summ += d[i];
+// Checks the CRC of the RECORD structure. Returns true if OK. Sets the version and the correct CRC if write is true
+bool W25Q::CFG_checkSum(RECORD* cfg, bool write) {
+	if (write) cfg->version = CFG_VERSION;
+	uint32_t rec_crc	= cfg->crc;
+	cfg->crc			= 0;
+	uint32_t crc		= crc32(0, cfg, sizeof(RECORD));
+	cfg->crc			= write?crc:rec_crc;
+	return (cfg->version == CFG_VERSION && rec_crc == crc);
+}
+
+/*
+ * Read the whole tip calibration file as the records of the current format (TIP, 20 bytes) and of version 0 (TIP_V0, 16 bytes)
+ * and count the records with correct checksum. The chunk size is a multiple of both record sizes
+ */
+void W25Q::tipVotes(FIL *f, uint16_t *tips, uint16_t *tips_v0) {
+	uint8_t	buff[tip_chunk_sz * sizeof(TIP)];
+	TIP		tip;
+	TIP_V0	old;
+	UINT	br	= 0;
+	*tips		= 0;
+	*tips_v0	= 0;
+	f_lseek(f, 0);
+	while (FR_OK == f_read(f, (void *)buff, sizeof(buff), &br) && br > 0) {
+		for (UINT pos = 0; pos + sizeof(TIP) <= br; pos += sizeof(TIP)) {
+			memcpy((void *)&tip, &buff[pos], sizeof(TIP));
+			if (TIP_checkSum(&tip, false)) ++*tips;
+		}
+		for (UINT pos = 0; pos + sizeof(TIP_V0) <= br; pos += sizeof(TIP_V0)) {
+			memcpy((void *)&old, &buff[pos], sizeof(TIP_V0));
+			if (TIP_checkSumV0(&old)) ++*tips_v0;
+		}
 	}
-	bool res = (rec_summ == summ);
-	if (write) cfg->crc = summ;
-	return res;
+	f_lseek(f, 0);
+}
+
+/*
+ * Convert the tip calibration file of version 0 to the current format. The record order is preserved,
+ * the record with incorrect checksum is converted to the empty record. The old backup file is removed.
+ * The format is decided by the file size and by the number of correct records of each format in the whole file:
+ * the 8-bit checksum of version 0 matches a random record once in 256, so the first record alone cannot decide it.
+ * The record size that does not divide the file size loses its votes, the tie keeps the file as is
+ */
+bool W25Q::migrateTips(void) {
+	W25Q::close();
+	FIL in_f, out_f;
+	if (FR_OK != f_open(&in_f, fn_tip_calib, FA_READ | FA_OPEN_EXISTING))
+		return false;
+	TIP		tip;
+	TIP_V0	old[tip_chunk_sz];
+	UINT	br = 0;
+	FSIZE_t	size	= f_size(&in_f);
+	bool	fit		= (size % sizeof(TIP) == 0);
+	bool	fit_v0	= (size % sizeof(TIP_V0) == 0);
+	uint16_t tips = 0, tips_v0 = 0;
+	tipVotes(&in_f, &tips, &tips_v0);
+	if (fit != fit_v0) {									// Only one record size fits the file
+		if (!fit)		tips	= 0;
+		if (!fit_v0)	tips_v0	= 0;
+	}
+	if (tips > 0 && tips >= tips_v0) {						// The file is in the current format
+		f_close(&in_f);
+		return true;
+	}
+	if (tips_v0 == 0) {										// Unknown format
+		f_close(&in_f);
+		return false;
+	}
+	if (FR_OK != f_open(&out_f, fn_tip_tmp, FA_CREATE_ALWAYS | FA_WRITE)) {
+		f_close(&in_f);
+		return false;
+	}
+	f_lseek(&in_f, 0);
+	bool ret = true;
+	while (ret) {
+		f_read(&in_f, (void *)old, sizeof(old), &br);
+		uint8_t n = br / sizeof(TIP_V0);
+		if (n == 0) break;									// End of file
+		for (uint8_t i = 0; i < n && ret; ++i) {
+			memset((void *)&tip, 0, sizeof(TIP));
+			if (TIP_checkSumV0(&old[i])) {
+				tip.t200	= old[i].t200;
+				tip.t260	= old[i].t260;
+				tip.t330	= old[i].t330;
+				tip.t400	= old[i].t400;
+				tip.mask	= old[i].mask;
+				tip.ambient	= old[i].ambient;
+				memcpy(tip.name, old[i].name, tip_name_sz);
+			}
+			TIP_checkSum(&tip, true);
+			UINT written = 0;
+			f_write(&out_f, (void *)&tip, sizeof(TIP), &written);
+			ret = (written == sizeof(TIP));
+		}
+	}
+	f_close(&in_f);
+	f_close(&out_f);
+	if (ret) {
+		f_unlink(fn_tip_calib);
+		f_rename(fn_tip_tmp, fn_tip_calib);
+		f_unlink(fn_tip_backup);							// The backup file has old format
+	} else {
+		f_unlink(fn_tip_tmp);
+	}
+	return ret;
 }
 
 // Create backup of configuration data
@@ -310,7 +499,7 @@ bool W25Q::backup(ACT_FILE type) {
 		if (FR_OK == f_stat(fn_tip_calib, &fno)) {
 			f_size = fno.fsize;								// Ensure the file size is multiple of TIP size
 			uint16_t tips = f_size / sizeof(TIP);
-			f_size = tips * sizeof(TIPS);
+			f_size = tips * sizeof(TIP);
 		}
 	}
 
@@ -327,17 +516,19 @@ bool W25Q::backup(ACT_FILE type) {
 		free(buff);
 		return false;
 	}
-	bool ret = true;
+	bool ret		= true;
+	bool limited	= (f_size > 0);							// Copy complete tip records only
 	while (true) {
 		UINT to_read	= blk_size;
-		if (f_size > 0) {
-			to_read = f_size;
-			if (to_read > blk_size)
-				to_read = blk_size;
+		if (limited) {
+			if (f_size == 0)
+				break;
+			if (to_read > f_size)
+				to_read = f_size;
 		}
 		UINT read		= 0;
 		UINT write		= 0;
-		f_read(&in_f, buff, blk_size, &read);				// Read a chunk of data from the source file
+		f_read(&in_f, buff, to_read, &read);				// Read a chunk of data from the source file
 		if (read == 0)										// EOF
 			break;
 		f_size -= read;
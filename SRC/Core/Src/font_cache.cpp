@@ -0,0 +1,192 @@
+/*
+ * font_cache.cpp
+ *
+ *  Created on: 18 oct 2026
+ *
+ *  2026 OCT 18
+ *  	FONT_CACHE::open() can open the font inside the file, i.e. in the binary language pack
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "font_cache.h"
+#include "main.h"
+#include "W25Qxx.h"
+#include "u8g_font.h"
+
+static const uint8_t* fontCacheGlyph(void *font_cache, uint16_t encoding) {
+	return ((FONT_CACHE *)font_cache)->glyph(encoding);
+}
+
+/*
+ * Build the map of the font sectors, load the font header and build the glyph index.
+ * The font starts at offset in the file, size is the font size or 0 if the font takes the rest of the file.
+ * The file is closed, all the font data are read from the flash sectors directly
+ */
+bool FONT_CACHE::open(FIL *file, uint32_t offset, uint32_t size) {
+	close();
+	font_size	= (size > 0)?size:((f_size(file) > offset)?f_size(file) - offset:0);
+	font_start	= offset % font_sector_size;
+	uint32_t first = offset / font_sector_size;
+	sectors		= (font_start + font_size + font_sector_size - 1) / font_sector_size;
+	if (font_size <= font_header_size || offset + font_size > f_size(file) ||
+			(sector = (uint32_t *)malloc(sectors * sizeof(uint32_t))) == 0) {
+		f_close(file);
+		return false;
+	}
+	bool ok = true;
+	for (uint16_t s = 0; s < sectors && ok; ++s) {			// Read one byte of each sector to know its physical address
+		uint8_t	b;
+		UINT	br = 0;
+		ok = (FR_OK == f_lseek(file, (FSIZE_t)(first + s) * font_sector_size));
+		ok = ok && (FR_OK == f_read(file, &b, 1, &br)) && br == 1 && file->sect != 0;
+		if (ok) sector[s] = file->sect;						// The sector number in the file private buffer
+	}
+	f_close(file);
+	if (ok) {
+		header_data = (uint8_t *)malloc(font_header_size);
+		ok = header_data && readAt(0, header_data, font_header_size) && buildIndex();
+	}
+	if (ok) {
+		cache_data = (uint8_t *)malloc(font_cache_slots * slot_size);
+		ok = (cache_data != 0);
+	}
+	if (!ok) {
+		close();
+		return false;
+	}
+	for (uint8_t i = 0; i < font_cache_slots; ++i) {
+		slot[i].encoding	= 0xFFFF;						// Empty slot
+		slot[i].used		= 0;
+	}
+	lru_counter = cache_hits = cache_misses = read_ms = 0;
+	u8g2_SetExternalFont(header_data, fontCacheGlyph, this);
+	return true;
+}
+
+void FONT_CACHE::close(void) {
+	if (header_data)
+		u8g2_SetExternalFont(0, 0, 0);
+	if (header_data)	free(header_data);
+	if (sector)			free(sector);
+	if (index)			free(index);
+	if (cache_data)		free(cache_data);
+	header_data	= 0;
+	sector		= 0;
+	index		= 0;
+	cache_data	= 0;
+	sectors		= glyphs = index_size = 0;
+	font_start	= 0;
+	slot_size	= 0;
+}
+
+// Find the glyph in the index and then in the cache. Load the glyph data into the least recently used slot if not cached
+const uint8_t* FONT_CACHE::glyph(uint16_t encoding) {
+	int16_t lo = 0, hi = glyphs - 1;
+	t_glyph_index *g = 0;
+	while (lo <= hi) {
+		int16_t mid = (lo + hi) >> 1;
+		if (index[mid].encoding == encoding) {
+			g = &index[mid];
+			break;
+		}
+		if (index[mid].encoding < encoding)
+			lo = mid + 1;
+		else
+			hi = mid - 1;
+	}
+	if (!g) return 0;
+
+	uint8_t lru = 0;
+	for (uint8_t i = 0; i < font_cache_slots; ++i) {
+		if (slot[i].encoding == encoding) {
+			slot[i].used = ++lru_counter;
+			++cache_hits;
+			return &cache_data[i * slot_size];
+		}
+		if (slot[i].used < slot[lru].used)
+			lru = i;
+	}
+	++cache_misses;
+	uint32_t start = HAL_GetTick();
+	uint8_t *data = &cache_data[lru * slot_size];
+	if (!readAt(g->offset, data, g->size)) {
+		slot[lru].encoding	= 0xFFFF;
+		slot[lru].used		= 0;
+		return 0;
+	}
+	read_ms += HAL_GetTick() - start;
+	slot[lru].encoding	= encoding;
+	slot[lru].used		= ++lru_counter;
+	return data;
+}
+
+// Read the font data directly from the flash sectors
+bool FONT_CACHE::readAt(uint32_t offset, uint8_t *buff, uint16_t size) {
+	if (offset + size > font_size)
+		return false;
+	offset += font_start;									// The offset from the first font sector
+	while (size > 0) {
+		uint16_t s		= offset / font_sector_size;
+		uint16_t pos	= offset % font_sector_size;
+		uint16_t chunk	= font_sector_size - pos;
+		if (chunk > size) chunk = size;
+		uint32_t addr	= (sector[s] << 12) + pos;			// See diskio.c
+		if (W25Qxx_Read(addr, buff, chunk) != W25Qxx_RET_OK)
+			return false;
+		offset	+= chunk;
+		buff	+= chunk;
+		size	-= chunk;
+	}
+	return true;
+}
+
+/*
+ * Walk through the glyph lists of the font (see u8g2_font_get_glyph_data()) and save the glyph data location.
+ * ASCII glyph record: encoding (1 byte), record size (1 byte), data
+ * Unicode glyph record: encoding (2 bytes), record size (1 byte), data
+ */
+bool FONT_CACHE::buildIndex(void) {
+	uint8_t h[3];
+	uint32_t offset = font_header_size;
+	while (true) {											// ASCII glyphs
+		if (!readAt(offset, h, 2)) return false;
+		if (h[1] == 0) break;								// End of the list
+		if (h[1] < 2 || !addGlyph(h[0], offset + 2, h[1] - 2)) return false;
+		offset += h[1];
+	}
+	uint16_t start_pos_unicode = header_data[21] << 8 | header_data[22];
+	if (start_pos_unicode == 0)
+		return glyphs > 0;
+	offset = font_header_size + start_pos_unicode;
+	if (!readAt(offset, h, 2)) return false;
+	offset += h[0] << 8 | h[1];								// The first entry of the unicode lookup table points to the glyphs
+	while (true) {											// Unicode glyphs
+		if (!readAt(offset, h, 2)) return false;			// The list end mark (2 bytes) can be the end of the font
+		uint16_t e = h[0] << 8 | h[1];
+		if (e == 0) break;									// End of the list
+		if (!readAt(offset + 2, &h[2], 1)) return false;
+		if (h[2] < 3 || !addGlyph(e, offset + 3, h[2] - 3)) return false;
+		offset += h[2];
+	}
+	return glyphs > 0;
+}
+
+// Add the glyph to the index keeping the index sorted by encoding
+bool FONT_CACHE::addGlyph(uint16_t encoding, uint32_t offset, uint8_t size) {
+	if (glyphs >= index_size) {
+		t_glyph_index *ni = (t_glyph_index *)realloc(index, (index_size + 64) * sizeof(t_glyph_index));
+		if (!ni) return false;
+		index		= ni;
+		index_size += 64;
+	}
+	uint16_t i = glyphs++;
+	for (; i > 0 && index[i-1].encoding > encoding; --i)
+		index[i] = index[i-1];
+	index[i].encoding	= encoding;
+	index[i].offset		= offset;
+	index[i].size		= size;
+	if (size > slot_size)
+		slot_size = size;
+	return true;
+}
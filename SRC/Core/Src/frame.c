@@ -0,0 +1,85 @@
+/*
+ * frame.c
+ *
+ *  Created on: 2026 OCT 18
+ *      Author: Alex
+ */
+
+#include <string.h>
+#include "frame.h"
+#include "crc.h"
+
+uint16_t COBS_Encode(const uint8_t *src, uint16_t len, uint8_t *dst) {
+	uint16_t code_pos	= 0;
+	uint16_t out		= 1;
+	uint8_t	 code		= 1;
+	for (uint16_t i = 0; i < len; ++i) {
+		if (src[i] == 0) {
+			dst[code_pos]	= code;
+			code_pos		= out++;
+			code			= 1;
+		} else {
+			dst[out++] = src[i];
+			if (++code == 0xFF) {								// The maximum block length
+				dst[code_pos]	= code;
+				code_pos		= out++;
+				code			= 1;
+			}
+		}
+	}
+	dst[code_pos] = code;
+	return out;
+}
+
+uint16_t COBS_Decode(const uint8_t *src, uint16_t len, uint8_t *dst) {
+	uint16_t in		= 0;
+	uint16_t out	= 0;
+	while (in < len) {
+		uint8_t code = src[in++];
+		if (code == 0 || in + code - 1 > len)
+			return 0;
+		for (uint8_t i = 1; i < code; ++i) {
+			if (src[in] == 0) return 0;
+			dst[out++] = src[in++];
+		}
+		if (code != 0xFF && in < len)
+			dst[out++] = 0;
+	}
+	return out;
+}
+
+/*
+ * Build the frame ready to be sent: encoded packet and zero delimiter.
+ * The out buffer should be FRAME_MAX_SIZE bytes at least. Returns the frame length or 0 if the payload is too long
+ */
+uint16_t FRAME_Pack(uint8_t type, uint8_t seq, const void *payload, uint16_t len, uint8_t *out) {
+	if (len > FRAME_MAX_PAYLOAD) return 0;
+	uint8_t pkt[FRAME_MAX_PAYLOAD + FRAME_OVERHEAD];
+	pkt[0] = type;
+	pkt[1] = seq;
+	memcpy(&pkt[2], payload, len);
+	uint32_t crc = crc32(0, pkt, len + 2);
+	for (uint8_t i = 0; i < 4; ++i)
+		pkt[len + 2 + i] = (crc >> (i * 8)) & 0xFF;			// Little endian
+	uint16_t n = COBS_Encode(pkt, len + FRAME_OVERHEAD, out);
+	out[n++] = 0;
+	return n;
+}
+
+/*
+ * Decode the received frame without zero delimiter and check the CRC.
+ * The payload buffer should be FRAME_MAX_PAYLOAD bytes at least. Returns the payload length or -1 if error
+ */
+int16_t FRAME_Unpack(const uint8_t *frame, uint16_t len, uint8_t *type, uint8_t *seq, uint8_t *payload) {
+	if (len > FRAME_MAX_SIZE) return -1;
+	uint8_t pkt[FRAME_MAX_SIZE];
+	uint16_t n = COBS_Decode(frame, len, pkt);
+	if (n < FRAME_OVERHEAD || n > FRAME_MAX_PAYLOAD + FRAME_OVERHEAD) return -1;
+	n -= 4;
+	uint32_t crc = (uint32_t)pkt[n] | (uint32_t)pkt[n+1] << 8 | (uint32_t)pkt[n+2] << 16 | (uint32_t)pkt[n+3] << 24;
+	if (crc != crc32(0, pkt, n)) return -1;
+	*type	= pkt[0];
+	*seq	= pkt[1];
+	memcpy(payload, &pkt[2], n - 2);
+	return n - 2;
+}
@@ -1,26 +1,27 @@
 /*
  * graph.cpp
  *
+ *  2026 OCT 18
+ *  	The history data is allocated in the display memory pool
  */
 
 #include <stdlib.h>
 #include "graph.h"
+#include "pool.h"
 #include "tools.h"
 
 bool GRAPH::allocate(uint16_t size) {
 	data_index	= 0;
 	full_buff	= false;
 	if (this->size > 0 && this->size < size) {
-		free(h_temp);
-		free(h_disp);
-		this->size = 0;
+		freeData();
 	}
 	if (this->size == 0) {
-		h_temp = (int16_t *)malloc(size * sizeof(int16_t));
+		h_temp = (int16_t *)TFT_PoolAlloc(size * sizeof(int16_t));
 		if (h_temp) {
-			h_disp = (uint16_t *)malloc(size * sizeof(uint16_t));
+			h_disp = (uint16_t *)TFT_PoolAlloc(size * sizeof(uint16_t));
 			if (!h_disp) {
-				free(h_temp);
+				TFT_PoolFree(h_temp);
 				h_temp = 0;
 				h_disp = 0;
 				return false;
@@ -28,13 +29,16 @@ bool GRAPH::allocate(uint16_t size) {
 			this->size = size;
 		}
 	}
-	return true;
+	return this->size > 0;
 }
 
 void GRAPH::freeData(void) {
 	if (size > 0) {
-		free(h_temp);
-		free(h_disp);
+		TFT_PoolFree(h_temp);
+		TFT_PoolFree(h_disp);
+		h_temp	= 0;
+		h_disp	= 0;
+		size	= 0;
 	}
 }
 
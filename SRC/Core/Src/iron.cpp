@@ -9,6 +9,9 @@
  *    						To make sure the IRON tip temperature is correct after controller startup or tip change
  * 2023 JAN 01
  *     Added temperature initialization code into IRON::init() method
+ * 2026 OCT 18
+ *     The IRON power is limited by the adaptive measurement window, MWINDOW, instead of the fixed value.
+ *     The power percentage is relative to the window limit, so the full power is 100%
  */
 
 #include <math.h>
@@ -21,6 +24,7 @@ void IRON::init(uint16_t temp) {
 	chill		= false;
 	temp_boost	= 0;
 	t_reset		= true;										// This flag indicating the temperature value was reset
+	mwin.init();
 	UNIT::init(iron_sw_len, iron_off_value,	iron_on_value, sw_tilt_len,	sw_off_value, sw_on_value);
 	t_iron_short.length(iron_emp_coeff);
 	t_iron_short.reset(temp);
@@ -43,7 +47,7 @@ void IRON::switchPower(bool On) {
 	} else {
 		resetPID();
 		uint16_t t = h_temp.read();
-		if (t < temp_set && t + 200 < temp_set) {
+		if (t < temp_set && t + heat_up_gap < temp_set) {
 			mode		= POWER_HEATING;
 		} else {
 			mode		= POWER_ON;
@@ -74,13 +78,14 @@ uint16_t IRON::avgPower(void) {
 	uint16_t p = h_power.read();
 	if (mode == POWER_FIXED)
 		p = fix_power;
-	if (p > max_power) p = max_power;
+	uint16_t max_p = mwin.maxPower();
+	if (p > max_p) p = max_p;
 	return p;
 }
 
 uint8_t IRON::avgPowerPcnt(void) {
 	uint16_t p 		= h_power.read();
-	uint16_t max_p 	= max_power;
+	uint16_t max_p 	= mwin.maxPower();
 	if (mode == POWER_FIXED) {
 		p	  = fix_power;
 		max_p = max_fix_power;
@@ -148,7 +153,6 @@ uint16_t IRON::power(int32_t t) {
 				PID::pidStable();
 			}
 			p = PID::reqPower(temp_set, t);
-			p = constrain(p, 0, max_power);
 			break;
 		case POWER_ON:
 		{
@@ -171,7 +175,6 @@ uint16_t IRON::power(int32_t t) {
 				}
 			}
 			p = PID::reqPower(t_set, t);
-			p = constrain(p, 0, max_power);
 			break;
 		}
 		case POWER_FIXED:
@@ -193,6 +196,7 @@ uint16_t IRON::power(int32_t t) {
 			break;
 	}
 
+	p = constrain(p, 0, mwin.maxPower());					// The temperature is read after the heater was switched off for the window time
 	int32_t	ap		= h_power.average(p);
 	diff 			= ap - p;
 	d_power.update(diff*diff);
@@ -3,6 +3,8 @@
  *
  *  Created on: 15 aug. 2019.
  *      Author: Alex
+ *  2026 OCT 18
+ *  	TIPS::index() uses binary search in the sorted index of the tip names
  */
 
 #include "iron_tips.h"
@@ -107,6 +109,8 @@ static char tip_names[][tip_name_sz] = {
 };
 
 static uint16_t tip_number	= sizeof(tip_names) / tip_name_sz;
+static uint8_t	tip_order[sizeof(tip_names) / tip_name_sz];	// Tip indexes sorted by the tip name
+static bool		tip_order_ready = false;
 
 uint16_t TIPS::loaded(void) {
 	return tip_number;
@@ -119,10 +123,31 @@ const char* TIPS::name(uint8_t index) {
 	return 0;
 }
 
-int TIPS::index(const char *name) {
+// Build the sorted tip index once. The tip list is short, the insertion sort is good enough here
+void TIPS::sortNames(void) {
 	for (uint16_t i = 0; i < tip_number; ++i) {
-		if (strncmp(name, tip_names[i], tip_name_sz) == 0)
-			return i;
+		uint16_t j = i;
+		for (; j > 0 && strncmp(tip_names[i], tip_names[tip_order[j-1]], tip_name_sz) < 0; --j) {
+			tip_order[j] = tip_order[j-1];
+		}
+		tip_order[j] = i;
+	}
+	tip_order_ready = true;
+}
+
+int TIPS::index(const char *name) {
+	if (!tip_order_ready)
+		sortNames();
+	int16_t lo = 0, hi = tip_number - 1;
+	while (lo <= hi) {
+		int16_t mid = (lo + hi) >> 1;
+		int cmp = strncmp(name, tip_names[tip_order[mid]], tip_name_sz);
+		if (cmp == 0)
+			return tip_order[mid];
+		if (cmp < 0)
+			hi = mid - 1;
+		else
+			lo = mid + 1;
 	}
 	return -1;
 }
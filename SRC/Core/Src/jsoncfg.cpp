@@ -1,10 +1,54 @@
 /*
  * jsoncfg.cpp
  *
+ * 2026 OCT 18
+ *     FILE_PARSER::readFile() reads the file by blocks into the RAM buffer
+ *     Ported the listeners to the zero-allocation parser callbacks
+ *     Added "pack" entry to the language configuration
+ *     JSON_KEY_STACK counts overflowed levels, so pop() does not remove the parent key after overflow
+ *     The language entry with the pack file only is accepted
+ *     JSON_LANG_CFG::startDocument() clears the language entry, so the repeated read does not duplicate the language
+ *     FILE_PARSER::readFile() calculates CRC32 of the file, added "messages_crc" and "font_crc" entries to the language configuration
  */
 
+#include <stdlib.h>
+#include <string.h>
 #include "jsoncfg.h"
 #include "vars.h"
+#include "crc.h"
+
+//--------------------------------------------------- Stack of JSON keys -------------------------------------
+bool JSON_KEY_STACK::push(const char *key) {
+	if (lost > 0) {											// Already overflowed, the key cannot be saved
+		++lost;
+		return false;
+	}
+	uint8_t pos = 0;
+	if (depth > 0)
+		pos = k_pos[depth-1] + strlen(&k_buff[k_pos[depth-1]]) + 1;
+	uint16_t len = strlen(key);
+	if (depth >= sizeof(k_pos) || pos + len + 1 > (int)sizeof(k_buff)) {
+		++lost;
+		return false;
+	}
+	strcpy(&k_buff[pos], key);
+	k_pos[depth++] = pos;
+	return true;
+}
+
+void JSON_KEY_STACK::pop(void) {
+	if (lost > 0)
+		--lost;												// Remove overflowed level, keep the saved keys
+	else if (depth > 0)
+		--depth;
+}
+
+// Returns empty string if the stack is empty or the top level was not saved
+const char* JSON_KEY_STACK::top(void) {
+	if (depth == 0 || lost > 0)
+		return "";
+	return &k_buff[k_pos[depth-1]];
+}
 
 //--------------------------------------------------- Configuration file parser -------------------------------
 /*
@@ -40,11 +84,17 @@ void FILE_PARSER::endArray() {
 }
 */
 
+void FILE_PARSER::key(const char *key, uint16_t len) {
+	if (len >= JSON_BUFFER_MAX_LENGTH)
+		len = JSON_BUFFER_MAX_LENGTH - 1;
+	memcpy(d_key, key, len);
+	d_key[len] = '\0';
+}
+
 void FILE_PARSER::startDocument() {
-	while (!s_key.empty() ) {
-		s_key.pop();
-	}
-	d_key.clear();
+	s_key.clear();
+	s_array.clear();
+	d_key[0] = '\0';
 }
 
 void FILE_PARSER::startObject() {
@@ -53,7 +103,7 @@ void FILE_PARSER::startObject() {
 
 void FILE_PARSER::endObject() {
 	s_key.pop();
-	d_key.clear();
+	d_key[0] = '\0';
 }
 
 void FILE_PARSER::startArray() {
@@ -62,30 +112,43 @@ void FILE_PARSER::startArray() {
 
 void FILE_PARSER::endArray() {
 	s_array.pop();
-	d_key.clear();
+	d_key[0] = '\0';
 }
 
+/*
+ * Read the file by blocks and feed the parser from the RAM buffer.
+ * If there is no memory for the block buffer, read the file byte by byte. The CRC32 of the whole file is calculated on the way
+ */
 void FILE_PARSER::readFile(FIL *file) {
 	JsonStreamingParser parser;
 	parser.setListener(this);
 
+	uint8_t		c;											// Single byte buffer, used if no memory available
+	uint8_t		*buff	= (uint8_t *)malloc(read_blk_size);
+	UINT		b_size	= read_blk_size;
+	if (!buff) {
+		buff	= &c;
+		b_size	= 1;
+	}
 	bool is_body = false;
+	file_crc = 0;
 	while(true) {
 		UINT	br = 0;										// Number of bytes actually read from the file
-		uint8_t c;											// Byte to be read
-		f_read(file, (void *)&c, 1, &br);
-		if (br == 1) {										// Byte read successfully
-			if (!is_body && (c == '{' || c == '[')) {
+		if (FR_OK != f_read(file, (void *)buff, b_size, &br) || br == 0)
+			break;											// end of file reached
+		file_crc = crc32(file_crc, buff, br);
+		for (UINT i = 0; i < br; ++i) {
+			if (!is_body && (buff[i] == '{' || buff[i] == '[')) {
 				is_body = true;
 			}
 			if (is_body) {
-				parser.parse(c);
+				parser.parse(buff[i]);
 			}
-		} else {											// end of file reached
-			f_close(file);
-			return;
 		}
 	}
+	if (buff != &c)
+		free(buff);
+	f_close(file);
 }
 
 //--------------------------------------------------- "cfg.json" main NLS configuration file parser -----------
@@ -103,48 +166,89 @@ void JSON_LANG_CFG::readConfig(FIL *file) {
  * font file contains u8g2 font to be loaded to draw the messages
  * {
 	"languages": [
-		{ "name": "russian", "messages": "ru_lang.json", "font": "ru.font"},
-		{ "name": "french",  "messages": "fr_lang.json", "font": "fr.font"}
+		{ "name": "russian", "messages": "ru_lang.json", "font": "ru.font", "pack": "russian.nlp"},
+		{ "name": "french",  "messages": "fr_lang.json", "font": "fr.font", "messages_crc": "1C291CA3", "font_crc": "0A3B5F10"}
 	]
 }
+ * The pack file is optional binary language pack, built by NLS/nls_pack.py from the messages and font files
+ * The messages_crc and font_crc are optional CRC32 of the files in hex, printed by NLS/nls_pack.py --crc.
+ * The file with another CRC is not loaded
  */
-void JSON_LANG_CFG::value(std::string value) {
-	std::string array = s_array.top();
-	if (array.compare("languages") == 0) {
-		if (d_key.compare("name") == 0) {					// Found new language entry
-			if (!data.lang.empty() && data.lang.compare(value) != 0) {
+void JSON_LANG_CFG::value(const char *value, uint16_t len) {
+	if (strcmp(s_array.top(), "languages") == 0) {
+		if (strcmp(d_key, "name") == 0) {					// Found new language entry
+			if (isComplete() && data.lang.compare(0, std::string::npos, value, len) != 0) {
 				lang_list.push_back(data);					// Save previous language data to the language list if the language is different
 			}
-			data.lang = value;								// Initialize next language data structure
-			data.font_file.clear();
-			data.messages_file.clear();
-		} else if (d_key.compare("messages") == 0) {
-			data.messages_file = value;
-		} else if (d_key.compare("font") == 0) {
-			data.font_file = value;
+			clearData();									// Initialize next language data structure
+			data.lang.assign(value, len);
+		} else if (strcmp(d_key, "messages") == 0) {
+			data.messages_file.assign(value, len);
+		} else if (strcmp(d_key, "font") == 0) {
+			data.font_file.assign(value, len);
+		} else if (strcmp(d_key, "pack") == 0) {
+			data.pack_file.assign(value, len);
+		} else if (strcmp(d_key, "messages_crc") == 0 || strcmp(d_key, "font_crc") == 0) {
+			char hex[9];
+			if (len == 0 || len >= sizeof(hex))
+				return;
+			memcpy(hex, value, len);
+			hex[len] = '\0';
+			char *end = 0;
+			uint32_t crc = strtoul(hex, &end, 16);
+			if (*end != '\0')								// Not a hex number
+				return;
+			if (d_key[0] == 'm') {
+				data.messages_crc	= crc;
+				data.check_messages	= true;
+			} else {
+				data.font_crc		= crc;
+				data.check_font		= true;
+			}
 		}
 	}
 }
 
+void JSON_LANG_CFG::clearData(void) {
+	data.lang.clear();
+	data.font_file.clear();
+	data.messages_file.clear();
+	data.pack_file.clear();
+	data.messages_crc	= 0;
+	data.font_crc		= 0;
+	data.check_messages	= false;
+	data.check_font		= false;
+}
+
+// The language entry left by previous read or by addEnglish() should not be added to the list
+void JSON_LANG_CFG::startDocument() {
+	FILE_PARSER::startDocument();
+	clearData();
+}
+
 // Commit last language
 void JSON_LANG_CFG::endDocument() {
-	if (!data.lang.empty() && !data.messages_file.empty()) { // Language can use default font. In this case, font entry will be empty
+	if (isComplete()) {
 		lang_list.push_back(data);
 	}
 }
 
+// Language can use default font. In this case, font entry will be empty. The pack file contains both messages and font
+bool JSON_LANG_CFG::isComplete(void) {
+	return !data.lang.empty() && (!data.messages_file.empty() || !data.pack_file.empty());
+}
+
 // Add default language (English) to the language list
 void JSON_LANG_CFG::addEnglish() {
+	clearData();											// Use default font and messages
 	data.lang = std::string(def_language);					// "English"
-	data.font_file.clear();									// Use default font
-	data.messages_file.clear();								// Use default messages
 	t_lang_list::const_iterator first = lang_list.begin();
 	lang_list.insert(first, data);
 }
 
 //--------------------------------------------------- Messages parser -----------------------------------------
-void JSON_MESSAGES::value(std::string value) {
-	if (pMsg) {
-		pMsg->set(d_key, value, s_key.top());
-	}
+void JSON_MESSAGES::value(const char *value, uint16_t len) {
+	if (!pMsg || len == 0)
+		return;
+	pMsg->set(d_key, value, len, s_key.top());
 }
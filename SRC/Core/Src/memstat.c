@@ -0,0 +1,112 @@
+/*
+ * memstat.c
+ *
+ *  Created on: 2026 OCT 18
+ *      Author: Alex
+ *
+ *  MEM_LargestFree() is hardware independent, the rest is built for the controller only
+ */
+
+#include <stdlib.h>
+#include <stddef.h>
+#include "memstat.h"
+
+volatile uint8_t	mem_irq_depth	= 0;
+volatile uint8_t	mem_irq_peak	= 0;
+
+// The usable size of the largest free chunk or the unclaimed heap space, whichever is bigger
+uint32_t MEM_LargestFree(const t_mem_chunk *free_list, uint32_t unclaimed) {
+	uint32_t largest = unclaimed;
+	for (const t_mem_chunk *c = free_list; c; c = c->next) {
+		uint32_t usable = (c->size > (long)offsetof(t_mem_chunk, next))?c->size - offsetof(t_mem_chunk, next):0;
+		if (usable > largest)
+			largest = usable;
+	}
+	return largest;
+}
+
+#ifdef USE_HAL_DRIVER
+#include <malloc.h>
+#include "main.h"
+
+#define STACK_PAINT		(0xA5A5A5A5)
+#define STACK_MARGIN	(64)									// Bytes below current stack pointer left unpainted
+
+extern char			end asm("end");								// The heap start, defined by the linker script
+extern uint32_t		_estack;									// The stack top, defined by the linker script
+extern char			*sbrk_heap_end;								// The current heap top, see _sbrk() in syscalls.c
+extern char			*sbrk_heap_peak;
+extern uint32_t		sbrk_fails;
+extern t_mem_chunk	*__malloc_free_list __attribute__((weak));	// newlib-nano only, zero address for the full newlib
+static uint32_t		*paint_bottom	= 0;						// The lowest painted word
+static uint32_t		allocs			= 0;
+
+// Fill the free RAM between the heap top and the stack pointer with the pattern. Call it as early as possible
+void MEM_PaintStack(void) {
+	char *heap = sbrk_heap_end?sbrk_heap_end:&end;
+	uint32_t *p		= (uint32_t *)(((uintptr_t)heap + 3) & ~(uintptr_t)3);
+	uint32_t *top	= (uint32_t *)(__get_MSP() - STACK_MARGIN);
+	paint_bottom	= p;
+	while (p < top)
+		*p++ = STACK_PAINT;
+}
+
+void MEM_Stat(t_mem_stat *st) {
+	struct mallinfo mi = mallinfo();
+	char *heap 		= sbrk_heap_end?sbrk_heap_end:&end;
+	char *peak		= sbrk_heap_peak?sbrk_heap_peak:&end;
+	st->heap_used	= mi.uordblks;
+	st->heap_free	= mi.fordblks;
+	st->heap_peak	= peak - &end;
+	st->allocs		= allocs;
+	st->sbrk_fails	= sbrk_fails;
+	st->irq_depth	= mem_irq_peak;
+	st->stack_peak	= 0;
+	st->stack_free	= 0;
+	st->largest_free= MEM_LargestFree(&__malloc_free_list?__malloc_free_list:0, 0);
+	if (!paint_bottom) return;
+	// The heap can grow into the painted area, skip the words claimed by the heap
+	uint32_t *p		= (uint32_t *)(((uintptr_t)heap + 3) & ~(uintptr_t)3);
+	if (p < paint_bottom) p = paint_bottom;
+	uint32_t *from	= p;
+	while (p < &_estack && *p == STACK_PAINT)
+		++p;
+	st->stack_peak	= (uint8_t *)&_estack - (uint8_t *)p;
+	st->stack_free	= (uint8_t *)p - (uint8_t *)from;
+	if (st->stack_free > st->largest_free)
+		st->largest_free = st->stack_free;
+}
+
+#ifdef __NEWLIB__
+/*
+ * Count live allocations. The newlib malloc(), free(), calloc() and realloc() are thin wrappers
+ * around the reentrant functions, so the wrappers here replace them at link time.
+ */
+void *malloc(size_t size) {
+	void *ptr = _malloc_r(_REENT, size);
+	if (ptr) ++allocs;
+	return ptr;
+}
+
+void free(void *ptr) {
+	if (ptr && allocs) --allocs;
+	_free_r(_REENT, ptr);
+}
+
+void *calloc(size_t n, size_t size) {
+	void *ptr = _calloc_r(_REENT, n, size);
+	if (ptr) ++allocs;
+	return ptr;
+}
+
+void *realloc(void *ptr, size_t size) {
+	void *res = _realloc_r(_REENT, ptr, size);
+	if (!ptr && res) {
+		++allocs;
+	} else if (ptr && size == 0 && allocs) {
+		--allocs;
+	}
+	return res;
+}
+#endif
+#endif
@@ -15,6 +15,21 @@
  *  2024 OCT 9
  *  	MOdified MABOUT::loop(). The flash debug and encoder debug modes are called from about dialog
  *  	Modified MDEBUG::loop(). The flash debug mode called from about dialog
+ *  2026 OCT 18
+ *  	FDEBUG reads the directory page by page instead of loading whole directory list
+ *  	Added FDEBUG::benchmark() to measure flash and SD card throughput
+ *  	The IRON button switches MDEBUG to the heap and stack usage page, also shows the scheduler idle load and latency
+ *  	MWORK enables encoder acceleration when the preset temperature is edited
+ *  	MTPID::confirm() does not wait for the brightness fade
+ *  	The Hot Air Gun button in MDEBUG starts and stops the telemetry session log
+ *  	Added MWORK::remote() to apply the remote control commands the same way as the encoders do
+ *  	MDEBUG memory page shows the font cache statistics
+ *  	FDEBUG releases the language data before loading files from the SD-card and loads it again after
+ *  	FDEBUG benchmark shows random write throughput
+ *  	MWORK::events() redraws the screen at once on encoder, switch and AC events
+ *  	MWORK::swTimeout() averages the idle power every 500 ms independent of the screen redraw
+ *  	FDEBUG saves the telemetry session files to the SD-CARD by double press of IRON button, see FDEBUG::saveLogs()
+ *  	FDEBUG does not delete the file of the active telemetry session
  */
 
 #include <stdio.h>
@@ -24,6 +39,7 @@
 #include "cfgtypes.h"
 #include "core.h"
 #include "unit.h"
+#include "pool.h"
 
 //---------------------- The Menu mode -------------------------------------------
 void MODE::setup(MODE* return_mode, MODE* short_mode, MODE* long_mode) {
@@ -94,11 +110,11 @@ void MWORK::init(void) {
 	}
 	if (pCFG->isBigTempStep()) {							// The preset temperature step is 5 degrees
 		i_old_temp_set -= i_old_temp_set % 5;				// The preset temperature should be rounded to 5
-		pIE->reset(i_old_temp_set, it_min, it_max, 5, 5, false);
-		pGE->reset(g_old_temp_set, gt_min, gt_max, 5, 5, false);
+		pIE->reset(i_old_temp_set, it_min, it_max, 5, 25, false);
+		pGE->reset(g_old_temp_set, gt_min, gt_max, 5, 25, false);
 	} else {
-		pIE->reset(i_old_temp_set, it_min, it_max, 1, 1, false);
-		pGE->reset(g_old_temp_set, gt_min, gt_max, 1, 1, false);
+		pIE->reset(i_old_temp_set, it_min, it_max, 1, 10, false);
+		pGE->reset(g_old_temp_set, gt_min, gt_max, 1, 10, false);
 	}
 
 	pD->clear();
@@ -156,15 +172,35 @@ bool MWORK::hwTimeout(bool tilt_active) {
 	return false;
 }
 
+void MWORK::ironStandby(int16_t ambient) {
+	uint16_t temp 	= pCore->cfg.lowTempInternal(ambient, d_t12);
+	alt_temp	 	= pCore->cfg.getLowTemp();
+	pCore->iron.lowPowerMode(temp);
+	i_phase 		= IRPH_LOWPWR;							// Switch to low power mode
+	phase_end 		= HAL_GetTick() + pCore->cfg.getOffTimeout() * 60000;
+	pCore->dspl.msgStandby(u_upper);
+	pCore->dspl.drawTempSet(alt_temp, u_upper);
+}
+
+void MWORK::ironResume(void) {
+	pCore->iron.switchPower(true);
+	i_phase			= IRPH_HEATING;
+	phase_end		= 0;
+	lowpower_time	= 0;									// Reset the lowpower mode timeout
+	pCore->dspl.msgON(u_upper);
+	pCore->dspl.drawTempSet(i_old_temp_set, u_upper);
+}
+
 // Use applied power analysis to automatically power-off the IRON
 void MWORK::swTimeout(uint16_t temp, uint16_t temp_set, uint16_t temp_setH, uint32_t td, uint32_t pd, uint16_t ap) {
 	DSPL*	pD		= &pCore->dspl;
 	CFG*	pCFG	= &pCore->cfg;
 
 	int ip = idle_pwr.read();
-	if ((temp <= temp_set) && (temp_set - temp <= 4) && (td <= 200) && (pd <= 25)) {
-		// Evaluate the average power in the idle state
+	if ((temp <= temp_set) && (temp_set - temp <= 4) && (td <= 200) && (pd <= 25) && HAL_GetTick() >= idle_sample) {
+		// Evaluate the average power in the idle state. The screen can be redrawn sooner by the events, sample by period
 		ip = idle_pwr.average(ap);
+		idle_sample = HAL_GetTick() + period;
 	}
 
 	// Check the IRON current status: idle or used
@@ -343,13 +379,7 @@ bool MWORK::idleMode(void) {
 	if (i_phase == IRPH_NORMAL) {							// The IRON has reaches the preset temperature and 'Ready' message is already cleared
 		if (low_power_enabled) {							// Use hardware tilt switch if low power mode enabled
 			if (hwTimeout(tilt_active)) {
-				uint16_t temp 	 = pCore->cfg.lowTempInternal(ambient, d_t12);
-				alt_temp	 	 = pCore->cfg.getLowTemp();
-				pIron->lowPowerMode(temp);
-				i_phase = IRPH_LOWPWR;						// Switch to low power mode
-				phase_end = HAL_GetTick() + pCore->cfg.getOffTimeout() * 60000;
-				pCore->dspl.msgStandby(u_upper);
-				pCore->dspl.drawTempSet(alt_temp, u_upper);
+				ironStandby(ambient);
 			}
 		} else if (pCore->cfg.getOffTimeout() > 0) {		// Do not use tilt switch, use software auto-off feature
 			swTimeout(temp, temp_set, temp_set_h, td, pd, ap); // Update time_to_return value based IRON status
@@ -366,6 +396,16 @@ bool MWORK::idleMode(void) {
 	return tilt_active;
 }
 
+/*
+ * Redraw the screen at once when the encoder rotated, the switch or AC status changed. The temperature is shown by period.
+ * The control logic in loop() runs on every redraw; swTimeout() samples the idle power by its own timer, so the extra redraws
+ * do not change the averaging rate. The other checks there compare the time stamps and are safe to run sooner.
+ */
+void MWORK::events(uint32_t ev) {
+	if (ev & (EV_ENCODER | EV_SWITCH | EV_AC))
+		update_screen = 0;
+}
+
 MODE* MWORK::loop(void) {
 	DSPL*	pD		= &pCore->dspl;
 	CFG*	pCFG	= &pCore->cfg;
@@ -449,9 +489,9 @@ MODE* MWORK::loop(void) {
 		}
 		if (pCFG->isBigTempStep()) {						// The preset temperature step is 5 degrees
 			g_old_temp_set -= g_old_temp_set % 5;			// The preset temperature should be rounded to 5
-			pGE->reset(g_old_temp_set, t_min, t_max, 5, 5, false);
+			pGE->reset(g_old_temp_set, t_min, t_max, 5, 25, false);
 		} else {
-			pGE->reset(g_old_temp_set, t_min, t_max, 1, 1, false);
+			pGE->reset(g_old_temp_set, t_min, t_max, 1, 10, false);
 		}
 		edit_temp		= true;
 		pD->drawFanPcnt(pHG->presetFanPcnt());				// Redraw in standard mode
@@ -592,6 +632,120 @@ MODE* MWORK::loop(void) {
 	return this;
 }
 
+/*
+ * Apply the remote control command, called from the main loop when the working mode is active.
+ * The preset values are changed like the user does with the encoders, the encoder positions are updated as well.
+ * The Hot Air Gun is switched by the emulated reed switch in the core, see core.cpp
+ */
+uint8_t MWORK::remote(const t_rc_request &req) {
+	DSPL*	pD		= &pCore->dspl;
+	CFG*	pCFG	= &pCore->cfg;
+	IRON*	pIron	= &pCore->iron;
+	HOTGUN*	pHG		= &pCore->hotgun;
+
+	tDevice	dev		= (req.dev == d_gun)?d_gun:d_t12;
+	bool	iron_off = (i_phase == IRPH_OFF || i_phase == IRPH_COOLING || i_phase == IRPH_COLD || i_phase == IRPH_NOHANDLE);
+	int16_t ambient	= pCore->ambientTemp();
+	switch (req.cmd) {
+		case RC_SET_TEMP:
+		{
+			uint16_t t_min	= pCFG->tempMinC(dev);
+			uint16_t t_max	= pCFG->tempMaxC(dev);
+			if (!pCFG->isCelsius()) {
+				t_min	= celsiusToFahrenheit(t_min);
+				t_max	= celsiusToFahrenheit(t_max);
+			}
+			if (req.value < t_min || req.value > t_max)
+				return RC_BAD_ARG;
+			uint16_t t = req.value;
+			if (pCFG->isBigTempStep())
+				t -= t % 5;
+			if (dev == d_t12) {
+				if (i_phase == IRPH_BOOST || i_phase == IRPH_NOHANDLE)
+					return RC_FAIL;
+				if (i_phase == IRPH_LOWPWR || i_phase == IRPH_GOINGOFF)
+					ironResume();
+				i_old_temp_set = t;
+				pCore->i_enc.write(t);
+				pCFG->savePresetTempHuman(t);
+				pIron->setTemp(pCFG->humanToTemp(t, ambient, d_t12));
+				if (!iron_off)
+					i_phase = IRPH_HEATING;
+				pD->drawTempSet(t, u_upper);
+				idle_pwr.reset();
+				lowpower_time = 0;
+			} else {
+				pHG->setTemp(pCFG->humanToTemp(t, ambient, d_gun));
+				pCFG->saveGunPreset(t, pHG->presetFan());
+				if (edit_temp) {
+					g_old_temp_set = t;
+					pCore->g_enc.write(t);
+				}
+				pD->drawTempSet(t, u_lower);
+			}
+			break;
+		}
+		case RC_SET_FAN:
+			if (dev != d_gun)
+				return RC_BAD_DEV;
+			if (req.value > pHG->maxFanSpeed())
+				return RC_BAD_ARG;
+			pHG->setFan(req.value);
+			pCFG->saveGunPreset(pCFG->gunTempPreset(), pHG->presetFan());
+			if (!edit_temp) {
+				g_old_temp_set = pHG->presetFan();
+				pCore->g_enc.write(g_old_temp_set);
+			}
+			pD->drawFanPcnt(pHG->presetFanPcnt(), !edit_temp);
+			break;
+		case RC_POWER:
+			if (dev != d_t12)
+				return RC_BAD_DEV;
+			if (i_phase == IRPH_NOHANDLE)
+				return RC_FAIL;
+			if (req.value) {
+				if (iron_off) {
+					changeIronShort();
+				} else if (i_phase == IRPH_LOWPWR || i_phase == IRPH_GOINGOFF || i_phase == IRPH_BOOST) {
+					ironResume();
+				}
+			} else if (!iron_off) {
+				changeIronShort();							// Switch off the IRON
+			}
+			break;
+		case RC_STANDBY:
+			if (dev != d_t12)
+				return RC_BAD_DEV;
+			if (req.value) {
+				if (i_phase == IRPH_LOWPWR)
+					break;
+				if (iron_off || i_phase == IRPH_BOOST || pCFG->getLowTemp() == 0)
+					return RC_FAIL;
+				ironStandby(ambient);
+			} else if (i_phase == IRPH_LOWPWR) {
+				ironResume();
+			}
+			break;
+		case RC_TIP:
+			if (dev != d_t12)
+				return RC_BAD_DEV;
+			if (req.value < 1 || req.value >= pCFG->TIPS::loaded() || pCFG->nearActiveTip(req.value) != req.value)
+				return RC_BAD_ARG;								// Only active tip can be selected
+			if (!iron_off)
+				return RC_FAIL;
+			if (req.value != pCFG->currentTipIndex(d_t12)) {
+				pCFG->changeTip(req.value);
+				pIron->reset();
+				pD->drawTipName(pCFG->tipName(d_t12), pCFG->isTipCalibrated(), u_upper);
+			}
+			break;
+		default:
+			return RC_BAD_CMD;
+	}
+	update_screen = 0;
+	return RC_OK;
+}
+
 //---------------------- The tip selection mode ----------------------------------
 void MSLCT::init(void) {;
 	CFG*	pCFG	= &pCore->cfg;
@@ -2009,8 +2163,7 @@ bool MTPID::confirm(void) {
 	pCore->dspl.pidShowMenu(pid_k, 3);
 
 	while (true) {
-		if (pCore->dspl.adjust())							// Adjust display brightness
-			HAL_Delay(5);
+		pCore->dspl.adjust();								// Start the display brightness fade
 		uint8_t answer = pCore->g_enc.read();
 		if (pCore->g_enc.buttonStatus() > 0)
 			return answer == 0;
@@ -2368,8 +2521,9 @@ void MDEBUG::init(void) {
 	pCore->i_enc.reset(0, 0, max_iron_power, 1, 5, false);
 	pCore->g_enc.reset(min_fan_speed, min_fan_speed, max_fan_power,  1, 1, false);
 	pCore->dspl.clear();
-	pCore->dspl.drawTitleString("Debug info");
-	gun_is_on = false;
+	pCore->dspl.drawTitleString(pCore->tlog.isActive()?"Debug: log":"Debug info");
+	gun_is_on 		= false;
+	show_memory		= false;
 	update_screen	= 0;
 }
 
@@ -2406,13 +2560,47 @@ MODE* MDEBUG::loop(void) {
 		}
 	}
 
-	if (pCore->g_enc.buttonStatus() == 2) {						// The Hot Air Gun button was pressed for a long time, exit debug mode
+	uint8_t g_button = pCore->g_enc.buttonStatus();
+	if (g_button == 2) {										// The Hot Air Gun button was pressed for a long time, exit debug mode
 	   	return mode_lpress;
 	}
 
+	bool redraw = false;
+	if (pCore->i_enc.buttonStatus() == 1) {						// The IRON button toggles the memory usage page
+		show_memory = !show_memory;
+		redraw		= true;
+	}
+	if (g_button == 1) {										// The Hot Air Gun button starts or stops the telemetry log
+		if (pCore->tlog.isActive()) {
+			pCore->tlog.stop();
+			pCore->buzz.shortBeep();
+		} else if (pCore->tlog.start(&pCore->cfg)) {
+			pCore->buzz.shortBeep();
+		} else {
+			pCore->buzz.failedBeep();
+		}
+		redraw		= true;
+	}
+	if (redraw) {
+		pD->clear();
+		if (pCore->tlog.isActive())
+			pD->drawTitleString(show_memory?"Memory: log":"Debug: log");
+		else
+			pD->drawTitleString(show_memory?"Memory usage":"Debug info");
+		pD->BRGT::on();
+		update_screen = 0;
+	}
+
 	if (HAL_GetTick() < update_screen) return this;
 	update_screen = HAL_GetTick() + 491;						// The screen update period is a primary number to update TIM1 counter value
 
+	if (show_memory) {
+		t_mem_stat st;
+		MEM_Stat(&st);
+		pD->memoryShow(st, TFT_PoolFailures(), TFT_PoolOversized(), pCore->sched.idleLoad(), pCore->sched.maxLatency(), pCore->nls.fontCache());
+		return this;
+	}
+
 	uint16_t data[9];
 	data[0]	= pIron->unitCurrent();
 	data[1]	= pHG->unitCurrent();
@@ -2424,13 +2612,14 @@ MODE* MDEBUG::loop(void) {
 	data[7]	= gtimPeriod();										// GUN_TIM period
 	data[8]	= pCore->ambientInternal();
 
-	bool gtim_ok = isACsine() && (abs(data[7] - 1000) < 50);
+	bool gtim_ok = acFrequency() > 0;							// The TIM1 period depends on AC frequency: 1000 ms for 50 Hz and 833 ms for 60 Hz
 	pD->debugShow(data, (old_ip > 0), pHG->isReedSwitch(true), pIron->isConnected(), pHG->isConnected(), gtim_ok);
 	return this;
 }
 
 void FDEBUG::init(void) {
 	msg = MSG_LAST;												// No error message yet
+	pCore->i_enc.setButtonTiming(0, double_press);				// The double press saves the session logs
 	pCore->dspl.clear();
 	pCore->dspl.drawTitle(MSG_FLASH_DEBUG);
 	if (!pCore->cfg.W25Q::mount()) {							// The flash can be already mounted
@@ -2452,37 +2641,66 @@ void FDEBUG::init(void) {
 }
 
 MODE* FDEBUG::loop(void) {
-	if (pCore->i_enc.buttonStatus() == 2) {						// Iron encoder button long press, load data from the SD-card
+	uint8_t i_status = pCore->i_enc.buttonStatus();
+	if (i_status == 2) {										// Iron encoder button long press, load data from the SD-card
+		closeDirectory();
 		pCore->cfg.umount();									// SPI FLASH will be mounted later to copy data files
+		uint8_t lang = pCore->nls.languageIndex();
+		pCore->nls.defaultNLS();								// The font file can be rewritten, close the font cache sector map
+		pCore->dspl.setLetterFont(0);
 		pCore->dspl.clear();
 		pCore->dspl.dim(50);
 		pCore->dspl.debugMessage("Copying files", 10, 100, 100);
-		t_msg_id e = lang_loader.load();
+		t_msg_id e = lang_loader.load(this);
+		pCore->nls.loadLanguageData(lang);						// Reload the language data from the updated files
+		pCore->dspl.setLetterFont(pCore->nls.font());
 		if (e == MSG_LAST) {
 			pCore->buzz.shortBeep();
 		} else {
 			char sd_status[5];
 			sprintf(sd_status, "%3d", lang_loader.sdStatus());	// SD status initialized by SD_Init() function (see sdspi.c)
 			pFail->setMessage(e, sd_status);
-			return pFail;
+			return leave(pFail);
 		}
-		return mode_lpress;
+		return leave(mode_lpress);
 	}
 
 	uint8_t b_status = pCore->g_enc.buttonStatus();
 	if (b_status == 2) {										// The button was pressed for a long time, finish mode
-	   	return mode_lpress;
+	   	return leave(mode_lpress);
+	}
+
+	if (result_shown) {											// Wait for any button to return to the directory list
+		if (i_status || b_status) {
+			result_shown = false;
+			pCore->dspl.clear();
+			pCore->dspl.drawTitle(MSG_FLASH_DEBUG);
+			update_screen = 0;
+		}
+		return this;
+	}
+	if (i_status == 1 && status == FLASH_OK && delete_index < 0) {	// Iron encoder button short press, start storage benchmark
+		benchmark();
+		return this;
+	}
+	if (i_status == 3 && status == FLASH_OK && delete_index < 0) {	// Iron encoder button double press, save the session logs
+		saveLogs();
+		return this;
 	}
 
 	if (status == FLASH_OK) {									// Flash is OK, draw the directory list
-		uint8_t f_index = (delete_index > 0)?delete_index:old_ge;
-		if (b_status == 1  && pCore->cfg.canDelete(dir_list[f_index].c_str())) {
+		if (counting && delete_index < 0)
+			countEntries();
+		uint16_t f_index = (delete_index >= 0)?delete_index:old_ge;
+		FILINFO fi;
+		if (b_status == 1 && readEntry(f_index, &fi) && pCore->cfg.canDelete(fi.fname) &&
+				!(pCore->tlog.isActive() && strcmp(fi.fname, pCore->tlog.fileName()) == 0)) {	// Do not delete the active session log
 			if (delete_index >= 0) {
 				if (pCore->g_enc.read() == 0) {					// Confirmed to delete file
-					f_unlink(dir_list[delete_index].c_str());
+					f_unlink(fi.fname);
 					readDirectory();
 				} else {
-					pCore->g_enc.reset(delete_index, 0, dir_list.size()-1, 1, 1, false);
+					pCore->g_enc.reset(delete_index, 0, dir_size-1, 1, 1, false);
 				}
 				pCore->dspl.clear();
 				pCore->dspl.drawTitle(MSG_FLASH_DEBUG);
@@ -2514,7 +2732,7 @@ MODE* FDEBUG::loop(void) {
 					}
 				}
 			} else {
-				return mode_lpress;
+				return leave(mode_lpress);
 			}
 		}
 	}
@@ -2523,9 +2741,9 @@ MODE* FDEBUG::loop(void) {
 	update_screen = HAL_GetTick() + update_timeout;
 	if (status == FLASH_OK) {
 		if (delete_index >= 0) {
-			pCore->dspl.showDialog(MSG_DELETE_FILE, 50, old_ge == 0, dir_list[delete_index].c_str());
+			pCore->dspl.showDialog(MSG_DELETE_FILE, 50, old_ge == 0, entryName(delete_index));
 		} else {
-			pCore->dspl.directoryShow(dir_list, old_ge);
+			showDirectory();
 		}
 	} else if (status == FLASH_NO_FILESYSTEM) {
 		if (!confirm_format) {
@@ -2540,30 +2758,195 @@ MODE* FDEBUG::loop(void) {
 	return this;
 }
 
+/*
+ * Open the directory twice: the first one to read the visible entries, the second one to count the entries.
+ * The entries are counted by small portions in FDEBUG::loop(), so the first page is shown immediately
+ */
 void FDEBUG::readDirectory(void) {
-	DIR	dir;
+	closeDirectory();
 	c_dir = "/";
-	FRESULT res = f_opendir(&dir, c_dir.c_str());
-	if (res != FR_OK) {
+	dir_open = (FR_OK == f_opendir(&dir, c_dir.c_str()));
+	counting = dir_open && (FR_OK == f_opendir(&count_dir, c_dir.c_str()));
+	if (!counting) {
+		closeDirectory();
 		msg 	= MSG_EEPROM_DIRECTORY;
 		status	= FLASH_NO_DIRECTORY;
 		old_ge	= 0;
 		pCore->g_enc.reset(0, 0, 0, 0, 0, false);					// No encoder change
 		return;
 	}
-	FILINFO file_info;
-	dir_list.clear();
-	for (;;) {
-		res = f_readdir(&dir, &file_info);
-	    if ((res != FR_OK) || (file_info.fname[0] == '\0')) {
-	    	break;
-	    }
-	    std::string entry = std::string(file_info.fname);
-	    dir_list.push_back(entry);
+	dir_pos		= 0;
+	dir_size	= 0;
+	page_num	= 0;												// Invalidate page cache
+	old_ge		= 0;
+	countEntries();
+	pCore->g_enc.reset(0, 0, (dir_size > 0)?dir_size-1:0, 1, 1, false);	// Select directory entry by the rotary encoder
+	update_screen = 0;												// Force to redraw screen
+}
+
+void FDEBUG::closeDirectory(void) {
+	if (dir_open)
+		f_closedir(&dir);
+	if (counting)
+		f_closedir(&count_dir);
+	dir_open = counting = false;
+}
+
+void FDEBUG::countEntries(void) {
+	FILINFO fi;
+	uint16_t prev_size = dir_size;
+	for (uint8_t i = 0; i < count_step; ++i) {
+		if (FR_OK != f_readdir(&count_dir, &fi) || fi.fname[0] == '\0') {
+			f_closedir(&count_dir);
+			counting = false;
+			break;
+		}
+		++dir_size;
+	}
+	if (dir_size != prev_size) {
+		pCore->g_enc.extendUpper(dir_size-1);						// Extend the encoder range, keep the queued detents and presses
+		if (prev_size < old_ge + DSPL::dir_lines)					// The visible page is not full
+			update_screen = 0;
+	}
+}
+
+// Read the directory entry by index. Rewind the directory when move backward
+bool FDEBUG::readEntry(uint16_t index, FILINFO *fi) {
+	if (!dir_open) return false;
+	if (index < dir_pos) {
+		if (FR_OK != f_readdir(&dir, 0))							// Rewind the directory
+			return false;
+		dir_pos = 0;
+	}
+	while (dir_pos <= index) {
+		if (FR_OK != f_readdir(&dir, fi) || fi->fname[0] == '\0')
+			return false;
+		++dir_pos;
+	}
+	return true;
+}
+
+// Returns the entry name from the page cache, reloads the page starting from the index if the entry is not cached
+const char* FDEBUG::entryName(uint16_t index) {
+	if (index < page_first || index >= page_first + page_num) {
+		FILINFO fi;
+		page_first	= index;
+		page_num	= 0;
+		uint8_t page_size = sizeof(page) / sizeof(t_dir_entry);
+		while (page_num < page_size && readEntry(page_first + page_num, &fi)) {
+			strncpy(page[page_num].name, fi.fname, sizeof(page[0].name)-1);
+			page[page_num].name[sizeof(page[0].name)-1] = '\0';
+			++page_num;
+		}
+		if (page_num == 0) return "";
 	}
-	f_closedir(&dir);
-	old_ge = dir_list.size();										// Force to redraw screen
-	pCore->g_enc.reset(0, 0, old_ge-1, 1, 1, false);				// Select directory entry by the rotary encoder
+	return page[index - page_first].name;
+}
+
+/*
+ * Run the benchmark on the SPI flash and on the SD-card, if it is inserted
+ * The flash drive is mounted already
+ */
+void FDEBUG::benchmark(void) {
+	CYCLE_TIMER		timer;
+	STORAGE_BENCH	bench(&timer);
+	t_bench_result	fs[BENCH_FS_LAST], raw[BENCH_RAW_LAST];
+	uint16_t		y	= 40;
+	uint16_t		w	= pCore->dspl.width() - 20;
+	closeDirectory();
+	pCore->dspl.clear();
+	pCore->dspl.drawTitleString("Storage, KB/s");
+	pCore->dspl.debugMessage("Testing...", 10, y, w);
+	if (bench.volume("0:", fs, raw)) {
+		showBenchResult("Flash", fs, BENCH_FS_LAST, BENCH_RND_READ, y);
+		showBenchResult("Raw", raw, BENCH_RAW_LAST, BENCH_ERASE, y+50);
+	} else {
+		pCore->dspl.debugMessage("Flash test failed", 10, y, w);
+	}
+	y += 100;
+	FATFS *sdfs = (FATFS *)malloc(sizeof(FATFS));
+	if (sdfs && FR_OK == f_mount(sdfs, "1:/", 1)) {
+		pCore->dspl.debugMessage("Testing...", 10, y, w);
+		if (bench.volume("1:", fs))
+			showBenchResult("SD", fs, BENCH_FS_LAST, BENCH_RND_READ, y);
+		else
+			pCore->dspl.debugMessage("SD test failed", 10, y, w);
+		f_mount(NULL, "1:/", 0);
+	} else {
+		pCore->dspl.debugMessage("No SD card", 10, y, w);
+	}
+	if (sdfs) free(sdfs);
+	readDirectory();
+	result_shown	= true;
+	update_screen	= HAL_GetTick() + update_timeout;
+}
+
+/*
+ * Copy the telemetry session files to the SD-CARD, the active session file is skipped.
+ * The flash drive is unmounted first, because SDLOAD mounts it by its own file system object
+ */
+void FDEBUG::saveLogs(void) {
+	uint16_t	w	= pCore->dspl.width() - 20;
+	closeDirectory();
+	pCore->cfg.umount();
+	pCore->dspl.clear();
+	pCore->dspl.drawTitleString("Session logs");
+	pCore->dspl.debugMessage("Copying to SD card", 10, 40, w);
+	uint8_t		saved	= 0;
+	const char	*active	= pCore->tlog.isActive()?pCore->tlog.fileName():0;
+	t_msg_id	e		= lang_loader.saveLogs(active, &saved, this);
+	char line[32];
+	if (e == MSG_LAST) {
+		snprintf(line, 32, "Saved %d files", saved);
+		pCore->buzz.shortBeep();
+	} else if (e == MSG_SD_MOUNT) {
+		snprintf(line, 32, "No SD card");
+	} else {
+		snprintf(line, 32, "Failed, saved %d files", saved);
+		pCore->buzz.failedBeep();
+	}
+	pCore->dspl.debugMessage(line, 10, 40, w);
+	pCore->cfg.W25Q::mount();
+	readDirectory();
+	result_shown	= true;
+	update_screen	= HAL_GetTick() + update_timeout;
+}
+
+// Restore the IRON button timing changed in init()
+MODE* FDEBUG::leave(MODE *next) {
+	pCore->i_enc.setButtonTiming(0, 0);
+	return next;
+}
+
+// Show throughput of each operation in the first line and the latency percentiles (50%, 90%, max) of 'lat' operation in the second line
+void FDEBUG::showBenchResult(const char *name, t_bench_result res[], uint8_t n, uint8_t lat, uint16_t y) {
+	char line[48];
+	uint16_t w = pCore->dspl.width() - 20;
+	int l = snprintf(line, 48, "%-5s", name);
+	for (uint8_t i = 0; i < n && l < 48; ++i)
+		l += snprintf(&line[l], 48-l, " %4lu", res[i].kbps);
+	pCore->dspl.debugMessage(line, 10, y, w);
+	snprintf(line, 48, "  us: %lu/%lu/%lu", res[lat].p50, res[lat].p90, res[lat].max);
+	pCore->dspl.debugMessage(line, 10, y+24, w);
+}
+
+void FDEBUG::copyProgress(const char *name, uint8_t percent) {
+	char msg[40];
+	snprintf(msg, 40, "%-24.24s %3d%%", name, percent);
+	pCore->dspl.debugMessage(msg, 10, 130, 300);
+}
+
+void FDEBUG::showDirectory(void) {
+	uint16_t first = old_ge;
+	if (dir_size < old_ge + DSPL::dir_lines)
+		first = (dir_size > DSPL::dir_lines)?dir_size - DSPL::dir_lines:0;
+	uint8_t items = ((dir_size - first) >= DSPL::dir_lines)?DSPL::dir_lines:(dir_size-first);
+	if (first > 0 && (first < page_first || first + items > page_first + page_num))
+		entryName(first - 1);										// Load the page including previous entry to scroll back smoothly
+	const char *names[DSPL::dir_lines];
+	for (uint8_t i = 0; i < items; ++i)
+		names[i] = entryName(first + i);
+	pCore->dspl.directoryShow(names, items, old_ge - first);
 }
 
 //---------------------- The Encoder debug mode: check encoders -----------------
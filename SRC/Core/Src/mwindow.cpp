@@ -0,0 +1,82 @@
+/*
+ * mwindow.cpp
+ *
+ *  Created on: 2026 OCT 18
+ *      Author: Alex
+ */
+
+#include <stdlib.h>
+#include "mwindow.h"
+#include "tools.h"
+
+void MWINDOW::init(void) {
+	drift.length(emp_len);
+	noise.length(emp_len);
+	win			= 20;
+	adc_ticks	= MW_ADC_TICKS;
+	t_valid		= false;
+	holds		= 0;
+	checks		= 0;
+}
+
+// Called at the beginning of TIM2 period. Read the temperature as late as possible, the ADC should finish before the period ends
+uint16_t MWINDOW::tempPoint(uint16_t arr) {
+	t_point = arr - adc_ticks;
+	return t_point;
+}
+
+/*
+ * Called from ADC conversion complete callback with the IRON temperature samples taken in a row
+ * applied	- the IRON PWM value of the finished period, i.e. the time the heater was switched off
+ * cnt		- TIM2 counter when the ADC has finished
+ */
+uint16_t MWINDOW::measure(const uint16_t s[], uint8_t n, uint16_t applied, uint16_t cnt) {
+	uint32_t sum	= 0;
+	uint16_t lo		= 0xFFFF;
+	uint16_t hi		= 0;
+	for (uint8_t i = 0; i < n; ++i) {
+		sum += s[i];
+		if (s[i] < lo) lo = s[i];
+		if (s[i] > hi) hi = s[i];
+	}
+	uint16_t t = (sum + n/2) / n;
+
+	if (cnt < t_point) {									// TIM2 period ended before the ADC finished, the next period could power the heater
+		++adc_late;
+		if (adc_ticks < max_adc_ticks)
+			adc_ticks += 2;
+		return hold(t);
+	}
+	if (n < 2) return t;
+
+	int32_t quiet = (int32_t)t_point - applied;				// The time between heater switch-off and the first sample
+	if (applied == 0 || quiet >= max_win) {					// The amplifier has settled for sure
+		noise.update(hi - lo);
+	} else if (quiet < win - 2) {							// The period was shortened after the power was limited, the amplifier has not settled
+		return hold(t);
+	} else if (quiet <= win + 2) {							// The heater was powered till the window start
+		drift.update(abs(s[n-1] - s[0]));
+		if (++checks >= win_checks) {
+			checks = 0;
+			int32_t n_avg = noise.read();
+			int32_t d_avg = drift.read();
+			if (d_avg > n_avg + drift_high || n_avg > noise_high) {
+				win = constrain(win + 2, min_win, max_win);
+			} else if (d_avg <= n_avg + drift_low) {
+				win = constrain(win - 1, min_win, max_win);
+			}
+		}
+	}
+	t_last	= t;
+	t_valid	= true;
+	holds	= 0;
+	return t;
+}
+
+// The samples are not reliable, return the last settled temperature. t is the average of the samples
+uint16_t MWINDOW::hold(uint16_t t) {
+	if (!t_valid || holds >= max_holds)
+		return t;
+	++holds;
+	return t_last;
+}
@@ -1,32 +1,30 @@
 /*
  * nls.cpp
  *
+ * 2026 OCT 18
+ *    NLS_MSG::set() uses plain C-strings, no heap allocation to check the message key
+ *    Added hash index of the message keys. NLS_MSG::set() does not compare the key with every message
+ *    Added NLS_MSG::setMessage() and NLS_MSG::keysCRC()
+ *    The localized messages are copied into single memory block, arena
+ *    NLS_MSG::str() returns the pointer into the arena. Added NLS_MSG::trimArena()
  */
 
+#include <string.h>
+#include <stdlib.h>
 #include "nls.h"
 #include "vars.h"
+#include "tools.h"
 
 const char* NLS_MSG::msg(t_msg_id id) {
 	if (id < MSG_LAST) {
-		if (use_nls && message[(uint8_t)id].msg_nls.length() > 0)
-			return message[(uint8_t)id].msg_nls.c_str();
+		if (use_nls && message[(uint8_t)id].msg_nls)
+			return message[(uint8_t)id].msg_nls;
 		else
 			return message[(uint8_t)id].msg;
 	}
 	return 0;
 }
 
-std::string NLS_MSG::str(t_msg_id id) {
-	std::string ret = std::string();
-	if (id < MSG_LAST) {
-		if (use_nls && message[(uint8_t)id].msg_nls.length() > 0)
-			ret = message[(uint8_t)id].msg_nls;
-		else
-			ret = std::string(message[(uint8_t)id].msg);
-	}
-	return ret;
-}
-
 // Each menu starts with menu title, so actual menu size is less by 1
 uint8_t NLS_MSG::menuSize(t_msg_id id) {
 	uint8_t ret = 0;
@@ -52,16 +50,41 @@ uint8_t NLS_MSG::menuSize(t_msg_id id) {
 	return ret;
 }
 
-bool NLS_MSG::set(std::string& parameter, std::string& value, std::string& parent) {
+// FNV-1a hash of the key, folded to the hash table size
+uint8_t NLS_MSG::keyHash(const char *key) {
+	uint32_t h = 2166136261U;
+	while (*key) {
+		h ^= (uint8_t)*key++;
+		h *= 16777619U;
+	}
+	h ^= h >> 16;
+	return (h ^ (h >> 8)) & (sizeof(key_index) - 1);
+}
+
+/*
+ * Build the hash table of the message keys. Some keys are used in several menus (i.e. "quit" or "clear")
+ * So the same key can be found in the several slots, the message id is checked to be in the search range
+ */
+void NLS_MSG::buildIndex(void) {
+	memset(key_index, 0xFF, sizeof(key_index));
+	for (uint8_t i = 0; i < MSG_LAST; ++i) {
+		uint8_t h = keyHash(message[i].msg);
+		while (key_index[h] != 0xFF)						// Linear probing
+			h = (h + 1) & (sizeof(key_index) - 1);
+		key_index[h] = i;
+	}
+}
+
+int16_t NLS_MSG::find(const char *parameter, const char *parent) {
 	uint8_t first = 0;
 	uint8_t last = MSG_LAST;
-	if (!parent.empty()) {
-		if (parent.compare(standalone_msg) == 0) { 			// standalone_msg defined in vars.h
+	if (parent[0] != '\0') {
+		if (strcmp(parent, standalone_msg) == 0) { 			// standalone_msg defined in vars.h
 			first	= (uint8_t)MSG_ON;
 		} else {											// Perhaps, menu name specified
 			for (uint8_t m = 0; m < sizeof(menu)/sizeof(t_msg_id); ++m) {
 				const char *m_name = message[(uint8_t)menu[m]].msg;
-				if (parent.compare(m_name) == 0) {			// Menu has been found, limit search context
+				if (strcmp(parent, m_name) == 0) {			// Menu has been found, limit search context
 					first	= (uint8_t)menu[m];
 					last	= first + menuSize(menu[m]) + 1; // The first menu item is menu title
 					break;
@@ -69,12 +92,88 @@ bool NLS_MSG::set(std::string& parameter, std::string& value, std::string& paren
 			}
 		}
 	}
-	for (uint8_t i = first; i < last; ++i) {
-		if (parameter.compare(message[i].msg) == 0) {		// Parameter has been found
-			message[i].msg_nls = value;
-			use_nls = true;									// At least one message was loaded
-			return true;
-		}
+	uint8_t h = keyHash(parameter);
+	while (key_index[h] != 0xFF) {
+		uint8_t i = key_index[h];
+		if (i >= first && i < last && strcmp(parameter, message[i].msg) == 0)
+			return i;										// Parameter has been found
+		h = (h + 1) & (sizeof(key_index) - 1);
+	}
+	return -1;												// Parameter not found
+}
+
+bool NLS_MSG::set(const char *parameter, const char *value, uint16_t len, const char *parent) {
+	int16_t i = find(parameter, parent);
+	if (i < 0)
+		return false;										// Parameter not found
+	return setMessage(i, value, len);
+}
+
+// Copy the message into the arena
+bool NLS_MSG::setMessage(uint8_t id, const char *value, uint16_t len) {
+	if (id >= MSG_LAST || len == 0 || !arena || arena_used + len + 1 > arena_size)
+		return false;
+	char *m = &arena[arena_used];
+	memcpy(m, value, len);
+	m[len] = '\0';
+	arena_used += len + 1;
+	message[id].msg_nls = m;
+	use_nls = true;											// At least one message was loaded
+	return true;
+}
+
+bool NLS_MSG::setMessage(uint8_t id, uint16_t offset) {
+	if (id >= MSG_LAST || offset >= arena_used || arena[offset] == '\0')
+		return false;
+	message[id].msg_nls = &arena[offset];
+	use_nls = true;
+	return true;
+}
+
+// Allocate the arena to store the localized messages. Previously loaded messages are released
+bool NLS_MSG::allocateArena(uint16_t size) {
+	freeArena();
+	arena = (char *)malloc(size);
+	if (!arena)
+		return false;
+	arena_size = size;
+	return true;
+}
+
+// The arena is allocated by the messages file size. When the messages are loaded, the rest of the arena is released
+void NLS_MSG::trimArena(void) {
+	if (!arena || arena_used == 0 || arena_used >= arena_size)
+		return;
+	uint16_t offset[MSG_LAST];
+	for (uint8_t i = 0; i < MSG_LAST; ++i)
+		offset[i] = message[i].msg_nls?(message[i].msg_nls - arena):0xFFFF;
+	char *a = (char *)realloc(arena, arena_used);
+	if (!a)
+		return;												// Keep the whole arena
+	arena		= a;
+	arena_size	= arena_used;
+	for (uint8_t i = 0; i < MSG_LAST; ++i) {				// realloc() could move the arena
+		if (offset[i] != 0xFFFF)
+			message[i].msg_nls = &arena[offset[i]];
+	}
+}
+
+void NLS_MSG::freeArena(void) {
+	for (uint8_t i = 0; i < MSG_LAST; ++i)
+		message[i].msg_nls = 0;
+	if (arena)
+		free(arena);
+	arena		= 0;
+	arena_size	= 0;
+	arena_used	= 0;
+	use_nls		= false;
+}
+
+// The message keys are summed in the table order including the terminating zero
+uint32_t NLS_MSG::keysCRC(void) {
+	uint32_t crc = 0;
+	for (uint8_t i = 0; i < MSG_LAST; ++i) {
+		crc = crc32(crc, message[i].msg, strlen(message[i].msg) + 1);
 	}
-	return false;											// Parameter not found
+	return crc;
 }
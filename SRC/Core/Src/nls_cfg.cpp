@@ -1,12 +1,25 @@
 /*
  * nls_cfg.cpp
  *
+ * 2026 OCT 18
+ *     NLS::loadLanguageData() tries to load binary language pack first, falls back to the JSON messages file
+ *     The localized messages are loaded into the NLS_MSG arena, sized by the messages file
+ *     NLS::loadFont() opens the big font in FONT_CACHE instead of loading it into the memory
+ *     The language can be specified by the pack file only
+ *     NLS::loadPack() rejects the pack with message offset out of the string pool or unterminated string
+ *     NLS::loadMessages() parses the messages file once, the arena is sized by the file and then trimmed
+ *     NLS::loadLanguageData() loads the messages before the font, releases the messages if the font failed to load
+ *     NLS::defaultNLS() always switches to the default language
+ *     NLS::loadPack() reads the big font of the pack by FONT_CACHE instead of loading it into the memory
+ *     NLS::loadMessages() and NLS::loadFont() reject the file if its CRC32 differs from the one in the language configuration
  */
 
 #include <string.h>
 #include "nls_cfg.h"
+#include "tools.h"
 
 void NLS::init(NLS_MSG *pMsg) {
+	this->pMsg = pMsg;
 	msg_parser.setNLS_MSG(pMsg);							// Setup pointer to the NLS_MSG class instance to use NLS_MSG::set() method in the value callback procedure
 	if (FR_OK == f_mount(&flashfs, "0:/", 1)) {				// Try to mount SPI flash
 		std::string cfg_path = "0:" + std::string(fn_cfg);	// fn_cfg defined in vars.h, "cfg.json"
@@ -22,15 +35,18 @@ void NLS::init(NLS_MSG *pMsg) {
 void NLS::loadLanguageData(uint8_t index) {
 	if (index == language_index)							// The language is already loaded
 		return;
-	std::string msg_file = messageFile(index);
-	if (msg_file.empty()) {									// No message file for this language, load default messages
-		defaultNLS();
+	defaultNLS();											// Free font data and messages
+	if (loadPack(index)) {
+		language_index = index;
 		return;
 	}
-	defaultNLS();											// Free font data
-	if (loadFont(index)) {
-		if (loadMessages(index)) {							// Both font and messages are loaded successfully
+	if (messageFile(index).empty())							// No message file for this language, use default messages
+		return;
+	if (loadMessages(index)) {								// The arena is trimmed before the font is allocated
+		if (loadFont(index)) {								// Both font and messages are loaded successfully
 			language_index = index;
+		} else {
+			defaultNLS();
 		}
 	}
 }
@@ -41,11 +57,15 @@ void NLS::loadLanguageData(const char *language) {
 }
 
 void NLS::defaultNLS() {
+	if (pMsg)
+		pMsg->freeArena();									// Release all localized messages
+	if (font_cache.isOpen())
+		font_cache.close();
 	if (font_data) {
 		free(font_data);
 		font_data			= 0;
-		language_index		= 0;
 	}
+	language_index			= 0;							// The localized messages are released
 }
 
 std::string NLS::languageName(uint8_t index) {
@@ -74,7 +94,7 @@ std::string NLS::messageFile(uint8_t index) {
 		t_lang_list *ll = lang_cfg.getLangList();
 		return ll->at(index).messages_file;
 	}
-	return 0;
+	return std::string("");
 }
 
 std::string NLS::fontFile(uint8_t index) {
@@ -83,15 +103,117 @@ std::string NLS::fontFile(uint8_t index) {
 		t_lang_list *ll = lang_cfg.getLangList();
 		return ll->at(index).font_file;
 	}
+	return std::string("");
+}
+
+t_lang_cfg* NLS::langEntry(uint8_t index) {
+	if (index < lang_cfg.listSize())
+		return &lang_cfg.getLangList()->at(index);
 	return 0;
 }
 
+std::string NLS::packFile(uint8_t index) {
+	uint8_t num_lang = lang_cfg.listSize();					// Number of loaded languages
+	if (index < num_lang){
+		t_lang_list *ll = lang_cfg.getLangList();
+		return ll->at(index).pack_file;
+	}
+	return std::string("");
+}
+
+/*
+ * Load precompiled binary language pack by sequential read of the file. No parsing required
+ * The small font data is read directly into the font buffer. The big font, or the font that does not fit the memory,
+ * is checked by CRC and then read from the flash by FONT_CACHE, the same way as the big font file
+ */
+bool NLS::loadPack(uint8_t indx) {
+	std::string f = packFile(indx);
+	if (f.empty() || !pMsg)
+		return false;
+	if (FR_OK != f_mount(&flashfs, "0:/", 1))				// Try to mount SPI flash
+		return false;
+	std::string cfg_path = "0:" + f;
+	if (FR_OK != f_open(&cfg_f, cfg_path.c_str(), FA_READ))
+		return false;
+	t_nls_pack_header hdr;
+	UINT br = 0;											// Read bytes
+	f_read(&cfg_f, (void *)&hdr, sizeof(hdr), &br);
+	if (br != sizeof(hdr) || strncmp(hdr.magic, "NLSP", 4) != 0 || hdr.version != 1 ||
+		hdr.msg_num != MSG_LAST || hdr.keys_crc != pMsg->keysCRC() || hdr.pool_size > 0xFFFF) {
+		f_close(&cfg_f);
+		return false;										// The pack was built for another firmware version
+	}
+	uint16_t offset[MSG_LAST];								// Message offset table
+	f_read(&cfg_f, (void *)offset, sizeof(offset), &br);
+	bool ok = (br == sizeof(offset));
+	uint32_t crc = crc32(0, offset, sizeof(offset));
+	if (ok) {												// Read the string pool directly into the messages arena
+		ok = pMsg->allocateArena(hdr.pool_size);
+		if (ok) {
+			f_read(&cfg_f, (void *)pMsg->arenaData(), (UINT)hdr.pool_size, &br);
+			ok = (br == hdr.pool_size);
+			pMsg->arenaUsed(br);
+			crc = crc32(crc, pMsg->arenaData(), br);
+		}
+	}
+	uint32_t font_offset = sizeof(hdr) + sizeof(offset) + hdr.pool_size;
+	bool cached = false;									// The font is read by FONT_CACHE
+	if (ok && hdr.font_size > 0) {
+		if (hdr.font_size <= font_resident)
+			font_data = (uint8_t *)malloc(hdr.font_size);
+		if (font_data) {
+			f_read(&cfg_f, (void *)font_data, (UINT)hdr.font_size, &br);
+			ok = (br == hdr.font_size);
+			crc = crc32(crc, font_data, hdr.font_size);
+		} else {											// Calculate the font CRC by small chunks
+			cached = true;
+			uint8_t		chunk[128];
+			uint32_t	left = hdr.font_size;
+			while (ok && left > 0) {
+				UINT to_read = (left < sizeof(chunk))?left:sizeof(chunk);
+				ok = (FR_OK == f_read(&cfg_f, (void *)chunk, to_read, &br)) && (br == to_read);
+				crc = crc32(crc, chunk, br);
+				left -= br;
+			}
+		}
+	}
+	ok = ok && (crc == hdr.data_crc);
+	// The last string in the pool must be terminated, so every offset inside the pool points to the terminated string
+	if (ok && hdr.pool_size > 0)
+		ok = (pMsg->arenaData()[hdr.pool_size-1] == '\0');
+	for (uint8_t i = 0; ok && i < MSG_LAST; ++i) {
+		ok = (offset[i] == 0xFFFF || offset[i] < hdr.pool_size);
+	}
+	if (ok && cached)
+		ok = font_cache.open(&cfg_f, font_offset, hdr.font_size); // The file is closed by FONT_CACHE::open()
+	else
+		f_close(&cfg_f);
+	if (ok) {
+		for (uint8_t i = 0; i < MSG_LAST; ++i) {
+			pMsg->setMessage(i, offset[i]);					// 0xFFFF means the message is not translated
+		}
+	} else {
+		pMsg->freeArena();
+		if (font_data) {
+			free(font_data);
+			font_data = 0;
+		}
+	}
+	return ok;
+}
+
+/*
+ * The font that fits the memory is checked by CRC after it is loaded. The font read by FONT_CACHE is checked
+ * by small chunks before the cache is opened. The CRC is checked if it is specified in the language configuration
+ */
 bool NLS::loadFont(uint8_t indx) {
 	if (FR_OK != f_mount(&flashfs, "0:/", 1))				// Try to mount SPI flash
 		return false;
 	std::string f = fontFile(indx);
 	if (f.empty())
 		return true;
+	t_lang_cfg *lang = langEntry(indx);
+	bool check = lang && lang->check_font;
 	std::string cfg_path = "0:" + f;
 	FILINFO fno;
 	if (FR_OK != f_stat(cfg_path.c_str(), &fno))
@@ -100,15 +222,25 @@ bool NLS::loadFont(uint8_t indx) {
 		return false;
 	if (FR_OK != f_open(&cfg_f, cfg_path.c_str(), FA_READ))
 		return false;
-	font_data = (uint8_t *)malloc(fno.fsize);				// Try to allocate memory for the font
-	if (!font_data) {
-		f_close(&cfg_f);
-		return false;
-	}
+	if (fno.fsize <= font_resident)
+		font_data = (uint8_t *)malloc(fno.fsize);			// Try to allocate memory for the font
 	UINT br = 0;											// Read bytes
+	if (!font_data) {										// Read the glyphs from the flash on demand
+		if (check) {
+			uint8_t		chunk[128];
+			uint32_t	crc = 0;
+			while (FR_OK == f_read(&cfg_f, (void *)chunk, sizeof(chunk), &br) && br > 0)
+				crc = crc32(crc, chunk, br);
+			if (crc != lang->font_crc || FR_OK != f_lseek(&cfg_f, 0)) {
+				f_close(&cfg_f);
+				return false;
+			}
+		}
+		return font_cache.open(&cfg_f);						// The file is closed by FONT_CACHE::open()
+	}
 	f_read(&cfg_f, (void *)font_data, (UINT)fno.fsize, &br);
 	f_close(&cfg_f);
-	if (br != fno.fsize) {
+	if (br != fno.fsize || (check && crc32(0, font_data, br) != lang->font_crc)) {
 		free(font_data);
 		font_data = 0;
 		return false;
@@ -122,7 +254,19 @@ bool NLS::loadMessages(uint8_t indx) {
 	std::string cfg_path = "0:" + messageFile(indx);		// Here messageFile is not null for sure
 	if (FR_OK != f_open(&cfg_f, cfg_path.c_str(), FA_READ))
 		return false;
+	uint32_t size = f_size(&cfg_f);							// The messages are shorter than the file
+	if (size == 0 || size > 0xFFFF || !pMsg || !pMsg->allocateArena(size)) {
+		f_close(&cfg_f);
+		return false;
+	}
 	msg_parser.readConfig(&cfg_f);							// readConfig closes the file automatically
+	t_lang_cfg *lang = langEntry(indx);
+	bool crc_ok = !lang || !lang->check_messages || msg_parser.fileCRC() == lang->messages_crc;
+	if (!pMsg->isLoaded() || !crc_ok) {						// No known message in the file or the file is corrupted
+		pMsg->freeArena();
+		return false;
+	}
+	pMsg->trimArena();
 	return true;
 }
 
@@ -2,6 +2,9 @@
  * pid.cpp
  *
  *      Author: Alex
+ *
+ *  2026 OCT 18
+ *  	PID::reqPower() saves the PID terms, see PID::terms()
  */
 
 #include "pid.h"
@@ -40,6 +43,16 @@ void PID::resetPID(uint16_t t) {
 	power  			= 0;
 }
 
+// Returns true if the terms were calculated since the last call
+bool PID::terms(int32_t *kp, int32_t *ki, int32_t *kd) {
+	*kp		= t_kp;
+	*ki		= t_ki;
+	*kd		= t_kd;
+	bool n	= t_new;
+	t_new	= false;
+	return n;
+}
+
 int32_t PID::changePID(uint8_t p, int32_t k) {
 	switch(p) {
     	case 1:
@@ -89,13 +102,20 @@ int32_t PID::reqPower(int16_t temp_set, int16_t temp_curr) {
 		power 		= 0;
 		int32_t	i_summ 	= temp_set - temp_curr;
 		power = Kp*(temp_set - temp_curr) + Ki * i_summ;
+		t_kp	= Kp*(temp_set - temp_curr);
+		t_ki	= Ki * i_summ;
+		t_kd	= 0;
 	} else {
 		int32_t kp = Kp * (temp_h1 	- temp_curr);
 		int32_t ki = Ki * (temp_set	- temp_curr);
 		int32_t kd = Kd * (temp_h0 	+ temp_curr - 2 * temp_h1);
 		int32_t delta_p = kp + ki + kd;
 		power += delta_p;									// Power is stored multiplied by denominator!
+		t_kp	= kp;
+		t_ki	= ki;
+		t_kd	= kd;
 	}
+	t_new	= true;
 	temp_h0 = temp_h1;
 	temp_h1 = temp_curr;
 	int32_t pwr = power + (1 << (denominator_p-1));			// prepare the power to divide by denominator, round the result
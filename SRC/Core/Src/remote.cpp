@@ -0,0 +1,93 @@
+/*
+ * remote.cpp
+ *
+ *  Created on: 2026 OCT 18
+ *      Author: Alex
+ */
+
+#include <string.h>
+#include "remote.h"
+
+void REMOTE::receive(const uint8_t *data, uint16_t len) {
+	for (uint16_t i = 0; i < len; ++i) {
+		uint8_t c = data[i];
+		if (c == 0) {										// Frame delimiter
+			if (!rx_skip && rx_len > 0)
+				command(rx, rx_len);
+			rx_len		= 0;
+			rx_skip		= false;
+		} else if (rx_skip) {
+			continue;
+		} else if (rx_len < FRAME_MAX_SIZE) {
+			rx[rx_len++] = c;
+		} else {
+			rx_skip = true;
+			++bad_frames;
+		}
+	}
+}
+
+void REMOTE::lost(void) {
+	if (!rx_skip)
+		++bad_frames;
+	rx_skip = true;
+}
+
+void REMOTE::poll(void) {
+	if (!handler) return;
+	for (uint8_t dev = 0; dev < devices; ++dev) {
+		t_rc_state st;
+		state(dev, st);
+		if (!ev_init || changed(st, last[dev])) {
+			last[dev] = st;
+			send(FRAME_EVENT, ev_seq++, &st, sizeof(st));
+		}
+	}
+	ev_init = true;
+}
+
+void REMOTE::command(const uint8_t *frame, uint16_t len) {
+	uint8_t type, seq;
+	uint8_t payload[FRAME_MAX_PAYLOAD];
+	int16_t n = FRAME_Unpack(frame, len, &type, &seq, payload);
+	if (n < 0 || type != FRAME_COMMAND) {					// Corrupted frame, the host will repeat the command by timeout
+		++bad_frames;
+		return;
+	}
+	t_rc_reply reply;
+	memset(&reply, 0, sizeof(reply));
+	reply.cmd		= (n > 0)?payload[0]:0xFF;
+	reply.status	= RC_BAD_CMD;
+	if (n == sizeof(t_rc_request) && handler) {
+		t_rc_request req;
+		memcpy(&req, payload, sizeof(req));
+		if (req.cmd >= RC_LAST) {
+			reply.status = RC_BAD_CMD;
+		} else if (req.dev >= devices) {
+			reply.status = RC_BAD_DEV;
+		} else if (req.cmd == RC_PING || req.cmd == RC_QUERY) {
+			reply.status = RC_OK;
+		} else {
+			reply.status = handler->execute(req);
+		}
+		state(req.dev < devices?req.dev:0, reply.state);
+	}
+	send(FRAME_REPLY, seq, &reply, sizeof(reply));
+}
+
+// The device state is changed. The current temperature and the power are changing all the time and are not checked
+bool REMOTE::changed(const t_rc_state &a, const t_rc_state &b) {
+	return a.mode != b.mode || a.flags != b.flags || a.tip != b.tip || a.preset != b.preset || a.fan != b.fan;
+}
+
+void REMOTE::state(uint8_t dev, t_rc_state &st) {
+	handler->state(dev, st);
+	st.errors = bad_frames & 0xFF;
+}
+
+void REMOTE::send(uint8_t type, uint8_t seq, const void *payload, uint16_t len) {
+	if (!out) return;
+	uint8_t frame[FRAME_MAX_SIZE];
+	uint16_t n = FRAME_Pack(type, seq, payload, len, frame);
+	if (n) out(frame, n);
+}
@@ -0,0 +1,95 @@
+/*
+ * scheduler.cpp
+ *
+ *  Created on: 2026 OCT 18
+ *      Author: Alex
+ */
+
+#include "scheduler.h"
+
+volatile uint32_t	SCHED::events	= 0;
+volatile uint32_t	SCHED::ev_time	= 0;
+
+// The time in SysTick cycles (HCLK) since start. Wraps every 51 seconds, only the difference is used
+uint32_t SCHED::now(void) {
+	uint32_t load	= SysTick->LOAD + 1;
+	uint32_t ms, val;
+	do {
+		ms	= HAL_GetTick();
+		val	= SysTick->VAL;
+	} while (ms != HAL_GetTick());
+	return ms * load + (load - 1 - val);
+}
+
+bool SCHED::addTask(t_task task, uint16_t period_ms) {
+	if (task_num >= max_tasks || !task) return false;
+	tasks[task_num].task	= task;
+	tasks[task_num].period	= period_ms;
+	tasks[task_num].next	= HAL_GetTick();
+	++task_num;
+	return true;
+}
+
+void SCHED::runTasks(void) {
+	uint32_t ms = HAL_GetTick();
+	for (uint8_t i = 0; i < task_num; ++i) {
+		if ((int32_t)(ms - tasks[i].next) >= 0) {
+			tasks[i].next = ms + tasks[i].period;
+			(*tasks[i].task)();
+		}
+	}
+}
+
+bool SCHED::taskDue(void) {
+	uint32_t ms = HAL_GetTick();
+	for (uint8_t i = 0; i < task_num; ++i) {
+		if ((int32_t)(ms - tasks[i].next) >= 0)
+			return true;
+	}
+	return false;
+}
+
+void SCHED::signal(uint32_t ev) {
+	if (__atomic_fetch_or(&events, ev, __ATOMIC_RELAXED) == 0)
+		ev_time = now();
+}
+
+// Returns pending events and clears them. Updates the response latency statistics
+uint32_t SCHED::takeEvents(void) {
+	if (events == 0) return 0;
+	uint32_t t	= ev_time;
+	uint32_t ev	= __atomic_exchange_n(&events, 0, __ATOMIC_RELAXED);
+	uint32_t cycles = now() - t;
+	if (cycles < SystemCoreClock) {							// Ignore the values when the clock wrapped between the readings
+		uint32_t mks = cycles / (SystemCoreClock / 1000000);
+		if (mks > lat_max) lat_max = mks;
+		lat_avg8 += mks - (lat_avg8 >> 3);
+	}
+	return ev;
+}
+
+/*
+ * Sleep till the next interrupt if there is nothing to do.
+ * The interrupts are disabled while checking the events, so the event raised just before WFI wakes the controller up.
+ * The SysTick interrupt ends the sleep every millisecond, the idle load counts the time spent in WFI only.
+ */
+void SCHED::sleep(void) {
+	uint32_t ms = HAL_GetTick();
+	if (ms - window_start >= window) {
+		uint32_t total = (ms - window_start) * (SysTick->LOAD + 1);
+		idle_pcnt		= (uint64_t)idle_cycles * 100 / total;
+		idle_cycles		= 0;
+		window_start	= ms;
+	}
+	__disable_irq();
+	if (events || taskDue()) {
+		__enable_irq();
+		return;
+	}
+	uint32_t t = now();
+	__WFI();
+	__enable_irq();											// The pending interrupt is served here
+	uint32_t slept = now() - t;
+	if (slept < SystemCoreClock)							// Ignore the values when the clock wrapped between the readings
+		idle_cycles += slept;
+}
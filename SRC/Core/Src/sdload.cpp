@@ -1,12 +1,24 @@
 /*
  * sdload.cpp
  *
+ * 2026 OCT 18
+ *     Copy binary language pack if it is specified in the language configuration
+ *     Skip the file if its CRC32 is equal to the flash copy CRC32
+ *     Show copy progress on the display
+ *     Verify the copied file by CRC32
+ *     The language can be described by the pack file only, the font file is optional
+ *     The copy progress is reported by SDLOAD_PROGRESS::copyProgress()
+ *     The telemetry session files are copied from the flash to the SD-CARD by SDLOAD::saveLogs()
  */
 
+#include <string.h>
+#include <ctype.h>
 #include "sdload.h"
 #include "jsoncfg.h"
+#include "tools.h"
 
-t_msg_id SDLOAD::load(void) {
+t_msg_id SDLOAD::load(SDLOAD_PROGRESS *pProgress) {
+	this->pProgress = pProgress;
 	t_msg_id e = init();
 	if (MSG_LAST != e)
 		return e;
@@ -16,11 +28,54 @@ t_msg_id SDLOAD::load(void) {
 	umountAll();
 	if (buffer) {											// Deallocate copy buffer memory
 		free(buffer);
-		buffer_size = 0;
+		buffer		= 0;
+		buffer_size	= 0;
 	}
 	return (l>0)?MSG_LAST:MSG_SD_INCONSISTENT;
 }
 
+/*
+ * Copy the telemetry session files tlogNN.bin from the flash drive root to the SD-CARD root.
+ * The active session file is skipped, it is not complete yet. The file already saved with the same content is not copied again
+ */
+t_msg_id SDLOAD::saveLogs(const char *active, uint8_t *saved, SDLOAD_PROGRESS *pProgress) {
+	this->pProgress = pProgress;
+	*saved = 0;
+	if (FR_OK != f_mount(&sdfs, "1:/", 1))
+		return MSG_SD_MOUNT;
+	if (FR_OK != f_mount(&flashfs, "0:/", 1)) {
+		f_mount(NULL, "1:/", 0);
+		return MSG_EEPROM_READ;
+	}
+	t_msg_id e = MSG_LAST;
+	DIR dir;
+	if (!allocateCopyBuffer()) {
+		e = MSG_SD_MEMORY;
+	} else if (FR_OK != f_opendir(&dir, "0:/")) {
+		e = MSG_EEPROM_DIRECTORY;
+	} else {
+		FILINFO fno;
+		while (FR_OK == f_readdir(&dir, &fno) && fno.fname[0]) {
+			if (!isLogFile(fno.fname) || (active && strcmp(fno.fname, active) == 0))
+				continue;
+			std::string name = fno.fname;
+			if (!copyFile(name, "0:", "1:")) {
+				e = MSG_SD_INCONSISTENT;
+				break;
+			}
+			++*saved;
+		}
+		f_closedir(&dir);
+	}
+	umountAll();
+	if (buffer) {											// Deallocate copy buffer memory, load() can be called later
+		free(buffer);
+		buffer		= 0;
+		buffer_size	= 0;
+	}
+	return e;
+}
+
 t_msg_id SDLOAD::init(void) {
 	if (FR_OK != f_mount(&sdfs, "1:/", 1))
 		return MSG_SD_MOUNT;
@@ -65,10 +120,15 @@ uint8_t SDLOAD::copyLanguageData(void) {
 		t_lang_cfg lang = lang_list->back();
 		lang_list->pop_back();
 		bool lang_ok = isLanguageDataConsistent(lang);		// Check the language files exist
-		if (lang_ok)
+		if (lang_ok && !lang.messages_file.empty())
 			lang_ok = copyFile(lang.messages_file);
-		if (lang_ok)
+		if (lang_ok && !lang.font_file.empty())				// The language can use default font
 			lang_ok = copyFile(lang.font_file);
+		if (lang_ok && !lang.pack_file.empty()) {
+			bool pack_ok = copyFile(lang.pack_file);
+			if (lang.messages_file.empty())					// The binary pack is optional if JSON files are present
+				lang_ok = pack_ok;
+		}
 		if (lang_ok)
 			++l_copied;
 	}
@@ -81,63 +141,122 @@ uint8_t SDLOAD::copyLanguageData(void) {
 }
 
 bool SDLOAD::isLanguageDataConsistent(t_lang_cfg &lang_data) {
-	std::string file_path = "1:" + lang_data.messages_file;
-	FILINFO fno;
-	// Checking message file
-	if (FR_OK != f_stat(file_path.c_str(), &fno))
+	if (lang_data.messages_file.empty())					// The binary pack contains both messages and font
+		return isSourceFile(lang_data.pack_file);
+	if (!isSourceFile(lang_data.messages_file))
 		return false;
-	if (fno.fsize == 0 || (fno.fattrib & AM_ARC) == 0)
+	return lang_data.font_file.empty() || isSourceFile(lang_data.font_file);
+}
+
+// Check the file exists on the SD-CARD and it is not empty
+bool SDLOAD::isSourceFile(std::string &name) {
+	if (name.empty())
 		return false;
-	// Checking font file
-	file_path = "1:" + lang_data.font_file;
+	std::string file_path = "1:" + name;
+	FILINFO fno;
 	if (FR_OK != f_stat(file_path.c_str(), &fno))
 		return false;
-	if (fno.fsize == 0 || (fno.fattrib & AM_ARC) == 0)
-		return false;
-	return true;
+	return fno.fsize > 0 && (fno.fattrib & AM_ARC) != 0;
+}
+
+// The telemetry session file name: tlogNN.bin, see TLOG::start()
+bool SDLOAD::isLogFile(const char *name) {
+	return strlen(name) == 10 && strncmp(name, "tlog", 4) == 0 && isdigit(name[4]) && isdigit(name[5]) &&
+			strcmp(&name[6], ".bin") == 0;
 }
 
-bool SDLOAD::haveToUpdate(std::string &name) {
+/*
+ * Compare the file content instead of the file timestamp. The timestamp can be changed by copying the file to the SD-CARD
+ * The flash is read much faster than written, so it is cheaper to calculate CRC of both files than to rewrite the file
+ */
+bool SDLOAD::haveToUpdate(std::string &name, const char *src, const char *dst) {
 	FILINFO fno;
-	std::string file_path = "1:" + name;					// Source file path on SD-CARD
-	if (FR_OK != f_stat(file_path.c_str(), &fno))			// Failed to get info of the new file
+	std::string s_file_path = src + name;					// Source file path
+	if (FR_OK != f_stat(s_file_path.c_str(), &fno))			// Failed to get info of the new file
 		return true;
-	uint32_t source_date = fno.fdate << 16 | fno.ftime;		// The source file timestamp
-	file_path = "0:" + name;								// Destination file path on SPI FLASH
-	if (FR_OK != f_stat(file_path.c_str(), &fno))			// Failed to get info of the file, perhaps, the destination file does not exist
+	FSIZE_t source_size = fno.fsize;
+	std::string d_file_path = dst + name;					// Destination file path
+	if (FR_OK != f_stat(d_file_path.c_str(), &fno))			// Failed to get info of the file, perhaps, the destination file does not exist
 		return true;
-	if (fno.fsize == 0 || (fno.fattrib & AM_ARC) == 0)		// Destination file size is zero or is not a n archive file at all
+	if ((fno.fattrib & AM_ARC) == 0)						// Destination is not an archive file at all
+		return false;
+	if (fno.fsize != source_size)
+		return true;
+	uint32_t d_crc = 0, s_crc = 0;
+	if (!fileCRC(d_file_path, &d_crc) || !fileCRC(s_file_path, &s_crc))
+		return true;
+	return (d_crc != s_crc);
+}
+
+bool SDLOAD::fileCRC(std::string &path, uint32_t *crc) {
+	FIL	f;
+	if (FR_OK != f_open(&f, path.c_str(), FA_READ))
 		return false;
-	uint32_t dest_date = fno.fdate << 16 | fno.ftime;		// The destination file timestamp
-	return (dest_date < source_date);						// If the destination file timestamp is older than source one
+	uint32_t c = 0;
+	bool ok = true;
+	while (true) {
+		UINT br = 0;										// Read bytes
+		if (FR_OK != f_read(&f, (void *)buffer, (UINT)buffer_size, &br)) {
+			ok = false;
+			break;
+		}
+		if (br == 0)										// End of file
+			break;
+		c = crc32(c, buffer, br);
+	}
+	f_close(&f);
+	*crc = c;
+	return ok;
 }
 
-bool SDLOAD::copyFile(std::string &name) {
+void SDLOAD::showProgress(std::string &name, uint32_t done, uint32_t size) {
+	if (!pProgress) return;
+	uint8_t percent = (size > 0)?((uint64_t)done * 100 / size):100;
+	pProgress->copyProgress(name.c_str(), percent);
+}
+
+// Copy the file between the drives, from the SD-CARD to the SPI FLASH by default
+bool SDLOAD::copyFile(std::string &name, const char *src, const char *dst) {
 	FIL	sf, df;												// Source and destination file descriptors
-	if (!haveToUpdate(name)) return true;					// The file already exists on the SPI FLASH and its date is not older than the source file on SD-CARD
 	if (!buffer || buffer_size == 0)						// Here the copy buffer has to be allocated already, but double check it
 		return false;
-	std::string s_file_path = "1:" + name;					// Source file path on SD-CARD
+	if (!haveToUpdate(name, src, dst)) {					// The destination file already exists and has the same content
+		showProgress(name, 1, 1);
+		return true;
+	}
+	std::string s_file_path = src + name;					// Source file path
 	if (FR_OK != f_open(&sf, s_file_path.c_str(), FA_READ))	// Failed to open source file for reading
 		return false;
-	std::string d_file_path = "0:" + name;								// Destination file path on SPI FLASH
-	if (FR_OK != f_open(&df, d_file_path.c_str(), FA_CREATE_ALWAYS | FA_WRITE)) // Failed to create destination file for writing
+	std::string d_file_path = dst + name;								// Destination file path
+	if (FR_OK != f_open(&df, d_file_path.c_str(), FA_CREATE_ALWAYS | FA_WRITE)) { // Failed to create destination file for writing
+		f_close(&sf);
 		return false;
+	}
 	bool copied = true;
+	uint32_t done = 0;
+	uint32_t size = f_size(&sf);
+	uint32_t crc  = 0;										// CRC of the source file
 	while (true) {											// The file copy loop
 		UINT br = 0;										// Read bytes
-		f_read(&sf, (void *)buffer, (UINT)buffer_size, &br);
+		f_read(&sf, (void *)buffer, (UINT)buffer_size, &br);	// The flash is programming the last page of the previous block meanwhile
 		if (br == 0)										// End of source file
 			break;
+		crc = crc32(crc, buffer, br);
 		UINT written = 0;									// Written bytes
 		f_write(&df, (void *)buffer, br, &written);
 		if (written != br) {
 			copied = false;
 			break;
 		}
+		done += br;
+		showProgress(name, done, size);
 	}
 	f_close(&df);
 	f_close(&sf);
+	if (copied) {											// Read the file back to check it was written correctly
+		uint32_t d_crc = 0;
+		copied = fileCRC(d_file_path, &d_crc) && d_crc == crc;
+	}
 	if (!copied) {
 		f_unlink(d_file_path.c_str());						// Remove destination file in case on any error
 	} else {												// Copy date and time from the source file to the destination file
@@ -0,0 +1,139 @@
+/*
+ * serial.cpp
+ *
+ *  Created on: 2026 OCT 18
+ *      Author: Alex
+ */
+
+#include "serial.h"
+
+#ifdef SERIAL_PORT
+
+extern UART_HandleTypeDef	huart1;
+
+static SERIAL	*p_serial = 0;								// The port instance for HAL callbacks
+
+void SERIAL::init(void) {
+	p_serial = this;
+	MX_USART1_UART_Init();									// Generated by CubeMX, the function call is not generated
+	rxStart();
+}
+
+bool SERIAL::write(const uint8_t *data, uint16_t len) {
+	uint16_t used = (tx_head - tx_tail) & (tx_size - 1);
+	if (len >= tx_size - used) {
+		tx_dropped += len;
+		return false;
+	}
+	uint16_t h = tx_head;
+	for (uint16_t i = 0; i < len; ++i) {
+		tx_buff[h] = data[i];
+		h = (h + 1) & (tx_size - 1);
+	}
+	tx_head = h;
+	HAL_NVIC_DisableIRQ(USART1_IRQn);						// kick() is called from the transmit complete callback also
+	kick();
+	HAL_NVIC_EnableIRQ(USART1_IRQn);
+	return true;
+}
+
+uint16_t SERIAL::read(uint8_t *data, uint16_t max) {
+	uint16_t head	= rx_head;
+	if (rx_gap) head = rx_gap_at;							// Do not join the data around the gap
+	uint16_t n		= 0;
+	while (rx_tail != head && n < max) {
+		data[n++]	= rx_buff[rx_tail];
+		rx_tail		= (rx_tail + 1) & (rx_size - 1);
+	}
+	return n;
+}
+
+bool SERIAL::lost(void) {
+	bool gap = false;
+	HAL_NVIC_DisableIRQ(USART1_IRQn);						// rxGap() is called from USART and DMA interrupts
+	HAL_NVIC_DisableIRQ(DMA2_Stream2_IRQn);
+	if (rx_gap && rx_tail == rx_gap_at) {
+		rx_gap	= false;
+		gap		= true;
+	}
+	HAL_NVIC_EnableIRQ(DMA2_Stream2_IRQn);
+	HAL_NVIC_EnableIRQ(USART1_IRQn);
+	return gap;
+}
+
+// Start DMA transfer of the continuous data block from the tail of the ring
+void SERIAL::kick(void) {
+	if (tx_len || tx_head == tx_tail) return;
+	uint16_t end = (tx_head > tx_tail)?tx_head:tx_size;
+	tx_len = end - tx_tail;
+	if (HAL_UART_Transmit_DMA(&huart1, &tx_buff[tx_tail], tx_len) != HAL_OK)
+		tx_len = 0;											// Try again on next write()
+}
+
+void SERIAL::txComplete(void) {
+	tx_tail	= (tx_tail + tx_len) & (tx_size - 1);
+	tx_len	= 0;
+	kick();
+}
+
+void SERIAL::rxStart(void) {
+	rx_pos = 0;
+	HAL_UARTEx_ReceiveToIdle_DMA(&huart1, rx_dma, rx_dma_size);	// The DMA stream is in circular mode, see .ioc file
+}
+
+// Move the received data from DMA buffer into the ring, pos is the DMA buffer position of the next byte to be received
+void SERIAL::rxEvent(uint16_t pos) {
+	if (pos >= rx_dma_size) pos = 0;						// Full transfer, DMA continues from the buffer start
+	uint16_t h = rx_head;
+	while (rx_pos != pos) {
+		uint16_t next = (h + 1) & (rx_size - 1);
+		if (next == rx_tail) {								// The ring is full, the main loop is late
+			rx_head = h;
+			rxGap();
+			++rx_overruns;
+		} else {
+			rx_buff[h]	= rx_dma[rx_pos];
+			h			= next;
+		}
+		if (++rx_pos >= rx_dma_size) rx_pos = 0;
+	}
+	rx_head = h;
+}
+
+// Mark the place the data were lost at. The first gap only is marked, the frame checksum finds the others
+void SERIAL::rxGap(void) {
+	if (rx_gap) return;
+	rx_gap_at	= rx_head;
+	rx_gap		= true;
+}
+
+/*
+ * HAL aborts the circular reception on framing, noise or overrun error, and the transmission on DMA error.
+ * Restart the reception and skip the failed transmit block
+ */
+void SERIAL::error(void) {
+	if (huart1.RxState == HAL_UART_STATE_READY) {
+		++rx_errors;
+		rxGap();											// The data in DMA buffer after rx_pos are lost
+		rxStart();
+	}
+	if (huart1.gState == HAL_UART_STATE_READY && tx_len)
+		txComplete();
+}
+
+extern "C" void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart) {
+	if (huart->Instance == USART1 && p_serial)
+		p_serial->txComplete();
+}
+
+extern "C" void HAL_UARTEx_RxEventCallback(UART_HandleTypeDef *huart, uint16_t Size) {
+	if (huart->Instance == USART1 && p_serial)
+		p_serial->rxEvent(Size);
+}
+
+extern "C" void HAL_UART_ErrorCallback(UART_HandleTypeDef *huart) {
+	if (huart->Instance == USART1 && p_serial)
+		p_serial->error();
+}
+
+#endif
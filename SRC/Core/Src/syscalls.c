@@ -49,6 +49,7 @@
 /* Includes */
 #include <sys/stat.h>
 #include <stdlib.h>
+#include <stdint.h>
 #include <errno.h>
 #include <stdio.h>
 #include <signal.h>
@@ -65,6 +66,10 @@ extern int __io_getchar(void) __attribute__((weak));
 
 register char * stack_ptr asm("sp");
 
+char *sbrk_heap_end	= 0;						/* The current heap top, see memstat.c */
+char *sbrk_heap_peak	= 0;						/* The maximum heap top */
+uint32_t sbrk_fails		= 0;						/* The number of refused requests */
+
 char *__env[1] = { 0 };
 char **environ = __env;
 
@@ -117,22 +122,24 @@ __attribute__((weak)) int _write(int file, char *ptr, int len)
 caddr_t _sbrk(int incr)
 {
 	extern char end asm("end");
-	static char *heap_end;
 	char *prev_heap_end;
 
-	if (heap_end == 0)
-		heap_end = &end;
+	if (sbrk_heap_end == 0)
+		sbrk_heap_end = &end;
 
-	prev_heap_end = heap_end;
-	if (heap_end + incr > stack_ptr)
+	prev_heap_end = sbrk_heap_end;
+	if (sbrk_heap_end + incr > stack_ptr)
 	{
 //		write(1, "Heap and stack collision\n", 25);
 //		abort();
+		++sbrk_fails;
 		errno = ENOMEM;
 		return (caddr_t) -1;
 	}
 
-	heap_end += incr;
+	sbrk_heap_end += incr;
+	if (sbrk_heap_end > sbrk_heap_peak)
+		sbrk_heap_peak = sbrk_heap_end;
 
 	return (caddr_t) prev_heap_end;
 }
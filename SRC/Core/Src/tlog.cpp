@@ -0,0 +1,182 @@
+/*
+ * tlog.cpp
+ *
+ *  Created on: 2026 OCT 18
+ *      Author: Alex
+ *
+ *  2026 OCT 18
+ *  	The session file is appended by whole 4 KB blocks, the header is buffered with the first block
+ *  	The session file reserves contiguous space, the blocks are programmed into the sectors erased ahead of time
+ *  	TLOG::lost() counts the lost records, not the ring overflow events
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "tlog.h"
+#include "W25Qxx.h"
+
+void TLOG::push(const t_tlog_rec &rec) {
+	if (rec.dev >= TLOG_DEVICES) return;
+	t_ring *r	= &ring[rec.dev];
+	uint8_t h	= (r->head + 1) & (ring_size - 1);
+	if (h == r->tail) {										// The ring is full, the main loop is busy
+		r->lost = true;
+		++r->dropped;
+		return;
+	}
+	r->rec[r->head]	= rec;
+	if (r->lost) {
+		r->rec[r->head].flags |= TLOG_LOST;
+		r->lost = false;
+	}
+	__DMB();												// The record should be written before the head moves
+	r->head	= h;
+}
+
+/*
+ * Start new session: create next free file tlogNN.bin on the flash drive and reserve contiguous space for it.
+ * If the drive has no max_size contiguous space, the space is halved down to min_size.
+ * The flash sector of the first block is read by one byte read, the same way as FONT_CACHE does, and erased here.
+ * The header is written with the first block, so all blocks are aligned to the flash sectors
+ */
+bool TLOG::start(W25Q *drive) {
+	if (buff) return true;
+	if (!drive || !drive->mount()) return false;
+	this->drive = drive;
+	FILINFO fno;
+	uint16_t i = 0;
+	for ( ; i < max_files; ++i) {
+		sprintf(fn, "tlog%02d.bin", i);
+		if (FR_OK != f_stat(fn, &fno))
+			break;
+	}
+	if (i >= max_files) return false;						// Remove old session files first
+	FIL f;
+	if (FR_OK != f_open(&f, fn, FA_CREATE_NEW | FA_WRITE | FA_READ))
+		return false;
+	space = max_size;
+	FRESULT res = f_expand(&f, space, 1);
+	while (res != FR_OK && space > min_size) {
+		space /= 2;
+		res = f_expand(&f, space, 1);
+	}
+	uint8_t	b;
+	UINT	br	= 0;
+	bool	ok	= (res == FR_OK) && FR_OK == f_read(&f, &b, 1, &br) && br == 1 && f.sect != 0;
+	sector		= f.sect;
+	f_close(&f);
+	ok = ok && W25Qxx_RET_OK == W25Qxx_Erase(sector, 1);
+	if (ok) {
+		buff = (uint8_t *)malloc(block_size);
+		ok = (buff != 0);
+	}
+	if (!ok) {
+		f_unlink(fn);
+		return false;
+	}
+	t_tlog_header *h = (t_tlog_header *)buff;
+	memcpy(h->magic, "TLOG", 4);
+	h->version	= version;
+	h->rec_size	= sizeof(t_tlog_rec);
+	h->start_ms	= HAL_GetTick();
+	h->reserved	= 0;
+	buff_len	= sizeof(t_tlog_header);
+	file_size	= 0;
+	lost_recs	= 0;
+	lost_base	= dropped();
+	for (uint8_t d = 0; d < TLOG_DEVICES; ++d)				// Start from the fresh data
+		ring[d].tail = ring[d].head;
+	return true;
+}
+
+// Save the rest of the data and cut the reserved space of the session file to the written size
+void TLOG::stop(void) {
+	if (!buff) return;
+	if (buff_len > 0)
+		append();
+	lost_recs = dropped() - lost_base;
+	free(buff);
+	buff = 0;
+	FILINFO fno;
+	FIL f;
+	if (drive->mount() && FR_OK == f_stat(fn, &fno) && fno.fsize == space &&
+			FR_OK == f_open(&f, fn, FA_WRITE | FA_OPEN_EXISTING)) {
+		f_lseek(&f, file_size);
+		f_truncate(&f);
+		f_close(&f);
+	}
+}
+
+uint32_t TLOG::lost(void) {
+	return buff?(dropped() - lost_base):lost_recs;
+}
+
+// The records dropped by the interrupt handlers since the controller started
+uint32_t TLOG::dropped(void) {
+	uint32_t n = 0;
+	for (uint8_t d = 0; d < TLOG_DEVICES; ++d)
+		n += ring[d].dropped;
+	return n;
+}
+
+// Take the records from the rings. Save the block into the session file when it is full
+void TLOG::drain(void) {
+	for (uint8_t d = 0; d < TLOG_DEVICES; ++d) {
+		t_ring *r = &ring[d];
+		while (r->tail != r->head) {
+			if (sink)
+				(*sink)(r->rec[r->tail]);
+			if (buff) {
+				if (!put(r->rec[r->tail])) {
+					stop();
+					return;
+				}
+			}
+			r->tail = (r->tail + 1) & (ring_size - 1);
+		}
+	}
+	if (buff && file_size >= space)
+		stop();
+}
+
+// Copy the record into the block buffer, save the full block. The record tail goes to the next block
+bool TLOG::put(const t_tlog_rec &rec) {
+	const uint8_t *p = (const uint8_t *)&rec;
+	uint16_t n = sizeof(t_tlog_rec);
+	while (n > 0) {
+		uint16_t part = block_size - buff_len;
+		if (part > n) part = n;
+		memcpy(&buff[buff_len], p, part);
+		buff_len	+= part;
+		p			+= part;
+		n			-= part;
+		if (buff_len >= block_size && !append())
+			return false;
+	}
+	return true;
+}
+
+/*
+ * Program the block buffer into the next sector of the reserved space. The sector was erased ahead of time.
+ * The file is checked by its size first: the configuration code can unmount the drive any time,
+ * and the file removed in the flash debug mode has no reserved space any more.
+ * The last page of the partial block is padded by 0xFF, the erased flash value. After the full block is programmed,
+ * the erase of the next sector is started. The flash is busy with it while the next block is collected
+ */
+bool TLOG::append(void) {
+	uint32_t block = file_size / block_size;
+	FILINFO fno;
+	if (file_size + buff_len > space || !drive->mount() || FR_OK != f_stat(fn, &fno) || fno.fsize != space)
+		return false;
+	uint16_t len = (buff_len + 0xFF) & ~0xFF;				// Whole pages
+	memset(&buff[buff_len], 0xFF, len - buff_len);
+	if (W25Qxx_RET_OK != W25Qxx_Program((sector + block) << 12, buff, len))
+		return false;
+	file_size	+= buff_len;
+	bool full	= (buff_len == block_size);
+	buff_len	= 0;
+	if (full && file_size < space)
+		W25Qxx_EraseStart(sector + block + 1);
+	return true;
+}
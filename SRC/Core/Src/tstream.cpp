@@ -0,0 +1,29 @@
+/*
+ * tstream.cpp
+ *
+ *  Created on: 2026 OCT 18
+ *      Author: Alex
+ */
+
+#include "tstream.h"
+#include "frame.h"
+
+#ifdef SERIAL_PORT
+
+void TSTREAM::send(const t_tlog_rec &rec, uint8_t mode) {
+	if (!port || rate == 0) return;
+	if (rec.dev == TLOG_IRON) {
+		if ((int32_t)(rec.ms - next_iron) < 0) return;
+		next_iron = rec.ms + 1000 / rate - 2;				// Tolerate the jitter of the record time
+	}
+	t_tstream_pkt pkt;
+	pkt.rec			= rec;
+	pkt.mode		= mode;
+	pkt.reserved	= 0;
+	uint8_t frame[FRAME_MAX_SIZE];
+	uint16_t n = FRAME_Pack(FRAME_TELEMETRY, seq++, &pkt, sizeof(pkt), frame);
+	if (!port->write(frame, n))
+		++frames_dropped;
+}
+
+#endif
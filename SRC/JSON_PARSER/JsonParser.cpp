@@ -25,6 +25,7 @@ SOFTWARE.
 See more at http://blog.squix.ch and https://github.com/squix78/json-streaming-parser
 */
 
+#include <string.h>
 #include "JsonParser.h"
 
 JsonStreamingParser::JsonStreamingParser(void) {
@@ -214,12 +215,11 @@ void JsonStreamingParser::endString() {
     stackPos--;
     if (popped == STACK_KEY) {
     	buffer[buffer_pos] = '\0';
-    	std::string k(buffer);
-    	myListener->key(k);
+    	myListener->key(buffer, buffer_pos);
     	state = STATE_END_KEY;
     } else if (popped == STACK_STRING) {
     	buffer[buffer_pos] = '\0';
-    	myListener->value(std::string(buffer));
+    	myListener->value(buffer, buffer_pos);
     	state = STATE_AFTER_VALUE;
     } else {
     	// throw new ParsingError($this->_line_number, $this->_char_number,
@@ -411,7 +411,6 @@ void JsonStreamingParser::endUnicodeSurrogateInterstitial() {
 
 void JsonStreamingParser::endNumber() {
     buffer[buffer_pos] = '\0';
-    std::string value = std::string(buffer);
     //float result = 0.0;
     //if (doesCharArrayContain(buffer, buffer_pos, '.')) {
     //  result = value.toFloat();
@@ -419,7 +418,7 @@ void JsonStreamingParser::endNumber() {
       // needed special treatment in php, maybe not in Java and c
     //  result = value.toFloat();
     //}
-    myListener->value(value.c_str());
+    myListener->value(buffer, buffer_pos);
     buffer_pos = 0;
     state = STATE_AFTER_VALUE;
 }
@@ -440,9 +439,8 @@ void JsonStreamingParser::endDocument() {
 
 void JsonStreamingParser::endTrue() {
     buffer[buffer_pos] = '\0';
-    std::string value = std::string(buffer);
-    if (value.compare("true") == 0) {
-    	myListener->value("true");
+    if (strcmp(buffer, "true") == 0) {
+    	myListener->value("true", 4);
     } else {
     	// throw new ParsingError($this->_line_number, $this->_char_number,
     	// "Expected 'true'. Got: ".$true);
@@ -453,9 +451,8 @@ void JsonStreamingParser::endTrue() {
 
 void JsonStreamingParser::endFalse() {
     buffer[buffer_pos] = '\0';
-    std::string value = std::string(buffer);
-    if (value.compare("false") == 0) {
-    	myListener->value("false");
+    if (strcmp(buffer, "false") == 0) {
+    	myListener->value("false", 5);
     } else {
     	// throw new ParsingError($this->_line_number, $this->_char_number,
     	// "Expected 'true'. Got: ".$true);
@@ -466,9 +463,8 @@ void JsonStreamingParser::endFalse() {
 
 void JsonStreamingParser::endNull() {
     buffer[buffer_pos] = '\0';
-    std::string value = std::string(buffer);
-    if (value.compare("null") == 0) {
-    	myListener->value("null");
+    if (strcmp(buffer, "null") == 0) {
+    	myListener->value("null", 4);
     } else {
     	// throw new ParsingError($this->_line_number, $this->_char_number,
     	// "Expected 'true'. Got: ".$true);
@@ -27,6 +27,7 @@ See more at http://blog.squix.ch and https://github.com/squix78/json-streaming-p
 #define JSON_PARSER_H_
 
 #include <string>
+#include <stdint.h>
 
 // Maximum string length in JSON configuration  file
 #define JSON_BUFFER_MAX_LENGTH (40)
@@ -37,8 +38,12 @@ class JsonListener {
 		virtual			~JsonListener(void)				{ }
 		virtual void	whitespace(char c)				= 0;
 		virtual void	startDocument()					= 0;
-		virtual void	key(std::string key)			= 0;
-		virtual void	value(std::string value)		= 0;
+		// The key and value are passed as the pointer into parser buffer and the string length, no heap allocation
+		virtual void	key(const char *key, uint16_t len)		{ this->key(std::string(key, len));		}
+		virtual void	value(const char *value, uint16_t len)	{ this->value(std::string(value, len));	}
+		// Old interface, called by default implementation of the functions above
+		virtual void	key(std::string key)			{ }
+		virtual void	value(std::string value)		{ }
 		virtual void	endArray()						= 0;
 		virtual void	endObject()						= 0;
 		virtual void	endDocument()					= 0;
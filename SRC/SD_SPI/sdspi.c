@@ -1,9 +1,18 @@
 /* vim: set ai et ts=4 sw=4: */
 
+#include <string.h>
 #include "sdspi.h"
 
 #define BLOCK_SIZE_HC	(512)
 
+/*
+ * 2026 OCT 18
+ *   Block payloads are transferred by single SPI DMA transaction (SPI2_RX - DMA1 Stream3, SPI2_TX - DMA1 Stream4) instead of byte by byte
+ *   The data token wait is limited by SD_TOKEN_TIMEOUT
+ *   The card is initialized at low speed, the SPI clock is restored after initialization
+ *   Multiple block read and write accept 32-bit block count, as FatFS requests
+ */
+
 static void SD_Select() {
     HAL_GPIO_WritePin(SD_CS_GPIO_Port, SD_CS_Pin, GPIO_PIN_RESET);
 }
@@ -27,14 +36,63 @@ static uint8_t SD_NotReady(void) {
 	return 0;
 }
 
+// Clock out 0xFF bytes from the buffer while reading the data into the same buffer. The transmitted byte is always ahead of the received one
 static uint8_t SD_ReadBytes(uint8_t* buff, size_t buff_size) {
-    uint8_t tx = 0xFF;
-    for ( ; buff_size > 0; --buff_size) {
-        if (HAL_OK != HAL_SPI_TransmitReceive(&SD_SPI_PORT, &tx, buff, 1, HAL_MAX_DELAY))
-        	return 1;
-        ++buff;
-    }
-    return 0;
+	memset(buff, 0xFF, buff_size);
+	if (HAL_OK != HAL_SPI_TransmitReceive(&SD_SPI_PORT, buff, buff, buff_size, HAL_MAX_DELAY))
+		return 1;
+	return 0;
+}
+
+static uint8_t SD_WaitDMA(void) {
+	uint32_t start = HAL_GetTick();
+	while (HAL_SPI_GetState(&SD_SPI_PORT) != HAL_SPI_STATE_READY) {
+		if (HAL_GetTick() - start > SD_DMA_TIMEOUT) {
+			HAL_SPI_Abort(&SD_SPI_PORT);
+			return 1;
+		}
+	}
+	return (SD_SPI_PORT.ErrorCode == HAL_SPI_ERROR_NONE)?0:1;
+}
+
+// Read data block payload
+static uint8_t SD_ReadData(uint8_t* buff, size_t buff_size) {
+	if (SD_SPI_PORT.hdmarx && SD_SPI_PORT.hdmatx) {
+		memset(buff, 0xFF, buff_size);
+		if (HAL_OK != HAL_SPI_TransmitReceive_DMA(&SD_SPI_PORT, buff, buff, buff_size))
+			return 1;
+		return SD_WaitDMA();
+	}
+	return SD_ReadBytes(buff, buff_size);
+}
+
+// Write data block payload
+static uint8_t SD_WriteData(const uint8_t* buff, size_t buff_size) {
+	if (SD_SPI_PORT.hdmatx) {
+		if (HAL_OK != HAL_SPI_Transmit_DMA(&SD_SPI_PORT, (uint8_t *)buff, buff_size))
+			return 1;
+		return SD_WaitDMA();
+	}
+	if (HAL_OK != HAL_SPI_Transmit(&SD_SPI_PORT, (uint8_t *)buff, buff_size, HAL_MAX_DELAY))
+		return 1;
+	return 0;
+}
+
+// Wait for the data packet start token. The card sends 0xFF while the data is not ready
+static uint8_t SD_WaitToken(uint8_t token) {
+	uint8_t fb;
+	uint8_t tx		= 0xFF;
+	uint32_t start	= HAL_GetTick();
+	while (1) {
+		if (HAL_OK != HAL_SPI_TransmitReceive(&SD_SPI_PORT, &tx, &fb, sizeof(fb), HAL_MAX_DELAY))
+			return 1;
+		if (fb == token)
+			return 0;
+		if (fb != 0xFF)
+			return 2;										// Error token
+		if (HAL_GetTick() - start > SD_TOKEN_TIMEOUT)
+			return 3;										// Timed out
+	}
 }
 
 static uint32_t ext_bits(uint8_t *data, int msb, int lsb) {
@@ -104,19 +162,12 @@ static uint8_t SD_DATA_CMD(SPISD_CMD cmd, uint32_t arg, uint8_t token, uint8_t *
 	    return 1;
 	}
 
-    uint8_t fb;
-    uint8_t tx = 0xFF;
-    while (1) {
-        HAL_SPI_TransmitReceive(&SD_SPI_PORT, &tx, &fb, sizeof(fb), HAL_MAX_DELAY);
-        if (fb == token)
-            break;
-        if (fb != 0xFF) {
-        	SD_Unselect();
-            return 2;
-        }
+    if (SD_WaitToken(token) != 0) {
+        SD_Unselect();
+        return 2;
     }
 
-    if (SD_ReadBytes(data, size) != 0) {
+    if (SD_ReadData(data, size) != 0) {
         SD_Unselect();
         return 3;
     }
@@ -133,7 +184,7 @@ static uint8_t SD_DATA_CMD(SPISD_CMD cmd, uint32_t arg, uint8_t token, uint8_t *
 static void SD_GetParameters(SDCARD *sd) {
 	uint8_t csd[16];
 
-	if (0 > SD_DATA_CMD(CMD9_SEND_CSD, 0, 0xFE, csd, sizeof(csd))) {
+	if (0 != SD_DATA_CMD(CMD9_SEND_CSD, 0, 0xFE, csd, sizeof(csd))) {
 		sd->type		= TYPE_NOT_READY;
 		sd->blocks		= 0;
 		sd->erase_size	= 0;
@@ -180,6 +231,8 @@ static void SD_GetParameters(SDCARD *sd) {
     };
 }
 
+static uint8_t SD_InitCard(SDCARD *sd);
+
 uint8_t SD_Init(SDCARD *sd) {
 	sd->type		= TYPE_NOT_READY;
 	sd->blocks		= 0;
@@ -187,6 +240,7 @@ uint8_t SD_Init(SDCARD *sd) {
 	sd->init_status = 12;
 
 
+	// The card must be initialized at 100-400 kHz clock, switch to the high speed when it is ready
 	uint32_t spi_speed = SD_SPI_PORT.Init.BaudRatePrescaler;
 	SD_SPI_PORT.Init.BaudRatePrescaler = SPI_BAUDRATEPRESCALER_256; // 164 kbbs
 	HAL_SPI_Init(&SD_SPI_PORT);
@@ -195,39 +249,45 @@ uint8_t SD_Init(SDCARD *sd) {
     for (uint8_t i = 0; i < 10; ++i) {
         HAL_SPI_Transmit(&SD_SPI_PORT, &high, sizeof(high), HAL_MAX_DELAY);
     }
+    sd->init_status = SD_InitCard(sd);
     SD_SPI_PORT.Init.BaudRatePrescaler = spi_speed;
     HAL_SPI_Init(&SD_SPI_PORT);
+    if (sd->init_status == 0) {
+    	SD_GetParameters(sd);								// Read CSD at high speed
+    	SD_Unselect();
+    	if (sd->type == TYPE_NOT_READY)
+    		sd->init_status = 10;
+    }
+    return sd->init_status;
+}
 
+// Initialization sequence, returns init_status
+static uint8_t SD_InitCard(SDCARD *sd) {
     if (0x01 != SD_CMD(CMD0_GO_IDLE_STATE, 0x0)) {
     	SD_Unselect();
-    	sd->init_status = 1;
-    	return sd->init_status;
+    	return 1;
     }
 
     if (0x01 != SD_CMD(CMD8_SEND_IF_COND, 0x1AA)) {
         SD_Unselect();
-        sd->init_status = 2;
-        return sd->init_status;								// not an SDHC/SDXC/SDSC card
+        return 2;
     }
     // Read R7 trailing 32-bits data from SD card
     uint8_t resp[4];
     if (SD_ReadBytes(resp, sizeof(resp)) != 0) {
     	SD_Unselect();
-    	sd->init_status = 3;
-        return sd->init_status;
+    	return 3;
     }
 
     if (((resp[2] & 0x01) != 1) || (resp[3] != 0xAA)) {
     	SD_Unselect();
-    	sd->init_status = 4;
-        return sd->init_status;
+    	return 4;
     }
 
     for (uint32_t i = 0; ; ++i) {
         if (0x01 != SD_CMD(CMD55_APP_CMD, 0)) {
             SD_Unselect();
-            sd->init_status = 5;
-            return sd->init_status;
+            return 5;
         }
 
         uint8_t r1 = SD_CMD(ACMD41_APP_SEND_OP_COND, 0x40000000);
@@ -236,26 +296,22 @@ uint8_t SD_Init(SDCARD *sd) {
 
         if (r1 != 0x01){
             SD_Unselect();
-            sd->init_status = 6;
-            return sd->init_status;
+            return 6;
         }
 
         HAL_Delay(1);
         if (i > 30000) {
-        	sd->init_status = 11;
-        	return sd->init_status;							// Timed out
+        	return 11;										// Timed out
         }
     }
 
     if (0x00 != SD_CMD(CMD58_READ_OCR, 0)) {
         SD_Unselect();
-        sd->init_status = 7;
-        return sd->init_status;
+        return 7;
     }
     if (SD_ReadBytes(resp, sizeof(resp)) != 0) {
     	SD_Unselect();
-    	sd->init_status = 8;
-        return sd->init_status;
+    	return 8;
     }
 
     sd->type = TYPE_SDHC;
@@ -263,30 +319,21 @@ uint8_t SD_Init(SDCARD *sd) {
     	sd->type = TYPE_SDSC;
     	if (0x00 != SD_CMD(CMD16_SET_BLOCKLEN, BLOCK_SIZE_HC)) {
     		SD_Unselect();
-    		sd->init_status = 9;
-    		return sd->init_status;
+    		return 9;
     	}
     }
-
-    SD_GetParameters(sd);
     SD_Unselect();
-
-    if (sd->type == TYPE_NOT_READY) {
-    	sd->init_status = 10;
-    } else {
-    	sd->init_status = 0;
-    }
-    return sd->init_status;
+    return 0;
 }
 
-uint8_t	SD_Read(SDCARD *sd, uint32_t start_block, uint8_t count, uint8_t* data) {
+uint8_t	SD_Read(SDCARD *sd, uint32_t start_block, uint32_t count, uint8_t* data) {
 	if (count == 1) {
 		return SD_ReadSingleBlock(sd, start_block, data);
 	}
 	return SD_ReadBlocks(sd, start_block, count, data);
 }
 
-uint8_t	SD_Write(SDCARD *sd, uint32_t start_block, uint8_t count, const uint8_t* data) {
+uint8_t	SD_Write(SDCARD *sd, uint32_t start_block, uint32_t count, const uint8_t* data) {
 	if (count == 1) {
 		return SD_WriteSingleBlock(sd, start_block, data);
 	}
@@ -326,7 +373,10 @@ uint8_t SD_WriteSingleBlock(SDCARD *sd, uint32_t block_num, const uint8_t* data)
     uint8_t data_token = 0xFE;								// Data start token
     uint8_t crc[2] = { 0xFF, 0xFF };
     HAL_SPI_Transmit(&SD_SPI_PORT, &data_token, sizeof(data_token), HAL_MAX_DELAY);
-    HAL_SPI_Transmit(&SD_SPI_PORT, (uint8_t*)data, BLOCK_SIZE_HC, HAL_MAX_DELAY);
+    if (SD_WriteData(data, BLOCK_SIZE_HC) != 0) {
+        SD_Unselect();
+        return 4;
+    }
     HAL_SPI_Transmit(&SD_SPI_PORT, crc, sizeof(crc), HAL_MAX_DELAY);
 
     /*
@@ -349,7 +399,7 @@ uint8_t SD_WriteSingleBlock(SDCARD *sd, uint32_t block_num, const uint8_t* data)
     return 0;
 }
 
-uint8_t SD_ReadBlocks(SDCARD *sd, uint32_t start_block, uint8_t count, uint8_t* data) {
+uint8_t SD_ReadBlocks(SDCARD *sd, uint32_t start_block, uint32_t count, uint8_t* data) {
 	uint8_t crc[2];
 
 	if (count == 0)
@@ -371,22 +421,15 @@ uint8_t SD_ReadBlocks(SDCARD *sd, uint32_t start_block, uint8_t count, uint8_t*
 	}
 
 	// Read data stream by blocks (512 bytes)
-	for (uint8_t i = 0; i < count; ++i) {
+	for (uint32_t i = 0; i < count; ++i) {
 		// Each data packet starts with 'start token', 0xFE
-		uint8_t fb;
-		uint8_t tx = 0xFF;
-		while (1) {
-			HAL_SPI_TransmitReceive(&SD_SPI_PORT, &tx, &fb, sizeof(fb), HAL_MAX_DELAY);
-			if (fb == 0xFE)
-				break;
-			if (fb != 0xFF) {
-				SD_Unselect();
-				return 4;
-			}
+		if (SD_WaitToken(0xFE) != 0) {
+			SD_Unselect();
+			return 4;
 		}
 
 		// Read data packet
-		if (SD_ReadBytes(data+i*BLOCK_SIZE_HC, BLOCK_SIZE_HC) != 0) {
+		if (SD_ReadData(data+i*BLOCK_SIZE_HC, BLOCK_SIZE_HC) != 0) {
 			SD_Unselect();
 			return 5;
 		}
@@ -425,7 +468,7 @@ uint8_t SD_ReadBlocks(SDCARD *sd, uint32_t start_block, uint8_t count, uint8_t*
     return 0;
 }
 
-uint8_t SD_WriteSBlocks(SDCARD *sd, uint32_t start_block, uint8_t count, const uint8_t* data) {
+uint8_t SD_WriteSBlocks(SDCARD *sd, uint32_t start_block, uint32_t count, const uint8_t* data) {
 	if (count == 0)
 		return 0;
 	if (sd->type == TYPE_NOT_READY)
@@ -436,7 +479,7 @@ uint8_t SD_WriteSBlocks(SDCARD *sd, uint32_t start_block, uint8_t count, const u
 		count = sd->blocks - start_block;
 	}
 	if (sd->type == TYPE_SDSC)
-		count *= BLOCK_SIZE_HC;
+		start_block *= BLOCK_SIZE_HC;						// SDSC card is addressed in bytes
 
 	if (0 != SD_CMD(CMD25_WRITE_MULTIPLE_BLOCK, start_block)) {
 		SD_Unselect();
@@ -444,12 +487,15 @@ uint8_t SD_WriteSBlocks(SDCARD *sd, uint32_t start_block, uint8_t count, const u
 	}
 
 	// Write data stream by blocks (512 bytes)
-	for (uint8_t i = 0; i < count; ++i) {
+	for (uint32_t i = 0; i < count; ++i) {
 		// First send starting token, then data buffer and CRC
 		uint8_t data_token = 0xFC;							// Data start token
 		uint8_t crc[2] = { 0xFF, 0xFF };
 		HAL_SPI_Transmit(&SD_SPI_PORT, &data_token, sizeof(data_token), HAL_MAX_DELAY);
-		HAL_SPI_Transmit(&SD_SPI_PORT, (uint8_t *)data+i*BLOCK_SIZE_HC, BLOCK_SIZE_HC, HAL_MAX_DELAY);
+		if (SD_WriteData(data+i*BLOCK_SIZE_HC, BLOCK_SIZE_HC) != 0) {
+			SD_Unselect();
+			return 4;
+		}
 		HAL_SPI_Transmit(&SD_SPI_PORT, crc, sizeof(crc), HAL_MAX_DELAY);
 
 		/*
@@ -7,6 +7,13 @@
 #define SD_SPI_PORT      hspi2
 extern SPI_HandleTypeDef SD_SPI_PORT;
 
+/*
+ * The data blocks are transferred by DMA: SPI2_RX and SPI2_TX streams are linked to the SD_SPI_PORT in CubeMX.
+ * If the streams are not linked, the block is transferred by single blocking transfer
+ */
+#define SD_DMA_TIMEOUT	(100)								// ms, 512-byte block transfer timeout
+#define SD_TOKEN_TIMEOUT (200)								// ms, data token wait timeout (the card read access time is up to 100 ms)
+
 typedef enum e_sd_type {
 	TYPE_NOT_READY = 0, TYPE_SDSC, TYPE_SDHC
 } SD_TYPE;
@@ -40,13 +47,13 @@ extern "C" {
 // all procedures return 0 on success, > 0 on failure
 uint8_t		SD_Init(SDCARD *sd);
 
-uint8_t		SD_Read(SDCARD *sd, uint32_t start_block, uint8_t count, uint8_t* data);
-uint8_t		SD_Write(SDCARD *sd, uint32_t start_block, uint8_t count, const uint8_t* data);
+uint8_t		SD_Read(SDCARD *sd, uint32_t start_block, uint32_t count, uint8_t* data);
+uint8_t		SD_Write(SDCARD *sd, uint32_t start_block, uint32_t count, const uint8_t* data);
 
 uint8_t 	SD_ReadSingleBlock(SDCARD *sd,  uint32_t block_num, uint8_t* data); // sizeof(data) == 512!
 uint8_t		SD_WriteSingleBlock(SDCARD *sd, uint32_t block_num, const uint8_t* data); // sizeof(data) == 512!
-uint8_t		SD_ReadBlocks(SDCARD *sd, uint32_t start_block, uint8_t count, uint8_t* data);
-uint8_t		SD_WriteSBlocks(SDCARD *sd, uint32_t start_block, uint8_t count, const uint8_t* data);
+uint8_t		SD_ReadBlocks(SDCARD *sd, uint32_t start_block, uint32_t count, uint8_t* data);
+uint8_t		SD_WriteSBlocks(SDCARD *sd, uint32_t start_block, uint32_t count, const uint8_t* data);
 
 #ifdef __cplusplus
 }
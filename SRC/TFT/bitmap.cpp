@@ -8,6 +8,7 @@
 #include <string.h>
 #include <stdlib.h>
 #include "bitmap.h"
+#include "pool.h"
 #include "common.h"
 
 BITMAP::BITMAP(uint16_t width, uint16_t height) {
@@ -15,7 +16,7 @@ BITMAP::BITMAP(uint16_t width, uint16_t height) {
 	if (width == 0 || height == 0) return;
 
 	uint8_t	bytes_per_row = (width+7) >> 3;
-	ds = (struct data *)calloc(sizeof(struct data) + height * bytes_per_row, sizeof(uint8_t));
+	ds = (struct data *)TFT_PoolCalloc(sizeof(struct data) + height * bytes_per_row);
 	if (!ds) return;
 	ds->w 		= width;
 	ds->h 		= height;
@@ -49,7 +50,7 @@ BITMAP::BITMAP(const BITMAP &bm) {
 BITMAP&	BITMAP::operator=(const BITMAP &bm) {
 	if (this != &bm) {
 		if (ds != 0 && --(this->ds->links) == 0) {
-			free(ds);
+			TFT_PoolFree(ds);
 		}
 		this->ds = bm.ds;
 		++ds->links;
@@ -60,7 +61,7 @@ BITMAP&	BITMAP::operator=(const BITMAP &bm) {
 BITMAP::~BITMAP(void) {
 	if (!ds) return;
 	if (--ds->links > 0) return;						// Destroy yet another copy of the bitmap
-	free(ds);
+	TFT_PoolFree(ds);
 	ds = 0;
 }
 
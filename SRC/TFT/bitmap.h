@@ -13,7 +13,7 @@
 #include "u8g_font.h"
 
 /*
- * Bitmap data structure allocated in memory
+ * Bitmap data structure allocated in the memory pool, see pool.h
  * the space to store bitmap width and height is allocated together
  * with the space for bitmap itself
  * Each bitmap instance is allocated just once
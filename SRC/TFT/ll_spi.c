@@ -99,6 +99,7 @@ static uint16_t	buff_border					= BURST_HALF_SIZE; // We can write data to the b
 
 // Complete buffer sent callback procedure
 void HAL_SPI_TxCpltCallback(SPI_HandleTypeDef *hspi) {
+	if (hspi == &TFT_SPI_PORT)				// The SD card SPI port uses DMA too
 		buff_sending = 2;						// DMA buffer sending is complete
 }
 
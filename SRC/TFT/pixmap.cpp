@@ -6,16 +6,22 @@
 #include <string.h>
 #include <stdlib.h>
 #include "pixmap.h"
+#include "pool.h"
 #include "common.h"
 
+// The memory size required by the pixmap: data structure, color palette and the pixmap data
+uint32_t PIXMAP::memSize(uint16_t width, uint16_t height, uint8_t depth) {
+	uint16_t colors = 1 << depth;
+	uint32_t bytes_per_row = (depth*width+7) >> 3;
+	return sizeof(struct p_data) + colors * sizeof(uint16_t) + height * bytes_per_row;
+}
+
 PIXMAP::PIXMAP(uint16_t width, uint16_t height, uint8_t depth) {
 	ds = 0;
 	if (width == 0 || height == 0 || depth == 0 || depth > 8) return;
 
-	uint8_t colors = 1 << depth;
-	uint16_t bytes_per_row = (depth*width+7) >> 3;
 	// Allocate memory to store whole data structure, color patette and the pixmap data
-	ds = (struct p_data *)calloc(sizeof(struct p_data) + colors * sizeof(uint16_t) + height * bytes_per_row, sizeof(uint8_t));
+	ds = (struct p_data *)TFT_PoolCalloc(memSize(width, height, depth));
 	if (!ds) return;
 	ds->w 		= width;
 	ds->h 		= height;
@@ -32,7 +38,7 @@ PIXMAP::PIXMAP(const PIXMAP &bm) {
 PIXMAP&	PIXMAP::operator=(const PIXMAP &pm) {
 	if (this != &pm) {
 		if (ds != 0 && --(ds->links) == 0) {
-			free(ds);
+			TFT_PoolFree(ds);
 		}
 		this->ds = pm.ds;
 		++ds->links;
@@ -43,7 +49,7 @@ PIXMAP&	PIXMAP::operator=(const PIXMAP &pm) {
 PIXMAP::~PIXMAP(void) {
 	if (!ds) return;
 	if (--ds->links > 0) return;								// Destroy yet another copy of the bitmap
-	free(ds);
+	TFT_PoolFree(ds);
 	ds = 0;
 }
 
@@ -15,7 +15,7 @@
  * Pixmap is a multi-color icon with predefined palette of colors.
  * Supported depth: 1-8, number of colors 2, 4, 8, 16, ... 256
  * Each pixel coded by several bits in the pixmap-array.
- * Pixmap data structure is allocated in memory by malloc() call.
+ * Pixmap data structure is allocated in the memory pool, see pool.h
  * The space to store pixmap, pallete, width and height is allocated together
  * with the space for pixmap itself
  * Each pixmap instance is allocated just once
@@ -37,6 +37,7 @@ class PIXMAP {
 		PIXMAP(const PIXMAP &bm);
 		PIXMAP&		operator=(const PIXMAP &pm);
 		~PIXMAP(void);
+		static uint32_t	memSize(uint16_t width, uint16_t height, uint8_t depth);
 		uint8_t*	pixmap(void)								{ return (ds)?ds->data:0;	}
 		uint8_t		depth(void)									{ return (ds)?ds->depth:0;	}
 		uint16_t	width(void)									{ return (ds)?ds->w:0;		}
@@ -0,0 +1,124 @@
+/*
+ * pool.c
+ *
+ *  Created on: 2026 OCT 18
+ *      Author: Alex
+ *
+ *  The pool is used from the main loop only, the functions are not re-entrant.
+ *  2026 OCT 18
+ *  	The heap fallback for the big requests removed, the PID graph pixmap has its own block
+ *  	The largest class serves only the requests that do not fit the other classes
+ */
+
+#include <string.h>
+#include "pool.h"
+
+/*
+ * Size classes are selected for 320x240 screen and the fonts used by the controller:
+ *   64   - small icons and check boxes
+ *   256  - power gauge (13 x 56), preset temperature (3 letters)
+ *   512  - internal units value, fan speed (110 x 24), calibration power gauge (20 x 110), PID graph history
+ *   1280 - big temperature digits, menu item line (300 x 24)
+ *   10K  - PID graph pixmap: 228 x 177 pixels, 2 bits per pixel with default font, see DSPL::pidStart()
+ */
+static const uint16_t	block_size[TFT_POOL_CLASSES]	= {   64,  256,  512, 1280, TFT_POOL_MAX_BLOCK };
+static const uint8_t	block_num[TFT_POOL_CLASSES]		= {    8,    6,    6,    3,                  1 };
+#define POOL_ARENA_SIZE		(64*8 + 256*6 + 512*6 + 1280*3 + TFT_POOL_MAX_BLOCK*1)
+
+typedef struct s_block t_block;
+struct s_block {
+	t_block		*next;											// The next free block in the list
+};
+
+static uint32_t		arena[POOL_ARENA_SIZE/sizeof(uint32_t)];	// 32-bits aligned memory for all the blocks
+static uint8_t		*cls_begin[TFT_POOL_CLASSES];				// The first block of the class
+static t_block		*free_list[TFT_POOL_CLASSES]	= {0};
+static uint8_t		used[TFT_POOL_CLASSES]			= {0};
+static uint8_t		peak[TFT_POOL_CLASSES]			= {0};
+static bool			ready		= false;
+static uint32_t		failures	= 0;
+static uint32_t		oversized	= 0;
+
+// Link all the blocks of every class into its free list
+static void TFT_PoolInit(void) {
+	uint8_t *p = (uint8_t *)arena;
+	for (uint8_t c = 0; c < TFT_POOL_CLASSES; ++c) {
+		cls_begin[c]	= p;
+		free_list[c]	= 0;
+		for (int16_t i = block_num[c]-1; i >= 0; --i) {			// Build the list in the address order
+			t_block *b = (t_block *)(p + i * block_size[c]);
+			b->next = free_list[c];
+			free_list[c] = b;
+		}
+		p += block_size[c] * block_num[c];
+	}
+	ready = true;
+}
+
+// Returns the class index of the pool block or -1 if the pointer does not belong to the pool
+static int8_t TFT_PoolClass(void *ptr) {
+	uint8_t *p = (uint8_t *)ptr;
+	if (p < (uint8_t *)arena || p >= (uint8_t *)arena + sizeof(arena))
+		return -1;
+	for (int8_t c = TFT_POOL_CLASSES-1; c >= 0; --c) {
+		if (p >= cls_begin[c])
+			return c;
+	}
+	return -1;
+}
+
+void* TFT_PoolAlloc(uint32_t size) {
+	if (size == 0) return 0;
+	if (!ready) TFT_PoolInit();
+	if (size > block_size[TFT_POOL_CLASSES-1]) {				// Too big for the pool
+		++oversized;
+		return 0;
+	}
+	uint8_t last = TFT_POOL_CLASSES-1;							// The largest block is reserved for the PID graph pixmap
+	if (size <= block_size[last-1]) --last;
+	for (uint8_t c = 0; c <= last; ++c) {
+		if (size > block_size[c] || free_list[c] == 0)
+			continue;
+		t_block *b = free_list[c];
+		free_list[c] = b->next;
+		if (++used[c] > peak[c])
+			peak[c] = used[c];
+		return b;
+	}
+	++failures;
+	return 0;
+}
+
+void* TFT_PoolCalloc(uint32_t size) {
+	void *ptr = TFT_PoolAlloc(size);
+	if (ptr)
+		memset(ptr, 0, size);
+	return ptr;
+}
+
+void TFT_PoolFree(void *ptr) {
+	if (!ptr) return;
+	int8_t c = TFT_PoolClass(ptr);
+	if (c < 0) return;											// Not a pool block
+	t_block *b = (t_block *)ptr;
+	b->next = free_list[c];
+	free_list[c] = b;
+	if (used[c] > 0) --used[c];
+}
+
+bool TFT_PoolStat(uint8_t cls, t_pool_stat *stat) {
+	if (cls >= TFT_POOL_CLASSES || !stat) return false;
+	stat->size		= block_size[cls];
+	stat->blocks	= block_num[cls];
+	stat->used		= used[cls];
+	stat->peak		= peak[cls];
+	return true;
+}
+
+uint32_t TFT_PoolFailures(void) {
+	return failures;
+}
+
+uint32_t TFT_PoolOversized(void) {
+	return oversized;
+}
@@ -0,0 +1,49 @@
+/*
+ * pool.h
+ *
+ *  Created on: 2026 OCT 18
+ *      Author: Alex
+ *
+ *  Fixed-block memory pool for BITMAP, PIXMAP, REGION and other display buffers.
+ *  The pool arena is allocated statically and split into several size classes. Each class keeps
+ *  the list of free blocks, so allocation and release take constant time and never fragment the heap.
+ *  The request is served by the smallest class having a free block. When all suitable classes are exhausted,
+ *  the request is refused and counted, the heap is never used. The largest class is a single block reserved
+ *  for the biggest display buffer, the PID graph pixmap: it serves only the requests bigger than the other classes,
+ *  the small requests never spill into it. The requests bigger than TFT_POOL_MAX_BLOCK are refused
+ *  and counted separately. Both counters are shown in the debug mode.
+ *  The arena takes 19200 bytes of .bss permanently.
+ */
+
+#ifndef _POOL_H_
+#define _POOL_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define TFT_POOL_CLASSES	(5)
+#define TFT_POOL_MAX_BLOCK	(10240)									// The largest block size, bytes
+
+typedef struct s_pool_stat {
+	uint16_t	size;											// The block size of the class, bytes
+	uint8_t		blocks;											// The number of blocks in the class
+	uint8_t		used;											// The number of blocks allocated now
+	uint8_t		peak;											// The maximum number of blocks allocated at the same time
+} t_pool_stat;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void*		TFT_PoolAlloc(uint32_t size);
+void*		TFT_PoolCalloc(uint32_t size);
+void		TFT_PoolFree(void *ptr);
+bool		TFT_PoolStat(uint8_t cls, t_pool_stat *stat);
+uint32_t	TFT_PoolFailures(void);								// The number of refused requests: pool exhausted
+uint32_t	TFT_PoolOversized(void);							// The number of refused requests: bigger than TFT_POOL_MAX_BLOCK
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
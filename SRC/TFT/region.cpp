@@ -7,6 +7,7 @@
 #ifdef TFT_BMP_JPEG_ENABLE
 
 #include "region.h"
+#include "pool.h"
 #include "ff.h"
 #include "picture.h"
 
@@ -14,7 +15,7 @@
 REGION::REGION(uint32_t size) {
 	if (size == 0) return;
 	// Allocate memory to store whole data structure and the pixmap data
-	ds = (struct r_data *)malloc(sizeof(struct r_data) + size * 2); // Size is the number of 16-bits words
+	ds = (struct r_data *)TFT_PoolAlloc(sizeof(struct r_data) + size * 2); // Size is the number of 16-bits words
 	if (!ds) return;
 	ds->w 		= 1;							// Non-zero means the data allocated successfully
 	ds->h 		= 1;
@@ -26,7 +27,7 @@ REGION::REGION(uint16_t width, uint16_t height) {
 	if (width == 0 || height == 0) return;
 
 	// Allocate memory to store whole data structure and the pixmap data
-	ds = (struct r_data *)calloc(sizeof(struct r_data) + width * height, sizeof(uint16_t));
+	ds = (struct r_data *)TFT_PoolCalloc(sizeof(struct r_data) + (uint32_t)width * height * sizeof(uint16_t));
 	if (!ds) return;
 	ds->w 		= width;
 	ds->h 		= height;
@@ -52,7 +53,7 @@ REGION::REGION(const REGION &rn) {
 REGION&	REGION::operator=(const REGION &rg) {
 	if (this != &rg) {
 		if (ds != 0 && --(ds->links) == 0) {
-			free(ds);
+			TFT_PoolFree(ds);
 		}
 		this->ds = rg.ds;
 		++ds->links;
@@ -63,7 +64,7 @@ REGION&	REGION::operator=(const REGION &rg) {
 REGION::~REGION(void) {
 	if (!ds) return;
 	if (--ds->links > 0) return;				// Destroy yet another copy of the region
-	free(ds);
+	TFT_PoolFree(ds);
 	ds = 0;
 }
 
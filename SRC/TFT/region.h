@@ -17,7 +17,7 @@
 
 /*
  * Region is a full-color rectangular area to be drawn in the screen.
- * Region data structure is allocated in memory by malloc() call.
+ * Region data structure is allocated in the memory pool, see pool.h
  * Each Region instance is allocated just once
  * All other copies are just "links" to the main instance
  */
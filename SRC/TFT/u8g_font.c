@@ -87,6 +87,10 @@ static u8g2_uint_t		u8g2_font_calc_vref_bottom(u8g2_t *u8g2);
 static u8g2_uint_t 		u8g2_font_calc_vref_top(u8g2_t *u8g2);
 static u8g2_uint_t		u8g2_font_calc_vref_center(u8g2_t *u8g2);
 
+// The font, which glyphs are read by the callback function. Only the font header is in the memory
+static const uint8_t	*ext_font		= 0;
+static u8g2_glyph_cb	ext_glyph_cb	= 0;
+static void				*ext_ctx		= 0;
 
 void u8g2_u8gFont(u8g2_t *u8g2) {
 	u8g2->font = 0;
@@ -98,6 +102,12 @@ void u8g2_u8gFont(u8g2_t *u8g2) {
 	u8g2_SetFontPosBaseline(u8g2);
 }
 
+void u8g2_SetExternalFont(const uint8_t *font, u8g2_glyph_cb glyph_cb, void *ctx) {
+	ext_font		= font;
+	ext_glyph_cb	= glyph_cb;
+	ext_ctx			= ctx;
+}
+
 void u8g2_SetFont(u8g2_t *u8g2, const uint8_t  *font) {
 	if (u8g2->font != font ) {
 		u8g2->font	= font;
@@ -318,6 +328,8 @@ static void u8g2_UpdateRefHeight(u8g2_t *u8g2) {
  *   	Address of the glyph data or 0, if the encoding is not avialable in the font.
  */
 static const uint8_t *u8g2_font_get_glyph_data(u8g2_t *u8g2, uint16_t encoding) {
+	if (ext_glyph_cb && u8g2->font == ext_font)
+		return ext_glyph_cb(ext_ctx, encoding);
 	const uint8_t *font = u8g2->font;
 	font += U8G2_FONT_DATA_STRUCT_SIZE;
 
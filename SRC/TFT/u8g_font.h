@@ -109,7 +109,11 @@ typedef enum {
 	align_left = 0, align_center, align_right
 } BM_ALIGN;
 
+// The callback to get the glyph data of the font, that is not loaded into the memory
+typedef const uint8_t* (*u8g2_glyph_cb)(void *ctx, uint16_t encoding);
+
 void		u8g2_u8gFont(u8g2_t *u8g2);
+void		u8g2_SetExternalFont(const uint8_t *font, u8g2_glyph_cb glyph_cb, void *ctx);
 void 		u8g2_SetFont(u8g2_t *u8g2, const uint8_t  *font);
 void 		u8g2_SetFontMode(u8g2_t *u8g2, uint8_t is_transparent, uint16_t bg_color);
 void		u8g2_SetFontScale(u8g2_t *u8g2, uint8_t scale);
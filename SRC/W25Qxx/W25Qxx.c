@@ -12,6 +12,13 @@
  *
  *  2024 Feb 10
  *  	Fixed QSPI support. Write enable now start working
+ *
+ *  2026 Oct 18
+ *  	W25Qxx_Write() does not wait for the last page to be programmed. Every operation waits for the device ready first,
+ *  	so the caller can read next data block from another SPI device while the flash is busy.
+ *  	W25Qxx_Wait() polls the status register without delay for the first few milliseconds (page program time)
+ *  	Added W25Qxx_Program() to program erased area without the sector check and W25Qxx_Sync() to wait for the last operation
+ *  	Added W25Qxx_EraseStart() to erase the sector ahead of time without waiting for the erase to finish
  */
 
 #include "W25Qxx.h"
@@ -65,9 +72,9 @@ static bool			W25Qxx_WriteEnable(void);
 static uint32_t		W25Qxx_JEDEC_ID(void);
 static uint16_t		W25Qxx_Status(bool r1_only);
 static bool			W25Qxx_Command(uint8_t cmd);
-static bool			W25Qxx_EraseSector(uint32_t addr);
+static bool			W25Qxx_EraseSector(uint32_t addr, bool wait);
 static bool			W25Qxx_ProgramPage(uint32_t addr, uint8_t buff[256]);
-static bool			W25Qxx_EraseSector(uint32_t addr);
+static bool			W25Qxx_EraseSector(uint32_t addr, bool wait);
 static bool			W25Qxx_Wait(uint32_t to);
 static bool			W25Qxx_IsSectorEmpty(uint32_t addr);
 
@@ -231,23 +238,40 @@ W25Qxx_RET W25Qxx_Write(uint32_t addr, uint8_t buff[], uint16_t size) {
 
 	// If we are trying to write to the begin of the sector, check the sector has been erased
 	if (((addr & 0xFFF) == 0) && !W25Qxx_IsSectorEmpty(addr))
-		if (!W25Qxx_EraseSector(addr))
+		if (!W25Qxx_EraseSector(addr, true))
 			return W25Qxx_RET_ERASE;
 
+	return W25Qxx_Program(addr, buff, size);
+}
+
+// Program the erased area by 256-bytes pages. The last page is not waited for, see W25Qxx_Sync()
+W25Qxx_RET W25Qxx_Program(uint32_t addr, uint8_t buff[], uint16_t size) {
+	if (addr & 0xFF)										// Address should be aligned to the page border
+		return W25Qxx_RET_ALIGN;
+	if (size < 0x100 || (size & 0xFF))
+		return W25Qxx_RET_SIZE;
+	if (sector_count < (addr >> 12))						// addr / 4096
+		return W25Qxx_RET_ADDR;
+
 	if (!W25Qxx_Wait(5000))									// Wait for erase process to finish
 		return W25Qxx_RES_BUSY;
 
 	// Write data by 256-bytes long pages
 	for (uint16_t start = 0; start < size; start += 256) {
+		if (start > 0 && !W25Qxx_Wait(1000))				// Wait for previous page programmed. The last page is not waited for
+			return W25Qxx_RES_BUSY;
 		if (!W25Qxx_ProgramPage(addr, &buff[start]))
 			return W25Qxx_RET_WRITE;
 		addr += 256;
-		if (!W25Qxx_Wait(1000))								// Wait for device ready
-			return W25Qxx_RES_BUSY;
 	}
 	return W25Qxx_RET_OK;
 }
 
+// Wait for the last page program to finish
+W25Qxx_RET W25Qxx_Sync(void) {
+	return W25Qxx_Wait(1000)?W25Qxx_RET_OK:W25Qxx_RES_BUSY;
+}
+
 W25Qxx_RET W25Qxx_Erase(uint16_t start_sector, uint16_t n_sectors) {
 	if (n_sectors == 0)
 		return W25Qxx_RET_SIZE;
@@ -258,7 +282,7 @@ W25Qxx_RET W25Qxx_Erase(uint16_t start_sector, uint16_t n_sectors) {
 
 	for (uint16_t i = 0; i < n_sectors; ++i) {
 		uint32_t addr = (start_sector+i) << 12;				// 4k sector to byte address
-		if (!W25Qxx_EraseSector(addr))
+		if (!W25Qxx_EraseSector(addr, true))
 			return W25Qxx_RET_ERASE;
 
 		if (!W25Qxx_Wait(5000))								// Wait for erase process to finish
@@ -267,6 +291,15 @@ W25Qxx_RET W25Qxx_Erase(uint16_t start_sector, uint16_t n_sectors) {
 	return W25Qxx_RET_OK;
 }
 
+// Start the sector erase and return at once. The next operation waits for the erase to finish
+W25Qxx_RET W25Qxx_EraseStart(uint16_t sector) {
+	if (sector_count <= sector)
+		return W25Qxx_RET_ADDR;
+	if (!W25Qxx_Wait(5000))									// Wait for the previous operation to finish
+		return W25Qxx_RES_BUSY;
+	return W25Qxx_EraseSector((uint32_t)sector << 12, false)?W25Qxx_RET_OK:W25Qxx_RET_ERASE;
+}
+
 static bool W25Qxx_WriteEnable(void)  {
 	uint16_t stat = W25Qxx_Status(true);
 	if ((stat & S_WEL) == 0) {								// Read only
@@ -438,7 +471,7 @@ static bool W25Qxx_ProgramPage(uint32_t addr, uint8_t buff[256]) {
 	return res;
 }
 
-static bool W25Qxx_EraseSector(uint32_t addr) {
+static bool W25Qxx_EraseSector(uint32_t addr, bool wait) {
 	if (sector_count < (addr >> 12))							// addr / 4096
 		return false;
 	if (!W25Qxx_WriteEnable())
@@ -464,7 +497,7 @@ static bool W25Qxx_EraseSector(uint32_t addr) {
 
 	if (HAL_OK != HAL_QSPI_Command(&FLASH_QSPI, &scmd, HAL_QSPI_TIMEOUT_DEFAULT_VALUE))
 		return false;
-	if (W25Qxx_Wait(1000))						// Wait for device ready
+	if (!wait || W25Qxx_Wait(1000))				// Wait for device ready
 		return true;
 	return false;
 }
@@ -567,16 +600,14 @@ static bool W25Qxx_ProgramPage(uint32_t addr, uint8_t buff[256]) {
 	}
 	W25Qxx_Select();
 	if (HAL_OK == HAL_SPI_Transmit(&FLASH_SPI_PORT, (uint8_t *)cmd, cmd_length, 100)) {
-		if (HAL_OK == HAL_SPI_Transmit(&FLASH_SPI_PORT, (uint8_t *)buff, 256, 1000)) {
-			W25Qxx_Unselect();
-			res = W25Qxx_Wait(1000);
-		}
+		if (HAL_OK == HAL_SPI_Transmit(&FLASH_SPI_PORT, (uint8_t *)buff, 256, 1000))
+			res = true;										// The page is being programmed now, see W25Qxx_Write()
 	}
 	W25Qxx_Unselect();
 	return res;
 }
 
-static bool W25Qxx_EraseSector(uint32_t addr) {
+static bool W25Qxx_EraseSector(uint32_t addr, bool wait) {
 	if (!W25Qxx_WriteEnable())
 		return false;
 
@@ -585,7 +616,7 @@ static bool W25Qxx_EraseSector(uint32_t addr) {
 	W25Qxx_Select();
 	if (HAL_OK == HAL_SPI_Transmit(&FLASH_SPI_PORT, (uint8_t *)cmd, 4, 100)) {
 		W25Qxx_Unselect();
-		if (W25Qxx_Wait(10000)) {
+		if (!wait || W25Qxx_Wait(10000)) {
 			return true;
 		}
 	}
@@ -594,7 +625,8 @@ static bool W25Qxx_EraseSector(uint32_t addr) {
 }
 
 static bool W25Qxx_Wait(uint32_t to) {
-	uint32_t end = HAL_GetTick() + to;
+	uint32_t start	= HAL_GetTick();
+	uint32_t end	= start + to;
 	uint8_t t_data[2] = { CMD_STAT_R1_05, 0 };
 	uint8_t r_data[2] = {0};
 	while (1) {
@@ -607,7 +639,8 @@ static bool W25Qxx_Wait(uint32_t to) {
 		if (r_data[1] & S_BUSY) {
 			if (HAL_GetTick() >= end)
 				return false;
-			HAL_Delay(10);
+			if (HAL_GetTick() - start > 2)					// Page program takes less than 3 ms, poll it without delay
+				HAL_Delay(1);
 		} else {
 			return true;
 		}
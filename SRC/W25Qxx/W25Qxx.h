@@ -89,7 +89,10 @@ bool		W25Qxx_Init(void);
 uint16_t	W25Qxx_SectorCount(void);
 W25Qxx_RET	W25Qxx_Read(uint32_t addr, uint8_t buff[], uint16_t size);
 W25Qxx_RET	W25Qxx_Write(uint32_t addr, uint8_t buff[], uint16_t size);
+W25Qxx_RET	W25Qxx_Program(uint32_t addr, uint8_t buff[], uint16_t size);	// Program erased area, no sector erase
+W25Qxx_RET	W25Qxx_Sync(void);									// Wait for the last program operation to finish
 W25Qxx_RET	W25Qxx_Erase(uint16_t start_sector, uint16_t n_sectors);
+W25Qxx_RET	W25Qxx_EraseStart(uint16_t sector);					// Start the sector erase, do not wait for it
 
 #ifdef QSPI
 bool		W25Qxx_QSPI_MemoryMapped(void);
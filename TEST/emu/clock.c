@@ -0,0 +1,29 @@
+/*
+ * clock.c
+ *
+ *  Created on: 2026 OCT 18
+ *      Author: Alex
+ *
+ *  Emulated millisecond clock instead of SysTick
+ */
+
+#include "main.h"
+#include "emu.h"
+
+static uint32_t	tick	= 0;
+
+uint32_t HAL_GetTick(void) {
+	return tick;
+}
+
+void HAL_Delay(uint32_t delay) {
+	tick += delay;
+}
+
+void EMU_ClockAdvance(uint32_t ms) {
+	tick += ms;
+}
+
+void EMU_ClockSet(uint32_t ms) {
+	tick = ms;
+}
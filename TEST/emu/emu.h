@@ -0,0 +1,87 @@
+/*
+ * emu.h
+ *
+ *  Created on: 2026 OCT 18
+ *      Author: Alex
+ *
+ *  Host emulation of the hardware used by the modules under test.
+ *  The W25Qxx flash and the SD-CARD are RAM images behind the original driver API (W25Qxx.h, sdspi.h),
+ *  so the original FatFS glue (diskio.c) works on top of them.
+ *  The flash image keeps the NOR flash rules: the page program can only clear bits, the sector erase sets all bits.
+ *  The clock is a millisecond counter, advanced by the test or by the emulated device operations.
+ *  The GPIO port is the input data register the test sets by EMU_GpioSet().
+ *  The SD-CARD in SPI mode (spi_sd.c) answers the original sdspi.c driver on hspi2: SDHC initialization, block read and write.
+ *  The SPI transfer advances the clock by 1 ms per 1000 bytes, the DMA transfer completes at once unless it is stalled.
+ *  USART1 (huart1) has circular reception to idle and transmission by DMA. The test feeds the received bytes,
+ *  the emulator calls the HAL callbacks on half, full transfer and idle line, like the HAL interrupt handlers do.
+ *  The transmission is completed by the test, so the test decides when the TX interrupt comes.
+ *  The heap counter (heap.cpp) counts the allocations of malloc() and C++ new, the live blocks and bytes, the peak.
+ */
+
+#ifndef EMU_H_
+#define EMU_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "main.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct s_heap_emu_stat {
+	uint32_t	allocs;									// Allocations since EMU_HeapReset()
+	uint32_t	blocks;									// Live blocks
+	uint32_t	bytes;									// Live bytes
+	uint32_t	peak;									// Maximum live bytes since EMU_HeapReset()
+} t_heap_emu_stat;
+
+typedef struct s_spi_sd_stat {
+	uint32_t	dma;									// DMA transfers
+	uint32_t	aborts;									// Aborted DMA transfers
+	uint32_t	writes;									// Written blocks
+} t_spi_sd_stat;
+
+typedef struct s_w25q_emu_stat {
+	uint32_t	erases;									// Sector erase operations
+	uint32_t	write_erases;							// Sector erases inside W25Qxx_Write(), the caller waits for them
+	uint32_t	pages;									// Page program operations
+	uint32_t	program_errors;							// Attempts to set the bit that was not erased
+} t_w25q_emu_stat;
+
+bool		EMU_W25Q_Init(uint16_t sectors);			// Allocate erased image of 4k sectors
+void		EMU_W25Q_Free(void);
+uint8_t*	EMU_W25Q_Image(void);
+uint32_t	EMU_W25Q_SectorErases(uint16_t sector);		// Erase cycles of the sector
+void		EMU_W25Q_Stat(t_w25q_emu_stat *st);
+
+bool		EMU_SD_Init(uint32_t blocks);				// Allocate zero image of 512-byte blocks
+void		EMU_SD_Free(void);
+uint32_t	EMU_SD_Writes(void);						// Written blocks
+
+bool		EMU_SpiSdInit(uint32_t blocks);				// SDHC card of zero 512-byte blocks on hspi2
+void		EMU_SpiSdFree(void);
+uint8_t*	EMU_SpiSdImage(void);
+void		EMU_SpiSdTokenDelay(uint32_t bytes);		// 0xFF bytes before the data token, 0xFFFFFFFF - the token never comes
+void		EMU_SpiSdDmaStall(bool stall);				// The DMA transfer never completes
+void		EMU_SpiSdStat(t_spi_sd_stat *st);
+
+void		EMU_ClockAdvance(uint32_t ms);
+void		EMU_ClockSet(uint32_t ms);
+
+void		EMU_GpioSet(GPIO_TypeDef *port, uint16_t pin, bool high);
+
+void		EMU_UartReceive(const uint8_t *data, uint16_t len, bool idle);	// The line is idle after the data if idle is true
+void		EMU_UartError(void);						// Framing error, HAL stops the reception
+bool		EMU_UartTxDone(void);						// Complete the DMA transmission, returns false if there was none
+uint16_t	EMU_UartSent(uint8_t *data, uint16_t max);	// Take the bytes of completed transmissions
+
+void		EMU_HeapReset(void);						// Clear the allocation counter, the peak is the live bytes
+void		EMU_HeapStat(t_heap_emu_stat *st);
+void		EMU_HeapLimit(uint32_t size);				// The allocation of bigger block fails, 0 - no limit
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
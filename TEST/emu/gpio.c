@@ -0,0 +1,28 @@
+/*
+ * gpio.c
+ *
+ *  Created on: 2026 OCT 18
+ *      Author: Alex
+ *
+ *  Emulated GPIO: the pin level is the bit of the port input data register, the output pin writes the same bit
+ */
+
+#include "main.h"
+#include "emu.h"
+
+GPIO_TypeDef	EMU_GPIOA, EMU_GPIOB, EMU_GPIOC;
+
+GPIO_PinState HAL_GPIO_ReadPin(GPIO_TypeDef *port, uint16_t pin) {
+	return (port->IDR & pin)?GPIO_PIN_SET:GPIO_PIN_RESET;
+}
+
+void HAL_GPIO_WritePin(GPIO_TypeDef *port, uint16_t pin, GPIO_PinState state) {
+	EMU_GpioSet(port, pin, state == GPIO_PIN_SET);
+}
+
+void EMU_GpioSet(GPIO_TypeDef *port, uint16_t pin, bool high) {
+	if (high)
+		port->IDR |= pin;
+	else
+		port->IDR &= ~(uint32_t)pin;
+}
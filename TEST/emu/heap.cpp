@@ -0,0 +1,118 @@
+/*
+ * heap.cpp
+ *
+ *  Created on: 2026 OCT 18
+ *      Author: Alex
+ *
+ *  Heap usage counter. The test is linked with -Wl,--wrap=malloc,--wrap=free,--wrap=realloc,--wrap=calloc,
+ *  so the malloc() calls of the firmware modules come here, the C++ operators new and delete are replaced.
+ *  Every block has a header with its size, the counter keeps the number of allocations, live blocks and bytes, the peak.
+ *  The block size can be limited to emulate the fragmented heap of the controller.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <new>
+#include "emu.h"
+
+extern "C" {
+void*	__real_malloc(size_t size);
+void	__real_free(void *ptr);
+void*	__wrap_malloc(size_t size);
+void	__wrap_free(void *ptr);
+void*	__wrap_realloc(void *ptr, size_t size);
+void*	__wrap_calloc(size_t n, size_t size);
+}
+
+static t_heap_emu_stat	heap;
+static size_t			max_block	= 0;				// The biggest block to be allocated, 0 - no limit
+
+typedef union {
+	size_t		size;
+	max_align_t	align;
+} t_block_hdr;
+
+static void* allocate(size_t size) {
+	if (max_block && size > max_block)
+		return 0;
+	t_block_hdr *h = (t_block_hdr *)__real_malloc(sizeof(t_block_hdr) + size);
+	if (!h) return 0;
+	h->size = size;
+	++heap.allocs;
+	++heap.blocks;
+	heap.bytes += size;
+	if (heap.bytes > heap.peak)
+		heap.peak = heap.bytes;
+	return h + 1;
+}
+
+static void release(void *ptr) {
+	if (!ptr) return;
+	t_block_hdr *h = (t_block_hdr *)ptr - 1;
+	--heap.blocks;
+	heap.bytes -= h->size;
+	__real_free(h);
+}
+
+void* __wrap_malloc(size_t size) {
+	return allocate(size);
+}
+
+void __wrap_free(void *ptr) {
+	release(ptr);
+}
+
+void* __wrap_realloc(void *ptr, size_t size) {
+	void *p = allocate(size);
+	if (p && ptr) {
+		size_t old = ((t_block_hdr *)ptr - 1)->size;
+		memcpy(p, ptr, old < size?old:size);
+		release(ptr);
+	}
+	return p;
+}
+
+void* __wrap_calloc(size_t n, size_t size) {
+	void *p = allocate(n * size);
+	if (p) memset(p, 0, n * size);
+	return p;
+}
+
+void* operator new(size_t size) {
+	void *p = allocate(size);
+	if (!p) throw std::bad_alloc();
+	return p;
+}
+
+void* operator new[](size_t size) {
+	return operator new(size);
+}
+
+void operator delete(void *ptr) noexcept {
+	release(ptr);
+}
+
+void operator delete[](void *ptr) noexcept {
+	release(ptr);
+}
+
+void operator delete(void *ptr, size_t size) noexcept {
+	release(ptr);
+}
+
+void operator delete[](void *ptr, size_t size) noexcept {
+	release(ptr);
+}
+
+void EMU_HeapReset(void) {
+	heap.allocs	= 0;
+	heap.peak	= heap.bytes;
+}
+
+void EMU_HeapLimit(uint32_t size) {
+	max_block = size;
+}
+
+void EMU_HeapStat(t_heap_emu_stat *st) {
+	*st = heap;
+}
@@ -0,0 +1,65 @@
+/*
+ * sd_emu.c
+ *
+ *  Created on: 2026 OCT 18
+ *      Author: Alex
+ *
+ *  RAM image of the SD-CARD behind the sdspi.h API
+ */
+
+#include <string.h>
+#include "sdspi.h"
+#include "emu.h"
+
+#define SD_BLOCK		(512)
+
+static uint8_t		*image		= 0;
+static uint32_t		blocks		= 0;
+static uint32_t		written		= 0;
+
+bool EMU_SD_Init(uint32_t n_blocks) {
+	EMU_SD_Free();
+	image = (uint8_t *)calloc(n_blocks, SD_BLOCK);
+	if (!image)
+		return false;
+	blocks	= n_blocks;
+	written	= 0;
+	return true;
+}
+
+void EMU_SD_Free(void) {
+	if (image) free(image);
+	image	= 0;
+	blocks	= 0;
+}
+
+uint32_t EMU_SD_Writes(void) {
+	return written;
+}
+
+uint8_t SD_Init(SDCARD *sd) {
+	sd->type		= image?TYPE_SDHC:TYPE_NOT_READY;
+	sd->blocks		= blocks;
+	sd->erase_size	= 1;
+	sd->init_status	= image?0:1;
+	return sd->init_status;
+}
+
+uint8_t	SD_Read(SDCARD *sd, uint32_t start_block, uint32_t count, uint8_t* data) {
+	if (!image)
+		return 1;
+	if (start_block + count > blocks)
+		return 2;
+	memcpy(data, &image[start_block * SD_BLOCK], count * SD_BLOCK);
+	return 0;
+}
+
+uint8_t	SD_Write(SDCARD *sd, uint32_t start_block, uint32_t count, const uint8_t* data) {
+	if (!image)
+		return 1;
+	if (start_block + count > blocks)
+		return 2;
+	memcpy(&image[start_block * SD_BLOCK], data, count * SD_BLOCK);
+	written += count;
+	return 0;
+}
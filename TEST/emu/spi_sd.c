@@ -0,0 +1,304 @@
+/*
+ * spi_sd.c
+ *
+ *  Created on: 2026 OCT 18
+ *      Author: Alex
+ *
+ *  SD-CARD in SPI mode behind the HAL SPI functions of hspi2, to test the original sdspi.c driver.
+ *  The card is SDHC: it answers the initialization commands, reads and writes the 512-byte blocks of the RAM image.
+ *  The card answers one byte after the command, the data token comes after EMU_SpiSdTokenDelay() bytes of 0xFF.
+ *  Every transferred byte is exchanged with the card, the clock is advanced by 1 ms per 1000 bytes.
+ */
+
+#include <string.h>
+#include "main.h"
+#include "sdspi.h"
+#include "emu.h"
+
+#define SD_BLOCK		(512)
+#define QUEUE_SIZE		(SD_BLOCK + 32)
+#define TOKEN_WAIT		(0x100)								// The queue entry to send token_delay bytes of 0xFF
+
+typedef enum { MODE_CMD = 0, MODE_READ_MULTI, MODE_WRITE_SINGLE, MODE_WRITE_MULTI } t_mode;
+
+SPI_HandleTypeDef		hspi2;
+
+static uint8_t			*image			= 0;
+static uint32_t			blocks			= 0;
+static uint16_t			queue[QUEUE_SIZE];						// The bytes the card sends
+static uint16_t			q_head			= 0;
+static uint16_t			q_len			= 0;
+static uint32_t			wait			= 0;					// 0xFF bytes left before the data token
+static uint32_t			token_delay		= 0;
+static bool				dma_stall		= false;
+static HAL_SPI_StateTypeDef	state		= HAL_SPI_STATE_READY;
+static uint8_t			cmd[6];
+static uint8_t			cmd_len			= 0;
+static bool				idle			= true;
+static bool				app_cmd			= false;
+static t_mode			mode			= MODE_CMD;
+static uint32_t			block			= 0;					// The next block of the data transfer
+static uint8_t			w_buff[SD_BLOCK + 3];					// Received data packet: token, data block, CRC
+static uint16_t			w_len			= 0;
+static uint32_t			bytes			= 0;
+static t_spi_sd_stat	stat;
+
+bool EMU_SpiSdInit(uint32_t n_blocks) {
+	EMU_SpiSdFree();
+	image = (uint8_t *)calloc(n_blocks, SD_BLOCK);
+	if (!image)
+		return false;
+	blocks		= n_blocks;
+	q_len		= 0;
+	wait		= 0;
+	token_delay	= 0;
+	dma_stall	= false;
+	state		= HAL_SPI_STATE_READY;
+	cmd_len		= 0;
+	idle		= true;
+	app_cmd		= false;
+	mode		= MODE_CMD;
+	memset(&stat, 0, sizeof(stat));
+	hspi2.hdmarx	= 0;
+	hspi2.hdmatx	= 0;
+	hspi2.ErrorCode	= HAL_SPI_ERROR_NONE;
+	return true;
+}
+
+void EMU_SpiSdFree(void) {
+	if (image) free(image);
+	image	= 0;
+	blocks	= 0;
+}
+
+uint8_t* EMU_SpiSdImage(void) {
+	return image;
+}
+
+void EMU_SpiSdTokenDelay(uint32_t n_bytes) {
+	token_delay = n_bytes;
+}
+
+void EMU_SpiSdDmaStall(bool stall) {
+	dma_stall = stall;
+}
+
+void EMU_SpiSdStat(t_spi_sd_stat *st) {
+	*st = stat;
+}
+
+static void push(uint16_t b) {
+	if (q_len < QUEUE_SIZE)
+		queue[(q_head + q_len++) % QUEUE_SIZE] = b;
+}
+
+// The data packet: 0xFF bytes, start token, data, CRC
+static void pushData(const uint8_t *data, uint16_t size) {
+	push(TOKEN_WAIT);
+	push(0xFE);
+	for (uint16_t i = 0; i < size; ++i)
+		push(data[i]);
+	push(0xFF);												// CRC is not checked in SPI mode
+	push(0xFF);
+}
+
+static void command(void) {
+	uint8_t		index	= cmd[0] & 0x3F;
+	uint32_t	arg		= ((uint32_t)cmd[1] << 24) | ((uint32_t)cmd[2] << 16) | ((uint32_t)cmd[3] << 8) | cmd[4];
+	bool		app		= app_cmd;
+	uint8_t		r1		= idle?0x01:0x00;
+
+	q_len	= 0;
+	wait	= 0;
+	app_cmd	= false;
+	push(0xFF);												// NCR, the answer comes one byte later
+	switch (index) {
+		case CMD0_GO_IDLE_STATE:
+			idle = true;
+			mode = MODE_CMD;
+			push(0x01);
+			break;
+		case CMD8_SEND_IF_COND:
+			push(r1); push(0x00); push(0x00); push(0x01); push(arg & 0xFF);
+			break;
+		case CMD55_APP_CMD:
+			app_cmd = true;
+			push(r1);
+			break;
+		case ACMD41_APP_SEND_OP_COND:
+			if (!app) {
+				push(r1 | 0x04);							// Illegal command
+				break;
+			}
+			idle = false;
+			push(0x00);
+			break;
+		case CMD58_READ_OCR:
+			push(r1); push(0xC0); push(0xFF); push(0x80); push(0x00);	// Power up, CCS: SDHC
+			break;
+		case CMD9_SEND_CSD:
+		{
+			uint8_t csd[16] = { 0x40 };						// CSD version 2.0
+			uint32_t c_size = blocks / 1024 - 1;			// C_SIZE: csd[69:48]
+			csd[7] = (c_size >> 16) & 0x3F;
+			csd[8] = (c_size >> 8) & 0xFF;
+			csd[9] = c_size & 0xFF;
+			push(r1);
+			pushData(csd, sizeof(csd));
+			break;
+		}
+		case CMD12_STOP_TRANSMISSION:
+			mode = MODE_CMD;
+			push(0x00);										// After the stuff byte (NCR)
+			break;
+		case CMD17_READ_SINGLE_BLOCK:
+		case CMD18_READ_MULTIPLE_BLOCK:
+			if (idle || arg >= blocks) {
+				push(r1 | 0x40);							// Parameter error
+				break;
+			}
+			push(0x00);
+			pushData(&image[arg * SD_BLOCK], SD_BLOCK);
+			block = arg + 1;
+			if (index == CMD18_READ_MULTIPLE_BLOCK)
+				mode = MODE_READ_MULTI;
+			break;
+		case CMD24_WRITE_BLOCK:
+		case CMD25_WRITE_MULTIPLE_BLOCK:
+			if (idle || arg >= blocks) {
+				push(r1 | 0x40);
+				break;
+			}
+			push(0x00);
+			block	= arg;
+			w_len	= 0;
+			mode	= (index == CMD24_WRITE_BLOCK)?MODE_WRITE_SINGLE:MODE_WRITE_MULTI;
+			break;
+		default:
+			push(r1 | 0x04);
+			break;
+	}
+}
+
+// Data packet of the write command
+static void writeData(uint8_t b) {
+	if (w_len == 0) {										// Waiting for the data token
+		if (b == 0xFE && mode == MODE_WRITE_SINGLE)
+			w_buff[w_len++] = b;
+		else if (b == 0xFC && mode == MODE_WRITE_MULTI)
+			w_buff[w_len++] = b;
+		else if (b == 0xFD && mode == MODE_WRITE_MULTI) {	// Stop transaction token
+			mode = MODE_CMD;
+			q_len = 0;
+			push(0xFF);										// The byte before busy
+			push(0x00);										// Busy
+			push(0x00);
+		}
+		return;
+	}
+	w_buff[w_len++] = b;
+	if (w_len < sizeof(w_buff))
+		return;
+	w_len = 0;
+	if (block < blocks) {
+		memcpy(&image[block * SD_BLOCK], &w_buff[1], SD_BLOCK);
+		++stat.writes;
+	}
+	++block;
+	q_len = 0;
+	push((block <= blocks)?0x05:0x0D);						// Data accepted or write error
+	push(0x00);												// Busy while programming
+	push(0x00);
+	if (mode == MODE_WRITE_SINGLE)
+		mode = MODE_CMD;
+}
+
+static uint8_t exchange(uint8_t mosi) {
+	if (++bytes % 1000 == 0)
+		EMU_ClockAdvance(1);
+	if (!image || HAL_GPIO_ReadPin(SD_CS_GPIO_Port, SD_CS_Pin) == GPIO_PIN_SET) {
+		cmd_len = 0;
+		return 0xFF;										// The card is not selected
+	}
+
+	uint8_t miso = 0xFF;
+	if (wait > 0) {
+		if (wait != 0xFFFFFFFF)
+			--wait;
+	} else if (q_len > 0) {
+		uint16_t b = queue[q_head];
+		q_head = (q_head + 1) % QUEUE_SIZE;
+		--q_len;
+		if (b == TOKEN_WAIT)
+			wait = token_delay;
+		else
+			miso = b;
+		if (q_len == 0 && mode == MODE_READ_MULTI && block < blocks) {
+			pushData(&image[block * SD_BLOCK], SD_BLOCK);
+			++block;
+		}
+	}
+
+	if (mode == MODE_WRITE_SINGLE || mode == MODE_WRITE_MULTI) {
+		if (q_len == 0)										// The answer to the command is sent
+			writeData(mosi);
+	} else if (cmd_len > 0 || (mosi & 0xC0) == 0x40) {
+		cmd[cmd_len++] = mosi;
+		if (cmd_len == sizeof(cmd)) {
+			cmd_len = 0;
+			command();
+		}
+	}
+	return miso;
+}
+
+HAL_StatusTypeDef HAL_SPI_Init(SPI_HandleTypeDef *hspi) {
+	return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_SPI_TransmitReceive(SPI_HandleTypeDef *hspi, uint8_t *tx, uint8_t *rx, uint16_t size, uint32_t timeout) {
+	for (uint16_t i = 0; i < size; ++i)
+		rx[i] = exchange(tx[i]);
+	return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_SPI_Transmit(SPI_HandleTypeDef *hspi, uint8_t *data, uint16_t size, uint32_t timeout) {
+	for (uint16_t i = 0; i < size; ++i)
+		exchange(data[i]);
+	return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_SPI_TransmitReceive_DMA(SPI_HandleTypeDef *hspi, uint8_t *tx, uint8_t *rx, uint16_t size) {
+	if (state != HAL_SPI_STATE_READY)
+		return HAL_BUSY;
+	++stat.dma;
+	if (dma_stall) {
+		state = HAL_SPI_STATE_BUSY;
+		return HAL_OK;
+	}
+	return HAL_SPI_TransmitReceive(hspi, tx, rx, size, 0);
+}
+
+HAL_StatusTypeDef HAL_SPI_Transmit_DMA(SPI_HandleTypeDef *hspi, uint8_t *data, uint16_t size) {
+	if (state != HAL_SPI_STATE_READY)
+		return HAL_BUSY;
+	++stat.dma;
+	if (dma_stall) {
+		state = HAL_SPI_STATE_BUSY;
+		return HAL_OK;
+	}
+	return HAL_SPI_Transmit(hspi, data, size, 0);
+}
+
+// The stalled transfer is polled each millisecond
+HAL_SPI_StateTypeDef HAL_SPI_GetState(SPI_HandleTypeDef *hspi) {
+	if (state != HAL_SPI_STATE_READY)
+		EMU_ClockAdvance(1);
+	return state;
+}
+
+HAL_StatusTypeDef HAL_SPI_Abort(SPI_HandleTypeDef *hspi) {
+	++stat.aborts;
+	state = HAL_SPI_STATE_READY;
+	return HAL_OK;
+}
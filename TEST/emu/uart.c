@@ -0,0 +1,99 @@
+/*
+ * uart.c
+ *
+ *  Created on: 2026 OCT 18
+ *      Author: Alex
+ *
+ *  Emulated USART1 with DMA: circular reception to idle line and normal mode transmission
+ */
+
+#include <string.h>
+#include "main.h"
+#include "emu.h"
+
+UART_HandleTypeDef		huart1;
+
+static uint8_t			*rx_buff	= 0;				// The circular DMA buffer
+static uint16_t			rx_size		= 0;
+static uint16_t			rx_pos		= 0;				// The position DMA writes the next byte to
+static const uint8_t	*tx_data	= 0;				// The DMA transmission in progress
+static uint16_t			tx_len		= 0;
+static uint8_t			wire[4096];						// The transmitted bytes
+static uint16_t			wire_len	= 0;
+
+void MX_USART1_UART_Init(void) {
+	huart1.Instance	= USART1;
+	huart1.gState	= HAL_UART_STATE_READY;
+	huart1.RxState	= HAL_UART_STATE_READY;
+	rx_buff			= 0;
+	tx_len			= 0;
+	wire_len		= 0;
+}
+
+void HAL_NVIC_EnableIRQ(IRQn_Type irq)		{ }
+void HAL_NVIC_DisableIRQ(IRQn_Type irq)		{ }
+
+HAL_StatusTypeDef HAL_UART_Transmit_DMA(UART_HandleTypeDef *huart, const uint8_t *data, uint16_t size) {
+	if (huart->gState != HAL_UART_STATE_READY)
+		return HAL_BUSY;
+	huart->gState	= HAL_UART_STATE_BUSY_TX;
+	tx_data			= data;
+	tx_len			= size;
+	return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_UARTEx_ReceiveToIdle_DMA(UART_HandleTypeDef *huart, uint8_t *data, uint16_t size) {
+	if (huart->RxState != HAL_UART_STATE_READY)
+		return HAL_BUSY;
+	huart->RxState	= HAL_UART_STATE_BUSY_RX;
+	rx_buff			= data;
+	rx_size			= size;
+	rx_pos			= 0;
+	return HAL_OK;
+}
+
+__attribute__((weak)) void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart)					{ }
+__attribute__((weak)) void HAL_UARTEx_RxEventCallback(UART_HandleTypeDef *huart, uint16_t size)	{ }
+__attribute__((weak)) void HAL_UART_ErrorCallback(UART_HandleTypeDef *huart)					{ }
+
+void EMU_UartReceive(const uint8_t *data, uint16_t len, bool idle) {
+	for (uint16_t i = 0; i < len; ++i) {
+		if (!rx_buff || huart1.RxState != HAL_UART_STATE_BUSY_RX)
+			return;											// The reception is stopped, the bytes are lost
+		rx_buff[rx_pos++] = data[i];
+		if (rx_pos == rx_size / 2) {						// DMA half transfer interrupt
+			HAL_UARTEx_RxEventCallback(&huart1, rx_pos);
+		} else if (rx_pos == rx_size) {						// DMA transfer complete interrupt, circular mode continues
+			rx_pos = 0;
+			HAL_UARTEx_RxEventCallback(&huart1, rx_size);
+		}
+	}
+	if (idle && rx_pos != 0)								// USART idle line interrupt, the position can be reported already
+		HAL_UARTEx_RxEventCallback(&huart1, rx_pos);
+}
+
+void EMU_UartError(void) {
+	huart1.RxState = HAL_UART_STATE_READY;					// HAL aborts the DMA reception and calls the error callback
+	HAL_UART_ErrorCallback(&huart1);
+}
+
+bool EMU_UartTxDone(void) {
+	if (huart1.gState != HAL_UART_STATE_BUSY_TX)
+		return false;
+	if (wire_len + tx_len <= sizeof(wire)) {
+		memcpy(&wire[wire_len], tx_data, tx_len);
+		wire_len += tx_len;
+	}
+	tx_len			= 0;
+	huart1.gState	= HAL_UART_STATE_READY;					// HAL is ready for the next transmission in the callback
+	HAL_UART_TxCpltCallback(&huart1);
+	return true;
+}
+
+uint16_t EMU_UartSent(uint8_t *data, uint16_t max) {
+	uint16_t n = (wire_len < max)?wire_len:max;
+	memcpy(data, wire, n);
+	memmove(wire, &wire[n], wire_len - n);
+	wire_len -= n;
+	return n;
+}
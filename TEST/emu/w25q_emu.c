@@ -0,0 +1,139 @@
+/*
+ * w25q_emu.c
+ *
+ *  Created on: 2026 OCT 18
+ *      Author: Alex
+ *
+ *  RAM image of the W25Qxx flash behind the W25Qxx.h API. The write procedure follows the driver:
+ *  the page-aligned data is programmed by 256-byte pages, the sector is erased when the write starts
+ *  at the sector border and the sector is not empty.
+ */
+
+#include <string.h>
+#include "W25Qxx.h"
+#include "emu.h"
+
+#define W25Q_SECTOR		(4096)
+#define W25Q_PAGE		(256)
+
+static uint8_t			*image			= 0;
+static uint32_t			*sector_erases	= 0;
+static uint16_t			sector_count	= 0;
+static t_w25q_emu_stat	stat;
+
+bool EMU_W25Q_Init(uint16_t sectors) {
+	EMU_W25Q_Free();
+	image			= (uint8_t *)malloc((uint32_t)sectors * W25Q_SECTOR);
+	sector_erases	= (uint32_t *)calloc(sectors, sizeof(uint32_t));
+	if (!image || !sector_erases) {
+		EMU_W25Q_Free();
+		return false;
+	}
+	memset(image, 0xFF, (uint32_t)sectors * W25Q_SECTOR);
+	memset(&stat, 0, sizeof(stat));
+	sector_count = sectors;
+	return true;
+}
+
+void EMU_W25Q_Free(void) {
+	if (image)			free(image);
+	if (sector_erases)	free(sector_erases);
+	image			= 0;
+	sector_erases	= 0;
+	sector_count	= 0;
+}
+
+uint8_t* EMU_W25Q_Image(void) {
+	return image;
+}
+
+uint32_t EMU_W25Q_SectorErases(uint16_t sector) {
+	return (sector < sector_count)?sector_erases[sector]:0;
+}
+
+void EMU_W25Q_Stat(t_w25q_emu_stat *st) {
+	*st = stat;
+}
+
+static void eraseSector(uint16_t sector) {
+	memset(&image[(uint32_t)sector * W25Q_SECTOR], 0xFF, W25Q_SECTOR);
+	++sector_erases[sector];
+	++stat.erases;
+}
+
+static bool isSectorEmpty(uint16_t sector) {
+	const uint8_t *s = &image[(uint32_t)sector * W25Q_SECTOR];
+	for (uint16_t i = 0; i < W25Q_SECTOR; ++i) {
+		if (s[i] != 0xFF)
+			return false;
+	}
+	return true;
+}
+
+bool W25Qxx_Init(void) {
+	return image != 0;
+}
+
+uint16_t W25Qxx_SectorCount(void) {
+	return sector_count;
+}
+
+W25Qxx_RET W25Qxx_Read(uint32_t addr, uint8_t buff[], uint16_t size) {
+	if (!image || addr + size > (uint32_t)sector_count * W25Q_SECTOR)
+		return W25Qxx_RET_ADDR;
+	memcpy(buff, &image[addr], size);
+	return W25Qxx_RET_OK;
+}
+
+W25Qxx_RET W25Qxx_Write(uint32_t addr, uint8_t buff[], uint16_t size) {
+	if (addr & (W25Q_PAGE-1))
+		return W25Qxx_RET_ALIGN;
+	if (size < W25Q_PAGE || (size & (W25Q_PAGE-1)))
+		return W25Qxx_RET_SIZE;
+	if (!image || addr + size > (uint32_t)sector_count * W25Q_SECTOR)
+		return W25Qxx_RET_ADDR;
+	if ((addr & (W25Q_SECTOR-1)) == 0 && !isSectorEmpty(addr / W25Q_SECTOR)) {
+		eraseSector(addr / W25Q_SECTOR);
+		++stat.write_erases;
+	}
+	return W25Qxx_Program(addr, buff, size);
+}
+
+W25Qxx_RET W25Qxx_Program(uint32_t addr, uint8_t buff[], uint16_t size) {
+	if (addr & (W25Q_PAGE-1))
+		return W25Qxx_RET_ALIGN;
+	if (size < W25Q_PAGE || (size & (W25Q_PAGE-1)))
+		return W25Qxx_RET_SIZE;
+	if (!image || addr + size > (uint32_t)sector_count * W25Q_SECTOR)
+		return W25Qxx_RET_ADDR;
+	for (uint32_t i = 0; i < size; ++i) {
+		if ((i & (W25Q_PAGE-1)) == 0)
+			++stat.pages;
+		if ((image[addr+i] & buff[i]) != buff[i])		// NOR flash cannot set the bit by programming
+			++stat.program_errors;
+		image[addr+i] &= buff[i];
+	}
+	return W25Qxx_RET_OK;
+}
+
+W25Qxx_RET W25Qxx_Sync(void) {
+	return W25Qxx_RET_OK;
+}
+
+W25Qxx_RET W25Qxx_Erase(uint16_t start_sector, uint16_t n_sectors) {
+	if (n_sectors == 0)
+		return W25Qxx_RET_SIZE;
+	if ((uint32_t)start_sector + n_sectors > sector_count)
+		return W25Qxx_RET_ADDR;
+	for (uint16_t i = 0; i < n_sectors; ++i)
+		eraseSector(start_sector + i);
+	return W25Qxx_RET_OK;
+}
+
+// The sector is erased at once, the device is never busy
+W25Qxx_RET W25Qxx_EraseStart(uint16_t sector) {
+	if (sector >= sector_count)
+		return W25Qxx_RET_ADDR;
+	eraseSector(sector);
+	return W25Qxx_RET_OK;
+}
@@ -0,0 +1,86 @@
+/*
+ * stm32f4xx_hal.h
+ *
+ *  Created on: 2026 OCT 18
+ *      Author: Alex
+ *
+ *  The host replacement of the HAL header included by main.h. It declares only the types used by
+ *  the headers of the hardware independent modules under test. Nothing here talks to the hardware.
+ */
+
+#ifndef STM32F4XX_HAL_H_HOST_
+#define STM32F4XX_HAL_H_HOST_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+
+typedef enum { HAL_OK = 0, HAL_ERROR, HAL_BUSY, HAL_TIMEOUT } HAL_StatusTypeDef;
+typedef struct { void *Instance; } TIM_HandleTypeDef;
+typedef enum { HAL_UART_STATE_RESET = 0, HAL_UART_STATE_READY = 0x20, HAL_UART_STATE_BUSY_TX = 0x21, HAL_UART_STATE_BUSY_RX = 0x22 } HAL_UART_StateTypeDef;
+typedef struct { void *Instance; volatile HAL_UART_StateTypeDef gState, RxState; } UART_HandleTypeDef;
+typedef struct { void *Instance; } DMA_HandleTypeDef;
+typedef enum { HAL_SPI_STATE_RESET = 0, HAL_SPI_STATE_READY = 1, HAL_SPI_STATE_BUSY = 2 } HAL_SPI_StateTypeDef;
+typedef struct { uint32_t BaudRatePrescaler; } SPI_InitTypeDef;
+typedef struct { void *Instance; SPI_InitTypeDef Init; DMA_HandleTypeDef *hdmatx, *hdmarx; volatile uint32_t ErrorCode; } SPI_HandleTypeDef;
+typedef struct { volatile uint32_t IDR; } GPIO_TypeDef;		// Input data register only, see emu/gpio.c
+typedef enum { GPIO_PIN_RESET = 0, GPIO_PIN_SET } GPIO_PinState;
+
+typedef enum { USART1_IRQn = 37, DMA2_Stream2_IRQn = 58, DMA2_Stream7_IRQn = 70 } IRQn_Type;
+
+#define __DMB()		__sync_synchronize()
+#define USART1		((void*)0x40011000)
+#define HAL_MAX_DELAY				0xFFFFFFFFU
+#define HAL_SPI_ERROR_NONE			(0x00000000U)
+#define SPI_BAUDRATEPRESCALER_2		(0x00000000U)
+#define SPI_BAUDRATEPRESCALER_256	(0x00000038U)
+#define GPIO_PIN_0					((uint16_t)0x0001)
+#define GPIO_PIN_1					((uint16_t)0x0002)
+#define GPIO_PIN_2					((uint16_t)0x0004)
+#define GPIO_PIN_3					((uint16_t)0x0008)
+#define GPIO_PIN_4					((uint16_t)0x0010)
+#define GPIO_PIN_5					((uint16_t)0x0020)
+#define GPIO_PIN_6					((uint16_t)0x0040)
+#define GPIO_PIN_7					((uint16_t)0x0080)
+#define GPIO_PIN_8					((uint16_t)0x0100)
+#define GPIO_PIN_9					((uint16_t)0x0200)
+#define GPIO_PIN_10				((uint16_t)0x0400)
+#define GPIO_PIN_11				((uint16_t)0x0800)
+#define GPIO_PIN_12				((uint16_t)0x1000)
+#define GPIO_PIN_13				((uint16_t)0x2000)
+#define GPIO_PIN_14				((uint16_t)0x4000)
+#define GPIO_PIN_15				((uint16_t)0x8000)
+#define GPIOA		(&EMU_GPIOA)					// Emulated ports, see emu/gpio.c
+#define GPIOB		(&EMU_GPIOB)
+#define GPIOC		(&EMU_GPIOC)
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+extern GPIO_TypeDef	EMU_GPIOA, EMU_GPIOB, EMU_GPIOC;
+
+uint32_t	HAL_GetTick(void);							// Emulated millisecond counter, see emu/clock.c
+void		HAL_Delay(uint32_t delay);
+GPIO_PinState	HAL_GPIO_ReadPin(GPIO_TypeDef *port, uint16_t pin);
+void		HAL_GPIO_WritePin(GPIO_TypeDef *port, uint16_t pin, GPIO_PinState state);
+void		HAL_NVIC_EnableIRQ(IRQn_Type irq);			// The interrupts are called by the emulator only, see emu/uart.c
+void		HAL_NVIC_DisableIRQ(IRQn_Type irq);
+HAL_StatusTypeDef	HAL_UART_Transmit_DMA(UART_HandleTypeDef *huart, const uint8_t *data, uint16_t size);
+HAL_StatusTypeDef	HAL_UARTEx_ReceiveToIdle_DMA(UART_HandleTypeDef *huart, uint8_t *data, uint16_t size);
+void		HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart);
+void		HAL_UARTEx_RxEventCallback(UART_HandleTypeDef *huart, uint16_t size);
+void		HAL_UART_ErrorCallback(UART_HandleTypeDef *huart);
+HAL_StatusTypeDef	HAL_SPI_Init(SPI_HandleTypeDef *hspi);	// The SD-CARD in SPI mode on hspi2, see emu/spi_sd.c
+HAL_StatusTypeDef	HAL_SPI_Transmit(SPI_HandleTypeDef *hspi, uint8_t *data, uint16_t size, uint32_t timeout);
+HAL_StatusTypeDef	HAL_SPI_TransmitReceive(SPI_HandleTypeDef *hspi, uint8_t *tx, uint8_t *rx, uint16_t size, uint32_t timeout);
+HAL_StatusTypeDef	HAL_SPI_Transmit_DMA(SPI_HandleTypeDef *hspi, uint8_t *data, uint16_t size);
+HAL_StatusTypeDef	HAL_SPI_TransmitReceive_DMA(SPI_HandleTypeDef *hspi, uint8_t *tx, uint8_t *rx, uint16_t size);
+HAL_SPI_StateTypeDef	HAL_SPI_GetState(SPI_HandleTypeDef *hspi);
+HAL_StatusTypeDef	HAL_SPI_Abort(SPI_HandleTypeDef *hspi);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,42 @@
+/*
+ * test.h
+ *
+ *  Created on: 2026 OCT 18
+ *      Author: Alex
+ *
+ *  Minimal host test helpers. Every test program returns non-zero exit code if any check failed
+ */
+
+#ifndef TEST_H_
+#define TEST_H_
+
+#include <stdio.h>
+
+static int test_checks		= 0;
+static int test_failures	= 0;
+
+#define CHECK(cond)																\
+	do {																			\
+		++test_checks;																\
+		if (!(cond)) {																\
+			++test_failures;														\
+			printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond);			\
+		}																			\
+	} while (0)
+
+#define CHECK_EQ(a, b)																\
+	do {																			\
+		++test_checks;																\
+		long long va = (long long)(a), vb = (long long)(b);							\
+		if (va != vb) {																\
+			++test_failures;														\
+			printf("%s:%d: %s == %s failed: %lld != %lld\n", __FILE__, __LINE__, #a, #b, va, vb);	\
+		}																			\
+	} while (0)
+
+static inline int testResult(const char *name) {
+	printf("%-16s %d checks, %d failed\n", name, test_checks, test_failures);
+	return test_failures?1:0;
+}
+
+#endif
@@ -0,0 +1,104 @@
+/*
+ * test_bench.cpp
+ *
+ *  Created on: 2026 OCT 18
+ *
+ *  STORAGE_BENCH on the emulated W25Qxx flash with the fixed-step timer.
+ *  Checks the statistics, all the operations are measured, the existing file and the free space are not changed,
+ *  the raw program is performed on erased sectors only.
+ */
+
+#include <string.h>
+#include "bench.h"
+#include "emu.h"
+#include "test.h"
+
+// Every measured operation takes the same time
+class STEP_TIMER : public BENCH_TIMER {
+	public:
+		virtual void		start(void)						{ ++starts;	}
+		virtual uint32_t	elapsed(void)					{ return step;	}
+		uint32_t	starts	= 0;
+		uint32_t	step	= 1000;
+};
+
+static void testStat(void) {
+	BENCH_STAT		st;
+	t_bench_result	r;
+	st.reset();
+	st.result(&r);
+	CHECK_EQ(r.kbps, 0);
+	CHECK_EQ(r.max, 0);
+	for (uint32_t i = 10; i > 0; --i)
+		st.add(i * 100, 1024);
+	st.result(&r);
+	CHECK_EQ(r.p50, 500);
+	CHECK_EQ(r.p90, 900);
+	CHECK_EQ(r.max, 1000);
+	CHECK_EQ(r.kbps, 10 * 1000000 / 5500);					// 10 KB in 5.5 ms
+	st.reset();												// More samples than saved: the throughput uses all of them
+	for (uint32_t i = 0; i < 40; ++i)
+		st.add(1000, 2048);
+	st.result(&r);
+	CHECK_EQ(r.kbps, 2000);
+	CHECK_EQ(r.p90, 1000);
+}
+
+int main(void) {
+	static FATFS	fs;
+	static uint8_t	work[4096], keep[20000], check[20000];
+	testStat();
+
+	CHECK(EMU_W25Q_Init(512));
+	MKFS_PARM p = { FM_FAT | FM_SFD, 1, 0, 128, 4096 };
+	CHECK_EQ(f_mkfs("0:", &p, work, sizeof(work)), FR_OK);
+	CHECK_EQ(f_mount(&fs, "0:", 1), FR_OK);
+	for (uint32_t i = 0; i < sizeof(keep); ++i)
+		keep[i] = i * 7 + (i >> 8);
+	FIL f;
+	UINT n = 0;
+	CHECK_EQ(f_open(&f, "0:keep.dat", FA_CREATE_ALWAYS | FA_WRITE), FR_OK);
+	CHECK_EQ(f_write(&f, keep, sizeof(keep), &n), FR_OK);
+	f_close(&f);
+	DWORD free_before = 0, free_after = 0;
+	FATFS *pfs;
+	f_getfree("0:", &free_before, &pfs);
+
+	STEP_TIMER		timer;
+	STORAGE_BENCH	bench(&timer);
+	t_bench_result	res[BENCH_FS_LAST], raw[BENCH_RAW_LAST];
+	CHECK(bench.volume("0:", res, raw));
+	CHECK_EQ(timer.starts, 16 * (BENCH_FS_LAST + BENCH_RAW_LAST));
+	CHECK_EQ(res[BENCH_SEQ_WRITE].kbps, 4000);				// 4k block per 1 ms
+	CHECK_EQ(res[BENCH_SEQ_READ].kbps,  4000);
+	CHECK_EQ(res[BENCH_RND_WRITE].kbps, 500);				// 512 bytes per 1 ms
+	CHECK_EQ(res[BENCH_RND_READ].kbps,  500);
+	CHECK_EQ(res[BENCH_RND_WRITE].p50,  1000);
+	for (uint8_t i = 0; i < BENCH_RAW_LAST; ++i)
+		CHECK_EQ(raw[i].kbps, 4000);
+
+	t_w25q_emu_stat st;
+	EMU_W25Q_Stat(&st);
+	CHECK_EQ(st.program_errors, 0);							// Every raw program was performed on the erased sector
+
+	f_getfree("0:", &free_after, &pfs);
+	CHECK_EQ(free_after, free_before);						// The scratch files are removed
+	FILINFO fno;
+	CHECK(f_stat("0:bench.tmp", &fno) != FR_OK);
+	CHECK(f_stat("0:bench.raw", &fno) != FR_OK);
+	CHECK_EQ(f_open(&f, "0:keep.dat", FA_READ), FR_OK);		// The existing file is not affected
+	CHECK_EQ(f_read(&f, check, sizeof(check), &n), FR_OK);
+	CHECK_EQ(n, sizeof(keep));
+	CHECK(memcmp(keep, check, sizeof(keep)) == 0);
+	f_close(&f);
+	f_mount(NULL, "0:", 0);
+
+	CHECK_EQ(f_mount(&fs, "0:", 1), FR_OK);					// The file system is consistent after remount
+	CHECK_EQ(f_open(&f, "0:keep.dat", FA_READ), FR_OK);
+	CHECK_EQ(f_read(&f, check, sizeof(check), &n), FR_OK);
+	CHECK(memcmp(keep, check, sizeof(keep)) == 0);
+	f_close(&f);
+	f_mount(NULL, "0:", 0);
+	EMU_W25Q_Free();
+	return testResult("bench");
+}
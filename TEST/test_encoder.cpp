@@ -0,0 +1,318 @@
+/*
+ * test_encoder.cpp
+ *
+ *  Created on: 2026 OCT 18
+ *
+ *  The rotary encoder on emulated GPIO pins. The button is debounced and classified in buttonTick(),
+ *  that is called every millisecond as SysTick does. RENC::reset() discards the rotation and the button events
+ *  made before it, including the press in progress. RENC::extendUpper() keeps them.
+ *  The long and double press thresholds are set by RENC::setButtonTiming(), the double press is disabled by default.
+ *  The increment grows with the rotation velocity of the timed detents, the detents over the queue size are counted as lost.
+ */
+
+#include "encoder.h"
+#include "emu.h"
+#include "test.h"
+
+#define PIN_A		(1 << 0)
+#define PIN_B		(1 << 1)
+#define PIN_BTN		(1 << 9)
+
+static GPIO_TypeDef	port = { PIN_A | PIN_B | PIN_BTN };		// All pins are pulled up
+static RENC			enc(&port, PIN_A, &port, PIN_B);
+
+// Run the millisecond SysTick
+static void tick(uint32_t ms) {
+	while (ms--) {
+		EMU_ClockAdvance(1);
+		enc.buttonTick(HAL_GetTick());
+	}
+}
+
+// The button pin changes with the contact bounces, the button is active low
+static void button(bool pressed) {
+	for (uint8_t i = 0; i < 3; ++i) {
+		EMU_GpioSet(&port, PIN_BTN, pressed == (i & 1));
+		enc.buttonIntr();
+		tick(1);
+	}
+	EMU_GpioSet(&port, PIN_BTN, !pressed);
+	enc.buttonIntr();
+}
+
+// One detent: the main channel goes low and high, the secondary channel changes its level in between
+static void detent(void) {
+	EMU_GpioSet(&port, PIN_A, false);
+	enc.encoderIntr();
+	tick(1);
+	EMU_GpioSet(&port, PIN_B, false);
+	EMU_GpioSet(&port, PIN_A, true);
+	enc.encoderIntr();
+	tick(1);
+	EMU_GpioSet(&port, PIN_B, true);
+}
+
+static void testShortLong(void) {
+	button(true);
+	tick(30);
+	CHECK_EQ(enc.buttonStatus(), 0);						// Not released yet
+	uint32_t released = HAL_GetTick();
+	button(false);
+	CHECK_EQ(enc.buttonStatus(), 0);						// Not debounced yet
+	tick(30);
+	CHECK_EQ(enc.buttonStatus(), 1);
+	CHECK_EQ(enc.buttonTime(), released);					// The time of the first edge
+	CHECK_EQ(enc.buttonStatus(), 0);
+
+	button(true);
+	tick(1600);
+	CHECK_EQ(enc.buttonStatus(), 2);						// Long press is reported while the button is held
+	button(false);
+	tick(30);
+	CHECK_EQ(enc.buttonStatus(), 0);						// The release after long press is ignored
+
+	button(true);											// The event older than over press timeout is discarded
+	tick(30);
+	button(false);
+	tick(3000);
+	CHECK_EQ(enc.buttonStatus(), 0);
+}
+
+// Short press: the button is held 30 ms
+static void click(void) {
+	button(true);
+	tick(30);
+	button(false);
+	tick(30);
+}
+
+static void testButtonTiming(void) {
+	click();												// Double press is disabled by default: two short presses
+	tick(50);
+	click();
+	CHECK_EQ(enc.buttonStatus(), 1);
+	CHECK_EQ(enc.buttonStatus(), 1);
+	CHECK_EQ(enc.buttonStatus(), 0);
+
+	enc.setButtonTiming(0, 300);
+	click();
+	tick(50);
+	click();
+	CHECK_EQ(enc.buttonStatus(), 3);
+	CHECK_EQ(enc.buttonStatus(), 0);
+
+	click();												// The single press is reported after the double press pause
+	CHECK_EQ(enc.buttonStatus(), 0);
+	tick(300);
+	CHECK_EQ(enc.buttonStatus(), 1);
+
+	click();												// The pause is too long: two short presses
+	tick(400);
+	click();
+	tick(400);
+	CHECK_EQ(enc.buttonStatus(), 1);
+	CHECK_EQ(enc.buttonStatus(), 1);
+	CHECK_EQ(enc.buttonStatus(), 0);
+
+	click();												// Short press, then long press
+	button(true);
+	tick(1600);
+	CHECK_EQ(enc.buttonStatus(), 1);
+	CHECK_EQ(enc.buttonStatus(), 2);
+	button(false);
+	tick(400);
+	CHECK_EQ(enc.buttonStatus(), 0);
+
+	click();												// The first press of the double press is discarded by reset
+	enc.reset(0, 0, 10, 1, 1, false);
+	tick(1);
+	click();
+	tick(400);
+	CHECK_EQ(enc.buttonStatus(), 1);
+	CHECK_EQ(enc.buttonStatus(), 0);
+
+	enc.setButtonTiming(800, 0);							// Shorter long press
+	button(true);
+	tick(900);
+	CHECK_EQ(enc.buttonStatus(), 2);
+	button(false);
+	tick(30);
+	enc.setButtonTiming(3000, 0);							// Not longer than over press timeout, ignored
+	button(true);
+	tick(900);
+	CHECK_EQ(enc.buttonStatus(), 2);
+	button(false);
+	tick(30);
+	enc.setButtonTiming(1500, 0);
+	button(true);
+	tick(900);
+	CHECK_EQ(enc.buttonStatus(), 0);
+	tick(700);
+	CHECK_EQ(enc.buttonStatus(), 2);
+	button(false);
+	tick(30);
+}
+
+static void testResetButton(void) {
+	button(true);											// The queued event made before reset
+	tick(30);
+	button(false);
+	tick(30);
+	enc.reset(0, 0, 10, 1, 1, false);
+	CHECK_EQ(enc.buttonStatus(), 0);
+
+	button(true);											// The press in progress when reset
+	tick(30);
+	enc.reset(0, 0, 10, 1, 1, false);
+	tick(1);
+	button(false);
+	tick(30);
+	CHECK_EQ(enc.buttonStatus(), 0);
+	button(true);											// The bounce sequence in progress when reset: new press
+	enc.reset(0, 0, 10, 1, 1, false);
+	tick(30);
+	button(false);
+	tick(30);
+	CHECK_EQ(enc.buttonStatus(), 1);
+
+	button(true);											// Long press of the held button is not reported after reset
+	tick(1000);
+	enc.reset(0, 0, 10, 1, 1, false);
+	tick(1000);
+	button(false);
+	tick(30);
+	CHECK_EQ(enc.buttonStatus(), 0);
+
+	button(true);											// The next press works as usual
+	tick(30);
+	button(false);
+	tick(30);
+	CHECK_EQ(enc.buttonStatus(), 1);
+}
+
+static void testRotation(void) {
+	enc.reset(5, 0, 10, 1, 1, false);
+	for (uint8_t i = 0; i < 3; ++i) {
+		detent();
+		tick(100);
+	}
+	int16_t pos = enc.read();
+	CHECK(pos == 8 || pos == 2);							// The direction depends on the encoder soldering
+	int16_t dir = pos - 5;
+	for (uint8_t i = 0; i < 10; ++i) {
+		detent();
+		tick(100);
+	}
+	CHECK_EQ(enc.read(), (dir > 0)?10:0);					// Not looped, stops at the limit
+	for (uint8_t i = 0; i < 3; ++i) {						// The rotation made before reset is discarded
+		detent();
+		tick(100);
+	}
+	enc.reset(5, 0, 10, 1, 1, false);
+	CHECK_EQ(enc.read(), 5);
+	CHECK_EQ(enc.lostEvents(), 0);
+}
+
+// Make the detent() rotate up whatever the direction of the emulated encoder is
+static void rotateUp(void) {
+	enc.reset(0, 0, 4, 1, 1, false);
+	detent();
+	tick(300);
+	if (enc.read() == 0)
+		enc.setClockWise(false);
+}
+
+// n detents, one detent every period ms. Returns the position change
+static int16_t spin(uint16_t n, uint16_t period) {
+	int16_t start = enc.read();
+	for (uint16_t i = 0; i < n; ++i) {
+		detent();
+		tick(period - 2);									// detent() takes 2 ms
+	}
+	return enc.read() - start;
+}
+
+// The list grows while the detents and the press are queued: the range is extended, nothing is lost
+static void testExtendUpper(void) {
+	rotateUp();
+	enc.reset(0, 0, 4, 1, 1, false);
+	for (uint8_t i = 0; i < 8; ++i) {
+		detent();
+		tick(100);
+	}
+	button(true);
+	tick(30);
+	button(false);
+	tick(30);
+	enc.extendUpper(20);
+	CHECK_EQ(enc.read(), 8);
+	CHECK_EQ(enc.buttonStatus(), 1);
+	enc.extendUpper(2);										// The range is not narrowed
+	detent();
+	tick(100);
+	CHECK_EQ(enc.read(), 9);
+	enc.setClockWise(true);
+}
+
+// The acceleration curve: increment below 8 detents per second, fast increment above 40, square law between
+static void testAcceleration(void) {
+	rotateUp();
+	enc.setAcceleration(8, 40);
+	enc.reset(200, 0, 480, 1, 20, false);
+	CHECK_EQ(spin(5, 150), 5);								// 6.7 detents per second: one degree per detent
+	tick(300);
+	int16_t medium = spin(8, 40);							// 25 detents per second
+	CHECK(medium > 8 && medium < 8 * 20);
+	tick(300);
+	int16_t fast = spin(8, 20);								// 50 detents per second
+	CHECK(fast > medium);
+	CHECK_EQ(fast, 1 + 7 * 20);								// The first detent of the window is slow
+	tick(300);
+
+	enc.reset(200, 0, 480, 1, 20, false);					// 480 from 200 by one flick
+	spin(16, 20);
+	CHECK_EQ(enc.read(), 480);
+
+	enc.reset(200, 0, 480, 5, 20, false);					// The position is kept multiple of the increment
+	spin(6, 30);
+	CHECK_EQ(enc.read() % 5, 0);
+	CHECK(enc.read() > 200 + 6 * 5);
+
+	enc.reset(200, 0, 480, 1, 1, false);					// No acceleration without fast increment
+	CHECK_EQ(spin(8, 20), 8);
+	enc.setAcceleration(40, 8);								// Wrong curve is ignored
+	enc.reset(200, 0, 480, 1, 20, false);
+	CHECK_EQ(spin(5, 150), 5);
+	tick(300);
+	CHECK_EQ(spin(8, 20), 1 + 7 * 20);
+	enc.setClockWise(true);
+}
+
+// The queue keeps 63 detents while the main loop is busy, the others are lost
+static void testLostEvents(void) {
+	rotateUp();
+	enc.reset(0, 0, 1000, 1, 1, false);
+	uint32_t lost = enc.lostEvents();
+	for (uint8_t i = 0; i < 70; ++i) {
+		detent();
+		tick(10);
+	}
+	CHECK_EQ(enc.lostEvents() - lost, 7);
+	CHECK_EQ(enc.read(), 63);
+	CHECK_EQ(spin(5, 20), 5);								// The queue works again
+	CHECK_EQ(enc.lostEvents() - lost, 7);
+	enc.setClockWise(true);
+}
+
+int main(void) {
+	EMU_ClockSet(1000);
+	enc.addButton(&port, PIN_BTN);
+	testShortLong();
+	testButtonTiming();
+	testResetButton();
+	testRotation();
+	testExtendUpper();
+	testAcceleration();
+	testLostEvents();
+	return testResult("encoder");
+}
@@ -0,0 +1,171 @@
+/*
+ * test_flash.cpp
+ *
+ *  Created on: 2026 OCT 18
+ *
+ *  The tip calibration file on the emulated W25Qxx flash. W25Q::init() keeps the file if any tip record has correct CRC,
+ *  the inactive and not calibrated tips as well, and restores the backup file only if no record is readable.
+ *  W25Q::migrateTips() decides the file format by the correct records of the whole file, not by the first record.
+ */
+
+#include <string.h>
+#include "flash.h"
+#include "emu.h"
+#include "test.h"
+
+static W25Q flash;
+
+static void makeTip(TIP *tip, const char *name, uint8_t mask) {
+	memset((void *)tip, 0, sizeof(TIP));
+	tip->t200	= 1000;
+	tip->t260	= 1300;
+	tip->t330	= 1700;
+	tip->t400	= 2100;
+	tip->mask	= mask;
+	tip->ambient= 25;
+	strncpy(tip->name, name, tip_name_sz);
+}
+
+// Write raw data to the file on the flash drive
+static bool writeFile(const TCHAR *fn, const void *data, UINT size) {
+	FIL f;
+	UINT bw = 0;
+	if (!flash.mount() || FR_OK != f_open(&f, fn, FA_CREATE_ALWAYS | FA_WRITE))
+		return false;
+	f_write(&f, data, size, &bw);
+	f_close(&f);
+	flash.umount();
+	return bw == size;
+}
+
+static FSIZE_t fileSize(const TCHAR *fn) {
+	FILINFO fno;
+	FSIZE_t size = 0;
+	if (flash.mount() && FR_OK == f_stat(fn, &fno))
+		size = fno.fsize;
+	flash.umount();
+	return size;
+}
+
+// The tip record of version 0, the same as in flash.cpp
+typedef struct s_tip_v0 {
+	uint16_t	t200, t260, t330, t400;
+	uint8_t		mask;
+	char		name[tip_name_sz];
+	int8_t		ambient;
+	uint8_t		crc;
+} TIP_V0;
+
+static uint8_t checkSumV0(const TIP_V0 *tip) {
+	uint32_t summ = tip->t200;
+	summ <<= 1; summ += tip->t260;
+	summ <<= 1; summ += tip->t330;
+	summ <<= 1; summ += tip->t400;
+	summ <<= 1; summ += tip->mask;
+	summ <<= 1; summ += tip->ambient;
+	for (int i = 0; i < tip_name_sz; ++i) {
+		summ <<= 1; summ += (uint8_t)tip->name[i];
+	}
+	return (summ + 117) & 0xFF;
+}
+
+static void makeTipV0(TIP_V0 *tip, const char *name) {
+	memset((void *)tip, 0, sizeof(TIP_V0));
+	tip->t200	= 1000;
+	tip->t260	= 1300;
+	tip->t330	= 1700;
+	tip->t400	= 2100;
+	tip->mask	= TIP_ACTIVE | TIP_CALIBRATED;
+	tip->ambient= 25;
+	strncpy(tip->name, name, tip_name_sz);
+	tip->crc	= checkSumV0(tip);
+}
+
+static bool tipName(uint8_t index, const char *name) {
+	TIP tip;
+	return TIP_OK == flash.loadTipData(&tip, index) && strncmp(tip.name, name, tip_name_sz) == 0;
+}
+
+// Only inactive and not calibrated tips in the file: the records are correct, the backup should not replace them
+static void testInactiveTips(void) {
+	CHECK(flash.formatFlashDrive());
+	TIP tips[3];
+	makeTip(&tips[0], "B2", 0);
+	makeTip(&tips[1], "BC2", 0);
+	makeTip(&tips[2], "K", 0);
+	for (uint8_t i = 0; i < 3; ++i)
+		CHECK_EQ(flash.saveTipData(&tips[i], i), i);
+	TIP old;
+	makeTip(&old, "D24", TIP_ACTIVE | TIP_CALIBRATED);
+	CHECK(writeFile("tipcal.bak", &old, sizeof(old)));		// The backup of the older state
+	CHECK_EQ(flash.init(), FLASH_OK);
+	CHECK_EQ(fileSize("tipcal.dat"), 3 * sizeof(TIP));
+	CHECK(tipName(0, "B2"));
+	CHECK(tipName(2, "K"));
+	CHECK(fileSize("tipcal.bak") > 0);						// The backup is kept
+}
+
+// No readable record in the tip file: the backup is restored
+static void testCorruptTips(void) {
+	CHECK(flash.formatFlashDrive());
+	TIP tip;
+	makeTip(&tip, "B2", TIP_ACTIVE);
+	CHECK_EQ(flash.saveTipData(&tip, 0), 0);
+	CHECK_EQ(flash.saveTipData(&tip, 1), 1);				// The backup has one record now
+	uint8_t bad[2 * sizeof(TIP)];
+	memset(bad, 0x5A, sizeof(bad));
+	CHECK(writeFile("tipcal.dat", bad, sizeof(bad)));
+	CHECK_EQ(flash.init(), FLASH_OK);
+	CHECK_EQ(fileSize("tipcal.dat"), sizeof(TIP));
+	CHECK(tipName(0, "B2"));
+	CHECK_EQ(fileSize("tipcal.bak"), 0);
+}
+
+// The file of version 0 with the broken first record is converted, the broken record becomes empty
+static void testMigrateV0(void) {
+	CHECK(flash.formatFlashDrive());
+	TIP_V0 old[5];
+	const char *names[5] = { "B2", "BC2", "K", "D24", "ILS" };
+	for (uint8_t i = 0; i < 5; ++i)
+		makeTipV0(&old[i], names[i]);
+	old[0].crc ^= 0x55;
+	CHECK(writeFile("tipcal.dat", old, sizeof(old)));
+	CHECK_EQ(flash.init(), FLASH_OK);
+	CHECK_EQ(fileSize("tipcal.dat"), 5 * sizeof(TIP));
+	TIP tip;
+	CHECK_EQ(flash.loadTipData(&tip, 0), TIP_OK);
+	CHECK_EQ(tip.name[0], '\0');
+	for (uint8_t i = 1; i < 5; ++i)
+		CHECK(tipName(i, names[i]));
+}
+
+// The file of current format, 80 bytes, is a multiple of both record sizes. Its broken first record passes the checksum
+// of version 0, the other records keep the file in the current format
+static void testKeepCurrent(void) {
+	CHECK(flash.formatFlashDrive());
+	TIP tips[4];
+	const char *names[4] = { "B2", "BC2", "K", "D24" };
+	for (uint8_t i = 0; i < 4; ++i)
+		makeTip(&tips[i], names[i], TIP_ACTIVE | TIP_CALIBRATED);
+	for (uint8_t i = 0; i < 4; ++i)
+		CHECK_EQ(flash.saveTipData(&tips[i], i), i);
+	uint8_t raw[4 * sizeof(TIP)];
+	memcpy(raw, tips, sizeof(raw));
+	TIP_V0 *first = (TIP_V0 *)raw;							// The version byte of TIP is the crc byte of TIP_V0
+	first->crc = checkSumV0(first);
+	CHECK(writeFile("tipcal.dat", raw, sizeof(raw)));
+	CHECK_EQ(flash.init(), FLASH_OK);
+	CHECK_EQ(fileSize("tipcal.dat"), sizeof(raw));
+	for (uint8_t i = 1; i < 4; ++i)
+		CHECK(tipName(i, names[i]));
+}
+
+int main(void) {
+	CHECK(EMU_W25Q_Init(512));										// 2 MB flash
+	testInactiveTips();
+	testCorruptTips();
+	testMigrateV0();
+	testKeepCurrent();
+	EMU_W25Q_Free();
+	return testResult("flash");
+}
@@ -0,0 +1,135 @@
+/*
+ * test_font.cpp
+ *
+ *  Created on: 2026 OCT 18
+ *
+ *  FONT_CACHE reads the NLS font files from the emulated W25Qxx flash glyph by glyph.
+ *  Every ASCII and Unicode glyph read through the cache is compared with the font data, the cache statistics are checked.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <glob.h>
+#include <string>
+#include "font_cache.h"
+#include "u8g_font.h"
+#include "emu.h"
+#include "test.h"
+
+#define NLS_DIR		"../NLS/"
+
+static FATFS	fs;
+static uint8_t	work[4096];
+static const uint8_t	*ext_font	= 0;
+
+// The host replacement of the display font hook, FONT_CACHE registers the glyph callback here
+void u8g2_SetExternalFont(const uint8_t *font, u8g2_glyph_cb glyph_cb, void *ctx) {
+	ext_font = font;
+}
+
+static bool readHostFile(const char *path, std::string &data) {
+	FILE *f = fopen(path, "rb");
+	if (!f) return false;
+	char buff[512];
+	size_t n;
+	data.clear();
+	while ((n = fread(buff, 1, sizeof(buff), f)) > 0)
+		data.append(buff, n);
+	fclose(f);
+	return true;
+}
+
+static bool writeFile(const char *fn, const std::string &data) {
+	FIL f;
+	UINT bw = 0;
+	if (FR_OK != f_open(&f, fn, FA_CREATE_ALWAYS | FA_WRITE))
+		return false;
+	f_write(&f, data.data(), data.size(), &bw);
+	f_close(&f);
+	return bw == data.size();
+}
+
+static bool format(void) {
+	MKFS_PARM p;
+	p.fmt		= FM_FAT | FM_SFD;								// The same parameters as in W25Qxx.h
+	p.au_size	= 4096;
+	p.align		= 0;
+	p.n_fat		= 1;
+	p.n_root	= 128;
+	return FR_OK == f_mkfs("0:", &p, work, sizeof(work));
+}
+
+/*
+ * Compare the glyphs read by the cache with the font data, see FONT_CACHE::buildIndex()
+ * ASCII glyph record: encoding (1 byte), record size (1 byte), data
+ * Unicode glyph record: encoding (2 bytes), record size (1 byte), data. The list ends by zero encoding
+ */
+static bool checkGlyphs(FONT_CACHE &fc, const std::string &font, uint16_t *ascii, uint16_t *unicode) {
+	const uint8_t *f = (const uint8_t *)font.data();
+	uint32_t pos = 23;
+	*ascii = *unicode = 0;
+	while (f[pos+1] != 0) {
+		const uint8_t *g = fc.glyph(f[pos]);
+		if (!g || memcmp(g, &f[pos+2], f[pos+1] - 2) != 0)
+			return false;
+		++*ascii;
+		pos += f[pos+1];
+	}
+	uint16_t start_pos_unicode = f[21] << 8 | f[22];
+	if (start_pos_unicode == 0)
+		return true;
+	pos = 23 + start_pos_unicode;
+	pos += f[pos] << 8 | f[pos+1];
+	while (pos + 2 <= font.size()) {
+		uint16_t e = f[pos] << 8 | f[pos+1];
+		if (e == 0) break;
+		const uint8_t *g = fc.glyph(e);
+		if (!g || memcmp(g, &f[pos+3], f[pos+2] - 3) != 0)
+			return false;
+		++*unicode;
+		pos += f[pos+2];
+	}
+	return true;
+}
+
+static void testFont(const char *path) {
+	std::string font;
+	CHECK(readHostFile(path, font));
+	CHECK(writeFile("test.font", font));
+	FIL f;
+	CHECK_EQ(f_open(&f, "test.font", FA_READ), FR_OK);
+	FONT_CACHE fc;
+	CHECK(fc.open(&f));
+	CHECK(fc.isOpen());
+	CHECK(ext_font == fc.font());
+	if (!fc.isOpen()) return;
+	CHECK(memcmp(fc.font(), font.data(), 23) == 0);			// The font header
+	uint16_t ascii = 0, unicode = 0;
+	CHECK(checkGlyphs(fc, font, &ascii, &unicode));
+	printf("  %-16s %5u bytes %3u ascii %3u unicode glyphs\n", path + strlen(NLS_DIR), (unsigned)font.size(), ascii, unicode);
+	CHECK(ascii > 0);
+	CHECK_EQ(fc.misses(), ascii + unicode);					// Every glyph was read once
+	fc.glyph('A');											// Replaced in the cache by the last glyphs
+	fc.glyph('A');
+	CHECK_EQ(fc.misses(), ascii + unicode + 1);
+	CHECK_EQ(fc.hits(), 1);
+	CHECK(fc.glyph(0xFFFE) == 0);
+	fc.close();
+	CHECK(!fc.isOpen());
+	CHECK(ext_font == 0);
+}
+
+int main(void) {
+	CHECK(EMU_W25Q_Init(512));								// 2 MB flash
+	CHECK(format());
+	CHECK_EQ(f_mount(&fs, "0:", 1), FR_OK);
+	glob_t g;
+	CHECK_EQ(glob(NLS_DIR "*.font", 0, 0, &g), 0);
+	CHECK(g.gl_pathc >= 3);
+	for (size_t i = 0; i < g.gl_pathc; ++i)
+		testFont(g.gl_pathv[i]);
+	globfree(&g);
+	f_mount(0, "0:", 0);
+	EMU_W25Q_Free();
+	return testResult("font");
+}
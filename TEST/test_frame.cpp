@@ -0,0 +1,100 @@
+/*
+ * test_frame.cpp
+ *
+ *  Created on: 2026 OCT 18
+ *
+ *  COBS encoding keeps the data without zero bytes and restores it back, including the 254-byte block boundaries.
+ *  The frame survives the round trip, any corrupted or truncated frame is rejected.
+ */
+
+#include <string.h>
+#include "frame.h"
+#include "crc.h"
+#include "test.h"
+
+// Encode and decode the data, the encoded data should have no zero bytes
+static bool cobsRoundTrip(const uint8_t *data, uint16_t len) {
+	uint8_t enc[600], dec[600];
+	uint16_t n = COBS_Encode(data, len, enc);
+	if (n > len + 1 + len / 254) return false;				// The worst case overhead: one code byte per started 254-byte block
+	for (uint16_t i = 0; i < n; ++i)
+		if (enc[i] == 0) return false;
+	uint16_t m = COBS_Decode(enc, n, dec);
+	return m == len && memcmp(data, dec, len) == 0;
+}
+
+static void testCobs(void) {
+	uint8_t d[520] = {0};
+	CHECK(cobsRoundTrip(d, 0));
+	CHECK(cobsRoundTrip(d, 1));
+	CHECK(cobsRoundTrip(d, 10));							// Zeros only
+	for (uint16_t i = 0; i < sizeof(d); ++i)
+		d[i] = i % 255 + 1;									// No zeros
+	CHECK(cobsRoundTrip(d, 253));
+	CHECK(cobsRoundTrip(d, 254));							// The longest block
+	CHECK(cobsRoundTrip(d, 255));
+	CHECK(cobsRoundTrip(d, 508));
+	d[254] = 0;												// The zero right after the longest block
+	CHECK(cobsRoundTrip(d, 300));
+	d[100] = d[101] = 0;
+	CHECK(cobsRoundTrip(d, 300));
+
+	const uint8_t bad_code[] = {5, 1, 2};					// The block is longer than the data
+	uint8_t out[8];
+	CHECK_EQ(COBS_Decode(bad_code, sizeof(bad_code), out), 0);
+	const uint8_t zero_in[] = {3, 1, 0};					// The delimiter inside the frame
+	CHECK_EQ(COBS_Decode(zero_in, sizeof(zero_in), out), 0);
+}
+
+static void testFrame(void) {
+	uint8_t frame[FRAME_MAX_SIZE], payload[FRAME_MAX_PAYLOAD], data[FRAME_MAX_PAYLOAD+1];
+	uint8_t type = 0, seq = 0;
+	for (uint16_t i = 0; i < sizeof(data); ++i)
+		data[i] = (i % 5)?i:0;								// A lot of zeros to be stuffed
+
+	for (uint16_t len = 0; len <= FRAME_MAX_PAYLOAD; len += 16) {
+		uint16_t n = FRAME_Pack(FRAME_REPLY, len, data, len, frame);
+		CHECK(n > 0 && n <= FRAME_MAX_SIZE);
+		CHECK_EQ(frame[n-1], 0);							// The delimiter
+		CHECK(memchr(frame, 0, n-1) == 0);					// The only zero byte
+		CHECK_EQ(FRAME_Unpack(frame, n-1, &type, &seq, payload), len);
+		CHECK_EQ(type, FRAME_REPLY);
+		CHECK_EQ(seq, len);
+		CHECK(memcmp(payload, data, len) == 0);
+	}
+	CHECK_EQ(FRAME_Pack(FRAME_REPLY, 0, data, FRAME_MAX_PAYLOAD+1, frame), 0);
+
+	// Every single bit error is detected
+	uint16_t n = FRAME_Pack(FRAME_TELEMETRY, 7, data, 40, frame) - 1;
+	uint16_t accepted = 0;
+	for (uint16_t i = 0; i < n; ++i) {
+		for (uint8_t b = 0; b < 8; ++b) {
+			frame[i] ^= 1 << b;
+			if (FRAME_Unpack(frame, n, &type, &seq, payload) >= 0) ++accepted;
+			frame[i] ^= 1 << b;
+		}
+	}
+	CHECK_EQ(accepted, 0);
+	CHECK_EQ(FRAME_Unpack(frame, n, &type, &seq, payload), 40);
+
+	// Lost bytes are detected
+	for (uint16_t len = 0; len < n; ++len)
+		if (FRAME_Unpack(frame, len, &type, &seq, payload) >= 0) ++accepted;
+	CHECK_EQ(accepted, 0);
+	uint8_t lost[FRAME_MAX_SIZE];							// A byte lost in the middle
+	memcpy(lost, frame, 20);
+	memcpy(&lost[20], &frame[21], n - 21);
+	CHECK_EQ(FRAME_Unpack(lost, n-1, &type, &seq, payload), -1);
+	CHECK_EQ(FRAME_Unpack(frame, FRAME_MAX_SIZE+1, &type, &seq, payload), -1);	// Too long, two frames run together
+}
+
+static void testCrc(void) {
+	CHECK_EQ(crc32(0, "123456789", 9), 0xCBF43926);			// The standard check value, the host side uses zlib crc32()
+}
+
+int main(void) {
+	testCobs();
+	testFrame();
+	testCrc();
+	return testResult("frame");
+}
@@ -0,0 +1,208 @@
+/*
+ * test_json.cpp
+ *
+ *  Created on: 2026 OCT 18
+ *
+ *  Benchmark of the JSON parser listeners over the NLS json files. Every file is parsed from the RAM many times by the listeners
+ *  of the firmware (JSON_LANG_CFG, JSON_MESSAGES) that use the zero-allocation callbacks, and by the listeners
+ *  built the old way: std::string callbacks, std::stack<std::string> of the keys.
+ *  Prints the heap allocations, the heap peak and the time per parse. Checks the new listeners find the same messages
+ *  and languages, the messages are loaded without a heap allocation, the new listeners allocate less than the old ones.
+ *  FILE_PARSER::readFile() adds one block, the file read buffer (512 bytes), to the figures of the new listeners.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <glob.h>
+#include <time.h>
+#include <stack>
+#include <string>
+#include "jsoncfg.h"
+#include "emu.h"
+#include "test.h"
+
+#define NLS_DIR		"../NLS/"
+#define RUNS		(200)
+
+typedef struct s_bench {
+	uint32_t	allocs;										// Heap allocations per parse
+	uint32_t	peak;										// Heap peak during the parse, bytes
+	double		us;											// Time per parse
+} t_bench;
+
+//------------------------------------------------- The listeners of the old interface ------------------------
+class LEGACY_PARSER : public JsonListener {
+	public:
+		virtual void	key(std::string key)				{ d_key = key;	}
+		virtual void	startDocument()						{ while (!s_key.empty()) s_key.pop(); while (!s_array.empty()) s_array.pop(); d_key.clear(); }
+		virtual void	startObject()						{ s_key.push(d_key);				}
+		virtual void	endObject()							{ s_key.pop();   d_key.clear();		}
+		virtual void	startArray()						{ s_array.push(d_key);				}
+		virtual void	endArray()							{ s_array.pop(); d_key.clear();		}
+		virtual void	endDocument()						{ }
+		virtual void	whitespace(char c)					{ }
+	protected:
+		std::string				d_key;
+		std::stack<std::string>	s_array;
+		std::stack<std::string>	s_key;
+};
+
+class LEGACY_MESSAGES : public LEGACY_PARSER {
+	public:
+		LEGACY_MESSAGES(NLS_MSG *pMsg)						{ this->pMsg = pMsg; }
+		virtual void	value(std::string value) {
+			std::string parent = s_key.top();
+			int16_t i = pMsg->find(d_key.c_str(), parent.c_str());
+			if (i >= 0 && !value.empty()) found[i] = true;
+		}
+		uint8_t			count(void)							{ uint8_t n = 0; for (bool f : found) n += f; return n; }
+		void			clear(void)							{ memset(found, 0, sizeof(found)); }
+	private:
+		NLS_MSG			*pMsg;
+		bool			found[MSG_LAST] = {false};
+};
+
+class LEGACY_LANG_CFG : public LEGACY_PARSER {
+	public:
+		virtual void	value(std::string value) {
+			if (s_array.empty() || s_array.top().compare("languages") != 0)
+				return;
+			if (d_key.compare("name") == 0) {
+				if (!data.lang.empty() && data.lang.compare(value) != 0)
+					lang_list.push_back(data);
+				data.lang = value;
+				data.font_file.clear();
+				data.messages_file.clear();
+			} else if (d_key.compare("messages") == 0) {
+				data.messages_file = value;
+			} else if (d_key.compare("font") == 0) {
+				data.font_file = value;
+			}
+		}
+		virtual void	endDocument()						{ if (!data.lang.empty()) lang_list.push_back(data); }
+		void			clear(void)							{ lang_list.clear(); data.lang.clear(); }
+		uint8_t			listSize(void)						{ return lang_list.size(); }
+	private:
+		t_lang_cfg		data;
+		t_lang_list		lang_list;
+};
+
+//------------------------------------------------- The benchmark ---------------------------------------------
+// Feed the parser like FILE_PARSER::readFile() does: skip everything before the document body
+static void parse(JsonListener *listener, const std::string &json) {
+	JsonStreamingParser parser;
+	parser.setListener(listener);
+	bool is_body = false;
+	for (char c : json) {
+		if (!is_body && (c == '{' || c == '['))
+			is_body = true;
+		if (is_body)
+			parser.parse(c);
+	}
+}
+
+static double now(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+// The first parse is measured for the heap, the average time of all runs. prepare() is called before each run
+template <typename F>
+static t_bench bench(JsonListener *listener, const std::string &json, F prepare) {
+	t_bench b;
+	t_heap_emu_stat st;
+	prepare();
+	EMU_HeapStat(&st);
+	uint32_t base = st.bytes;
+	EMU_HeapReset();
+	parse(listener, json);
+	EMU_HeapStat(&st);
+	b.allocs	= st.allocs;
+	b.peak		= st.peak - base;
+	double t = 0;
+	for (int i = 0; i < RUNS; ++i) {
+		prepare();
+		double start = now();
+		parse(listener, json);
+		t += now() - start;
+	}
+	b.us = t / RUNS;
+	return b;
+}
+
+static void report(const char *name, const char *listener, const t_bench &b) {
+	printf("  %-16s %-8s %5u allocs %6u bytes peak %8.1f us\n", name, listener, b.allocs, b.peak, b.us);
+}
+
+static bool readFile(const std::string &path, std::string &data) {
+	FILE *f = fopen(path.c_str(), "rb");
+	if (!f) return false;
+	char buff[512];
+	size_t n;
+	data.clear();
+	while ((n = fread(buff, 1, sizeof(buff), f)) > 0)
+		data.append(buff, n);
+	fclose(f);
+	return true;
+}
+
+// The number of messages that point into the arena
+static uint8_t translated(NLS_MSG &nls, uint32_t arena_size) {
+	uint8_t n = 0;
+	for (uint8_t i = 0; i < MSG_LAST; ++i) {
+		const char *m = nls.msg((t_msg_id)i);
+		n += (m >= nls.arenaData() && m < nls.arenaData() + arena_size);
+	}
+	return n;
+}
+
+static void benchMessages(const char *name, const std::string &json) {
+	NLS_MSG			nls;
+	JSON_MESSAGES	fresh;
+	LEGACY_MESSAGES	legacy(&nls);
+	fresh.setNLS_MSG(&nls);
+	CHECK(nls.allocateArena(json.size()));					// The arena is allocated once before the parse
+	t_bench b_new = bench(&fresh, json, [&]() { nls.arenaUsed(0); });
+	uint8_t loaded = translated(nls, json.size());
+	t_bench b_old = bench(&legacy, json, [&]() { legacy.clear(); });
+	report(name, "new", b_new);
+	report(name, "old", b_old);
+	CHECK(loaded > MSG_LAST / 2);
+	CHECK_EQ(loaded, legacy.count());						// Both listeners find the same messages
+	CHECK_EQ(b_new.allocs, 0);
+	CHECK(b_new.allocs < b_old.allocs);
+	nls.freeArena();
+}
+
+static void benchLangCfg(const char *name, const std::string &json) {
+	JSON_LANG_CFG	fresh;
+	LEGACY_LANG_CFG	legacy;
+	t_bench b_new = bench(&fresh, json, [&]() { fresh.getLangList()->clear(); });	// As readConfig() does
+	t_bench b_old = bench(&legacy, json, [&]() { legacy.clear(); });
+	report(name, "new", b_new);
+	report(name, "old", b_old);
+	CHECK(fresh.listSize() > 0);
+	CHECK_EQ(fresh.listSize(), legacy.listSize());
+	CHECK(b_new.allocs <= b_old.allocs);					// Short strings do not allocate, the list itself does
+}
+
+int main(void) {
+	glob_t g;
+	CHECK_EQ(glob(NLS_DIR "*.json", 0, 0, &g), 0);
+	printf("JSON parser benchmark, %d runs\n", RUNS);
+	uint8_t files = 0;
+	for (size_t i = 0; i < g.gl_pathc; ++i) {
+		const char *name = g.gl_pathv[i] + strlen(NLS_DIR);
+		std::string json;
+		CHECK(readFile(g.gl_pathv[i], json));
+		if (json.find("\"languages\"") != std::string::npos)
+			benchLangCfg(name, json);
+		else
+			benchMessages(name, json);
+		++files;
+	}
+	globfree(&g);
+	CHECK(files >= 4);
+	return testResult("json");
+}
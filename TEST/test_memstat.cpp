@@ -0,0 +1,49 @@
+/*
+ * test_memstat.cpp
+ *
+ *  Created on: 2026 OCT 18
+ *
+ *  The largest allocatable block is found in the newlib-nano free list or above the heap top.
+ *  The interrupt nesting depth peak is kept after the handlers return.
+ */
+
+#include <stddef.h>
+#include "memstat.h"
+#include "test.h"
+
+static void testLargestFree(void) {
+	const uint32_t hdr = offsetof(t_mem_chunk, next);		// The chunk header is not available to the caller
+	CHECK_EQ(MEM_LargestFree(0, 0), 0);
+	CHECK_EQ(MEM_LargestFree(0, 3000), 3000);				// Empty free list: the unclaimed space only
+
+	t_mem_chunk c[4];										// Fragmented heap: the free chunks of 24, 520, 16 and 136 bytes
+	c[0].size = 24;		c[0].next = &c[1];
+	c[1].size = 520;	c[1].next = &c[2];
+	c[2].size = 16;		c[2].next = &c[3];
+	c[3].size = 136;	c[3].next = 0;
+	CHECK_EQ(MEM_LargestFree(c, 0), 520 - hdr);
+	CHECK_EQ(MEM_LargestFree(c, 100), 520 - hdr);			// The fragment is bigger than the unclaimed space
+	CHECK_EQ(MEM_LargestFree(c, 4096), 4096);
+	CHECK_EQ(MEM_LargestFree(&c[2], 0), 136 - hdr);			// The list tail
+
+	c[0].size = 0;		c[0].next = 0;						// Corrupted header does not wrap around
+	CHECK_EQ(MEM_LargestFree(c, 8), 8);
+}
+
+static void testIrqDepth(void) {
+	CHECK_EQ(mem_irq_peak, 0);
+	MEM_IrqEnter();											// TIM2 handler
+	MEM_IrqEnter();											// Preempted by the EXTI handler
+	MEM_IrqLeave();
+	MEM_IrqEnter();											// Another preemption, not deeper
+	MEM_IrqLeave();
+	MEM_IrqLeave();
+	CHECK_EQ(mem_irq_depth, 0);
+	CHECK_EQ(mem_irq_peak, 2);
+}
+
+int main(void) {
+	testLargestFree();
+	testIrqDepth();
+	return testResult("memstat");
+}
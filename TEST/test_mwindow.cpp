@@ -0,0 +1,143 @@
+/*
+ * test_mwindow.cpp
+ *
+ *  Created on: 2026 OCT 18
+ *
+ *  The IRON measurement window fed by the thermocouple amplifier model: after the heater is switched off
+ *  the amplifier output decays to the temperature exponentially, the ADC samples are taken 1.5 TIM2 ticks apart.
+ *  Checks the window adapts to the amplifier recovery time and stays in its limits, the IRON power is limited by the window,
+ *  the samples taken too early or after the TIM2 period end are replaced by the last settled temperature for a limited time,
+ *  the ADC time margin grows when the ADC is late.
+ */
+
+#include <math.h>
+#include "mwindow.h"
+#include "test.h"
+
+#define LOOPS	(MW_ADC_LOOPS)
+#define TEMP	(1500)											// The iron temperature, ADC counts
+
+static uint32_t rnd = 1;
+
+static int noise(void) {										// -2 .. +2 ADC counts
+	rnd = rnd * 1103515245 + 12345;
+	return (int)((rnd >> 16) % 5) - 2;
+}
+
+// The amplifier output 'quiet' TIM2 ticks after the heater was switched off, tau is the recovery time in TIM2 ticks
+static void sample(uint16_t s[], int32_t quiet, double tau, double tail = 400.0) {
+	for (uint8_t i = 0; i < LOOPS; ++i)
+		s[i] = TEMP + (uint16_t)lround(tail * exp(-(quiet + 1.5 * i) / tau)) + noise();
+}
+
+// The iron is powered at full power, every 20-th period the heater is off. Returns the maximum temperature error of last periods
+static int run(MWINDOW &mw, double tau, uint32_t periods, double tail = 400.0) {
+	uint16_t s[LOOPS];
+	int err = 0;
+	bool limited = true;
+	for (uint32_t p = 0; p < periods; ++p) {
+		uint16_t arr		= 2000 + (p % 3) * 4 - 4;				// acZeroCross() trims the period
+		uint16_t tp			= mw.tempPoint(arr);
+		uint16_t applied	= (p % 20 == 19)?0:mw.maxPower();
+		if (applied > tp - mw.window()) limited = false;
+		int32_t quiet		= (applied == 0)?1000:tp - applied;
+		sample(s, quiet, tau, tail);
+		uint16_t t = mw.measure(s, LOOPS, applied, tp + 6);		// The ADC sequence takes 6 ticks
+		if (p >= periods - 200) {
+			int e = abs((int)t - TEMP);
+			if (e > err) err = e;
+		}
+	}
+	CHECK(limited);												// The power never exceeds the window
+	return err;
+}
+
+static void testInit(void) {
+	MWINDOW mw;
+	mw.init();
+	CHECK_EQ(mw.window(), 20);
+	CHECK_EQ(mw.adcTicks(), MW_ADC_TICKS);
+	CHECK_EQ(mw.tempPoint(1999), 1989);
+	CHECK_EQ(mw.maxPower(), 1969);
+	CHECK_EQ(mw.late(), 0);
+	// The ADC sequence fits the margin, see the static_assert in mwindow.h
+	double adc_ticks = MW_ADC_LOOPS * MW_ADC_LOOP_CYCLES * 100000.0 / MW_ADC_CLOCK;
+	CHECK(adc_ticks + MW_ADC_LATENCY <= MW_ADC_TICKS);
+}
+
+static void testAdapt(void) {
+	MWINDOW fast, slow, stuck;
+	fast.init();
+	slow.init();
+	stuck.init();
+	rnd = 1;
+	int fast_err = run(fast, 3.0, 4000);
+	int slow_err = run(slow, 10.0, 4000);
+	CHECK(fast.window() < 20);									// The fast amplifier needs shorter window than default
+	CHECK(slow.window() > 20);
+	CHECK(fast.window() >= 4);
+	CHECK(slow.window() <= 60);
+	CHECK(fast_err <= 8);										// The settled temperature is read, the noise and the tail remain
+	CHECK(slow_err <= 8 + 400.0 * exp(-slow.window() / 10.0));	// The slow amplifier tail is bigger when the drift is small
+	run(stuck, 100.0, 10000, 2000.0);							// The amplifier never settles: the window is limited
+	CHECK_EQ(stuck.window(), 60);
+	uint16_t tp = stuck.tempPoint(2000);
+	CHECK_EQ(stuck.maxPower(), tp - 60);
+	CHECK_EQ(fast.late(), 0);
+}
+
+static void testHeaterOff(void) {
+	MWINDOW mw;
+	mw.init();
+	uint16_t s[LOOPS] = {1500, 1501, 1502, 1503};
+	mw.tempPoint(2000);
+	CHECK_EQ(mw.measure(s, LOOPS, 0, 1996), 1502);				// The rounded average
+	uint16_t one[1] = {1234};
+	CHECK_EQ(mw.measure(one, 1, 0, 1996), 1234);
+}
+
+static void testEarly(void) {
+	MWINDOW mw;
+	mw.init();
+	uint16_t tp = mw.tempPoint(2000);
+	uint16_t hot[LOOPS] = {1900, 1880, 1860, 1840};
+	CHECK_EQ(mw.measure(hot, LOOPS, tp - 5, tp + 6), 1870);		// No settled temperature yet, the samples are used
+	uint16_t s[LOOPS] = {1500, 1500, 1500, 1500};
+	CHECK_EQ(mw.measure(s, LOOPS, 0, tp + 6), 1500);
+	for (int i = 0; i < 4; ++i)									// The period was shortened: quiet is 5 ticks only
+		CHECK_EQ(mw.measure(hot, LOOPS, tp - 5, tp + 6), 1500);
+	CHECK_EQ(mw.measure(hot, LOOPS, tp - 5, tp + 6), 1870);		// Do not hold the old temperature forever
+	CHECK_EQ(mw.measure(s, LOOPS, tp - 20, tp + 6), 1500);		// The window was kept: settled
+	CHECK_EQ(mw.measure(hot, LOOPS, tp - 5, tp + 6), 1500);		// The hold counter was reset
+	CHECK_EQ(mw.window(), 20);
+}
+
+static void testLate(void) {
+	MWINDOW mw;
+	mw.init();
+	uint16_t tp = mw.tempPoint(2000);
+	CHECK_EQ(tp, 1990);
+	uint16_t s[LOOPS] = {1500, 1500, 1500, 1500};
+	CHECK_EQ(mw.measure(s, LOOPS, 0, tp + 6), 1500);
+	uint16_t hot[LOOPS] = {1800, 1800, 1800, 1800};
+	CHECK_EQ(mw.measure(hot, LOOPS, 0, 3), 1500);				// TIM2 counter has wrapped: the ADC finished in the next period
+	CHECK_EQ(mw.late(), 1);
+	CHECK_EQ(mw.adcTicks(), MW_ADC_TICKS + 2);
+	CHECK_EQ(mw.tempPoint(2000), 2000 - MW_ADC_TICKS - 2);
+	CHECK_EQ(mw.maxPower(), 2000 - MW_ADC_TICKS - 2 - 20);
+	for (int i = 0; i < 20; ++i)
+		mw.measure(hot, LOOPS, 0, 3);
+	CHECK_EQ(mw.late(), 21);
+	CHECK_EQ(mw.adcTicks(), 30);								// The margin is limited
+	mw.init();
+	CHECK_EQ(mw.adcTicks(), MW_ADC_TICKS);
+}
+
+int main(void) {
+	testInit();
+	testAdapt();
+	testHeaterOff();
+	testEarly();
+	testLate();
+	return testResult("mwindow");
+}
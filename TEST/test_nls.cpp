@@ -0,0 +1,279 @@
+/*
+ * test_nls.cpp
+ *
+ *  Created on: 2026 OCT 18
+ *
+ *  NLS loads the binary language pack from the emulated W25Qxx flash. The pack is built by the test from NLS/ubuntu_we.font.
+ *  The font that fits the memory is loaded into the memory, the font that does not fit is read by FONT_CACHE
+ *  from the pack file at the font offset. Checks every ASCII glyph read by the cache, the pack with corrupted font is rejected.
+ *  The JSON messages file is loaded into the single arena: the heap blocks, bytes and peak of the language switch are printed
+ *  and compared with the copies of the messages in std::string, one per message, the way NLS_MSG kept them before.
+ *  The messages and font files with CRC32 different from the one in cfg.json are rejected, the font in memory and in FONT_CACHE.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include "nls_cfg.h"
+#include "crc.h"
+#include "u8g_font.h"
+#include "emu.h"
+#include "test.h"
+
+#define FONT_FILE		"../NLS/ubuntu_we.font"
+#define CYR_FONT_FILE	"../NLS/ubuntu_cyr.font"
+#define RU_MSG_FILE		"../NLS/ru_lang.json"
+
+static FATFS	fs;
+static uint8_t	work[4096];
+static NLS_MSG	msg;
+static NLS		nls;
+static std::string	font, cyr_font, ru_msg;
+static const uint8_t	*ext_font	= 0;
+
+// The host replacement of the display font hook, FONT_CACHE registers the glyph callback here
+void u8g2_SetExternalFont(const uint8_t *font, u8g2_glyph_cb glyph_cb, void *ctx) {
+	ext_font = font;
+}
+
+static bool readHostFile(const char *path, std::string &data) {
+	FILE *f = fopen(path, "rb");
+	if (!f) return false;
+	char buff[512];
+	size_t n;
+	data.clear();
+	while ((n = fread(buff, 1, sizeof(buff), f)) > 0)
+		data.append(buff, n);
+	fclose(f);
+	return true;
+}
+
+static bool writeFile(const char *fn, const std::string &data) {
+	FIL f;
+	UINT bw = 0;
+	if (FR_OK != f_mount(&fs, "0:", 1) || FR_OK != f_open(&f, fn, FA_CREATE_ALWAYS | FA_WRITE))
+		return false;
+	f_write(&f, data.data(), data.size(), &bw);
+	f_close(&f);
+	f_mount(0, "0:", 0);
+	return bw == data.size();
+}
+
+static bool format(void) {
+	MKFS_PARM p;
+	p.fmt		= FM_FAT | FM_SFD;								// The same parameters as in W25Qxx.h
+	p.au_size	= 4096;
+	p.align		= 0;
+	p.n_fat		= 1;
+	p.n_root	= 128;
+	return FR_OK == f_mkfs("0:", &p, work, sizeof(work));
+}
+
+// The pack of three messages and the font, see NLS/nls_pack.py
+static std::string buildPack(const std::string &font_data) {
+	std::string pool;
+	uint16_t offset[MSG_LAST];
+	memset(offset, 0xFF, sizeof(offset));
+	const struct { t_msg_id id; const char *text; } m[] = {
+		{MSG_ON, "ligado"}, {MSG_OFF, "desligado"}, {MSG_MENU_MAIN, "Menu principal"}
+	};
+	for (auto &e : m) {
+		offset[e.id] = pool.size();
+		pool.append(e.text, strlen(e.text) + 1);
+	}
+	t_nls_pack_header hdr;
+	memcpy(hdr.magic, "NLSP", 4);
+	hdr.version		= 1;
+	hdr.msg_num		= MSG_LAST;
+	hdr.keys_crc	= msg.keysCRC();
+	hdr.pool_size	= pool.size();
+	hdr.font_size	= font_data.size();
+	uint32_t crc	= crc32(0, offset, sizeof(offset));
+	crc				= crc32(crc, pool.data(), pool.size());
+	hdr.data_crc	= crc32(crc, font_data.data(), font_data.size());
+	std::string pack((const char *)&hdr, sizeof(hdr));
+	pack.append((const char *)offset, sizeof(offset));
+	return pack + pool + font_data;
+}
+
+// Compare every ASCII glyph read by FONT_CACHE with the font data. ASCII glyph record: encoding, record size, data
+static bool asciiGlyphs(FONT_CACHE *fc, uint16_t *checked) {
+	const uint8_t *f = (const uint8_t *)font.data();
+	uint32_t pos = 23;
+	*checked = 0;
+	while (pos + 2 <= font.size() && f[pos+1] != 0) {
+		const uint8_t *g = fc->glyph(f[pos]);
+		if (!g || memcmp(g, &f[pos+2], f[pos+1] - 2) != 0)
+			return false;
+		++*checked;
+		pos += f[pos+1];
+	}
+	return true;
+}
+
+static void testResident(void) {
+	nls.loadLanguageData("portuguese");
+	CHECK_EQ(nls.languageIndex(), 1);
+	CHECK(strcmp(msg.msg(MSG_ON), "ligado") == 0);
+	CHECK(strcmp(msg.msg(MSG_FAN), "Fan:") == 0);			// Not translated
+	CHECK(!nls.fontCache()->isOpen());
+	CHECK(nls.font() != 0 && memcmp(nls.font(), font.data(), font.size()) == 0);
+	nls.defaultNLS();
+	CHECK(strcmp(msg.msg(MSG_ON), "ON") == 0);
+	CHECK(nls.font() == 0);
+}
+
+// The memory is fragmented: the font block cannot be allocated, the font is read from the pack by FONT_CACHE
+static void testCached(void) {
+	EMU_HeapLimit(8192);
+	nls.loadLanguageData("portuguese");
+	CHECK_EQ(nls.languageIndex(), 1);
+	CHECK(strcmp(msg.msg(MSG_MENU_MAIN), "Menu principal") == 0);
+	CHECK(nls.fontCache()->isOpen());
+	CHECK(nls.font() == nls.fontCache()->font());
+	CHECK(ext_font == nls.font());							// The display reads the glyphs through the cache
+	CHECK(nls.font() && memcmp(nls.font(), font.data(), 23) == 0);	// The font header
+	uint16_t checked = 0;
+	CHECK(asciiGlyphs(nls.fontCache(), &checked));
+	CHECK(checked > 90);
+	CHECK(nls.fontCache()->glyph(0xFFFE) == 0);
+	nls.defaultNLS();
+	CHECK(!nls.fontCache()->isOpen());
+	CHECK(ext_font == 0);
+	EMU_HeapLimit(0);
+}
+
+// The last font byte is corrupted: the pack is rejected in both ways to load the font
+static void testCorrupted(void) {
+	std::string pack = buildPack(font);
+	pack[pack.size() - 1] ^= 0x55;
+	CHECK(writeFile("pt.nlp", pack));
+	for (uint32_t limit : {0, 8192}) {
+		EMU_HeapLimit(limit);
+		nls.loadLanguageData("portuguese");
+		CHECK_EQ(nls.languageIndex(), 0);
+		CHECK(strcmp(msg.msg(MSG_ON), "ON") == 0);
+		CHECK(!nls.fontCache()->isOpen());
+		CHECK(nls.font() == 0);
+	}
+	EMU_HeapLimit(0);
+}
+
+// The size of the messages in the arena including the terminating zeros
+static uint32_t arenaMessages(void) {
+	uint32_t size = 0;
+	for (uint8_t i = 0; i < MSG_LAST; ++i) {
+		const char *m = msg.msg((t_msg_id)i);
+		if (m >= msg.arenaData() && m < msg.arenaData() + 0x10000)
+			size += strlen(m) + 1;
+	}
+	return size;
+}
+
+static void testMessagesHeap(void) {
+	t_heap_emu_stat before, loaded, legacy, released;
+	EMU_HeapStat(&before);
+	EMU_HeapReset();
+	nls.loadLanguageData("russian");
+	EMU_HeapStat(&loaded);
+	CHECK_EQ(nls.languageIndex(), 2);
+	CHECK(strcmp(msg.msg(MSG_ON), "вкл") == 0);
+	CHECK(msg.str(MSG_ON) == msg.msg(MSG_ON));				// No copy
+	uint32_t arena = arenaMessages();
+	CHECK(arena > 0);
+	CHECK_EQ(loaded.blocks - before.blocks, 2);				// The arena and the font
+	CHECK_EQ(loaded.bytes - before.bytes, arena + cyr_font.size());	// The arena is trimmed to the messages
+	CHECK(loaded.peak - before.bytes <= arena + cyr_font.size() + 512);	// The arena is trimmed before the font is loaded
+	printf("  messages arena:      %4u bytes in 1 block, peak %u bytes, %u allocations to load the language\n",
+		arena, loaded.peak - before.bytes, loaded.allocs);
+
+	{														// One std::string per message
+		std::string copy[MSG_LAST];
+		EMU_HeapReset();
+		for (uint8_t i = 0; i < MSG_LAST; ++i)
+			copy[i] = msg.msg((t_msg_id)i);
+		EMU_HeapStat(&legacy);
+		printf("  std::string/message: %4u bytes in %u blocks\n", legacy.bytes - loaded.bytes, legacy.blocks - loaded.blocks);
+		CHECK(legacy.blocks - loaded.blocks > 1);
+	}
+	nls.defaultNLS();										// The messages are released in one operation
+	EMU_HeapStat(&released);
+	CHECK_EQ(released.blocks, before.blocks);
+	CHECK_EQ(released.bytes, before.bytes);
+	CHECK(strcmp(msg.msg(MSG_ON), "ON") == 0);
+}
+
+static std::string hex(uint32_t crc) {
+	char buff[9];
+	snprintf(buff, sizeof(buff), "%08X", crc);
+	return std::string(buff);
+}
+
+// The language configuration: russian messages with the cyrillic font and with the big font that is read by FONT_CACHE
+static bool langConfig(uint32_t msg_crc, uint32_t font_crc, uint32_t big_font_crc) {
+	std::string cfg = "{\"languages\": [{\"name\": \"portuguese\", \"pack\": \"pt.nlp\"},"
+		"{\"name\": \"russian\", \"messages\": \"ru_lang.json\", \"font\": \"ubuntu_cyr.font\", "
+		"\"messages_crc\": \"" + hex(msg_crc) + "\", \"font_crc\": \"" + hex(font_crc) + "\"},"
+		"{\"name\": \"big\", \"messages\": \"ru_lang.json\", \"font\": \"ubuntu_we.font\", "
+		"\"font_crc\": \"" + hex(big_font_crc) + "\"}]}";
+	if (!writeFile("cfg.json", cfg))
+		return false;
+	nls.defaultNLS();
+	nls.init(&msg);
+	return nls.numLanguages() == 4;
+}
+
+static void checkRejected(const char *lang) {
+	nls.loadLanguageData(lang);
+	CHECK_EQ(nls.languageIndex(), 0);
+	CHECK(strcmp(msg.msg(MSG_ON), "ON") == 0);
+	CHECK(nls.font() == 0);
+	CHECK(!nls.fontCache()->isOpen());
+}
+
+static void testFileCRC(void) {
+	uint32_t msg_crc	= crc32(0, ru_msg.data(), ru_msg.size());
+	uint32_t font_crc	= crc32(0, cyr_font.data(), cyr_font.size());
+	uint32_t big_crc	= crc32(0, font.data(), font.size());
+	CHECK(writeFile("ubuntu_we.font", font));
+	CHECK(langConfig(msg_crc ^ 1, font_crc, big_crc));		// Wrong messages CRC
+	checkRejected("russian");
+	CHECK(langConfig(msg_crc, font_crc ^ 1, big_crc));		// Wrong font CRC, the font fits the memory
+	checkRejected("russian");
+	EMU_HeapLimit(8192);									// The big font is read by FONT_CACHE
+	CHECK(langConfig(msg_crc, font_crc, big_crc ^ 1));
+	checkRejected("big");
+	CHECK(langConfig(msg_crc, font_crc, big_crc));
+	nls.loadLanguageData("big");
+	CHECK_EQ(nls.languageIndex(), 3);
+	CHECK(nls.fontCache()->isOpen());
+	EMU_HeapLimit(0);
+	nls.loadLanguageData("russian");
+	CHECK_EQ(nls.languageIndex(), 2);
+	CHECK(strcmp(msg.msg(MSG_ON), "вкл") == 0);
+	CHECK(nls.font() != 0 && memcmp(nls.font(), cyr_font.data(), cyr_font.size()) == 0);
+	nls.defaultNLS();
+}
+
+int main(void) {
+	CHECK(readHostFile(FONT_FILE, font));
+	CHECK(readHostFile(CYR_FONT_FILE, cyr_font));
+	CHECK(readHostFile(RU_MSG_FILE, ru_msg));
+	CHECK(font.size() > 3 * 4096);							// The font takes several flash sectors
+	CHECK(EMU_W25Q_Init(512));								// 2 MB flash
+	CHECK(format());
+	CHECK(writeFile("cfg.json", "{\"languages\": [{\"name\": \"portuguese\", \"pack\": \"pt.nlp\"},"
+		"{\"name\": \"russian\", \"messages\": \"ru_lang.json\", \"font\": \"ubuntu_cyr.font\"}]}"));
+	CHECK(writeFile("pt.nlp", buildPack(font)));
+	CHECK(writeFile("ru_lang.json", ru_msg));
+	CHECK(writeFile("ubuntu_cyr.font", cyr_font));
+	nls.init(&msg);
+	CHECK_EQ(nls.numLanguages(), 3);						// English, portuguese and russian
+	testMessagesHeap();
+	testResident();
+	testCached();
+	testCorrupted();
+	testFileCRC();
+	EMU_W25Q_Free();
+	return testResult("nls");
+}
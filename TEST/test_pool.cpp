@@ -0,0 +1,108 @@
+/*
+ * test_pool.cpp
+ *
+ *  Created on: 2026 OCT 18
+ *
+ *  The display memory pool: the smallest free class is used, the exhausted pool and the oversized requests
+ *  are refused and counted, the heap is never used, the released blocks are reused.
+ *  The small requests never take the largest block, it is kept for the PID graph pixmap.
+ */
+
+#include <stdint.h>
+#include "pool.h"
+#include "test.h"
+
+static t_pool_stat classStat(uint8_t cls) {
+	t_pool_stat st = {0};
+	TFT_PoolStat(cls, &st);
+	return st;
+}
+
+// The largest block serves the PID graph pixmap: 228 x 177 pixels, 2 bits per pixel, 4-color palette
+static void testLargest(void) {
+	uint32_t pid_graph = 7 + 4*2 + 177 * ((228*2+7) >> 3);
+	CHECK(pid_graph <= TFT_POOL_MAX_BLOCK);
+	void *p = TFT_PoolAlloc(pid_graph);
+	CHECK(p != 0);
+	CHECK_EQ(classStat(TFT_POOL_CLASSES-1).used, 1);
+	CHECK(TFT_PoolAlloc(pid_graph) == 0);					// Single block only
+	CHECK_EQ(TFT_PoolFailures(), 1);
+	TFT_PoolFree(p);
+	CHECK_EQ(classStat(TFT_POOL_CLASSES-1).used, 0);
+
+	CHECK(TFT_PoolAlloc(TFT_POOL_MAX_BLOCK+1) == 0);		// No heap fallback
+	CHECK_EQ(TFT_PoolOversized(), 1);
+	CHECK_EQ(TFT_PoolFailures(), 1);
+}
+
+// Exhaust the smallest class: the requests go to the bigger classes except the largest one, then refused
+static void testExhaust(void) {
+	uint32_t total = 0;
+	for (uint8_t c = 0; c < TFT_POOL_CLASSES-1; ++c)
+		total += classStat(c).blocks;
+	void *p[64];
+	uint32_t n = 0;
+	while (n < 64) {
+		void *b = TFT_PoolAlloc(10);
+		if (!b) break;
+		p[n++] = b;
+	}
+	CHECK_EQ(n, total);
+	CHECK_EQ(TFT_PoolFailures(), 2);
+	for (uint8_t c = 0; c < TFT_POOL_CLASSES-1; ++c) {
+		t_pool_stat st = classStat(c);
+		CHECK_EQ(st.used, st.blocks);
+		CHECK_EQ(st.peak, st.blocks);
+	}
+	CHECK_EQ(classStat(TFT_POOL_CLASSES-1).used, 0);		// The largest block is not taken by small request
+	CHECK(TFT_PoolAlloc(classStat(TFT_POOL_CLASSES-2).size) == 0);
+	CHECK_EQ(TFT_PoolFailures(), 3);
+	void *pid = TFT_PoolAlloc(classStat(TFT_POOL_CLASSES-2).size + 1);	// The PID graph still gets its block
+	CHECK(pid != 0);
+	CHECK_EQ(classStat(TFT_POOL_CLASSES-1).used, 1);
+	TFT_PoolFree(pid);
+	for (uint32_t i = 0; i < n; ++i)
+		TFT_PoolFree(p[i]);
+	for (uint8_t c = 0; c < TFT_POOL_CLASSES; ++c)
+		CHECK_EQ(classStat(c).used, 0);
+
+	void *b = TFT_PoolAlloc(10);							// The smallest class is free again
+	CHECK_EQ(classStat(0).used, 1);
+	TFT_PoolFree(b);
+}
+
+// The request takes the smallest class the data fits
+static void testClass(void) {
+	// The arena size stated in pool.h
+	uint32_t arena = 0;
+	for (uint8_t c = 0; c < TFT_POOL_CLASSES; ++c)
+		arena += (uint32_t)classStat(c).size * classStat(c).blocks;
+	CHECK_EQ(arena, 19200);
+
+	uint16_t prev = 0;
+	for (uint8_t c = 0; c < TFT_POOL_CLASSES; ++c) {
+		t_pool_stat st = classStat(c);
+		CHECK(st.size > prev);
+		void *p = TFT_PoolCalloc(st.size);
+		CHECK(p != 0);
+		CHECK_EQ(classStat(c).used, 1);
+		TFT_PoolFree(p);
+		if (c > 0) {
+			p = TFT_PoolAlloc(prev+1);
+			CHECK_EQ(classStat(c).used, 1);
+			TFT_PoolFree(p);
+		}
+		prev = st.size;
+	}
+	int local = 0;
+	TFT_PoolFree(&local);									// Not a pool block, ignored
+	TFT_PoolFree(0);
+	CHECK(!TFT_PoolStat(TFT_POOL_CLASSES, 0));
+}
+
+int main(void) {
+	testLargest();
+	testExhaust();
+	testClass();
+	return testResult("pool");
+}
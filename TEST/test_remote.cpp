@@ -0,0 +1,323 @@
+/*
+ * test_remote.cpp
+ *
+ *  Created on: 2026 OCT 18
+ *
+ *  The remote control protocol: every command gets the reply, the broken frames are dropped and counted,
+ *  the state change events are sent once. The serial port on the emulated USART1: the transmit ring is sent
+ *  by DMA blocks, the received data survive the DMA buffer wrap, and when the main loop is late the lost data
+ *  is reported at its place, so the command around the gap is dropped instead of joined with the next one.
+ */
+
+#include <string.h>
+#include "remote.h"
+#include "serial.h"
+#include "emu.h"
+#include "test.h"
+
+class FAKE_RC : public REMOTE_HANDLER {
+	public:
+		virtual uint8_t	execute(const t_rc_request &req) {
+			++executed;
+			last = req;
+			if (req.cmd == RC_SET_TEMP) {
+				if (req.value > 450) return RC_BAD_ARG;
+				preset = req.value;
+			}
+			return RC_OK;
+		}
+		virtual void	state(uint8_t dev, t_rc_state &st) {
+			memset(&st, 0xAA, sizeof(st));					// The REMOTE should fill the errors field itself
+			st.dev		= dev;
+			st.mode		= 1;
+			st.flags	= RC_WORKING;
+			st.tip		= 3;
+			st.temp		= 250 + temp_noise++;				// Not a state change
+			st.preset	= (dev == 0)?preset:200;
+			st.fan		= 1000;
+			st.power	= 10;
+		}
+		uint32_t		executed	= 0;
+		t_rc_request	last;
+		uint16_t		preset		= 300;
+		uint16_t		temp_noise	= 0;
+};
+
+// The bytes the station sent
+static uint8_t	out_buff[4096];
+static uint16_t	out_len = 0;
+
+static bool outWrite(const uint8_t *data, uint16_t len) {
+	memcpy(&out_buff[out_len], data, len);
+	out_len += len;
+	return true;
+}
+
+typedef struct {
+	uint8_t	type, seq;
+	int16_t	len;
+	uint8_t	payload[FRAME_MAX_PAYLOAD];
+} t_rx_frame;
+
+// Split the sent bytes into frames, returns the number of frames
+static uint16_t takeFrames(const uint8_t *data, uint16_t len, t_rx_frame *f, uint16_t max) {
+	uint16_t n = 0, start = 0;
+	for (uint16_t i = 0; i < len && n < max; ++i) {
+		if (data[i] == 0) {
+			f[n].len = FRAME_Unpack(&data[start], i - start, &f[n].type, &f[n].seq, f[n].payload);
+			++n;
+			start = i + 1;
+		}
+	}
+	return n;
+}
+
+static uint16_t command(uint8_t cmd, uint8_t dev, uint16_t value, uint8_t seq, uint8_t *frame) {
+	t_rc_request req;
+	req.cmd		= cmd;
+	req.dev		= dev;
+	req.value	= value;
+	return FRAME_Pack(FRAME_COMMAND, seq, &req, sizeof(req), frame);
+}
+
+// The command as TLOG/remote.py sends it: with the leading delimiter
+static uint16_t hostCommand(uint8_t cmd, uint8_t dev, uint16_t value, uint8_t seq, uint8_t *frame) {
+	frame[0] = 0;
+	return command(cmd, dev, value, seq, &frame[1]) + 1;
+}
+
+static t_rc_reply reply(const t_rx_frame &f) {
+	t_rc_reply r;
+	memcpy(&r, f.payload, sizeof(r));
+	return r;
+}
+
+static void testCommands(void) {
+	static REMOTE	rc;
+	FAKE_RC			h;
+	t_rx_frame		f[8];
+	uint8_t			frame[FRAME_MAX_SIZE];
+	rc.init(&h, outWrite);
+
+	uint16_t n = command(RC_PING, 1, 0, 17, frame);
+	out_len = 0;
+	rc.receive(frame, n);
+	CHECK_EQ(takeFrames(out_buff, out_len, f, 8), 1);
+	CHECK_EQ(f[0].type, FRAME_REPLY);
+	CHECK_EQ(f[0].seq, 17);
+	CHECK_EQ(f[0].len, sizeof(t_rc_reply));
+	CHECK_EQ(reply(f[0]).status, RC_OK);
+	CHECK_EQ(reply(f[0]).state.dev, 1);
+	CHECK_EQ(reply(f[0]).state.errors, 0);
+	CHECK_EQ(h.executed, 0);								// Ping does not reach the handler
+
+	n = command(RC_SET_TEMP, 0, 320, 18, frame);
+	out_len = 0;
+	for (uint16_t i = 0; i < n; ++i)						// Byte by byte
+		rc.receive(&frame[i], 1);
+	CHECK_EQ(takeFrames(out_buff, out_len, f, 8), 1);
+	CHECK_EQ(reply(f[0]).status, RC_OK);
+	CHECK_EQ(reply(f[0]).state.preset, 320);
+	CHECK_EQ(h.last.value, 320);
+
+	out_len = 0;											// Wrong requests
+	n = command(RC_SET_TEMP, 0, 999, 19, frame);	rc.receive(frame, n);
+	n = command(RC_LAST, 0, 0, 20, frame);			rc.receive(frame, n);
+	n = command(RC_SET_TEMP, 2, 300, 21, frame);	rc.receive(frame, n);
+	uint8_t shrt = RC_PING;
+	n = FRAME_Pack(FRAME_COMMAND, 22, &shrt, 1, frame);	rc.receive(frame, n);
+	CHECK_EQ(takeFrames(out_buff, out_len, f, 8), 4);
+	CHECK_EQ(reply(f[0]).status, RC_BAD_ARG);
+	CHECK_EQ(reply(f[1]).status, RC_BAD_CMD);
+	CHECK_EQ(reply(f[2]).status, RC_BAD_DEV);
+	CHECK_EQ(reply(f[3]).status, RC_BAD_CMD);
+	CHECK_EQ(f[3].seq, 22);
+	CHECK_EQ(h.executed, 2);
+	CHECK_EQ(rc.errors(), 0);
+
+	// The broken frames are dropped without reply, the count is in the next reply
+	out_len = 0;
+	n = command(RC_SET_TEMP, 0, 200, 23, frame);
+	frame[3] ^= 0x10;
+	rc.receive(frame, n);									// Corrupted
+	uint8_t junk[FRAME_MAX_SIZE + 10];
+	memset(junk, 0x55, sizeof(junk));
+	rc.receive(junk, sizeof(junk));							// Too long
+	uint8_t zero = 0;
+	rc.receive(&zero, 1);
+	n = command(RC_SET_TEMP, 0, 210, 24, frame);
+	rc.receive(frame, 5);
+	rc.lost();												// The transport lost the data here
+	rc.receive(&frame[5], n - 5);							// The rest of the frame is not joined with anything
+	CHECK_EQ(out_len, 0);
+	CHECK_EQ(h.executed, 2);
+	CHECK_EQ(rc.errors(), 3);
+	n = command(RC_QUERY, 0, 0, 25, frame);
+	rc.receive(frame, n);
+	CHECK_EQ(takeFrames(out_buff, out_len, f, 8), 1);
+	CHECK_EQ(f[0].seq, 25);
+	CHECK_EQ(reply(f[0]).state.errors, 3);
+	CHECK_EQ(reply(f[0]).state.preset, 320);
+
+	rc.lost();												// The data lost between the frames
+	n = command(RC_QUERY, 0, 0, 26, frame);
+	out_len = 0;
+	rc.receive(frame, n);									// The frame after the gap is dropped till its delimiter
+	CHECK_EQ(out_len, 0);
+	CHECK_EQ(rc.errors(), 4);
+	rc.lost();
+	rc.receive(&zero, 1);									// The host starts the command with the delimiter
+	rc.receive(frame, n);
+	CHECK_EQ(takeFrames(out_buff, out_len, f, 8), 1);
+	CHECK_EQ(f[0].seq, 26);
+	CHECK_EQ(rc.errors(), 5);
+}
+
+static void testEvents(void) {
+	static REMOTE	rc;
+	FAKE_RC			h;
+	t_rx_frame		f[8];
+	rc.init(&h, outWrite);
+	out_len = 0;
+	rc.poll();												// Initial state of both devices
+	CHECK_EQ(takeFrames(out_buff, out_len, f, 8), 2);
+	CHECK_EQ(f[0].type, FRAME_EVENT);
+	CHECK_EQ(f[1].seq, f[0].seq + 1);
+	out_len = 0;
+	rc.poll();												// The temperature changed only
+	CHECK_EQ(out_len, 0);
+	h.preset = 350;
+	rc.poll();
+	CHECK_EQ(takeFrames(out_buff, out_len, f, 8), 1);
+	t_rc_state st;
+	memcpy(&st, f[0].payload, sizeof(st));
+	CHECK_EQ(st.dev, 0);
+	CHECK_EQ(st.preset, 350);
+	CHECK_EQ(st.errors, 0);
+}
+
+static SERIAL	port;
+static REMOTE	station;
+
+static bool serialWrite(const uint8_t *data, uint16_t len) {
+	return port.write(data, len);
+}
+
+// The remote control task of the main loop, see remoteControl() in core.cpp
+static void remoteControl(void) {
+	uint8_t data[32];
+	for (;;) {
+		uint16_t n = port.read(data, sizeof(data));
+		if (n > 0)
+			station.receive(data, n);
+		else if (port.lost())
+			station.lost();
+		else
+			break;
+	}
+}
+
+// Complete all DMA transmissions and take the frames sent
+static uint16_t serialFrames(t_rx_frame *f, uint16_t max) {
+	while (EMU_UartTxDone()) ;
+	uint8_t buff[4096];
+	uint16_t len = EMU_UartSent(buff, sizeof(buff));
+	return takeFrames(buff, len, f, max);
+}
+
+static void testSerialTx(void) {
+	uint8_t data[1100], sent[2048];
+	for (uint16_t i = 0; i < sizeof(data); ++i)
+		data[i] = i * 7;
+	port.init();
+	CHECK(port.write(data, 100));
+	CHECK(port.write(&data[100], 800));						// Queued behind the transmission in progress
+	CHECK(!port.write(data, 200));							// No room
+	CHECK_EQ(port.dropped(), 200);
+	uint16_t blocks = 0;
+	while (EMU_UartTxDone()) ++blocks;
+	CHECK_EQ(blocks, 2);
+	CHECK(port.write(&data[900], 150));						// Wraps around the ring end: two DMA blocks
+	while (EMU_UartTxDone()) ++blocks;
+	CHECK_EQ(blocks, 4);
+	CHECK_EQ(EMU_UartSent(sent, sizeof(sent)), 1050);
+	CHECK(memcmp(sent, data, 1050) == 0);
+}
+
+static void testSerialRx(void) {
+	uint8_t data[600], got[600];
+	for (uint16_t i = 0; i < sizeof(data); ++i)
+		data[i] = i + 1;
+	port.init();
+	EMU_UartReceive(data, 5, true);							// Short packet, the idle line delivers it
+	CHECK_EQ(port.read(got, sizeof(got)), 5);
+	CHECK(memcmp(got, data, 5) == 0);
+	EMU_UartReceive(&data[5], 200, true);					// Several DMA buffer wraps
+	CHECK_EQ(port.read(got, sizeof(got)), 200);
+	CHECK(memcmp(got, &data[5], 200) == 0);
+	CHECK(!port.lost());
+
+	EMU_UartReceive(data, 600, true);						// The main loop is late: the ring keeps 511 bytes
+	uint16_t n = 0, r;
+	while ((r = port.read(&got[n], 100)) > 0) n += r;
+	CHECK_EQ(n, 511);
+	CHECK(memcmp(got, data, 511) == 0);
+	CHECK_EQ(port.overruns(), 89);
+	CHECK(port.lost());										// Once, at the place the data were lost
+	CHECK(!port.lost());
+	EMU_UartReceive(&data[10], 10, true);					// The new data after the gap
+	CHECK_EQ(port.read(got, sizeof(got)), 10);
+	CHECK(memcmp(got, &data[10], 10) == 0);
+
+	port.init();											// DMA buffer from the start
+	EMU_UartReceive(data, 40, false);						// Framing error: the data not moved from DMA buffer are lost
+	EMU_UartError();
+	CHECK_EQ(port.rxErrors(), 1);
+	CHECK_EQ(port.read(got, sizeof(got)), 32);				// Moved by the half transfer interrupt
+	CHECK(port.lost());
+	EMU_UartReceive(data, 3, true);							// The reception is restarted
+	CHECK_EQ(port.read(got, sizeof(got)), 3);
+}
+
+// The host sends the commands without waiting for the replies while the main loop is busy
+static void testSerialRemote(void) {
+	static FAKE_RC	h;
+	t_rx_frame		f[64];
+	uint8_t			frame[FRAME_MAX_SIZE+1];
+	port.init();
+	station.init(&h, serialWrite);
+
+	uint16_t sent = 0;
+	for (uint8_t seq = 0; seq < 60; ++seq) {
+		uint16_t n = hostCommand(RC_SET_TEMP, 0, 300 + seq, seq, frame);
+		EMU_UartReceive(frame, n, true);
+		sent += n;
+	}
+	CHECK(sent > 512);										// More than the receive ring
+	remoteControl();
+	uint16_t replies = serialFrames(f, 64);
+	CHECK(replies > 30 && replies < 60);
+	for (uint16_t i = 0; i < replies; ++i) {
+		CHECK_EQ(f[i].seq, i);								// The commands before the gap in order
+		CHECK_EQ(reply(f[i]).status, RC_OK);
+	}
+	CHECK_EQ(h.executed, replies);
+	CHECK_EQ(h.preset, 300 + replies - 1);					// No command was made of two
+	CHECK_EQ(station.errors(), 1);							// The command broken by the gap
+
+	uint16_t n = hostCommand(RC_QUERY, 0, 0, 100, frame);	// The host asks again
+	EMU_UartReceive(frame, n, true);
+	remoteControl();
+	CHECK_EQ(serialFrames(f, 64), 1);
+	CHECK_EQ(f[0].seq, 100);
+	CHECK_EQ(reply(f[0]).state.errors, 1);
+}
+
+int main(void) {
+	testCommands();
+	testEvents();
+	testSerialTx();
+	testSerialRx();
+	testSerialRemote();
+	return testResult("remote");
+}
@@ -0,0 +1,173 @@
+/*
+ * test_sdload.cpp
+ *
+ *  Created on: 2026 OCT 18
+ *      Author: Alex
+ *
+ *  SDLOAD copies the language files from the emulated SD-CARD to the emulated W25Qxx flash through FatFS.
+ *  Checks the copied content, the unchanged files are not rewritten, the changed file is updated,
+ *  the incomplete language is skipped and the flash is programmed by NOR flash rules only.
+ *  SDLOAD::saveLogs() copies the finished telemetry session files back to the SD-CARD.
+ */
+
+#include <string.h>
+#include "sdload.h"
+#include "emu.h"
+#include "test.h"
+
+static FATFS	sdfs, flashfs;
+static uint8_t	work[4096];
+
+class PROGRESS : public SDLOAD_PROGRESS {
+	public:
+		virtual void	copyProgress(const char *name, uint8_t percent) { ++calls; last = percent; }
+		uint32_t		calls	= 0;
+		uint8_t			last	= 0;
+};
+
+static bool format(void) {
+	MKFS_PARM p;
+	p.fmt		= FM_FAT | FM_SFD;								// The same parameters as in W25Qxx.h
+	p.au_size	= 4096;
+	p.align		= 0;
+	p.n_fat		= 1;
+	p.n_root	= 128;
+	if (FR_OK != f_mkfs("0:", &p, work, sizeof(work)))
+		return false;
+	p.fmt		= FM_ANY | FM_SFD;
+	p.au_size	= 0;
+	p.n_fat		= 2;
+	p.n_root	= 0;
+	return FR_OK == f_mkfs("1:", &p, work, sizeof(work));
+}
+
+// The path starts with the drive: "0:" is the flash, "1:" is the SD-CARD
+static bool writeFile(const char *path, const void *data, UINT size) {
+	FIL f;
+	UINT bw = 0;
+	char drive[3] = { path[0], ':', 0 };
+	if (FR_OK != f_mount((path[0] == '1')?&sdfs:&flashfs, drive, 1) || FR_OK != f_open(&f, path, FA_CREATE_ALWAYS | FA_WRITE))
+		return false;
+	f_write(&f, data, size, &bw);
+	f_close(&f);
+	f_mount(NULL, drive, 0);
+	return bw == size;
+}
+
+static bool sameFile(const char *name, const uint8_t *data, UINT size, const char *drive = "0:") {
+	FIL f;
+	UINT br = 0;
+	std::string path = std::string(drive) + name;
+	uint8_t *buff = (uint8_t *)malloc(size + 1);
+	bool ok = buff && FR_OK == f_mount((drive[0] == '1')?&sdfs:&flashfs, drive, 1) && FR_OK == f_open(&f, path.c_str(), FA_READ);
+	if (ok) {
+		f_read(&f, buff, size + 1, &br);
+		f_close(&f);
+		ok = (br == size) && memcmp(buff, data, size) == 0;
+	}
+	f_mount(NULL, drive, 0);
+	free(buff);
+	return ok;
+}
+
+static bool exists(const char *name, const char *drive = "0:") {
+	FILINFO fno;
+	std::string path = std::string(drive) + name;
+	bool ok = FR_OK == f_mount((drive[0] == '1')?&sdfs:&flashfs, drive, 1) && FR_OK == f_stat(path.c_str(), &fno);
+	f_mount(NULL, drive, 0);
+	return ok;
+}
+
+static void fill(uint8_t *data, uint32_t size, uint32_t seed) {
+	for (uint32_t i = 0; i < size; ++i) {
+		seed = seed * 1103515245 + 12345;
+		data[i] = seed >> 16;
+	}
+}
+
+int main(void) {
+	static uint8_t ru_msg[3000], ru_font[10000], de_pack[6000];
+	const char *cfg = "{\"languages\": [\n"
+			"{\"name\": \"russian\", \"messages\": \"ru.json\", \"font\": \"ru.font\"},\n"
+			"{\"name\": \"german\", \"pack\": \"de.nlp\"},\n"
+			"{\"name\": \"french\", \"messages\": \"fr.json\", \"font\": \"fr.font\"}\n"
+			"]}\n";
+	fill(ru_msg,  sizeof(ru_msg),  1);
+	fill(ru_font, sizeof(ru_font), 2);
+	fill(de_pack, sizeof(de_pack), 3);
+
+	CHECK(EMU_W25Q_Init(512));										// 2 MB flash
+	CHECK(EMU_SD_Init(8192));										// 4 MB SD-CARD
+	CHECK(format());
+	CHECK(writeFile("1:cfg.json", cfg, strlen(cfg)));
+	CHECK(writeFile("1:ru.json", ru_msg, sizeof(ru_msg)));
+	CHECK(writeFile("1:ru.font", ru_font, sizeof(ru_font)));
+	CHECK(writeFile("1:de.nlp", de_pack, sizeof(de_pack)));
+	CHECK(writeFile("1:fr.json", ru_msg, 100));					// French font is missing
+
+	// First copy: all files of complete languages are copied
+	SDLOAD		loader;
+	PROGRESS	progress;
+	CHECK_EQ(loader.load(&progress), MSG_LAST);
+	CHECK(sameFile("ru.json", ru_msg, sizeof(ru_msg)));
+	CHECK(sameFile("ru.font", ru_font, sizeof(ru_font)));
+	CHECK(sameFile("de.nlp", de_pack, sizeof(de_pack)));
+	CHECK(sameFile("cfg.json", (const uint8_t *)cfg, strlen(cfg)));
+	CHECK(!exists("fr.json"));										// Incomplete language is not copied
+	CHECK(progress.calls > 0);
+	CHECK_EQ(progress.last, 100);
+
+	// Second copy: nothing changed, nothing written
+	t_w25q_emu_stat before, after;
+	EMU_W25Q_Stat(&before);
+	CHECK_EQ(loader.load(), MSG_LAST);
+	EMU_W25Q_Stat(&after);
+	CHECK_EQ(after.pages, before.pages);
+	CHECK_EQ(after.erases, before.erases);
+
+	// The font changed, the size is the same. Only the font is rewritten
+	ru_font[5000] ^= 0x5A;
+	CHECK(writeFile("1:ru.font", ru_font, sizeof(ru_font)));
+	EMU_W25Q_Stat(&before);
+	CHECK_EQ(loader.load(), MSG_LAST);
+	EMU_W25Q_Stat(&after);
+	CHECK(sameFile("ru.font", ru_font, sizeof(ru_font)));
+	CHECK(sameFile("ru.json", ru_msg, sizeof(ru_msg)));
+	uint32_t font_pages = (sizeof(ru_font) + 4095) / 4096 * 16;	// The file data is written by whole 4k sectors
+	CHECK(after.pages - before.pages >= font_pages);
+	CHECK(after.pages - before.pages < font_pages + 6*16);		// Plus FAT and directory sector updates only
+	CHECK_EQ(after.program_errors, 0);
+
+	// No complete language on the SD-CARD
+	const char *bad_cfg = "{\"languages\": [{\"name\": \"french\", \"messages\": \"fr.json\", \"font\": \"fr.font\"}]}";
+	CHECK(writeFile("1:cfg.json", bad_cfg, strlen(bad_cfg)));
+	CHECK_EQ(loader.load(), MSG_SD_INCONSISTENT);
+
+	// The session logs are saved to the SD-CARD, the active session and other files are skipped
+	static uint8_t log0[9000], log1[5000];
+	fill(log0, sizeof(log0), 4);
+	fill(log1, sizeof(log1), 5);
+	CHECK(writeFile("0:tlog00.bin", log0, sizeof(log0)));
+	CHECK(writeFile("0:tlog01.bin", log1, sizeof(log1)));
+	CHECK(writeFile("0:tlog.bin",   log1, 100));
+	uint8_t saved = 0;
+	CHECK_EQ(loader.saveLogs("tlog01.bin", &saved, &progress), MSG_LAST);
+	CHECK_EQ(saved, 1);
+	CHECK(sameFile("tlog00.bin", log0, sizeof(log0), "1:"));
+	CHECK(!exists("tlog01.bin", "1:"));
+	CHECK(!exists("tlog.bin", "1:"));
+	CHECK_EQ(loader.saveLogs(0, &saved), MSG_LAST);					// No active session
+	CHECK_EQ(saved, 2);
+	CHECK(sameFile("tlog01.bin", log1, sizeof(log1), "1:"));
+	CHECK(sameFile("tlog00.bin", log0, sizeof(log0), "0:"));		// The source files are kept
+	CHECK_EQ(loader.load(), MSG_SD_INCONSISTENT);					// The copy buffer is released between the calls
+
+	// No SD-CARD
+	EMU_SD_Free();
+	CHECK_EQ(loader.load(), MSG_SD_MOUNT);
+	CHECK_EQ(loader.saveLogs(0, &saved), MSG_SD_MOUNT);
+	CHECK_EQ(saved, 0);
+
+	EMU_W25Q_Free();
+	return testResult("sdload");
+}
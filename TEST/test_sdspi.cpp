@@ -0,0 +1,110 @@
+/*
+ * test_sdspi.cpp
+ *
+ *  Created on: 2026 OCT 18
+ *
+ *  The original sdspi.c driver on the emulated SD-CARD in SPI mode. The card is initialized, the blocks are written
+ *  and read back by blocking transfers and by DMA. The data token wait and the DMA transfer are limited in time:
+ *  the card that never sends the data token and the stalled DMA transfer return the error.
+ */
+
+#include <string.h>
+#include "sdspi.h"
+#include "emu.h"
+#include "test.h"
+
+static SDCARD			sd;
+static DMA_HandleTypeDef	dma_rx, dma_tx;
+static uint8_t			wr[4 * 512];
+static uint8_t			rd[4 * 512];
+
+static void testInit(void) {
+	hspi2.Init.BaudRatePrescaler = SPI_BAUDRATEPRESCALER_2;
+	CHECK_EQ(SD_Init(&sd), 0);
+	CHECK_EQ(sd.type, TYPE_SDHC);
+	CHECK_EQ(sd.blocks, 2048);
+	CHECK_EQ(sd.erase_size, 512);
+	CHECK_EQ(hspi2.Init.BaudRatePrescaler, SPI_BAUDRATEPRESCALER_2);	// The high speed is restored
+}
+
+// Single and multiple block write and read. Returns the DMA transfers
+static uint32_t readWrite(uint8_t seed) {
+	t_spi_sd_stat before, after;
+	EMU_SpiSdStat(&before);
+	for (uint16_t i = 0; i < sizeof(wr); ++i)
+		wr[i] = (uint8_t)(i * 7 + seed);
+	CHECK_EQ(SD_Write(&sd, 10, 1, wr), 0);
+	CHECK_EQ(SD_Write(&sd, 20, 4, wr), 0);
+	CHECK(memcmp(&EMU_SpiSdImage()[10 * 512], wr, 512) == 0);
+	CHECK(memcmp(&EMU_SpiSdImage()[20 * 512], wr, sizeof(wr)) == 0);
+	memset(rd, 0, sizeof(rd));
+	CHECK_EQ(SD_Read(&sd, 10, 1, rd), 0);
+	CHECK(memcmp(rd, wr, 512) == 0);
+	memset(rd, 0, sizeof(rd));
+	CHECK_EQ(SD_Read(&sd, 20, 4, rd), 0);
+	CHECK(memcmp(rd, wr, sizeof(wr)) == 0);
+	EMU_SpiSdStat(&after);
+	CHECK_EQ(after.writes - before.writes, 5);
+	return after.dma - before.dma;
+}
+
+static void testBlocking(void) {
+	hspi2.hdmarx = 0;
+	hspi2.hdmatx = 0;
+	CHECK_EQ(readWrite(1), 0);
+}
+
+// Every block payload is one DMA transfer: 5 blocks written, 5 blocks read
+static void testDMA(void) {
+	hspi2.hdmarx = &dma_rx;
+	hspi2.hdmatx = &dma_tx;
+	CHECK_EQ(readWrite(2), 10);
+	EMU_SpiSdTokenDelay(2000);								// The card is ready in about 2 ms
+	CHECK_EQ(readWrite(3), 10);
+	EMU_SpiSdTokenDelay(0);
+}
+
+static void testTokenTimeout(void) {
+	EMU_SpiSdTokenDelay(0xFFFFFFFF);
+	uint32_t start = HAL_GetTick();
+	CHECK(SD_Read(&sd, 10, 1, rd) != 0);
+	uint32_t elapsed = HAL_GetTick() - start;
+	CHECK(elapsed > SD_TOKEN_TIMEOUT && elapsed < SD_TOKEN_TIMEOUT + 10);
+	start = HAL_GetTick();
+	CHECK(SD_Read(&sd, 20, 4, rd) != 0);
+	elapsed = HAL_GetTick() - start;
+	CHECK(elapsed > SD_TOKEN_TIMEOUT && elapsed < SD_TOKEN_TIMEOUT + 10);
+	CHECK(SD_Init(&sd) != 0);								// CSD is not read
+	CHECK_EQ(sd.type, TYPE_NOT_READY);
+	EMU_SpiSdTokenDelay(0);
+	CHECK_EQ(SD_Init(&sd), 0);								// The card works again
+	CHECK_EQ(SD_Read(&sd, 10, 1, rd), 0);
+}
+
+static void testDmaStall(void) {
+	t_spi_sd_stat st;
+	EMU_SpiSdDmaStall(true);
+	uint32_t start = HAL_GetTick();
+	CHECK(SD_Read(&sd, 10, 1, rd) != 0);
+	uint32_t elapsed = HAL_GetTick() - start;
+	CHECK(elapsed > SD_DMA_TIMEOUT && elapsed < SD_DMA_TIMEOUT + 10);
+	CHECK(SD_Write(&sd, 10, 1, wr) != 0);
+	EMU_SpiSdStat(&st);
+	CHECK_EQ(st.aborts, 2);
+	CHECK(EMU_SpiSdInit(2048));								// The card waits for the rest of the data block, power it off
+	hspi2.hdmarx = &dma_rx;
+	hspi2.hdmatx = &dma_tx;
+	CHECK_EQ(SD_Init(&sd), 0);
+	CHECK_EQ(readWrite(4), 10);
+}
+
+int main(void) {
+	CHECK(EMU_SpiSdInit(2048));								// 1 MB card
+	testInit();
+	testBlocking();
+	testDMA();
+	testTokenTimeout();
+	testDmaStall();
+	EMU_SpiSdFree();
+	return testResult("sdspi");
+}
@@ -0,0 +1,210 @@
+/*
+ * test_tlog.cpp
+ *
+ *  Created on: 2026 OCT 18
+ *
+ *  TLOG session on the emulated W25Qxx flash. The records are pushed as the interrupt handlers do and drained.
+ *  Checks the file content, the data sectors are erased ahead of time and programmed once, no sector erase is waited for
+ *  while the records are drained, the session survives the flash drive unmount made by the configuration code,
+ *  the lost records are flagged and counted, the session stops when its file is removed or its reserved space is full.
+ */
+
+#include <string.h>
+#include "tlog.h"
+#include "emu.h"
+#include "test.h"
+
+static FATFS	fs;
+static uint8_t	work[4096];
+static W25Q		drive;
+static uint32_t	sink_calls	= 0;
+
+// The host replacement of the flash drive mount, the only W25Q method TLOG uses, see flash.cpp
+bool W25Q::mount(void) {
+	if (fs.fs_type) return true;
+	return FR_OK == f_mount(&fs, "0:", 1);
+}
+
+static void sink(const t_tlog_rec &rec) {
+	++sink_calls;
+}
+
+static bool format(void) {
+	MKFS_PARM p;
+	p.fmt		= FM_FAT | FM_SFD;								// The same parameters as in W25Qxx.h
+	p.au_size	= 4096;
+	p.align		= 0;
+	p.n_fat		= 1;
+	p.n_root	= 128;
+	return FR_OK == f_mkfs("0:", &p, work, sizeof(work));
+}
+
+static t_tlog_rec record(uint32_t i) {
+	t_tlog_rec rec;
+	memset(&rec, 0, sizeof(rec));
+	rec.ms		= 1000 + i;
+	rec.dev		= i & 1;
+	rec.raw		= i;
+	rec.temp	= 2000 + i;
+	rec.kp		= -(int32_t)i;
+	return rec;
+}
+
+// Push and drain the records from first till last, not more than ring size at once
+static void session(TLOG &tlog, uint32_t first, uint32_t last) {
+	for (uint32_t i = first; i < last; ++i) {
+		tlog.push(record(i));
+		if ((i % 50) == 49)
+			tlog.drain();
+	}
+	tlog.drain();
+}
+
+// Check the session file: header and the records first..last-1. The IRON and Hot Air Gun records are drained by turns
+static void checkFile(const char *fn, uint32_t first, uint32_t last) {
+	FIL f;
+	FILINFO fno;
+	CHECK_EQ(f_stat(fn, &fno), FR_OK);
+	CHECK_EQ(fno.fsize, sizeof(t_tlog_header) + (last - first) * sizeof(t_tlog_rec));
+	CHECK_EQ(f_open(&f, fn, FA_READ), FR_OK);
+	t_tlog_header h;
+	UINT n = 0;
+	f_read(&f, &h, sizeof(h), &n);
+	CHECK(memcmp(h.magic, "TLOG", 4) == 0);
+	CHECK_EQ(h.rec_size, sizeof(t_tlog_rec));
+	uint32_t bad = 0;
+	uint32_t next[TLOG_DEVICES] = { first, first+1 };		// The next expected record of the device
+	for (uint32_t i = first; i < last; ++i) {
+		t_tlog_rec rec;
+		f_read(&f, &rec, sizeof(rec), &n);
+		if (n != sizeof(rec) || rec.dev >= TLOG_DEVICES) {
+			++bad;
+			continue;
+		}
+		t_tlog_rec exp = record(next[rec.dev]);
+		if (memcmp(&rec, &exp, sizeof(rec)) != 0)
+			++bad;
+		next[rec.dev] += 2;
+	}
+	CHECK_EQ(bad, 0);
+	f_close(&f);
+}
+
+static uint32_t dataSectorMaxErases(void) {
+	uint32_t max = 0;
+	for (uint32_t s = fs.database; s < fs.database + fs.n_fatent - 2; ++s) {
+		uint32_t e = EMU_W25Q_SectorErases(s);
+		if (e > max) max = e;
+	}
+	return max;
+}
+
+static void testSession(void) {
+	static TLOG tlog;										// Zero-initialized rings as in the core instance
+	tlog.setSink(sink);
+	CHECK(tlog.start(&drive));
+	CHECK_EQ(strcmp(tlog.fileName(), "tlog00.bin"), 0);
+	t_w25q_emu_stat st0, st1;
+	FILINFO fno;
+	CHECK_EQ(f_stat("tlog00.bin", &fno), FR_OK);
+	CHECK_EQ(fno.fsize, 512*1024);							// 1 MB does not fit the 1 MB drive, the space is halved
+	EMU_W25Q_Stat(&st0);
+	session(tlog, 0, 200);
+	CHECK_EQ(tlog.written(), 4096);							// One full block, the rest is buffered
+	f_mount(NULL, "0:", 0);									// The configuration code unmounts the drive
+	session(tlog, 200, 400);
+	CHECK_EQ(tlog.written(), 3*4096);
+	EMU_W25Q_Stat(&st1);
+	CHECK_EQ(st1.pages - st0.pages, 3*16);					// The data blocks only, the FAT and directory are not changed
+	CHECK_EQ(st1.write_erases, st0.write_erases);			// No erase is waited for while the records are drained
+	CHECK_EQ(st1.erases - st0.erases, 3);					// The next sector is erased ahead after each block
+	tlog.stop();
+	CHECK(!tlog.isActive());
+	CHECK_EQ(sink_calls, 400);
+	CHECK_EQ(tlog.lost(), 0);
+	drive.mount();
+	checkFile("tlog00.bin", 0, 400);						// The reserved space is cut to the written data
+	CHECK_EQ(dataSectorMaxErases(), 1);
+
+	CHECK_EQ(f_unlink("tlog00.bin"), FR_OK);				// The next session can reuse the sectors: one erase per sector
+	CHECK(tlog.start(&drive));
+	CHECK_EQ(strcmp(tlog.fileName(), "tlog00.bin"), 0);
+	session(tlog, 0, 400);
+	tlog.stop();
+	drive.mount();
+	checkFile("tlog00.bin", 0, 400);
+	CHECK(dataSectorMaxErases() <= 2);
+	EMU_W25Q_Stat(&st1);
+	CHECK_EQ(st1.program_errors, 0);
+}
+
+static void testLost(void) {
+	static TLOG tlog;
+	CHECK(tlog.start(&drive));
+	CHECK_EQ(strcmp(tlog.fileName(), "tlog01.bin"), 0);		// The previous session file is kept
+	for (uint32_t i = 0; i < 70; ++i)						// The main loop is busy, the IRON ring overflows
+		tlog.push(record(i*2));
+	tlog.drain();
+	CHECK_EQ(tlog.lost(), 7);								// 63 records fit the ring
+	tlog.push(record(1000));
+	tlog.drain();
+	tlog.stop();
+	CHECK_EQ(tlog.lost(), 7);
+	drive.mount();
+	FIL f;
+	UINT n = 0;
+	t_tlog_rec rec;
+	CHECK_EQ(f_open(&f, "tlog01.bin", FA_READ), FR_OK);
+	CHECK_EQ(f_size(&f), sizeof(t_tlog_header) + 64*sizeof(t_tlog_rec));
+	f_lseek(&f, f_size(&f) - sizeof(t_tlog_rec));
+	f_read(&f, &rec, sizeof(rec), &n);
+	CHECK_EQ(rec.raw, 1000);
+	CHECK_EQ(rec.flags & TLOG_LOST, TLOG_LOST);
+	f_close(&f);
+}
+
+// The session file is removed in the flash debug mode: the session stops, its former sectors are not programmed
+static void testRemoved(void) {
+	static TLOG tlog;
+	t_w25q_emu_stat st0, st1;
+	CHECK(tlog.start(&drive));
+	session(tlog, 0, 50);
+	CHECK_EQ(f_unlink(tlog.fileName()), FR_OK);
+	EMU_W25Q_Stat(&st0);
+	session(tlog, 50, 200);
+	EMU_W25Q_Stat(&st1);
+	CHECK(!tlog.isActive());
+	CHECK_EQ(st1.pages, st0.pages);
+}
+
+// The session stops when the reserved space is full
+static void testFull(void) {
+	static TLOG tlog;
+	FILINFO fno;
+	CHECK(tlog.start(&drive));
+	CHECK_EQ(f_stat(tlog.fileName(), &fno), FR_OK);
+	uint32_t space = fno.fsize;								// The drive is not empty, the space can be less than 512 KB
+	CHECK(space >= 64*1024);
+	for (uint32_t i = 0; i < 20000 && tlog.isActive(); i += 50)
+		session(tlog, i, i + 50);
+	CHECK(!tlog.isActive());
+	CHECK_EQ(tlog.written(), space);
+	drive.mount();
+	CHECK_EQ(f_stat(tlog.fileName(), &fno), FR_OK);
+	CHECK_EQ(fno.fsize, space);
+	t_w25q_emu_stat st;
+	EMU_W25Q_Stat(&st);
+	CHECK_EQ(st.program_errors, 0);
+}
+
+int main(void) {
+	EMU_W25Q_Init(256);
+	CHECK(format());
+	testSession();
+	testLost();
+	testRemoved();
+	testFull();
+	f_mount(NULL, "0:", 0);
+	EMU_W25Q_Free();
+	return testResult("tlog");
+}
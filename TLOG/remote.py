@@ -0,0 +1,159 @@
+#!/usr/bin/env python3
+#
+# remote.py
+#
+# Controls the soldering station built with SERIAL_PORT define over the serial port, see SRC/Core/Inc/remote.h
+# Every command prints the reply status and the device state. The 'monitor' command prints the state change events.
+#
+# Usage:
+#   remote.py /dev/ttyUSB0 query iron
+#   remote.py /dev/ttyUSB0 temp iron 320         preset temperature in the configured units
+#   remote.py /dev/ttyUSB0 fan gun 1200          preset fan speed, 0 - max fan speed of cfg.json
+#   remote.py /dev/ttyUSB0 power gun on
+#   remote.py /dev/ttyUSB0 standby iron on
+#   remote.py /dev/ttyUSB0 tip iron 12           tip index, only active tip can be selected when the IRON is off
+#   remote.py /dev/ttyUSB0 rate iron 0           telemetry stream rate, Hz. 0 - disable the stream
+#   remote.py /dev/ttyUSB0 monitor
+#
+# Command payload (frame type 2): uint8 cmd, uint8 dev, uint16 value
+# Reply payload (frame type 3): uint8 cmd, uint8 status, state
+# Event payload (frame type 4): state
+# State: uint8 dev, uint8 mode, uint8 flags, uint8 tip, uint16 temp, uint16 preset, uint16 fan, uint8 power, uint8 errors
+#   errors is the number of the command frames the station dropped (corrupted or lost), modulo 256
+#
+
+import argparse
+import struct
+import sys
+import time
+import zlib
+
+from tstream import Stream, unpack, IRON_MODES, GUN_MODES
+
+FRAME_COMMAND	= 2
+FRAME_REPLY		= 3
+FRAME_EVENT		= 4
+COMMANDS		= ("ping", "query", "temp", "fan", "power", "standby", "tip", "rate")
+STATUS			= ("ok", "bad command", "bad device", "bad argument", "busy", "failed")
+DEVICES			= ("iron", "gun")
+REQUEST			= struct.Struct("<BBH")
+STATE			= struct.Struct("<BBBBHHHBB")
+REPLY			= struct.Struct("<BB")
+FLAGS			= ((1, "connected"), (2, "celsius"), (4, "working"))
+
+
+def cobs_encode(data):
+	out		= bytearray([0])
+	code_pos, code = 0, 1
+	for b in data:
+		if b == 0:
+			out[code_pos] = code
+			code_pos, code = len(out), 1
+			out.append(0)
+		else:
+			out.append(b)
+			code += 1
+			if code == 0xFF:
+				out[code_pos] = code
+				code_pos, code = len(out), 1
+				out.append(0)
+	out[code_pos] = code
+	return bytes(out)
+
+
+# The leading delimiter closes the frame broken by the data the station lost, so this one is not dropped with it
+def pack(ftype, seq, payload):
+	pkt = bytes([ftype, seq]) + payload
+	return b"\0" + cobs_encode(pkt + struct.pack("<I", zlib.crc32(pkt))) + b"\0"
+
+
+def state_str(payload, offset=0):
+	dev, mode, flags, tip, temp, preset, fan, power, errors = STATE.unpack_from(payload, offset)
+	modes	= IRON_MODES if dev == 0 else GUN_MODES
+	s = "%s: %s, temp %d, preset %d, power %d%%" % (DEVICES[dev] if dev < len(DEVICES) else dev,
+		modes[mode] if mode < len(modes) else mode, temp, preset, power)
+	if dev == 0:
+		s += ", tip %d" % tip
+	else:
+		s += ", fan %d" % fan
+	if errors:
+		s += ", %d dropped commands" % errors
+	f = [n for b, n in FLAGS if flags & b]
+	return s + (" [%s]" % ", ".join(f) if f else "")
+
+
+def value(arg):
+	if arg is None:
+		return 0
+	if arg in ("on", "off"):
+		return 1 if arg == "on" else 0
+	return int(arg)
+
+
+class Frames(Stream):
+	""" Yields all the frames, not only telemetry records """
+	def frames(self, data):
+		self.buff += data
+		while True:
+			end = self.buff.find(b"\0")
+			if end < 0:
+				return
+			frame = bytes(self.buff[:end])
+			del self.buff[:end + 1]
+			if frame:
+				p = unpack(frame)
+				if p is None:
+					self.bad += 1
+				else:
+					yield p
+
+
+def command(port, frames, cmd, dev, val, seq, timeout, retries):
+	req = pack(FRAME_COMMAND, seq, REQUEST.pack(cmd, dev, val))
+	for _ in range(retries):
+		port.write(req)
+		end = time.time() + timeout
+		while time.time() < end:
+			for ftype, s, payload in frames.frames(port.read(port.in_waiting or 1)):
+				if ftype == FRAME_REPLY and s == seq and len(payload) >= REPLY.size + STATE.size:
+					return payload
+	return None
+
+
+def main():
+	ap = argparse.ArgumentParser(description="Control the soldering station over the serial port")
+	ap.add_argument("port",				help="serial port")
+	ap.add_argument("command",			choices=COMMANDS + ("monitor",))
+	ap.add_argument("device",			nargs="?", default="iron", choices=DEVICES)
+	ap.add_argument("value",			nargs="?")
+	ap.add_argument("-b", "--baud",		type=int, default=115200)
+	ap.add_argument("--timeout",		type=float, default=0.5, help="reply timeout, s")
+	ap.add_argument("--retries",		type=int, default=3)
+	a = ap.parse_args()
+	try:
+		import serial
+	except ImportError:
+		sys.exit("pyserial is required to read the serial port")
+
+	frames = Frames()
+	with serial.Serial(a.port, a.baud, timeout=0.05) as port:
+		if a.command == "monitor":
+			try:
+				while True:
+					for ftype, _, payload in frames.frames(port.read(port.in_waiting or 1)):
+						if ftype == FRAME_EVENT and len(payload) >= STATE.size:
+							print(state_str(payload), flush=True)
+			except KeyboardInterrupt:
+				return
+		cmd		= COMMANDS.index(a.command)
+		reply	= command(port, frames, cmd, DEVICES.index(a.device), value(a.value),
+						int(time.time() * 1000) & 0xFF, a.timeout, a.retries)
+		if reply is None:
+			sys.exit("no reply from the station")
+		_, status = REPLY.unpack_from(reply, 0)
+		print("%s; %s" % (STATUS[status] if status < len(STATUS) else status, state_str(reply, REPLY.size)))
+		sys.exit(0 if status == 0 else 1)
+
+
+if __name__ == "__main__":
+	main()
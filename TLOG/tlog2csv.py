@@ -0,0 +1,97 @@
+#!/usr/bin/env python3
+#
+# tlog2csv.py
+#
+# Converts the telemetry session file, written by the controller to the flash drive, into CSV.
+# The session is started and stopped by the Hot Air Gun button in the debug mode, the files are
+# named tlog00.bin ... tlog99.bin. The flash drive is soldered on the board: copy the files to the SD card
+# by double press of the IRON encoder button in the flash debug mode, then read the SD card on the PC.
+# The file of the session interrupted by power loss keeps its reserved size, the unwritten tail is 0xFF.
+#
+# Usage:
+#   tlog2csv.py tlog00.bin                 writes tlog00.csv
+#   tlog2csv.py tlog00.bin -o session.csv
+#   tlog2csv.py tlog00.bin --device iron   IRON records only
+#
+# File format (little endian), see t_tlog_header and t_tlog_rec in SRC/Core/Inc/tlog.h:
+#   char magic[4] "TLOG", uint16 version, uint16 rec_size, uint32 start_ms, uint32 reserved
+#   records: uint32 ms, uint8 dev, uint8 flags, uint16 raw, uint16 temp, uint16 preset,
+#            int32 kp, int32 ki, int32 kd, uint16 power, uint16 current, uint16 ambient, uint16 reserved
+#
+# The temperatures are in internal units, the PID terms are multiplied by PID denominator.
+#
+
+import argparse
+import csv
+import os
+import struct
+import sys
+
+HEADER		= struct.Struct("<4sHHII")
+RECORD		= struct.Struct("<IBBHHHiiiHHHH")
+DEVICES		= ("iron", "gun")
+FLAG_PID	= 1
+FLAG_LOST	= 2
+ERASED		= b"\xff"										# The erased flash byte
+COLUMNS		= ("time_ms", "device", "raw", "temp", "preset", "kp", "ki", "kd", "power", "current", "ambient", "pid", "lost")
+
+
+def records(data, name):
+	""" Check the header and yield the decoded records """
+	if len(data) < HEADER.size:
+		sys.exit("%s: file is too short" % name)
+	magic, version, rec_size, start_ms, _ = HEADER.unpack_from(data, 0)
+	if magic != b"TLOG":
+		sys.exit("%s: not a telemetry file" % name)
+	if version != 1 or rec_size < RECORD.size:
+		sys.exit("%s: unsupported version %d, record size %d" % (name, version, rec_size))
+	pos = HEADER.size
+	while pos + rec_size <= len(data):
+		if data[pos:pos + rec_size] == ERASED * rec_size:	# The unwritten tail of the reserved space
+			return
+		ms, dev, flags, raw, temp, preset, kp, ki, kd, power, current, ambient, _ = RECORD.unpack_from(data, pos)
+		pos += rec_size
+		yield {
+			"time_ms":	ms - start_ms,
+			"device":	DEVICES[dev] if dev < len(DEVICES) else str(dev),
+			"raw":		raw,
+			"temp":		temp,
+			"preset":	preset,
+			"kp":		kp if flags & FLAG_PID else "",
+			"ki":		ki if flags & FLAG_PID else "",
+			"kd":		kd if flags & FLAG_PID else "",
+			"power":	power,
+			"current":	current,
+			"ambient":	ambient,
+			"pid":		1 if flags & FLAG_PID else 0,
+			"lost":		1 if flags & FLAG_LOST else 0,
+		}
+	if pos != len(data):
+		print("%s: %d bytes of incomplete record ignored" % (name, len(data) - pos), file=sys.stderr)
+
+
+def main():
+	ap = argparse.ArgumentParser(description="Convert the soldering station telemetry log to CSV")
+	ap.add_argument("log",				help="telemetry session file, tlogNN.bin")
+	ap.add_argument("-o", "--output",	help="output CSV file, default is the log name with .csv extension")
+	ap.add_argument("--device",			choices=DEVICES, help="write the records of this device only")
+	a = ap.parse_args()
+
+	with open(a.log, "rb") as f:
+		data = f.read()
+	out = a.output or os.path.splitext(a.log)[0] + ".csv"
+	n = lost = 0
+	with open(out, "w", newline="") as f:
+		w = csv.DictWriter(f, fieldnames=COLUMNS)
+		w.writeheader()
+		for r in records(data, a.log):
+			if a.device and r["device"] != a.device:
+				continue
+			w.writerow(r)
+			n		+= 1
+			lost	+= r["lost"]
+	print("%s: %d records, %d gaps" % (out, n, lost))
+
+
+if __name__ == "__main__":
+	main()
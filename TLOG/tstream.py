@@ -0,0 +1,188 @@
+#!/usr/bin/env python3
+#
+# tstream.py
+#
+# Receives the live telemetry stream from the serial port of the controller built with SERIAL_PORT define,
+# see SRC/Core/Inc/serial.h. Prints the records as CSV or plots the IRON and Hot Air Gun data.
+#
+# Usage:
+#   tstream.py /dev/ttyUSB0                      CSV to stdout
+#   tstream.py /dev/ttyUSB0 -o session.csv
+#   tstream.py /dev/ttyUSB0 --plot               needs matplotlib
+#   tstream.py capture.bin --file                decode the raw stream saved before
+#
+# Frame format, see SRC/Core/Inc/frame.h: COBS encoded packet terminated by zero byte.
+# Packet: uint8 type, uint8 seq, payload, uint32 CRC32 of the previous bytes (little endian).
+# Telemetry payload (type 1) is t_tstream_pkt: t_tlog_rec (see tlog2csv.py) followed by uint8 mode, uint8 reserved.
+#
+
+import argparse
+import csv
+import struct
+import sys
+import zlib
+
+from tlog2csv import RECORD, DEVICES, FLAG_PID, FLAG_LOST, COLUMNS
+
+FRAME_TELEMETRY	= 1
+IRON_MODES		= ("off", "heating", "on", "fixed", "cooling", "pid_tune", "boost")
+GUN_MODES		= ("off", "on", "fixed", "cooling", "pid_tune")
+
+
+def cobs_decode(data):
+	""" Returns decoded bytes or None if the data is corrupted """
+	out	= bytearray()
+	i	= 0
+	while i < len(data):
+		code = data[i]
+		i += 1
+		if code == 0 or i + code - 1 > len(data):
+			return None
+		out += data[i:i + code - 1]
+		i += code - 1
+		if code != 0xFF and i < len(data):
+			out.append(0)
+	return bytes(out)
+
+
+def unpack(frame):
+	""" Returns (type, seq, payload) or None if the frame is corrupted """
+	pkt = cobs_decode(frame)
+	if pkt is None or len(pkt) < 6:
+		return None
+	crc, = struct.unpack_from("<I", pkt, len(pkt) - 4)
+	if crc != zlib.crc32(pkt[:-4]):
+		return None
+	return pkt[0], pkt[1], pkt[2:-4]
+
+
+class Stream:
+	""" Splits the byte stream into frames and decodes the telemetry records """
+	def __init__(self):
+		self.buff	= bytearray()
+		self.bad	= 0
+		self.seq	= None
+		self.gaps	= 0
+
+	def feed(self, data):
+		self.buff += data
+		while True:
+			end = self.buff.find(b"\0")
+			if end < 0:
+				return
+			frame = bytes(self.buff[:end])
+			del self.buff[:end + 1]
+			if not frame:
+				continue
+			p = unpack(frame)
+			if p is None:
+				self.bad += 1
+				continue
+			ftype, seq, payload = p
+			if ftype != FRAME_TELEMETRY:					# Remote control frames have own sequence numbers
+				continue
+			if self.seq is not None and seq != (self.seq + 1) & 0xFF:
+				self.gaps += 1
+			self.seq = seq
+			if len(payload) >= RECORD.size + 1:
+				yield self.record(payload)
+
+	@staticmethod
+	def record(payload):
+		ms, dev, flags, raw, temp, preset, kp, ki, kd, power, current, ambient, _ = RECORD.unpack_from(payload, 0)
+		modes	= IRON_MODES if dev == 0 else GUN_MODES
+		mode	= payload[RECORD.size]
+		return {
+			"time_ms":	ms,
+			"device":	DEVICES[dev] if dev < len(DEVICES) else str(dev),
+			"raw":		raw,
+			"temp":		temp,
+			"preset":	preset,
+			"kp":		kp if flags & FLAG_PID else "",
+			"ki":		ki if flags & FLAG_PID else "",
+			"kd":		kd if flags & FLAG_PID else "",
+			"power":	power,
+			"current":	current,
+			"ambient":	ambient,
+			"pid":		1 if flags & FLAG_PID else 0,
+			"lost":		1 if flags & FLAG_LOST else 0,
+			"mode":		modes[mode] if mode < len(modes) else str(mode),
+		}
+
+
+def source(a):
+	""" Yields the chunks of raw data from the serial port or from the file """
+	if a.file:
+		with open(a.port, "rb") as f:
+			while True:
+				data = f.read(4096)
+				if not data:
+					return
+				yield data
+	try:
+		import serial
+	except ImportError:
+		sys.exit("pyserial is required to read the serial port")
+	with serial.Serial(a.port, a.baud, timeout=0.1) as port:
+		while True:
+			yield port.read(port.in_waiting or 1)
+
+
+def plot(a, stream):
+	import matplotlib.pyplot as plt
+	from collections import deque
+	hist = {d: {k: deque(maxlen=a.points) for k in ("t", "temp", "preset", "power")} for d in DEVICES}
+	fig, axes = plt.subplots(2, 1, sharex=True)
+	plt.ion()
+	n = 0
+	for data in source(a):
+		for r in stream.feed(data):
+			h = hist[r["device"]]
+			h["t"].append(r["time_ms"] / 1000.0)
+			for k in ("temp", "preset", "power"):
+				h[k].append(r[k])
+			n += 1
+		if n >= 10:
+			n = 0
+			for ax, d in zip(axes, DEVICES):
+				h = hist[d]
+				ax.clear()
+				ax.set_title(d)
+				ax.plot(h["t"], h["temp"], label="temp")
+				ax.plot(h["t"], h["preset"], label="preset")
+				ax2 = ax.twinx()
+				ax2.clear()
+				ax2.plot(h["t"], h["power"], "r:", label="power")
+				ax.legend(loc="upper left")
+			plt.pause(0.01)
+
+
+def main():
+	ap = argparse.ArgumentParser(description="Receive the soldering station telemetry stream")
+	ap.add_argument("port",				help="serial port or the file with --file")
+	ap.add_argument("-b", "--baud",		type=int, default=115200)
+	ap.add_argument("-o", "--output",	help="write CSV to the file instead of stdout")
+	ap.add_argument("--file",			action="store_true", help="read the raw stream from the file")
+	ap.add_argument("--plot",			action="store_true", help="plot the data instead of CSV output")
+	ap.add_argument("--points",			type=int, default=1000, help="the number of points to plot")
+	a = ap.parse_args()
+
+	stream = Stream()
+	try:
+		if a.plot:
+			plot(a, stream)
+			return
+		out = open(a.output, "w", newline="") if a.output else sys.stdout
+		w = csv.DictWriter(out, fieldnames=COLUMNS + ("mode",))
+		w.writeheader()
+		for data in source(a):
+			for r in stream.feed(data):
+				w.writerow(r)
+			out.flush()
+	except KeyboardInterrupt:
+		pass
+	print("bad frames: %d, sequence gaps: %d" % (stream.bad, stream.gaps), file=sys.stderr)
+
+
+if __name__ == "__main__":
+	main()